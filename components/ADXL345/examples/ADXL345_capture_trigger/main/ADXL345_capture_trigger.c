@@ -0,0 +1,258 @@
+/**
+ * File:       ADXL345_capture_trigger.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Pre/post trigger capture from the simulated ADXL345.  Shocks on X fire the
+ * software threshold trigger, and a timer fires one more capture through
+ * ADXL345_captureTrigger from another task.  Y carries a running sample
+ * number instead of motion, so every frozen window can be checked for a
+ * dropped, repeated or misplaced sample, including across the point where
+ * the mirrored buffer wraps.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_capture.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_simwave.h"
+
+#define RATE_800HZ          0x0D
+#define SPI_HZ              5000000
+#define OVERHEAD_US         20
+#define WATERMARK           16
+#define POLL_MS             10
+#define WINDOW_LENGTH       1024
+#define POST_TRIGGER        256
+#define THRESHOLD_MG        2000
+#define SHOCK_MG            4000
+#define SHOCK_US            5000
+#define SHOCK_PERIOD_US     2000000
+#define THRESHOLD_CAPTURES  2
+#define API_TRIGGER_US      1500000
+#define CAPTURE_TIMEOUT_US  4000000
+#define CAPTURES            (THRESHOLD_CAPTURES + 1)
+// Y counts through this many values, well inside the +/-16 g range
+#define TAG_MODULO          4096
+// Full resolution counts per g
+#define ONE_G_COUNTS        256
+
+typedef struct _taggedWave {
+    ADXL345_SIM_WAVE wave;
+    uint32_t sequence;
+} TAGGED_WAVE;
+
+typedef struct _captureResult {
+    ADXL345_CAPTURE_SOURCE source;
+    int count;
+    int triggerIndex;
+    int16_t triggerValue;
+    // Steps of the Y sample number other than +1
+    int gaps;
+    // Samples ahead of the trigger that were already over the threshold
+    int early;
+} CAPTURE_RESULT;
+
+ADXL345_SIM sim;
+ADXL345_DEVICE accel;
+ADXL345_CAPTURE capture;
+TAGGED_WAVE tagged;
+CAPTURE_RESULT results[CAPTURES];
+int captured;
+int64_t drainUs;
+int drains;
+
+// Function predefinition
+void tagged_wave(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+void window_captured(const ADXL345_CAPTURE_WINDOW *window, void *arg);
+void trigger_timer(void *arg);
+bool run_capture(void);
+const char *source_name(ADXL345_CAPTURE_SOURCE source);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, SPI_HZ, OVERHEAD_US));
+    ADXL345_simSetSpi(&sim, SPI_HZ, OVERHEAD_US);
+    ADXL345_simWaveInit(&tagged.wave);
+    tagged.wave.gravityMg.z = 1000;
+    tagged.wave.noiseMg = 20;
+    tagged.wave.shockMg.x = SHOCK_MG;
+    tagged.wave.shockUs = SHOCK_US;
+    tagged.wave.shockPeriodUs = SHOCK_PERIOD_US;
+    ADXL345_simSetGenerator(&sim, tagged_wave, &tagged);
+
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+    ADXL345_CONFIG config = {
+        .range = ADXL345_RANGE_16G,
+        .fullResolution = true,
+        .bwRate = RATE_800HZ,
+    };
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &config));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, WATERMARK));
+    ESP_ERROR_CHECK(ADXL345_captureInit(&capture, WINDOW_LENGTH, POST_TRIGGER, window_captured, results));
+
+    esp_timer_handle_t timer;
+    const esp_timer_create_args_t timerArgs = {
+        .callback = trigger_timer,
+        .arg = &capture,
+        .name = "capture_trigger",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &timer));
+
+    uint32_t startOverruns = sim.overruns;
+    bool complete = true;
+    ADXL345_captureSetThreshold(&capture, &accel, THRESHOLD_MG, ADXL345_AXIS_X);
+    int16_t thresholdCounts = capture.threshold;
+    for (int c = 0; c < THRESHOLD_CAPTURES; c++) {
+        complete = run_capture() && complete;
+    }
+    // With the threshold off only the request can fire it
+    ADXL345_captureSetThreshold(&capture, &accel, 0, ADXL345_AXIS_X);
+    ESP_ERROR_CHECK(esp_timer_start_once(timer, API_TRIGGER_US));
+    complete = run_capture() && complete;
+    ADXL345_setMeasure(&accel, false);
+    esp_timer_delete(timer);
+    uint32_t lost = sim.overruns - startOverruns;
+
+    printf("%-8s %-10s %8s %8s %8s %8s %6s %6s\n", "Capture", "Source", "Samples", "Trigger", "Post", "Value",
+           "Gaps", "Early");
+    bool pass = complete && captured == CAPTURES && lost == 0;
+    for (int c = 0; c < captured; c++) {
+        const CAPTURE_RESULT *result = &results[c];
+        int post = result->count - 1 - result->triggerIndex;
+        printf("%-8d %-10s %8d %8d %8d %8d %6d %6d\n", c, source_name(result->source), result->count,
+               result->triggerIndex, post, result->triggerValue, result->gaps, result->early);
+        printf("BENCH,capture_%d,samples,%d\n", c, result->count);
+        printf("BENCH,capture_%d,post_trigger,%d\n", c, post);
+        printf("BENCH,capture_%d,gaps,%d\n", c, result->gaps);
+
+        ADXL345_CAPTURE_SOURCE expected = (c < THRESHOLD_CAPTURES) ? ADXL345_CAPTURE_SOURCE_THRESHOLD
+                                                                   : ADXL345_CAPTURE_SOURCE_API;
+        bool triggered = (expected == ADXL345_CAPTURE_SOURCE_API) || (abs(result->triggerValue) > thresholdCounts);
+        // The first shock may come soon after starting, every later capture has wrapped the buffer
+        bool full = (c == 0) ? (result->count > POST_TRIGGER) : (result->count == WINDOW_LENGTH);
+        if (result->source != expected || !full || post != POST_TRIGGER ||
+            result->gaps != 0 || result->early != 0 || !triggered) {
+            pass = false;
+        }
+    }
+
+    double perDrainUs = (drains > 0) ? (double) drainUs / drains : 0.0;
+    printf("Drains:  %d, %.1f us each with simulated bus time, %lu samples lost\n", drains, perDrainUs,
+           (unsigned long) lost);
+    printf("BENCH,drain,us,%.1f\n", perDrainUs);
+    printf("BENCH,drain,lost,%lu\n", (unsigned long) lost);
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * ADXL345_SIM_GENERATOR that plays the wave on X and Z and puts a running
+ * sample number on Y, in milli-g that convert back to exactly that count.
+ *
+ * @param timeUs Time of the sample
+ * @param sample ADXL345_SAMPLE to fill in milli-g
+ * @param arg    TAGGED_WAVE
+ */
+void tagged_wave(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg) {
+    TAGGED_WAVE *wave = (TAGGED_WAVE *) arg;
+    ADXL345_simWave(timeUs, sample, &wave->wave);
+    int tag = (int) (wave->sequence++ % TAG_MODULO) - TAG_MODULO / 2;
+    sample->y = (int16_t) (tag * 1000 / ONE_G_COUNTS);
+}
+
+/**
+ * Capture callback, checks the frozen window and records what it found.
+ *
+ * @param window ADXL345_CAPTURE_WINDOW frozen
+ * @param arg    Array of CAPTURE_RESULT
+ */
+void window_captured(const ADXL345_CAPTURE_WINDOW *window, void *arg) {
+    if (captured >= CAPTURES) {
+        return;
+    }
+    CAPTURE_RESULT *result = &((CAPTURE_RESULT *) arg)[captured++];
+    *result = (CAPTURE_RESULT) {
+        .source = window->source,
+        .count = window->count,
+        .triggerIndex = window->triggerIndex,
+    };
+    if (window->triggerIndex >= 0 && window->triggerIndex < window->count) {
+        result->triggerValue = window->x[window->triggerIndex];
+    }
+
+    for (int i = 1; i < window->count; i++) {
+        int step = (window->y[i] - window->y[i - 1] + TAG_MODULO) % TAG_MODULO;
+        if (step != 1) {
+            result->gaps++;
+        }
+    }
+    // The trigger has to be the first sample over the threshold, not a later one
+    if (window->source == ADXL345_CAPTURE_SOURCE_THRESHOLD) {
+        for (int i = 0; i < window->triggerIndex && i < window->count; i++) {
+            if (abs(window->x[i]) > capture.threshold) {
+                result->early++;
+            }
+        }
+    }
+}
+
+/**
+ * esp_timer callback, requests a capture from the timer task.
+ *
+ * @param arg ADXL345_CAPTURE to trigger
+ */
+void trigger_timer(void *arg) {
+    ADXL345_captureTrigger((ADXL345_CAPTURE *) arg, ADXL345_CAPTURE_SOURCE_API);
+}
+
+/**
+ * Rearms the capture and drains into it every POLL_MS until it completes.
+ *
+ * @return true if the capture completed within CAPTURE_TIMEOUT_US
+ */
+bool run_capture(void) {
+    ADXL345_captureRearm(&capture);
+    int64_t startUs = esp_timer_get_time();
+
+    while (capture.state != ADXL345_CAPTURE_COMPLETE) {
+        if (esp_timer_get_time() - startUs > CAPTURE_TIMEOUT_US) {
+            return false;
+        }
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+
+        int64_t start = esp_timer_get_time();
+        esp_err_t err = ADXL345_captureDrain(&capture, &accel);
+        drainUs += esp_timer_get_time() - start;
+        drains++;
+        if (err != ESP_OK) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns a printable name for the param source.
+ */
+const char *source_name(ADXL345_CAPTURE_SOURCE source) {
+    switch (source) {
+        case ADXL345_CAPTURE_SOURCE_API:
+            return "api";
+        case ADXL345_CAPTURE_SOURCE_THRESHOLD:
+            return "threshold";
+        case ADXL345_CAPTURE_SOURCE_ACTIVITY:
+            return "activity";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,150 @@
+/**
+ * File:       ADXL345_fault_injection.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Drains the FIFO of a simulated ADXL345 on a noisy, occasionally wedged
+ * bus, and checks that the driver keeps sampling with bounded latency.
+ */
+#include <stdio.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+
+#define RUN_SECONDS         10
+#define DRAIN_PERIOD_MS     20
+#define STICK_EVERY_MS      1000
+#define BROWNOUT_EVERY_MS   3000
+#define CHECK_EVERY_DRAINS  8
+#define RATE_800HZ          0x0D
+
+#define NACK_PERMILLE       20
+#define TIMEOUT_PERMILLE    5
+// What the I2C controller's own timeout would cost a failed transfer
+#define FAULT_TIMEOUT_US    2000
+
+// Transfers one recovery makes: the device ID check and six configuration writes
+#define RECOVERY_TRANSFERS  7
+
+ADXL345_SIM sim;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ fifoRead;
+ADXL345_BLOCK block;
+
+ADXL345_CONFIG accelConfig = {
+    .range = ADXL345_RANGE_2G,
+    .fullResolution = true,
+    .bwRate = RATE_800HZ,
+};
+
+// Function predefinition
+uint32_t latency_bound_us(const ADXL345_DEVICE *dev);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, 400000, 20));
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &accelConfig));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, 0));
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&fifoRead));
+    ADXL345_simSetFaults(&sim, NACK_PERMILLE, TIMEOUT_PERMILLE, FAULT_TIMEOUT_US);
+
+    int64_t startUs = esp_timer_get_time();
+    int64_t nextStickUs = startUs + STICK_EVERY_MS * 1000;
+    int64_t nextBrownoutUs = startUs + BROWNOUT_EVERY_MS * 1000;
+    uint32_t drains = 0;
+    uint32_t failedDrains = 0;
+    uint32_t samples = 0;
+    int64_t worstUs = 0;
+
+    while (esp_timer_get_time() - startUs < RUN_SECONDS * 1000000ll) {
+        int64_t now = esp_timer_get_time();
+        if (now >= nextStickUs) {
+            ADXL345_simSetStuck(&sim, true);
+            nextStickUs += STICK_EVERY_MS * 1000;
+        }
+        if (now >= nextBrownoutUs) {
+            ADXL345_simPowerCycle(&sim);
+            nextBrownoutUs += BROWNOUT_EVERY_MS * 1000;
+        }
+
+        int64_t drainStart = esp_timer_get_time();
+        if (++drains % CHECK_EVERY_DRAINS == 0) {
+            ADXL345_checkConfig(&accel);
+        }
+        esp_err_t err = ADXL345_readFifoStart(&accel, &fifoRead);
+        if (err == ESP_OK) {
+            err = ADXL345_readFifoFinish(&accel, &fifoRead, &block);
+        }
+        int64_t drainUs = esp_timer_get_time() - drainStart;
+
+        if (drainUs > worstUs) {
+            worstUs = drainUs;
+        }
+        if (err == ESP_OK) {
+            samples += block.count;
+        } else {
+            failedDrains++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+    }
+
+    double seconds = (esp_timer_get_time() - startUs) / 1e6;
+    uint32_t expected = (uint32_t) (seconds * 1000000.0 / ADXL345_samplePeriodUs(RATE_800HZ));
+    uint32_t boundUs = latency_bound_us(&accel);
+    const ADXL345_HEALTH *health = &accel.health;
+
+    printf("Simulated bus: %lu transfers, %lu faults, %lu recoveries\n", (unsigned long) sim.transfers,
+           (unsigned long) sim.faults, (unsigned long) sim.recoveries);
+    printf("Driver:        %lu errors (%lu timeouts, %lu NACKs), %lu retries, %lu failed transfers\n",
+           (unsigned long) health->errors, (unsigned long) health->timeouts, (unsigned long) health->nacks,
+           (unsigned long) health->retries, (unsigned long) health->failures);
+    printf("               %lu recoveries, %lu re-inits\n", (unsigned long) health->recoveries,
+           (unsigned long) health->reinits);
+    printf("Drains:        %lu, %lu failed\n", (unsigned long) drains, (unsigned long) failedDrains);
+    printf("Samples:       %lu of %lu (%.1f%%)\n", (unsigned long) samples, (unsigned long) expected,
+           100.0 * samples / expected);
+    printf("Worst drain:   %lld us (bound %lu us)\n", (long long) worstUs, (unsigned long) boundUs);
+
+    bool healthy = !accel.needsRecovery && ADXL345_checkConfig(&accel) == ESP_OK;
+    bool pass = healthy && worstUs <= boundUs && samples * 10 >= expected * 9;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Returns the longest one drain can take under the device's retry policy.
+ * Each of the FIFO count read's attempts may first recover the sensor and
+ * then time out itself, with the backoff doubling in between, and the queued
+ * bursts are bounded by the drain timeout.
+ *
+ * @param dev ADXL345_DEVICE to take the retry policy from
+ */
+uint32_t latency_bound_us(const ADXL345_DEVICE *dev) {
+    // Time for a transfer to fail, either on the bus or by the transport giving up waiting
+    uint32_t attemptUs = FAULT_TIMEOUT_US;
+    uint32_t boundUs = 0;
+    uint32_t backoffUs = dev->retry.backoffUs;
+
+    for (int attempt = 0; attempt < dev->retry.attempts; attempt++) {
+        if (attempt > 0) {
+            boundUs += backoffUs;
+            backoffUs *= 2;
+        }
+        boundUs += (RECOVERY_TRANSFERS + 1) * attemptUs;
+    }
+    // A brownout found by the config check costs one more full recovery
+    boundUs += dev->retry.attempts * attemptUs + RECOVERY_TRANSFERS * attemptUs;
+    boundUs += dev->retry.drainTimeoutMs * 1000;
+    // Scheduling slack, a tick either side
+    return boundUs + 2 * portTICK_PERIOD_MS * 1000;
+}
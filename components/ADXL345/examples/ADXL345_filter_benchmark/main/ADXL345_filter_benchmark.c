@@ -0,0 +1,354 @@
+/**
+ * File:       ADXL345_filter_benchmark.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Cost of the ADXL345 filter kernels on one 32 sample FIFO drain, against
+ * plain scalar versions of the same filters.  The scalar versions work a
+ * sample at a time, the way the filters would be written without thought
+ * for vectorizing them, and are built with vectorization turned off, so
+ * each pair shows what the block layout buys.  Both are run on the same
+ * input and must agree bit for bit before any timing is trusted.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "esp_timer.h"
+#include "ADXL345.h"
+#include "ADXL345_filter.h"
+
+#define SAMPLE_RATE_HZ      800.0f
+// Blocks are generated and timed a batch at a time, so the timer's
+// microsecond resolution doesn't swamp a kernel that takes a fraction of one
+#define BATCH_BLOCKS        64
+#define BATCHES             300
+#define AVG_WINDOW          8
+#define DECIMATION          4
+#define LOW_PASS_HZ         50.0f
+#define HIGH_PASS_HZ        0.5f
+// A whole pipeline, average, two biquads and decimation, on one FIFO drain
+#define REQUIRED_PIPELINE_US 5.0
+// Gravity on Z, in full resolution counts
+#define GRAVITY_COUNTS      256
+
+#define SCALAR __attribute__((noinline, optimize("no-tree-vectorize")))
+
+typedef void (*KERNEL_FN)(void *state, ADXL345_BLOCK *block);
+
+typedef struct _kernel {
+    const char *name;
+    KERNEL_FN scalar;
+    void *scalarState;
+    KERNEL_FN block;
+    void *blockState;
+    // Gives blocks uneven lengths, to exercise state carried between blocks
+    bool unevenBlocks;
+} KERNEL;
+
+typedef struct _kernelResult {
+    double scalarNs;
+    double blockNs;
+    bool matched;
+    // Z axis of the last block, to check what a filter settled on
+    int32_t lastZSum;
+} KERNEL_RESULT;
+
+typedef struct _scalarAverage {
+    int window;
+    int next;
+    int32_t sum[3];
+    int16_t history[3][ADXL345_MAX_AVG_WINDOW];
+} SCALAR_AVERAGE;
+
+typedef struct _scalarDecimator {
+    int factor;
+    int phase;
+    int32_t acc[3];
+} SCALAR_DECIMATOR;
+
+static ADXL345_BLOCK batch[BATCH_BLOCKS];
+static ADXL345_BLOCK scalarOut[BATCH_BLOCKS];
+static ADXL345_BLOCK blockOut[BATCH_BLOCKS];
+static uint32_t seed;
+
+// Function predefinition
+void bench_kernel(const KERNEL *kernel, KERNEL_RESULT *result);
+double bench_pipeline(void);
+void fill_batch(int batchIndex, bool unevenBlocks);
+int16_t noise(int amplitude);
+bool blocks_equal(const ADXL345_BLOCK *a, const ADXL345_BLOCK *b);
+void report(const KERNEL *kernel, const KERNEL_RESULT *result);
+void average_kernel(void *state, ADXL345_BLOCK *block);
+void biquad_kernel(void *state, ADXL345_BLOCK *block);
+void decimate_kernel(void *state, ADXL345_BLOCK *block);
+void scalar_average(void *state, ADXL345_BLOCK *block);
+void scalar_biquad(void *state, ADXL345_BLOCK *block);
+void scalar_decimate(void *state, ADXL345_BLOCK *block);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    static SCALAR_AVERAGE scalarAverage = { .window = AVG_WINDOW };
+    static ADXL345_MOVING_AVERAGE average;
+    static ADXL345_BIQUAD lowPass, scalarLowPass, highPass, scalarHighPass;
+    static SCALAR_DECIMATOR scalarDecimator = { .factor = DECIMATION };
+    static ADXL345_DECIMATOR decimator;
+
+    ADXL345_movingAverageInit(&average, AVG_WINDOW);
+    ADXL345_biquadLowPass(&lowPass, SAMPLE_RATE_HZ, LOW_PASS_HZ);
+    scalarLowPass = lowPass;
+    ADXL345_biquadHighPass(&highPass, SAMPLE_RATE_HZ, HIGH_PASS_HZ);
+    scalarHighPass = highPass;
+    ADXL345_decimatorInit(&decimator, DECIMATION);
+
+    const KERNEL kernels[] = {
+        { "average",   scalar_average,  &scalarAverage,   average_kernel,  &average,   false },
+        { "low_pass",  scalar_biquad,   &scalarLowPass,   biquad_kernel,   &lowPass,   false },
+        { "high_pass", scalar_biquad,   &scalarHighPass,  biquad_kernel,   &highPass,  false },
+        { "decimate",  scalar_decimate, &scalarDecimator, decimate_kernel, &decimator, true  },
+    };
+
+    printf("%-12s %10s %10s %8s %6s\n", "Kernel", "Scalar ns", "Block ns", "Speedup", "Match");
+    bool pass = true;
+    for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+        KERNEL_RESULT result;
+        bench_kernel(&kernels[i], &result);
+        report(&kernels[i], &result);
+        pass = pass && result.matched;
+
+        // Noise averages out over a block, gravity left behind as an offset doesn't
+        if (kernels[i].blockState == &highPass && abs(result.lastZSum) >= ADXL345_BLOCK_SIZE) {
+            printf("High-pass left %ld counts of gravity in the last block\n", (long) result.lastZSum);
+            pass = false;
+        }
+    }
+
+    double pipelineUs = bench_pipeline();
+    printf("Pipeline:    %.2f us per %d sample drain (%.0f samples/s)\n", pipelineUs, ADXL345_BLOCK_SIZE,
+           ADXL345_BLOCK_SIZE * 1e6 / pipelineUs);
+    printf("BENCH,pipeline,us_per_block,%.3f\n", pipelineUs);
+    printf("%s\n", (pass && pipelineUs <= REQUIRED_PIPELINE_US) ? "PASS" : "FAIL");
+}
+
+/**
+ * Runs the same input through both versions of a kernel, a batch at a time,
+ * timing each batch and checking the two agree.
+ *
+ * @param kernel KERNEL to run
+ * @param result KERNEL_RESULT to fill in
+ */
+void bench_kernel(const KERNEL *kernel, KERNEL_RESULT *result) {
+    int64_t scalarUs = 0;
+    int64_t blockUs = 0;
+    *result = (KERNEL_RESULT) { 0.0, 0.0, true, 0 };
+
+    for (int b = 0; b < BATCHES; b++) {
+        fill_batch(b, kernel->unevenBlocks);
+        memcpy(scalarOut, batch, sizeof(batch));
+        memcpy(blockOut, batch, sizeof(batch));
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BATCH_BLOCKS; i++) {
+            kernel->scalar(kernel->scalarState, &scalarOut[i]);
+        }
+        int64_t middle = esp_timer_get_time();
+        for (int i = 0; i < BATCH_BLOCKS; i++) {
+            kernel->block(kernel->blockState, &blockOut[i]);
+        }
+        int64_t end = esp_timer_get_time();
+
+        scalarUs += middle - start;
+        blockUs += end - middle;
+        for (int i = 0; i < BATCH_BLOCKS; i++) {
+            result->matched = result->matched && blocks_equal(&scalarOut[i], &blockOut[i]);
+        }
+    }
+
+    const ADXL345_BLOCK *last = &blockOut[BATCH_BLOCKS - 1];
+    for (int i = 0; i < last->count; i++) {
+        result->lastZSum += last->z[i];
+    }
+    result->scalarNs = scalarUs * 1000.0 / (BATCHES * BATCH_BLOCKS);
+    result->blockNs = blockUs * 1000.0 / (BATCHES * BATCH_BLOCKS);
+}
+
+/**
+ * Times a whole pipeline, a moving average, a low-pass, a high-pass and
+ * decimation, over the same input.
+ *
+ * @return Average time per block in microseconds
+ */
+double bench_pipeline(void) {
+    static ADXL345_FILTER_PIPELINE pipeline;
+    ADXL345_pipelineInit(&pipeline);
+    pipeline.averageEnabled = ADXL345_movingAverageInit(&pipeline.average, AVG_WINDOW);
+    ADXL345_biquadLowPass(&pipeline.biquads[0], SAMPLE_RATE_HZ, LOW_PASS_HZ);
+    ADXL345_biquadHighPass(&pipeline.biquads[1], SAMPLE_RATE_HZ, HIGH_PASS_HZ);
+    pipeline.numBiquads = 2;
+    pipeline.decimatorEnabled = ADXL345_decimatorInit(&pipeline.decimator, DECIMATION);
+
+    int64_t busyUs = 0;
+    for (int b = 0; b < BATCHES; b++) {
+        fill_batch(b, false);
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < BATCH_BLOCKS; i++) {
+            ADXL345_pipelineProcess(&pipeline, &batch[i]);
+        }
+        busyUs += esp_timer_get_time() - start;
+    }
+    return (double) busyUs / (BATCHES * BATCH_BLOCKS);
+}
+
+/**
+ * Fills the batch with 1 g on Z, 40 Hz vibration on X and Y, and a few
+ * counts of noise on every axis.  The noise restarts with the first batch,
+ * so every kernel sees the same input.
+ *
+ * @param batchIndex   Batch number, from 0
+ * @param unevenBlocks Whether to shorten some blocks by a sample or two
+ */
+void fill_batch(int batchIndex, bool unevenBlocks) {
+    if (batchIndex == 0) {
+        seed = 12345;
+    }
+    for (int b = 0; b < BATCH_BLOCKS; b++) {
+        batch[b].count = unevenBlocks ? ADXL345_BLOCK_SIZE - (b % 3) : ADXL345_BLOCK_SIZE;
+        for (int i = 0; i < ADXL345_BLOCK_SIZE; i++) {
+            int sample = (batchIndex * BATCH_BLOCKS + b) * ADXL345_BLOCK_SIZE + i;
+            float swing = sinf(2.0f * (float) M_PI * 40.0f * sample / SAMPLE_RATE_HZ);
+            batch[b].x[i] = (int16_t) (swing * 120.0f) + noise(4);
+            batch[b].y[i] = (int16_t) (swing * -60.0f) + noise(4);
+            batch[b].z[i] = GRAVITY_COUNTS + noise(4);
+        }
+    }
+}
+
+/**
+ * Returns uniform noise in the param +/- amplitude, from a small xorshift
+ * generator so every run sees the same input.
+ *
+ * @param amplitude Largest deviation in counts
+ */
+int16_t noise(int amplitude) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (int16_t) ((int) (seed % (2 * amplitude + 1)) - amplitude);
+}
+
+bool blocks_equal(const ADXL345_BLOCK *a, const ADXL345_BLOCK *b) {
+    size_t bytes = a->count * sizeof(int16_t);
+    return a->count == b->count && memcmp(a->x, b->x, bytes) == 0 && memcmp(a->y, b->y, bytes) == 0
+        && memcmp(a->z, b->z, bytes) == 0;
+}
+
+/**
+ * Prints one kernel as a table row, and as BENCH,<kernel>,<metric>,<value>
+ * lines for CI to collect.
+ */
+void report(const KERNEL *kernel, const KERNEL_RESULT *result) {
+    double speedup = (result->blockNs > 0.0) ? result->scalarNs / result->blockNs : 0.0;
+    printf("%-12s %10.0f %10.0f %7.2fx %6s\n", kernel->name, result->scalarNs, result->blockNs, speedup,
+           result->matched ? "yes" : "NO");
+    printf("BENCH,%s,scalar_ns_per_block,%.0f\n", kernel->name, result->scalarNs);
+    printf("BENCH,%s,block_ns_per_block,%.0f\n", kernel->name, result->blockNs);
+    printf("BENCH,%s,speedup,%.2f\n", kernel->name, speedup);
+}
+
+void average_kernel(void *state, ADXL345_BLOCK *block) {
+    ADXL345_movingAverageProcess((ADXL345_MOVING_AVERAGE *) state, block);
+}
+
+void biquad_kernel(void *state, ADXL345_BLOCK *block) {
+    ADXL345_biquadProcess((ADXL345_BIQUAD *) state, block);
+}
+
+void decimate_kernel(void *state, ADXL345_BLOCK *block) {
+    ADXL345_decimatorProcess((ADXL345_DECIMATOR *) state, block, block);
+}
+
+/**
+ * Moving average a sample at a time, over a circular history.
+ */
+SCALAR void scalar_average(void *state, ADXL345_BLOCK *block) {
+    SCALAR_AVERAGE *filter = (SCALAR_AVERAGE *) state;
+    int16_t *axes[3] = { block->x, block->y, block->z };
+    for (int i = 0; i < block->count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            filter->sum[axis] += axes[axis][i] - filter->history[axis][filter->next];
+            filter->history[axis][filter->next] = axes[axis][i];
+            axes[axis][i] = (int16_t) (filter->sum[axis] / filter->window);
+            // Division rounds towards zero, the shift in the block kernel rounds down
+            if (filter->sum[axis] < 0 && filter->sum[axis] % filter->window != 0) {
+                axes[axis][i]--;
+            }
+        }
+        filter->next = (filter->next + 1) % filter->window;
+    }
+}
+
+/**
+ * The same biquad arithmetic as ADXL345_biquadProcess, an axis at a time.
+ */
+SCALAR void scalar_biquad(void *state, ADXL345_BLOCK *block) {
+    ADXL345_BIQUAD *filter = (ADXL345_BIQUAD *) state;
+    int16_t *axes[3] = { block->x, block->y, block->z };
+    for (int axis = 0; axis < 3; axis++) {
+        for (int i = 0; i < block->count; i++) {
+            int64_t acc = ((int64_t) filter->b0 * axes[axis][i] + (int64_t) filter->b1 * filter->x1[axis]
+                           + (int64_t) filter->b2 * filter->x2[axis]) * (1 << ADXL345_BIQUAD_STATE_Q);
+            acc -= (int64_t) filter->a1 * filter->y1[axis] + (int64_t) filter->a2 * filter->y2[axis];
+            acc += filter->error[axis];
+            int32_t y0 = (int32_t) (acc >> ADXL345_BIQUAD_Q);
+            filter->error[axis] = (int32_t) (acc - ((int64_t) y0 << ADXL345_BIQUAD_Q));
+
+            filter->x2[axis] = filter->x1[axis];
+            filter->x1[axis] = axes[axis][i];
+            filter->y2[axis] = filter->y1[axis];
+            filter->y1[axis] = y0;
+
+            int32_t out = (y0 + (1 << (ADXL345_BIQUAD_STATE_Q - 1))) >> ADXL345_BIQUAD_STATE_Q;
+            if (out > INT16_MAX) {
+                out = INT16_MAX;
+            } else if (out < INT16_MIN) {
+                out = INT16_MIN;
+            }
+            axes[axis][i] = (int16_t) out;
+        }
+    }
+}
+
+/**
+ * Decimation a sample at a time, emitting whenever a group fills.
+ */
+SCALAR void scalar_decimate(void *state, ADXL345_BLOCK *block) {
+    SCALAR_DECIMATOR *decimator = (SCALAR_DECIMATOR *) state;
+    int16_t *axes[3] = { block->x, block->y, block->z };
+    int produced = 0;
+    for (int i = 0; i < block->count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            decimator->acc[axis] += axes[axis][i];
+        }
+        if (++decimator->phase == decimator->factor) {
+            for (int axis = 0; axis < 3; axis++) {
+                int32_t sum = decimator->acc[axis];
+                // Floor division, matching the shift in the block kernel
+                int32_t average = sum / decimator->factor;
+                if (sum < 0 && sum % decimator->factor != 0) {
+                    average--;
+                }
+                axes[axis][produced] = (int16_t) average;
+                decimator->acc[axis] = 0;
+            }
+            produced++;
+            decimator->phase = 0;
+        }
+    }
+    block->count = produced;
+}
@@ -0,0 +1,240 @@
+/**
+ * File:       ADXL345_log_roundtrip.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * File backed round trip of the ADXL345 sample logger.  Simulated vibration
+ * is logged to a file over two logger sessions, with a rate change in the
+ * first and a torn page, as a power cut mid write leaves, between them.  The
+ * file is then decoded and every sample compared with what was appended,
+ * and the compression of the vibration frames is reported.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_logger.h"
+#include "ADXL345_simwave.h"
+
+#define LOG_PATH            "adxl345_log.bin"
+#define RATE_3200HZ         0x0F
+#define RATE_100HZ          0x0A
+#define FIRST_BLOCKS        198
+#define SLOW_BLOCKS         20
+#define SECOND_BLOCKS       100
+#define TOTAL_SAMPLES       ((FIRST_BLOCKS + SLOW_BLOCKS + SECOND_BLOCKS) * ADXL345_BLOCK_SIZE)
+#define WRITER_PRIO         5
+// Full resolution counts per g
+#define ONE_G_COUNTS        256
+#define MIN_RATIO           3.0
+
+typedef struct _expected {
+    int16_t x[TOTAL_SAMPLES];
+    int16_t y[TOTAL_SAMPLES];
+    int16_t z[TOTAL_SAMPLES];
+    int64_t timeUs[TOTAL_SAMPLES];
+    uint8_t rateCode[TOTAL_SAMPLES];
+    int count;
+    int checked;
+    int mismatches;
+} EXPECTED;
+
+static EXPECTED expected;
+ADXL345_LOGGER logger;
+ADXL345_SIM_WAVE vibration;
+ADXL345_SIM_WAVE still;
+
+// Function predefinition
+void log_blocks(ADXL345_SIM_WAVE *wave, uint8_t rateCode, int blocks, int64_t *timeUs);
+bool tear_page(const char *path);
+void check_frame(const ADXL345_LOG_FRAME *frame, void *arg);
+uint8_t *read_file(const char *path, size_t *length);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    // The reference vibration, and a sensor at rest for the rate change
+    ADXL345_simWaveInit(&vibration);
+    vibration.gravityMg.z = 1000;
+    vibration.sineMg.x = 500;
+    vibration.sineMg.y = 125;
+    vibration.sineMilliHz = 80000;
+    vibration.noiseMg = 20;
+    ADXL345_simWaveInit(&still);
+    still.gravityMg.z = 1000;
+    still.noiseMg = 4;
+
+    remove(LOG_PATH);
+    int64_t timeUs = 0;
+    ESP_ERROR_CHECK(ADXL345_loggerStart(&logger, LOG_PATH, RATE_3200HZ, WRITER_PRIO, tskNO_AFFINITY));
+    log_blocks(&vibration, RATE_3200HZ, FIRST_BLOCKS, &timeUs);
+    // Every frame so far is vibration, and whole apart from the one staged
+    ADXL345_LOGGER_STATS vibrationStats = logger.stats;
+    log_blocks(&still, RATE_100HZ, SLOW_BLOCKS, &timeUs);
+    ESP_ERROR_CHECK(ADXL345_loggerStop(&logger));
+    ADXL345_LOGGER_STATS firstStats = logger.stats;
+
+    bool torn = tear_page(LOG_PATH);
+
+    ESP_ERROR_CHECK(ADXL345_loggerStart(&logger, LOG_PATH, RATE_3200HZ, WRITER_PRIO, tskNO_AFFINITY));
+    log_blocks(&vibration, RATE_3200HZ, SECOND_BLOCKS, &timeUs);
+    ESP_ERROR_CHECK(ADXL345_loggerStop(&logger));
+    ADXL345_LOGGER_STATS secondStats = logger.stats;
+
+    size_t length;
+    uint8_t *data = read_file(LOG_PATH, &length);
+    ADXL345_LOG_DECODE_STATS stats = { 0 };
+    if (data != NULL) {
+        ADXL345_logDecodePages(data, length, check_frame, &expected, &stats);
+        free(data);
+    }
+
+    uint32_t dropped = firstStats.samplesDropped + secondStats.samplesDropped;
+    uint32_t writeErrors = firstStats.writeErrors + secondStats.writeErrors;
+    double ratio = (double) vibrationStats.rawBytes / vibrationStats.encodedBytes;
+    double fileRatio = (double) expected.count * sizeof(ADXL345_SAMPLE) / length;
+    printf("Logged:  %d samples in %lu frames, %lu dropped, %lu write errors\n", expected.count,
+           (unsigned long) (firstStats.framesWritten + secondStats.framesWritten), (unsigned long) dropped,
+           (unsigned long) writeErrors);
+    printf("Decoded: %lu samples in %lu frames, %d mismatched, %lu CRC errors, %lu format errors\n",
+           (unsigned long) stats.samples, (unsigned long) stats.frames, expected.mismatches,
+           (unsigned long) stats.crcErrors, (unsigned long) stats.formatErrors);
+    // Each stop and the tear leave a page partly empty, so a short log pads out a lot
+    printf("File:    %zu bytes, %zu pages, %.2f:1 including padding\n", length, length / ADXL345_LOG_PAGE_SIZE,
+           fileRatio);
+    printf("Vibration frames: %.2f:1\n", ratio);
+    printf("BENCH,roundtrip,samples,%d\n", expected.count);
+    printf("BENCH,roundtrip,mismatches,%d\n", expected.mismatches);
+    printf("BENCH,vibration_3200hz,ratio,%.2f\n", ratio);
+    printf("BENCH,file,ratio,%.2f\n", fileRatio);
+
+    // The torn frame is the only one that should fail to decode
+    bool pass = torn && data != NULL && dropped == 0 && writeErrors == 0 && expected.mismatches == 0 &&
+                expected.checked == expected.count && stats.crcErrors + stats.formatErrors == 1 &&
+                length % ADXL345_LOG_PAGE_SIZE == 0 && ratio >= MIN_RATIO;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Appends the param number of blocks of the param wave to the logger, and
+ * to the expected samples, as if captured back to back at the param rate.
+ *
+ * @param wave     ADXL345_SIM_WAVE to sample
+ * @param rateCode BW_RATE code to log the blocks at
+ * @param blocks   Number of blocks
+ * @param timeUs   Time of the next sample, moved on past the last
+ */
+void log_blocks(ADXL345_SIM_WAVE *wave, uint8_t rateCode, int blocks, int64_t *timeUs) {
+    uint32_t periodUs = ADXL345_samplePeriodUs(rateCode);
+    logger.rateCode = rateCode;
+
+    for (int b = 0; b < blocks; b++) {
+        ADXL345_BLOCK block = { .count = ADXL345_BLOCK_SIZE };
+        int64_t firstUs = *timeUs;
+        for (int i = 0; i < block.count; i++) {
+            ADXL345_SAMPLE mg;
+            ADXL345_simWave(*timeUs, &mg, wave);
+            block.x[i] = (int16_t) (mg.x * ONE_G_COUNTS / 1000);
+            block.y[i] = (int16_t) (mg.y * ONE_G_COUNTS / 1000);
+            block.z[i] = (int16_t) (mg.z * ONE_G_COUNTS / 1000);
+
+            int n = expected.count++;
+            expected.x[n] = block.x[i];
+            expected.y[n] = block.y[i];
+            expected.z[n] = block.z[i];
+            expected.timeUs[n] = firstUs;
+            expected.rateCode[n] = rateCode;
+            *timeUs += periodUs;
+        }
+        ADXL345_loggerAppend(&logger, &block, firstUs);
+        // Give the writer a turn, the logger drops frames rather than wait for it
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * Leaves the log as a power cut partway through writing a page would, with
+ * the first half of a frame after the last whole page.
+ *
+ * @param path Log file
+ * @return true if the torn page was written
+ */
+bool tear_page(const char *path) {
+    static ADXL345_LOG_FRAME frame;
+    uint8_t encoded[ADXL345_LOG_MAX_FRAME];
+    frame.count = ADXL345_LOG_FRAME_SAMPLES;
+    frame.rateCode = RATE_3200HZ;
+    memcpy(frame.x, expected.x, sizeof(frame.x));
+    memcpy(frame.y, expected.y, sizeof(frame.y));
+    memcpy(frame.z, expected.z, sizeof(frame.z));
+    size_t length = ADXL345_logEncodeFrame(&frame, encoded, sizeof(encoded));
+
+    FILE *file = fopen(path, "ab");
+    if (file == NULL) {
+        return false;
+    }
+    bool written = length > 0 && fwrite(encoded, 1, length / 2, file) == length / 2;
+    return (fclose(file) == 0) && written;
+}
+
+/**
+ * Frame callback, compares each decoded sample with the next expected one,
+ * along with the frame's rate and timestamp.
+ *
+ * @param frame Decoded ADXL345_LOG_FRAME
+ * @param arg   EXPECTED samples
+ */
+void check_frame(const ADXL345_LOG_FRAME *frame, void *arg) {
+    EXPECTED *expect = (EXPECTED *) arg;
+    int first = expect->checked;
+    if (first + frame->count > expect->count) {
+        expect->mismatches += frame->count;
+        return;
+    }
+
+    // A frame's timestamp is its first block's, the time of its first sample
+    if (frame->timestampUs != expect->timeUs[first] || frame->rateCode != expect->rateCode[first]) {
+        expect->mismatches++;
+    }
+    for (int i = 0; i < frame->count; i++) {
+        int n = first + i;
+        if (frame->x[i] != expect->x[n] || frame->y[i] != expect->y[n] || frame->z[i] != expect->z[n] ||
+            frame->rateCode != expect->rateCode[n]) {
+            expect->mismatches++;
+        }
+    }
+    expect->checked += frame->count;
+}
+
+/**
+ * Reads the whole param file into a buffer the caller frees.
+ *
+ * @param path   File to read
+ * @param length Pointer to store the number of bytes read in
+ * @return The buffer, or NULL if the file couldn't be read
+ */
+uint8_t *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *data = (size >= 0) ? malloc(size > 0 ? size : 1) : NULL;
+    if (data != NULL && fread(data, 1, size, file) != (size_t) size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *length = (data != NULL) ? (size_t) size : 0;
+    return data;
+}
@@ -0,0 +1,219 @@
+/**
+ * File:       ADXL345_multi_bus.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Samples four ADXL345s at 800 Hz, two on each of the ESP32's I2C
+ * controllers.  Each controller has its own bus scheduler task pinned to its
+ * own core, so both buses transfer at once, and every sensor drains its FIFO
+ * into its own sample ring.  The main task merges the rings into a single
+ * stream in timestamp order, and once a second logs each sensor's rate, the
+ * total, how busy each bus was and whether the stream stayed in order.
+ */
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_i2c.h"
+#include "ADXL345_ring.h"
+#include "ADXL345_merge.h"
+#include "I2CBus.h"
+
+#define BUSES               2
+#define SENSORS_PER_BUS     2
+#define SENSORS             (BUSES * SENSORS_PER_BUS)
+#define BUS_HZ              400000
+#define BUS_TASK_PRIO       10
+// 800 Hz puts 16 samples in the 32 entry FIFO between drains
+#define DRAIN_PERIOD_US     20000
+#define MERGE_DELAY         (10 / portTICK_PERIOD_MS)
+#define REPORT_US           1000000
+#define RATE_800HZ          0x0D
+
+typedef struct _sensor {
+    i2c_master_dev_handle_t handle;
+    ADXL345_I2C_ASYNC i2c;
+    ADXL345_DEVICE dev;
+    ADXL345_FIFO_READ fifoRead;
+    ADXL345_RING ring;
+    I2CBUS_JOB job;
+} SENSOR;
+
+// Controller 0 on the standard pins, controller 1 on its own pair
+static const int BUS_SDA_IO[BUSES] = { 21, 32 };
+static const int BUS_SCL_IO[BUSES] = { 22, 33 };
+// Bus 0's task shares the PRO core with the merge, bus 1 has the APP core
+static const BaseType_t BUS_CORE[BUSES] = { 0, 1 };
+static const uint8_t SENSOR_ADDR[SENSORS_PER_BUS] = { ADXL345_DEFAULT_ADDR, ADXL345_ALT_ADDR };
+
+ADXL345_CONFIG accelConfig = {
+    .range = ADXL345_RANGE_16G,
+    .fullResolution = true,
+    .bwRate = RATE_800HZ,
+};
+
+I2CBUS buses[BUSES];
+SENSOR sensors[SENSORS];
+ADXL345_MERGE merge;
+
+static const char *TAG = "multi_bus";
+
+// Function predefinition
+void setup_bus(int bus);
+void setup_sensor(int bus, int index);
+esp_err_t drain_job(I2CBUS_JOB *job, void *arg);
+void report(uint32_t *samples, uint32_t *reported, int64_t elapsedUs);
+
+/**
+ * Application main
+ */
+void app_main(void) {
+    // Blocks are stamped with their first sample, up to a full FIFO before they're published
+    uint32_t fifoSpanUs = ADXL345_FIFO_DEPTH * ADXL345_samplePeriodUs(RATE_800HZ);
+    ADXL345_mergeInit(&merge, fifoSpanUs + ADXL345_MERGE_DEFAULT_SKEW_US);
+    for (int b = 0; b < BUSES; b++) {
+        setup_bus(b);
+        for (int i = 0; i < SENSORS_PER_BUS; i++) {
+            setup_sensor(b, i);
+        }
+    }
+    for (int b = 0; b < BUSES; b++) {
+        ESP_ERROR_CHECK(I2CBUS_start(&buses[b], BUS_TASK_PRIO, BUS_CORE[b]));
+    }
+
+    uint32_t samples[SENSORS] = { 0 };
+    uint32_t reported[SENSORS] = { 0 };
+    int64_t reportUs = esp_timer_get_time();
+    while (true) {
+        int64_t nowUs = esp_timer_get_time();
+        ADXL345_BLOCK *block;
+        int source;
+        while ((block = ADXL345_mergePeek(&merge, nowUs, NULL, &source)) != NULL) {
+            // Blocks arrive oldest first across all four sensors, ready for
+            // anything that needs to line them up, e.g. mode shape analysis
+            samples[source] += block->count;
+            ADXL345_mergeRelease(&merge);
+        }
+
+        if (nowUs - reportUs >= REPORT_US) {
+            report(samples, reported, nowUs - reportUs);
+            reportUs = nowUs;
+        }
+        vTaskDelay(MERGE_DELAY);
+    }
+}
+
+/**
+ * Creates the param I2C controller's bus, with room in its queue for a whole
+ * FIFO drain.
+ *
+ * @param bus Controller number
+ */
+void setup_bus(int bus) {
+    i2c_master_bus_config_t config = {
+        .i2c_port = bus,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .scl_io_num = BUS_SCL_IO[bus],
+        .sda_io_num = BUS_SDA_IO[bus],
+        .glitch_ignore_cnt = 7,
+        .trans_queue_depth = ADXL345_I2C_QUEUE_DEPTH,
+        .flags.enable_internal_pullup = true,
+    };
+    ESP_ERROR_CHECK(I2CBUS_init(&buses[bus], &config));
+}
+
+/**
+ * Adds a sensor to the param bus, streams its samples into its FIFO, and
+ * schedules a job to drain it into the sensor's ring.
+ *
+ * @param bus   Controller number
+ * @param index Sensor on that bus, which picks its address
+ */
+void setup_sensor(int bus, int index) {
+    SENSOR *sensor = &sensors[bus * SENSORS_PER_BUS + index];
+    i2c_device_config_t deviceConfig = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = SENSOR_ADDR[index],
+        .scl_speed_hz = BUS_HZ,
+    };
+    ESP_ERROR_CHECK(I2CBUS_addDevice(&buses[bus], &deviceConfig, &sensor->handle));
+
+    ADXL345_TRANSPORT transport;
+    ESP_ERROR_CHECK(ADXL345_i2cAsyncTransport(&transport, &sensor->i2c, buses[bus].handle, sensor->handle));
+    ESP_ERROR_CHECK(ADXL345_initTransport(&sensor->dev, &transport, &accelConfig));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&sensor->dev, ADXL345_FIFO_STREAM, 0));
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&sensor->fifoRead));
+
+    // The ring's producer is this bus's task, its consumer the merge
+    ADXL345_ringInit(&sensor->ring);
+    ESP_ERROR_CHECK(ADXL345_mergeAddSource(&merge, &sensor->ring, NULL));
+
+    I2CBUS_jobInit(&sensor->job, sensor->handle, 0, NULL, 0, DRAIN_PERIOD_US, 0, NULL, sensor);
+    sensor->job.run = drain_job;
+    ESP_ERROR_CHECK(I2CBUS_addJob(&buses[bus], &sensor->job));
+}
+
+/**
+ * Bus job that drains a sensor's FIFO straight into a slot of its ring, and
+ * stamps it with the time of its first sample, worked back from when the
+ * read finished.  If the merge has fallen behind and the ring is full, the
+ * samples are left in the FIFO for next time.
+ *
+ * @param job I2CBUS_JOB being run
+ * @param arg SENSOR to drain
+ */
+esp_err_t drain_job(I2CBUS_JOB *job, void *arg) {
+    SENSOR *sensor = (SENSOR *) arg;
+
+    ADXL345_BLOCK *block = ADXL345_ringAcquire(&sensor->ring);
+    if (block == NULL) {
+        return ESP_OK;
+    }
+    esp_err_t err = ADXL345_readFifoStart(&sensor->dev, &sensor->fifoRead);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = ADXL345_readFifoFinish(&sensor->dev, &sensor->fifoRead, block);
+    if (err == ESP_OK && block->count > 0) {
+        // The newest sample was taken about when the read finished, the rest a period apart before it
+        int64_t readUs = esp_timer_get_time();
+        int64_t firstUs = readUs - (int64_t) (block->count - 1) * ADXL345_samplePeriodUs(sensor->dev.config.bwRate);
+        ADXL345_ringPublish(&sensor->ring, firstUs);
+    }
+    return err;
+}
+
+/**
+ * Logs the rate each sensor was merged at since the last report, and the
+ * total, along with each bus's utilization and how the merge is doing.
+ *
+ * @param samples   Samples merged from each sensor so far
+ * @param reported  Samples as of the last report, brought up to date
+ * @param elapsedUs Time since the last report
+ */
+void report(uint32_t *samples, uint32_t *reported, int64_t elapsedUs) {
+    uint32_t total = 0;
+    for (int s = 0; s < SENSORS; s++) {
+        uint32_t rate = (uint32_t) ((uint64_t) (samples[s] - reported[s]) * 1000000 / elapsedUs);
+        total += rate;
+        reported[s] = samples[s];
+        ESP_LOGI(TAG, "Sensor %d (bus %d, 0x%02x): %lu Hz, ring overruns %lu", s, s / SENSORS_PER_BUS,
+                 SENSOR_ADDR[s % SENSORS_PER_BUS], (unsigned long) rate, (unsigned long) sensors[s].ring.overruns);
+    }
+    for (int b = 0; b < BUSES; b++) {
+        I2CBUS_STATS stats;
+        I2CBUS_getStats(&buses[b], &stats);
+        ESP_LOGI(TAG, "Bus %d: %lu.%lu%% busy, %lu errors, %lu deadline misses", b,
+                 (unsigned long) (stats.utilizationPermille / 10), (unsigned long) (stats.utilizationPermille % 10),
+                 (unsigned long) stats.errors, (unsigned long) stats.deadlineMisses);
+    }
+    ESP_LOGI(TAG, "Total %lu Hz, %lu blocks merged, %lu out of order", (unsigned long) total,
+             (unsigned long) merge.merged, (unsigned long) merge.late);
+}
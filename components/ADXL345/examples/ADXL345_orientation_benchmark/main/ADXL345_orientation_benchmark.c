@@ -0,0 +1,212 @@
+/**
+ * File:       ADXL345_orientation_benchmark.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Accuracy and throughput of the integer orientation module against libm.
+ * Pitch, roll and magnitude are computed for every sample of a set with the
+ * module and with double precision libm, and the worst differences are
+ * reported in output LSBs.  The same samples are then timed through the
+ * module's batch call and through a single precision atan2f/sqrtf version,
+ * which is what the module replaces.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "esp_timer.h"
+#include "ADXL345.h"
+#include "ADXL345_orientation.h"
+
+#define SAMPLES             4096
+#define PASSES              50
+// Full resolution counts at 1 g, and the largest reading at +/-16 g
+#define ONE_G_COUNTS        256
+#define FULL_SCALE_COUNTS   4095
+#define RAD_TO_CENTI_DEG    (18000.0 / M_PI)
+
+typedef struct _accuracy {
+    const char *name;
+    double pitchError;
+    double rollError;
+    double magnitudeError;
+} ACCURACY;
+
+static ADXL345_SAMPLE samples[SAMPLES];
+static ADXL345_ORIENTATION fixedOut[SAMPLES];
+static ADXL345_ORIENTATION libmOut[SAMPLES];
+static uint32_t seed = 12345;
+
+// Function predefinition
+void fill_sphere(int radius);
+void fill_full_scale(void);
+void check_accuracy(ACCURACY *accuracy);
+double bench_fixed(void);
+double bench_libm(void);
+void libm_orientation(const ADXL345_SAMPLE *in, int count, ADXL345_ORIENTATION *out);
+double angle_error(double reference, int16_t value);
+uint32_t next_random(void);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    ACCURACY results[3] = { { .name = "1g_sphere" }, { .name = "4g_sphere" }, { .name = "full_scale" } };
+
+    fill_sphere(ONE_G_COUNTS);
+    check_accuracy(&results[0]);
+    fill_sphere(4 * ONE_G_COUNTS);
+    check_accuracy(&results[1]);
+    fill_full_scale();
+    check_accuracy(&results[2]);
+
+    printf("%-12s %12s %12s %12s\n", "Samples", "Pitch LSB", "Roll LSB", "Mag counts");
+    bool pass = true;
+    for (int i = 0; i < 3; i++) {
+        printf("%-12s %12.3f %12.3f %12.3f\n", results[i].name, results[i].pitchError, results[i].rollError,
+               results[i].magnitudeError);
+        printf("BENCH,%s,pitch_error_lsb,%.3f\n", results[i].name, results[i].pitchError);
+        printf("BENCH,%s,roll_error_lsb,%.3f\n", results[i].name, results[i].rollError);
+        printf("BENCH,%s,magnitude_error_counts,%.3f\n", results[i].name, results[i].magnitudeError);
+        // The documented bound, one LSB of 0.01 degrees and one count
+        if (results[i].pitchError > 1.0 || results[i].rollError > 1.0 || results[i].magnitudeError > 1.0) {
+            pass = false;
+        }
+    }
+
+    // Times are over the 1 g sphere, where a still or slowly moving board lives
+    fill_sphere(ONE_G_COUNTS);
+    double fixedNs = bench_fixed();
+    double libmNs = bench_libm();
+    printf("Integer: %.1f ns per sample (%.0f samples/s)\n", fixedNs, 1e9 / fixedNs);
+    printf("libm:    %.1f ns per sample (%.0f samples/s)\n", libmNs, 1e9 / libmNs);
+    printf("Speedup: %.2fx\n", libmNs / fixedNs);
+    printf("BENCH,throughput,integer_ns_per_sample,%.1f\n", fixedNs);
+    printf("BENCH,throughput,libm_ns_per_sample,%.1f\n", libmNs);
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Fills the samples with points spread over a sphere of the param radius,
+ * every orientation a board can be held in under a steady acceleration.
+ *
+ * @param radius Length of each sample in counts
+ */
+void fill_sphere(int radius) {
+    for (int i = 0; i < SAMPLES; i++) {
+        // Uniform over the sphere: z uniform in [-1, 1], azimuth uniform
+        double z = 2.0 * next_random() / 4294967296.0 - 1.0;
+        double azimuth = 2.0 * M_PI * next_random() / 4294967296.0;
+        double r = sqrt(1.0 - z * z);
+        samples[i].x = (int16_t) lround(radius * r * cos(azimuth));
+        samples[i].y = (int16_t) lround(radius * r * sin(azimuth));
+        samples[i].z = (int16_t) lround(radius * z);
+    }
+}
+
+/**
+ * Fills the samples with readings anywhere in the +/-16 g full resolution
+ * range, the worst case for the module's scaling.
+ */
+void fill_full_scale(void) {
+    for (int i = 0; i < SAMPLES; i++) {
+        samples[i].x = (int16_t) ((int) (next_random() % (2 * FULL_SCALE_COUNTS + 1)) - FULL_SCALE_COUNTS);
+        samples[i].y = (int16_t) ((int) (next_random() % (2 * FULL_SCALE_COUNTS + 1)) - FULL_SCALE_COUNTS);
+        samples[i].z = (int16_t) ((int) (next_random() % (2 * FULL_SCALE_COUNTS + 1)) - FULL_SCALE_COUNTS);
+    }
+}
+
+/**
+ * Runs the current samples through the module and compares every result to
+ * double precision libm, keeping the worst difference of each output.
+ *
+ * @param accuracy ACCURACY to fill in
+ */
+void check_accuracy(ACCURACY *accuracy) {
+    ADXL345_orientationFromSamples(samples, SAMPLES, fixedOut);
+
+    for (int i = 0; i < SAMPLES; i++) {
+        double x = samples[i].x;
+        double y = samples[i].y;
+        double z = samples[i].z;
+        double pitch = atan2(-x, sqrt(y * y + z * z)) * RAD_TO_CENTI_DEG;
+        double roll = atan2(y, z) * RAD_TO_CENTI_DEG;
+        double magnitude = sqrt(x * x + y * y + z * z);
+
+        double pitchError = angle_error(pitch, fixedOut[i].pitch);
+        double rollError = angle_error(roll, fixedOut[i].roll);
+        double magnitudeError = fabs(magnitude - fixedOut[i].magnitude);
+        accuracy->pitchError = fmax(accuracy->pitchError, pitchError);
+        accuracy->rollError = fmax(accuracy->rollError, rollError);
+        accuracy->magnitudeError = fmax(accuracy->magnitudeError, magnitudeError);
+    }
+}
+
+/**
+ * Times the module's batch call over the samples.
+ *
+ * @return Average time per sample in nanoseconds
+ */
+double bench_fixed(void) {
+    int64_t start = esp_timer_get_time();
+    for (int p = 0; p < PASSES; p++) {
+        ADXL345_orientationFromSamples(samples, SAMPLES, fixedOut);
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / ((double) PASSES * SAMPLES);
+}
+
+/**
+ * Times the single precision libm version over the samples.
+ *
+ * @return Average time per sample in nanoseconds
+ */
+double bench_libm(void) {
+    int64_t start = esp_timer_get_time();
+    for (int p = 0; p < PASSES; p++) {
+        libm_orientation(samples, SAMPLES, libmOut);
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / ((double) PASSES * SAMPLES);
+}
+
+/**
+ * Pitch, roll and magnitude the straightforward way, with atan2f and sqrtf
+ * on every sample.
+ */
+void libm_orientation(const ADXL345_SAMPLE *in, int count, ADXL345_ORIENTATION *out) {
+    const float radToCentiDeg = (float) RAD_TO_CENTI_DEG;
+    for (int i = 0; i < count; i++) {
+        float x = in[i].x;
+        float y = in[i].y;
+        float z = in[i].z;
+        float yz = sqrtf(y * y + z * z);
+        out[i].pitch = (int16_t) lroundf(atan2f(-x, yz) * radToCentiDeg);
+        out[i].roll = (int16_t) lroundf(atan2f(y, z) * radToCentiDeg);
+        out[i].magnitude = (uint16_t) lroundf(sqrtf(x * x + y * y + z * z));
+    }
+}
+
+/**
+ * Returns the difference between two angles in hundredths of a degree,
+ * allowing for +180 and -180 degrees being the same angle.
+ *
+ * @param reference Reference angle
+ * @param value     Angle to compare
+ */
+double angle_error(double reference, int16_t value) {
+    double error = fabs(reference - value);
+    return (error > 18000.0) ? 36000.0 - error : error;
+}
+
+/**
+ * Returns the next value of a small xorshift generator, so every run sees
+ * the same samples.
+ */
+uint32_t next_random(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
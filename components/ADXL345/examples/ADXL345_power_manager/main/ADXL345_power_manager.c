@@ -0,0 +1,208 @@
+/**
+ * File:       ADXL345_power_manager.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Runs the power manager against the simulated ADXL345 through bursts of
+ * motion separated by stillness, once held at the active rate and once
+ * managed, and compares their energy, samples per joule and wake latency.
+ */
+#include <stdio.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_simwave.h"
+#include "ADXL345_power.h"
+
+// Each cycle moves for a second, then stays still for five
+#define CYCLES              3
+#define CYCLE_US            6000000
+#define MOVING_US           1000000
+#define BUS_HZ              400000
+#define IRQ_TIMEOUT_MS      50
+
+// Energy model, an ESP32 at 80 MHz while servicing and in light sleep otherwise
+#define SUPPLY_MV           3300
+#define HOST_ACTIVE_UA      30000
+#define HOST_SLEEP_UA       800
+
+// Motion is caught within one 12.5 Hz idle sample, plus servicing
+#define MAX_WAKE_US         250000
+// Left in the FIFO at the end of a run, and not yet drained
+#define SAMPLE_SLACK        ADXL345_FIFO_DEPTH
+
+typedef struct _run {
+    const char *name;
+    ADXL345_POWER_STATS stats;
+    uint32_t delivered;
+    int64_t maxMotionToActiveUs;
+} RUN;
+
+ADXL345_SIM sim;
+ADXL345_DEVICE accel;
+ADXL345_POWER power;
+ADXL345_SIM_WAVE stillWave;
+ADXL345_SIM_WAVE movingWave;
+SemaphoreHandle_t pinRaised;
+volatile bool pinHigh;
+volatile int64_t edgeUs;
+int64_t runStartUs;
+
+// Function predefinition
+void run_scenario(RUN *run, const ADXL345_POWER_CONFIG *config);
+void print_run(const RUN *run);
+void motion(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+void block_received(const ADXL345_BLOCK *block, uint8_t bwRate, void *arg);
+void state_changed(ADXL345_POWER_STATE state, void *arg);
+void interrupt_changed(int pin, bool level, void *arg);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    // Still is gravity and a little noise, moving adds a 3 Hz, 400 mg sway
+    ADXL345_simWaveInit(&stillWave);
+    stillWave.noiseMg = 10;
+    movingWave = stillWave;
+    movingWave.sineMg.x = 400;
+    movingWave.sineMg.y = 400;
+    movingWave.sineMilliHz = 3000;
+
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, BUS_HZ, 20));
+    ADXL345_simSetGenerator(&sim, motion, NULL);
+    pinRaised = xSemaphoreCreateBinary();
+
+    ADXL345_POWER_CONFIG config;
+    ADXL345_powerConfigInit(&config);
+    config.inactivitySeconds = 2;
+    config.supplyMv = SUPPLY_MV;
+    config.hostActiveUa = HOST_ACTIVE_UA;
+    config.hostSleepUa = HOST_SLEEP_UA;
+    // Never still for long enough to go idle, so always at the active rate
+    ADXL345_POWER_CONFIG alwaysOnConfig = config;
+    alwaysOnConfig.inactivitySeconds = UINT8_MAX;
+
+    RUN alwaysOn = { .name = "Always on" };
+    RUN managed = { .name = "Managed" };
+    run_scenario(&alwaysOn, &alwaysOnConfig);
+    run_scenario(&managed, &config);
+    print_run(&alwaysOn);
+    print_run(&managed);
+
+    const ADXL345_POWER_STATS *stats = &managed.stats;
+    uint32_t averageWakeUs = stats->wakes ? (uint32_t) (stats->totalWakeLatencyUs / stats->wakes) : 0;
+    printf("Wake:      interrupt to active rate %lu us average, %lu us max; motion to active rate %lld ms max\n",
+           (unsigned long) averageWakeUs, (unsigned long) stats->maxWakeLatencyUs,
+           (long long) (managed.maxMotionToActiveUs / 1000));
+
+    double alwaysOnUj = alwaysOn.stats.sensorUj + alwaysOn.stats.hostUj;
+    double managedUj = managed.stats.sensorUj + managed.stats.hostUj;
+    printf("Saving:    %.0f%% of the energy\n", 100.0 * (1.0 - managedUj / alwaysOnUj));
+
+    bool delivered = true;
+    for (int i = 0; i < 2; i++) {
+        const RUN *run = (i == 0) ? &alwaysOn : &managed;
+        delivered &= run->delivered <= run->stats.samples &&
+                     run->delivered + SAMPLE_SLACK + run->stats.samples / 50 >= run->stats.samples;
+    }
+    bool pass = delivered && alwaysOn.stats.wakes == 0 && alwaysOn.stats.sleeps == 0 &&
+                managed.stats.sleeps == CYCLES && managed.stats.wakes == CYCLES - 1 &&
+                managed.maxMotionToActiveUs < MAX_WAKE_US && managedUj < alwaysOnUj;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Puts the simulated sensor through CYCLES of motion and stillness under the
+ * power manager, servicing it whenever INT1 rises.
+ *
+ * @param run    RUN to record the results in
+ * @param config ADXL345_POWER_CONFIG to manage the sensor with
+ */
+void run_scenario(RUN *run, const ADXL345_POWER_CONFIG *config) {
+    ADXL345_simPowerCycle(&sim);
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+    ADXL345_CONFIG accelConfig = {
+        .range = ADXL345_RANGE_2G,
+        .fullResolution = true,
+        .bwRate = config->activeRate,
+    };
+
+    runStartUs = esp_timer_get_time();
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &accelConfig));
+    ESP_ERROR_CHECK(ADXL345_powerInit(&power, &accel, config, block_received, state_changed, run));
+    ESP_ERROR_CHECK(ADXL345_simSetInterruptCallback(&sim, interrupt_changed, NULL));
+
+    while (esp_timer_get_time() - runStartUs < (int64_t) CYCLES * CYCLE_US) {
+        if (!pinHigh && xSemaphoreTake(pinRaised, pdMS_TO_TICKS(IRQ_TIMEOUT_MS)) != pdTRUE) {
+            continue;
+        }
+        ADXL345_powerService(&power, edgeUs);
+    }
+
+    ADXL345_simSetInterruptCallback(&sim, NULL, NULL);
+    ADXL345_powerGetStats(&power, &run->stats);
+    pinHigh = false;
+}
+
+void print_run(const RUN *run) {
+    const ADXL345_POWER_STATS *stats = &run->stats;
+    double seconds = (stats->activeUs + stats->idleUs) / 1e6;
+    printf("%-10s %.1f s, %lu wakes, %lu sleeps, %.0f%% idle\n", run->name, seconds, (unsigned long) stats->wakes,
+           (unsigned long) stats->sleeps, 100.0 * stats->idleUs / (stats->activeUs + stats->idleUs));
+    printf("           %llu samples (%lu delivered), sensor %llu uJ, host %llu uJ with %llu ms awake\n",
+           (unsigned long long) stats->samples, (unsigned long) run->delivered,
+           (unsigned long long) stats->sensorUj, (unsigned long long) stats->hostUj,
+           (unsigned long long) (stats->hostAwakeUs / 1000));
+    printf("           %lu samples/J, %.0f uW average\n", (unsigned long) stats->samplesPerJoule,
+           (stats->sensorUj + stats->hostUj) / seconds);
+}
+
+/**
+ * Simulated motion, a burst of sway at the start of every cycle.
+ */
+void motion(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg) {
+    bool moving = (timeUs - runStartUs) % CYCLE_US < MOVING_US;
+    ADXL345_simWave(timeUs, sample, moving ? &movingWave : &stillWave);
+}
+
+void block_received(const ADXL345_BLOCK *block, uint8_t bwRate, void *arg) {
+    RUN *run = (RUN *) arg;
+    run->delivered += block->count;
+}
+
+/**
+ * Power manager callback, times each wake from the start of the burst of
+ * motion that caused it.
+ */
+void state_changed(ADXL345_POWER_STATE state, void *arg) {
+    RUN *run = (RUN *) arg;
+    if (state != ADXL345_POWER_ACTIVE) {
+        return;
+    }
+    int64_t sinceMotionUs = (esp_timer_get_time() - runStartUs) % CYCLE_US;
+    if (sinceMotionUs > run->maxMotionToActiveUs) {
+        run->maxMotionToActiveUs = sinceMotionUs;
+    }
+}
+
+/**
+ * Simulated INT1 callback, wakes the service loop and notes when.
+ */
+void interrupt_changed(int pin, bool level, void *arg) {
+    if (pin != ADXL345_SIM_INT1) {
+        return;
+    }
+    pinHigh = level;
+    if (level) {
+        edgeUs = esp_timer_get_time();
+        xSemaphoreGive(pinRaised);
+    }
+}
@@ -0,0 +1,331 @@
+/**
+ * File:       ADXL345_sim_benchmark.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Throughput and latency of the ADXL345 acquisition path, against the
+ * simulated sensor.  Each scenario drains the FIFO for a few seconds at one
+ * output data rate and bus speed, either polling on a timer or woken by the
+ * watermark interrupt, with synchronous or pipelined transfers, over I2C
+ * or SPI.  Two scenarios add a fixed amount of work per block, done either
+ * after each drain or on the previous block while the next one is in flight.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_simwave.h"
+
+#define SCENARIO_SECONDS    2
+#define MAX_DRAINS          4096
+#define RATE_800HZ          0x0D
+#define RATE_3200HZ         0x0F
+#define SPI_HZ              5000000
+// Drain with half the FIFO still free, leaving room for a slow drain
+#define WATERMARK           16
+// Fixed per transfer cost in the bus model, for driver and ISR time
+#define OVERHEAD_US         20
+// Give up waiting for the watermark and drain anyway
+#define IRQ_TIMEOUT_MS      50
+// Host scheduling noise can cost the odd sample even where the bus keeps up
+#define LOSS_TOLERANCE_PERMILLE 10
+// Work per block for the processing scenarios, filtering, logging and so on
+#define WORK_US             5000
+
+typedef struct _scenario {
+    const char *name;
+    uint8_t bwRate;
+    uint32_t busHz;
+    bool spi;
+    bool async;
+    bool watermarkIrq;
+    // Whether there is enough bus time to spare that losing samples is a failure
+    bool mustKeepUp;
+    // Work done per block, and whether it's done on the previous block while
+    // the next is read rather than after each drain
+    uint32_t workUs;
+    bool overlapWork;
+} SCENARIO;
+
+typedef struct _result {
+    uint32_t drains;
+    uint32_t failedDrains;
+    uint32_t samples;
+    uint32_t generated;
+    uint32_t lost;
+    double seconds;
+    double busUtilization;
+    uint32_t latencyAvgUs;
+    uint32_t latencyP99Us;
+    uint32_t latencyMaxUs;
+} RESULT;
+
+static const SCENARIO scenarios[] = {
+    { "sync_poll_100k_800hz",   RATE_800HZ,  100000,  false, false, false, false },
+    { "async_poll_100k_800hz",  RATE_800HZ,  100000,  false, true,  false, true  },
+    { "sync_poll_400k_800hz",   RATE_800HZ,  400000,  false, false, false, true  },
+    { "async_poll_400k_800hz",  RATE_800HZ,  400000,  false, true,  false, true  },
+    { "async_irq_400k_800hz",   RATE_800HZ,  400000,  false, true,  true,  true  },
+    { "sync_poll_400k_3200hz",  RATE_3200HZ, 400000,  false, false, false, false },
+    { "async_poll_400k_3200hz", RATE_3200HZ, 400000,  false, true,  false, false },
+    { "async_irq_400k_3200hz",  RATE_3200HZ, 400000,  false, true,  true,  false },
+    { "async_irq_1m_3200hz",    RATE_3200HZ, 1000000, false, true,  true,  false },
+    { "sync_poll_spi5m_3200hz", RATE_3200HZ, SPI_HZ,  true,  false, false, false },
+    { "async_irq_spi5m_3200hz", RATE_3200HZ, SPI_HZ,  true,  true,  true,  true  },
+    { "serial_work_400k_3200hz",  RATE_3200HZ, 400000, false, true, false, false, WORK_US, false },
+    { "overlap_work_400k_3200hz", RATE_3200HZ, 400000, false, true, false, false, WORK_US, true  },
+};
+
+ADXL345_SIM sim;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ fifoRead;
+ADXL345_BLOCK blocks[2];
+ADXL345_SIM_WAVE wave;
+ADXL345_SIM_RECORDING recording;
+SemaphoreHandle_t watermark;
+volatile int64_t watermarkUs;
+volatile bool watermarkHigh;
+uint32_t latencies[MAX_DRAINS];
+
+// Function predefinition
+void run_scenario(const SCENARIO *scenario, RESULT *result);
+void watermark_edge(int pin, bool level, void *arg);
+void process_block(const ADXL345_BLOCK *block, uint32_t workUs);
+int compare_u32(const void *a, const void *b);
+void report(const SCENARIO *scenario, const RESULT *result);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, 400000, OVERHEAD_US));
+    watermark = xSemaphoreCreateBinary();
+
+    // Vibration, noise and a knock every half second, or a recording if given
+    const char *path = getenv("ADXL345_RECORDING");
+    if (path != NULL && ADXL345_simLoadRecording(&recording, path) == ESP_OK) {
+        printf("Playing %s, %u rows\n", path, (unsigned) recording.count);
+        ADXL345_simSetGenerator(&sim, ADXL345_simRecording, &recording);
+    } else {
+        if (path != NULL) {
+            printf("Couldn't load %s, using synthetic motion\n", path);
+        }
+        ADXL345_simWaveInit(&wave);
+        wave.sineMg.x = 500;
+        wave.sineMilliHz = 80000;
+        wave.noiseMg = 20;
+        wave.shockMg.z = 4000;
+        wave.shockUs = 5000;
+        wave.shockPeriodUs = 500000;
+        ADXL345_simSetGenerator(&sim, ADXL345_simWave, &wave);
+    }
+
+    // Wire time of one FIFO entry, the register address and six data bytes
+    ADXL345_simSetBus(&sim, 100000, OVERHEAD_US);
+    uint32_t i2cUs = ADXL345_simTransferUs(&sim, 1, ADXL345_SAMPLE_BYTES);
+    ADXL345_simSetSpi(&sim, SPI_HZ, OVERHEAD_US);
+    uint32_t spiUs = ADXL345_simTransferUs(&sim, 1, ADXL345_SAMPLE_BYTES);
+    printf("FIFO entry: %lu us over 100 kHz I2C, %lu us over 5 MHz SPI, %.1fx the headroom\n",
+           (unsigned long) i2cUs, (unsigned long) spiUs, (double) i2cUs / spiUs);
+
+    printf("%-24s %9s %7s %6s %8s %8s %8s\n", "Scenario", "Samples/s", "Lost", "Bus %", "Avg us", "P99 us", "Max us");
+    bool pass = true;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        RESULT result;
+        run_scenario(&scenarios[i], &result);
+        report(&scenarios[i], &result);
+        bool lossy = result.lost * 1000 > result.generated * LOSS_TOLERANCE_PERMILLE;
+        if (scenarios[i].mustKeepUp && (lossy || result.failedDrains > 0)) {
+            pass = false;
+        }
+    }
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Runs one scenario from a freshly configured sensor, and measures each drain
+ * from the moment it fell due, the poll tick or the watermark edge, to the
+ * block being ready.
+ *
+ * @param scenario SCENARIO to run
+ * @param result   RESULT to fill in
+ */
+void run_scenario(const SCENARIO *scenario, RESULT *result) {
+    static ADXL345_TRANSPORT_OPS syncOps;
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+    if (!scenario->async) {
+        syncOps = *transport.ops;
+        syncOps.submitWriteRead = NULL;
+        transport.ops = &syncOps;
+    }
+    if (scenario->spi) {
+        ADXL345_simSetSpi(&sim, scenario->busHz, OVERHEAD_US);
+    } else {
+        ADXL345_simSetBus(&sim, scenario->busHz, OVERHEAD_US);
+    }
+
+    ADXL345_CONFIG config = {
+        .range = ADXL345_RANGE_16G,
+        .fullResolution = true,
+        .bwRate = scenario->bwRate,
+    };
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &config));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, WATERMARK));
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&fifoRead));
+    // Enabling the interrupt after the callback is set gives the first edge
+    xSemaphoreTake(watermark, 0);
+    watermarkHigh = false;
+    if (scenario->watermarkIrq) {
+        ESP_ERROR_CHECK(ADXL345_simSetInterruptCallback(&sim, watermark_edge, NULL));
+        ESP_ERROR_CHECK(ADXL345_writeRegister(&accel, ADXL345_INT_ENABLE, ADXL345_INT_WATERMARK));
+    }
+
+    uint32_t pollUs = WATERMARK * ADXL345_samplePeriodUs(scenario->bwRate);
+    uint32_t startSamples = sim.samples;
+    uint32_t startOverruns = sim.overruns;
+    uint64_t startBusyUs = sim.busyUs;
+    int64_t startUs = esp_timer_get_time();
+    int64_t dueUs = startUs;
+    uint64_t totalUs = 0;
+    const ADXL345_BLOCK *previous = NULL;
+    int current = 0;
+    *result = (RESULT) { 0 };
+
+    while (esp_timer_get_time() - startUs < SCENARIO_SECONDS * 1000000ll) {
+        if (scenario->watermarkIrq) {
+            // If the FIFO refilled past the watermark during the last drain the
+            // pin never dropped, and there won't be another edge to wait for
+            if (watermarkHigh) {
+                dueUs = esp_timer_get_time();
+            } else if (xSemaphoreTake(watermark, pdMS_TO_TICKS(IRQ_TIMEOUT_MS)) == pdTRUE) {
+                dueUs = watermarkUs;
+            } else {
+                dueUs = esp_timer_get_time();
+            }
+        } else {
+            // Polls run to a fixed schedule, so a slow drain doesn't push the next one back
+            dueUs += pollUs;
+            int64_t waitUs = dueUs - esp_timer_get_time();
+            if (waitUs > 0) {
+                vTaskDelay((waitUs + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+            }
+        }
+
+        ADXL345_BLOCK *block = &blocks[current];
+        esp_err_t err = ADXL345_readFifoStart(&accel, &fifoRead);
+        if (err == ESP_OK) {
+            // The bursts are queued, so the last block can be worked on while they run
+            if (scenario->overlapWork && previous != NULL) {
+                process_block(previous, scenario->workUs);
+                previous = NULL;
+            }
+            err = ADXL345_readFifoFinish(&accel, &fifoRead, block);
+        }
+        uint32_t latencyUs = (uint32_t) (esp_timer_get_time() - dueUs);
+
+        if (err != ESP_OK) {
+            result->failedDrains++;
+            continue;
+        }
+        if (scenario->workUs > 0) {
+            if (scenario->overlapWork) {
+                previous = block;
+                current ^= 1;
+            } else {
+                process_block(block, scenario->workUs);
+            }
+        }
+        result->samples += block->count;
+        totalUs += latencyUs;
+        if (result->drains < MAX_DRAINS) {
+            latencies[result->drains] = latencyUs;
+        }
+        result->drains++;
+    }
+
+    if (scenario->watermarkIrq) {
+        ADXL345_simSetInterruptCallback(&sim, NULL, NULL);
+    }
+    ADXL345_setMeasure(&accel, false);
+
+    result->seconds = (esp_timer_get_time() - startUs) / 1e6;
+    result->generated = sim.samples - startSamples;
+    result->lost = sim.overruns - startOverruns;
+    result->busUtilization = (sim.busyUs - startBusyUs) / (result->seconds * 1e6);
+
+    int stored = (result->drains < MAX_DRAINS) ? result->drains : MAX_DRAINS;
+    if (stored > 0) {
+        qsort(latencies, stored, sizeof(latencies[0]), compare_u32);
+        result->latencyAvgUs = (uint32_t) (totalUs / result->drains);
+        result->latencyP99Us = latencies[(stored * 99) / 100];
+        result->latencyMaxUs = latencies[stored - 1];
+    }
+}
+
+/**
+ * Simulated INT1 callback, tracks the pin level, and on a rising edge notes
+ * when the watermark was crossed and wakes the drain loop.
+ */
+void watermark_edge(int pin, bool level, void *arg) {
+    if (pin != ADXL345_SIM_INT1) {
+        return;
+    }
+    watermarkHigh = level;
+    if (level) {
+        watermarkUs = esp_timer_get_time();
+        xSemaphoreGive(watermark);
+    }
+}
+
+/**
+ * Stands in for the application's work on a block, by keeping the drain task
+ * busy for the param time.
+ *
+ * @param block  ADXL345_BLOCK to work on
+ * @param workUs Time to spend on it
+ */
+void process_block(const ADXL345_BLOCK *block, uint32_t workUs) {
+    volatile int32_t sum = 0;
+    int64_t endUs = esp_timer_get_time() + workUs;
+    while (esp_timer_get_time() < endUs) {
+        for (int i = 0; i < block->count; i++) {
+            sum += block->x[i] + block->y[i] + block->z[i];
+        }
+    }
+}
+
+int compare_u32(const void *a, const void *b) {
+    uint32_t left = *(const uint32_t *) a;
+    uint32_t right = *(const uint32_t *) b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * Prints one scenario as a table row, and as BENCH,<scenario>,<metric>,<value>
+ * lines for CI to collect.
+ */
+void report(const SCENARIO *scenario, const RESULT *result) {
+    double rate = result->samples / result->seconds;
+
+    printf("%-24s %9.0f %7lu %6.1f %8lu %8lu %8lu\n", scenario->name, rate, (unsigned long) result->lost,
+           100.0 * result->busUtilization, (unsigned long) result->latencyAvgUs,
+           (unsigned long) result->latencyP99Us, (unsigned long) result->latencyMaxUs);
+
+    printf("BENCH,%s,samples_per_s,%.0f\n", scenario->name, rate);
+    printf("BENCH,%s,generated,%lu\n", scenario->name, (unsigned long) result->generated);
+    printf("BENCH,%s,lost,%lu\n", scenario->name, (unsigned long) result->lost);
+    printf("BENCH,%s,failed_drains,%lu\n", scenario->name, (unsigned long) result->failedDrains);
+    printf("BENCH,%s,bus_utilization,%.3f\n", scenario->name, result->busUtilization);
+    printf("BENCH,%s,latency_avg_us,%lu\n", scenario->name, (unsigned long) result->latencyAvgUs);
+    printf("BENCH,%s,latency_p99_us,%lu\n", scenario->name, (unsigned long) result->latencyP99Us);
+    printf("BENCH,%s,latency_max_us,%lu\n", scenario->name, (unsigned long) result->latencyMaxUs);
+}
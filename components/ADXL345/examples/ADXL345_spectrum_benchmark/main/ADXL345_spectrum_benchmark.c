@@ -0,0 +1,253 @@
+/**
+ * File:       ADXL345_spectrum_benchmark.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Cost and accuracy of the ADXL345 vibration spectrum stage.  Frames of
+ * every supported size are analyzed with known tones in them, timing each
+ * frame and checking the peak frequency and amplitude it finds, and the cost
+ * is turned into the share of one core that continuous capture would need at
+ * 1600 and 3200 Hz.  The stage is then run live, on FIFO drains from the
+ * simulated sensor at 3200 Hz, to show it keeping up with the acquisition
+ * path rather than just on paper.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_simwave.h"
+#include "ADXL345_spectrum.h"
+
+#define FRAMES_PER_SIZE     40
+#define TONE_X_HZ           123.4
+#define TONE_X_COUNTS       200.0
+#define TONE_Y_HZ           410.0
+#define TONE_Y_COUNTS       50.0
+#define NOISE_COUNTS        4
+// Peak bin amplitude within this of the tone, the Hann window loses up to
+// 15% of a tone that falls halfway between two bins
+#define MAX_AMPLITUDE_ERROR 0.16
+// Continuous capture must leave most of the core to everything else
+#define MAX_CORE_SHARE      0.25
+
+#define LIVE_SECONDS        3
+#define LIVE_SIZE           1024
+#define LIVE_TONE_MILLI_HZ  80000
+#define RATE_3200HZ         0x0F
+#define SPI_HZ              5000000
+#define OVERHEAD_US         20
+#define WATERMARK           16
+#define LOSS_TOLERANCE_PERMILLE 10
+
+typedef struct _sizeResult {
+    int size;
+    double frameUs;
+    double peakErrorBins;
+    double amplitudeError;
+    double share1600;
+    double share3200;
+} SIZE_RESULT;
+
+// Too big for a task stack
+static ADXL345_SPECTRUM spectrum;
+static int16_t frame[3][ADXL345_SPECTRUM_MAX_SIZE];
+ADXL345_SIM sim;
+ADXL345_SIM_WAVE wave;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ fifoRead;
+ADXL345_BLOCK block;
+static uint32_t seed = 12345;
+
+// Function predefinition
+void bench_size(int size, SIZE_RESULT *result);
+bool run_live(void);
+void fill_frame(int size, int frameIndex, uint32_t sampleRateHz);
+int noise(void);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    printf("%-6s %10s %10s %10s %11s %11s\n", "Size", "Frame us", "Peak bins", "Amp error", "Core@1600", "Core@3200");
+    bool pass = true;
+    for (int size = ADXL345_SPECTRUM_MIN_SIZE; size <= ADXL345_SPECTRUM_MAX_SIZE; size <<= 1) {
+        SIZE_RESULT result;
+        bench_size(size, &result);
+        printf("%-6d %10.1f %10.2f %9.1f%% %10.2f%% %10.2f%%\n", size, result.frameUs, result.peakErrorBins,
+               100.0 * result.amplitudeError, 100.0 * result.share1600, 100.0 * result.share3200);
+        printf("BENCH,fft_%d,frame_us,%.1f\n", size, result.frameUs);
+        printf("BENCH,fft_%d,peak_error_bins,%.3f\n", size, result.peakErrorBins);
+        printf("BENCH,fft_%d,amplitude_error,%.4f\n", size, result.amplitudeError);
+        printf("BENCH,fft_%d,core_share_3200hz,%.4f\n", size, result.share3200);
+        if (result.peakErrorBins > 0.5 || result.amplitudeError > MAX_AMPLITUDE_ERROR
+            || result.share3200 > MAX_CORE_SHARE) {
+            pass = false;
+        }
+    }
+
+    pass = run_live() && pass;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Analyzes FRAMES_PER_SIZE frames of the param size at 3200 Hz, each with a
+ * tone on X and a weaker one on Y, and times every frame's three axes.
+ *
+ * @param size   Samples per axis in each frame
+ * @param result SIZE_RESULT to fill in
+ */
+void bench_size(int size, SIZE_RESULT *result) {
+    const uint32_t sampleRateHz = 3200;
+    ADXL345_spectrumInit(&spectrum, size, sampleRateHz);
+    double binHz = (double) sampleRateHz / size;
+    int64_t busyUs = 0;
+    *result = (SIZE_RESULT) { .size = size };
+
+    for (int f = 0; f < FRAMES_PER_SIZE; f++) {
+        fill_frame(size, f, sampleRateHz);
+
+        int64_t start = esp_timer_get_time();
+        for (int axis = 0; axis < 3; axis++) {
+            ADXL345_spectrumAnalyze(&spectrum, axis, frame[axis]);
+        }
+        busyUs += esp_timer_get_time() - start;
+
+        const ADXL345_SPECTRUM_RESULT *x = &spectrum.result[0];
+        double peakErrorBins = fabs(x->peakFreqCentiHz / 100.0 - TONE_X_HZ) / binHz;
+        double amplitude = (double) x->peakAmplitude / (1 << ADXL345_SPECTRUM_AMP_Q);
+        double amplitudeError = fabs(amplitude - TONE_X_COUNTS) / TONE_X_COUNTS;
+        if (peakErrorBins > result->peakErrorBins) {
+            result->peakErrorBins = peakErrorBins;
+        }
+        if (amplitudeError > result->amplitudeError) {
+            result->amplitudeError = amplitudeError;
+        }
+        // The weaker tone has to be found too, not hidden under the stronger one's leakage
+        double yErrorBins = fabs(spectrum.result[1].peakFreqCentiHz / 100.0 - TONE_Y_HZ) / binHz;
+        if (yErrorBins > result->peakErrorBins) {
+            result->peakErrorBins = yErrorBins;
+        }
+    }
+
+    result->frameUs = (double) busyUs / FRAMES_PER_SIZE;
+    result->share1600 = result->frameUs * 1600.0 / size / 1e6;
+    result->share3200 = result->frameUs * 3200.0 / size / 1e6;
+}
+
+/**
+ * Drains the simulated sensor's FIFO at 3200 Hz over SPI for LIVE_SECONDS,
+ * feeding every block to the spectrum stage as it arrives, with an 80 Hz
+ * vibration on X.
+ *
+ * @return true if no more than LOSS_TOLERANCE_PERMILLE of the samples were
+ *         lost and every frame found the vibration
+ */
+bool run_live(void) {
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, SPI_HZ, OVERHEAD_US));
+    ADXL345_simSetSpi(&sim, SPI_HZ, OVERHEAD_US);
+    ADXL345_simWaveInit(&wave);
+    wave.gravityMg.z = 1000;
+    wave.sineMg.x = 500;
+    wave.sineMilliHz = LIVE_TONE_MILLI_HZ;
+    wave.noiseMg = 20;
+    ADXL345_simSetGenerator(&sim, ADXL345_simWave, &wave);
+
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+    ADXL345_CONFIG config = {
+        .range = ADXL345_RANGE_16G,
+        .fullResolution = true,
+        .bwRate = RATE_3200HZ,
+    };
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &config));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, WATERMARK));
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&fifoRead));
+    ADXL345_spectrumInit(&spectrum, LIVE_SIZE, 3200);
+
+    uint32_t pollUs = WATERMARK * ADXL345_samplePeriodUs(RATE_3200HZ);
+    uint32_t startSamples = sim.samples;
+    uint32_t startOverruns = sim.overruns;
+    uint32_t missedTone = 0;
+    uint32_t failedDrains = 0;
+    int64_t analyzeUs = 0;
+    int64_t startUs = esp_timer_get_time();
+    int64_t dueUs = startUs;
+
+    while (esp_timer_get_time() - startUs < LIVE_SECONDS * 1000000ll) {
+        dueUs += pollUs;
+        int64_t waitUs = dueUs - esp_timer_get_time();
+        if (waitUs > 0) {
+            vTaskDelay((waitUs + portTICK_PERIOD_MS * 1000 - 1) / (portTICK_PERIOD_MS * 1000));
+        }
+
+        esp_err_t err = ADXL345_readFifoStart(&accel, &fifoRead);
+        if (err == ESP_OK) {
+            err = ADXL345_readFifoFinish(&accel, &fifoRead, &block);
+        }
+        if (err != ESP_OK) {
+            failedDrains++;
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        int analyzed = ADXL345_spectrumFeed(&spectrum, &block);
+        analyzeUs += esp_timer_get_time() - start;
+        // Every frame's peak on X should be within a bin of the vibration
+        int errorCentiHz = abs((int) spectrum.result[0].peakFreqCentiHz - LIVE_TONE_MILLI_HZ / 10);
+        if (analyzed > 0 && errorCentiHz > (int) ADXL345_spectrumBinFreqCentiHz(&spectrum, 1)) {
+            missedTone++;
+        }
+    }
+    ADXL345_setMeasure(&accel, false);
+
+    double seconds = (esp_timer_get_time() - startUs) / 1e6;
+    uint32_t generated = sim.samples - startSamples;
+    uint32_t lost = sim.overruns - startOverruns;
+    double share = analyzeUs / (seconds * 1e6);
+    printf("Live:  %lu frames of %d at 3200 Hz, %lu of %lu samples lost, %lu frames missed the tone, "
+           "%.2f%% of a core\n", (unsigned long) spectrum.frames, LIVE_SIZE, (unsigned long) lost,
+           (unsigned long) generated, (unsigned long) missedTone, 100.0 * share);
+    printf("BENCH,live_3200hz,frames,%lu\n", (unsigned long) spectrum.frames);
+    printf("BENCH,live_3200hz,lost,%lu\n", (unsigned long) lost);
+    printf("BENCH,live_3200hz,core_share,%.4f\n", share);
+
+    return spectrum.frames > 0 && missedTone == 0 && failedDrains == 0
+        && lost * 1000 <= generated * LOSS_TOLERANCE_PERMILLE;
+}
+
+/**
+ * Fills one frame of the param size with a tone on X, a weaker one on Y,
+ * gravity on Z and a few counts of noise on every axis.  Each frame starts
+ * where the last left off, so the tones' phases vary from frame to frame.
+ *
+ * @param size         Samples per axis
+ * @param frameIndex   Frame number, from 0
+ * @param sampleRateHz Rate the tones are sampled at
+ */
+void fill_frame(int size, int frameIndex, uint32_t sampleRateHz) {
+    for (int n = 0; n < size; n++) {
+        double t = (double) (frameIndex * size + n) / sampleRateHz;
+        frame[0][n] = (int16_t) lround(TONE_X_COUNTS * sin(2.0 * M_PI * TONE_X_HZ * t)) + noise();
+        frame[1][n] = (int16_t) lround(TONE_Y_COUNTS * sin(2.0 * M_PI * TONE_Y_HZ * t)) + noise();
+        frame[2][n] = 256 + noise();
+    }
+}
+
+/**
+ * Returns uniform noise within +/- NOISE_COUNTS, from a small xorshift
+ * generator so every run sees the same input.
+ */
+int noise(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (int) (seed % (2 * NOISE_COUNTS + 1)) - NOISE_COUNTS;
+}
@@ -0,0 +1,283 @@
+/**
+ * File:       ADXL345_telemetry_stream.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Streams full rate 3200 Hz data from the simulated ADXL345 through the
+ * telemetry stream into one end of a pseudo-terminal, decodes it from the
+ * other end, and checks that every frame arrived intact and that the stream
+ * fits in a 2 Mbaud UART.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_simwave.h"
+#include "ADXL345_stream.h"
+
+#define RUN_SECONDS         5
+#define RATE_3200HZ         0x0F
+#define WATERMARK           16
+#define IRQ_TIMEOUT_MS      50
+#define BUS_HZ              1000000
+#define LINK_BAUD           2000000
+// A UART sends ten bits for every byte, with its start and stop bits
+#define BITS_PER_BYTE       10
+#define DRAIN_TIMEOUT_MS    2000
+// Longest input for the COBS boundary check, three full 254 byte runs
+#define COBS_MAX_LENGTH     762
+// Written after the encoder's output to catch it writing past its length
+#define COBS_GUARD          0xEE
+
+typedef struct _received {
+    uint32_t samples;
+    uint32_t checksum;
+} RECEIVED;
+
+ADXL345_SIM sim;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ fifoRead;
+ADXL345_BLOCK block;
+ADXL345_SIM_WAVE wave;
+ADXL345_STREAM stream;
+ADXL345_STREAM_DECODER decoder;
+RECEIVED received;
+SemaphoreHandle_t watermark;
+volatile bool watermarkHigh;
+volatile bool receiving = true;
+int receiveFd;
+
+// Function predefinition
+int open_link(int *receiveSide);
+void receive_task(void *arg);
+void frame_received(const ADXL345_STREAM_FRAME *frame, void *arg);
+void watermark_edge(int pin, bool level, void *arg);
+uint32_t checksum_block(uint32_t checksum, int64_t timestampUs, const int16_t *x, const int16_t *y, const int16_t *z,
+                        int count);
+bool check_cobs(void);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    int sendFd = open_link(&receiveFd);
+    if (sendFd < 0) {
+        printf("Couldn't open a pseudo-terminal\nFAIL\n");
+        return;
+    }
+    ADXL345_streamDecoderInit(&decoder, frame_received, &received);
+    xTaskCreatePinnedToCore(receive_task, "receive", 4096, NULL, 5, NULL, tskNO_AFFINITY);
+    ESP_ERROR_CHECK(ADXL345_streamStart(&stream, ADXL345_streamFdWriter, (void *) (intptr_t) sendFd, RATE_3200HZ,
+                                        4, tskNO_AFFINITY));
+
+    // Vibration and noise, so consecutive samples differ
+    ESP_ERROR_CHECK(ADXL345_simInit(&sim, BUS_HZ, 20));
+    ADXL345_simWaveInit(&wave);
+    wave.sineMg.x = 500;
+    wave.sineMg.y = 250;
+    wave.sineMilliHz = 80000;
+    wave.noiseMg = 20;
+    ADXL345_simSetGenerator(&sim, ADXL345_simWave, &wave);
+
+    ADXL345_TRANSPORT transport;
+    ADXL345_simTransport(&transport, &sim);
+    ADXL345_CONFIG config = {
+        .range = ADXL345_RANGE_16G,
+        .fullResolution = true,
+        .bwRate = RATE_3200HZ,
+    };
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, &transport, &config));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, WATERMARK));
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&fifoRead));
+    watermark = xSemaphoreCreateBinary();
+    ESP_ERROR_CHECK(ADXL345_simSetInterruptCallback(&sim, watermark_edge, NULL));
+    ESP_ERROR_CHECK(ADXL345_writeRegister(&accel, ADXL345_INT_ENABLE, ADXL345_INT_WATERMARK));
+
+    uint32_t periodUs = ADXL345_samplePeriodUs(RATE_3200HZ);
+    uint32_t startSamples = sim.samples;
+    uint32_t startOverruns = sim.overruns;
+    uint32_t sentChecksum = 0;
+    uint32_t queued = 0;
+    int64_t startUs = esp_timer_get_time();
+
+    while (esp_timer_get_time() - startUs < RUN_SECONDS * 1000000ll) {
+        if (!watermarkHigh) {
+            xSemaphoreTake(watermark, pdMS_TO_TICKS(IRQ_TIMEOUT_MS));
+        }
+        esp_err_t err = ADXL345_readFifoStart(&accel, &fifoRead);
+        if (err == ESP_OK) {
+            err = ADXL345_readFifoFinish(&accel, &fifoRead, &block);
+        }
+        if (err != ESP_OK || block.count == 0) {
+            continue;
+        }
+
+        // The newest sample was taken about now, the rest a period apart before it
+        int64_t firstUs = esp_timer_get_time() - (int64_t) (block.count - 1) * periodUs;
+        if (ADXL345_streamAppend(&stream, &block, firstUs) == ESP_OK) {
+            sentChecksum = checksum_block(sentChecksum, firstUs, block.x, block.y, block.z, block.count);
+            queued++;
+        }
+    }
+    double seconds = (esp_timer_get_time() - startUs) / 1e6;
+    ADXL345_simSetInterruptCallback(&sim, NULL, NULL);
+    ADXL345_setMeasure(&accel, false);
+
+    // Let the sender and receiver catch up with the last frames
+    int64_t waitStartUs = esp_timer_get_time();
+    while ((stream.stats.framesSent + stream.stats.writeErrors < queued || decoder.stats.frames < stream.stats.framesSent) &&
+           esp_timer_get_time() - waitStartUs < DRAIN_TIMEOUT_MS * 1000ll) {
+        vTaskDelay(1);
+    }
+    receiving = false;
+
+    const ADXL345_STREAM_STATS *sent = &stream.stats;
+    const ADXL345_STREAM_DECODE_STATS *got = &decoder.stats;
+    uint32_t generated = sim.samples - startSamples;
+    double bitsPerSecond = sent->bytesSent * BITS_PER_BYTE / seconds;
+
+    printf("Acquired:  %lu of %lu samples, %lu lost to FIFO overruns\n", (unsigned long) sent->samplesSent,
+           (unsigned long) generated, (unsigned long) (sim.overruns - startOverruns));
+    printf("Sent:      %lu frames, %lu samples, %llu bytes, %lu dropped, %lu write errors\n",
+           (unsigned long) sent->framesSent, (unsigned long) sent->samplesSent, (unsigned long long) sent->bytesSent,
+           (unsigned long) sent->framesDropped, (unsigned long) sent->writeErrors);
+    printf("Received:  %lu frames, %lu samples, %lu lost, %lu CRC errors, %lu format errors, %lu overruns\n",
+           (unsigned long) got->frames, (unsigned long) got->samples, (unsigned long) got->lostFrames,
+           (unsigned long) got->crcErrors, (unsigned long) got->formatErrors, (unsigned long) got->overruns);
+    printf("Link:      %.0f bit/s, %.1f%% of %d baud\n", bitsPerSecond, 100.0 * bitsPerSecond / LINK_BAUD, LINK_BAUD);
+
+    bool intact = got->frames == sent->framesSent && got->samples == sent->samplesSent &&
+                  received.checksum == sentChecksum;
+    bool clean = sent->framesDropped == 0 && sent->writeErrors == 0 && got->lostFrames == 0 &&
+                 got->crcErrors == 0 && got->formatErrors == 0 && got->overruns == 0;
+    bool pass = intact && clean && bitsPerSecond < LINK_BAUD;
+    pass = check_cobs() && pass;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Opens a pseudo-terminal in raw mode, so every byte goes through untouched.
+ * Both ends are non-blocking, so waiting on one never stalls other tasks.
+ *
+ * @param receiveSide Pointer to store the receiving end in
+ * @return The sending end, or -1 on failure
+ */
+int open_link(int *receiveSide) {
+    int sendFd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (sendFd < 0 || grantpt(sendFd) != 0 || unlockpt(sendFd) != 0) {
+        return -1;
+    }
+    *receiveSide = open(ptsname(sendFd), O_RDWR | O_NOCTTY);
+    if (*receiveSide < 0) {
+        return -1;
+    }
+
+    struct termios termios;
+    tcgetattr(*receiveSide, &termios);
+    cfmakeraw(&termios);
+    tcsetattr(*receiveSide, TCSANOW, &termios);
+
+    fcntl(sendFd, F_SETFL, fcntl(sendFd, F_GETFL) | O_NONBLOCK);
+    fcntl(*receiveSide, F_SETFL, fcntl(*receiveSide, F_GETFL) | O_NONBLOCK);
+    return sendFd;
+}
+
+/**
+ * The host receiver, reads whatever has arrived and feeds it to the decoder.
+ */
+void receive_task(void *arg) {
+    uint8_t chunk[512];
+    while (receiving) {
+        ssize_t length = read(receiveFd, chunk, sizeof(chunk));
+        if (length > 0) {
+            ADXL345_streamFeed(&decoder, chunk, length);
+        } else {
+            vTaskDelay(1);
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * Decoder callback, adds the frame's timestamp and samples to the running
+ * checksum.  The decoder has already checked the sequence numbers.
+ */
+void frame_received(const ADXL345_STREAM_FRAME *frame, void *arg) {
+    RECEIVED *state = (RECEIVED *) arg;
+    state->samples += frame->count;
+    state->checksum = checksum_block(state->checksum, frame->timestampUs, frame->x, frame->y, frame->z, frame->count);
+}
+
+/**
+ * Simulated INT1 callback, wakes the drain loop on the watermark.
+ */
+void watermark_edge(int pin, bool level, void *arg) {
+    if (pin != ADXL345_SIM_INT1) {
+        return;
+    }
+    watermarkHigh = level;
+    if (level) {
+        xSemaphoreGive(watermark);
+    }
+}
+
+uint32_t checksum_block(uint32_t checksum, int64_t timestampUs, const int16_t *x, const int16_t *y, const int16_t *z,
+                        int count) {
+    checksum = checksum * 31 + (uint32_t) timestampUs;
+    checksum = checksum * 31 + (uint32_t) (timestampUs >> 32);
+    for (int i = 0; i < count; i++) {
+        checksum = checksum * 31 + (uint16_t) x[i];
+        checksum = checksum * 31 + (uint16_t) y[i];
+        checksum = checksum * 31 + (uint16_t) z[i];
+    }
+    return checksum;
+}
+
+/**
+ * Round trips COBS inputs either side of each 254 byte run boundary, with
+ * and without zeros, through the smallest buffer the encoder accepts, and
+ * checks that nothing is written past the returned length.  Telemetry frames
+ * are too short to reach a full run, so the stream above never tests this.
+ *
+ * @return true if every input decoded back exactly and stayed in bounds
+ */
+bool check_cobs(void) {
+    static uint8_t in[COBS_MAX_LENGTH];
+    static uint8_t out[COBS_MAX_LENGTH + COBS_MAX_LENGTH / 254 + 2];
+    static uint8_t decoded[COBS_MAX_LENGTH];
+    const size_t lengths[] = { 0, 1, 253, 254, 255, 507, 508, 509, COBS_MAX_LENGTH };
+    int checked = 0;
+    int failed = 0;
+
+    for (int zeros = 0; zeros < 2; zeros++) {
+        for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+            size_t length = lengths[l];
+            for (size_t i = 0; i < length; i++) {
+                in[i] = (zeros && i % 300 == 299) ? 0x00 : (uint8_t) (1 + i % 255);
+            }
+            memset(out, COBS_GUARD, sizeof(out));
+            size_t encoded = ADXL345_cobsEncode(in, length, out, length + length / 254 + 1);
+            int decodedLength = (encoded > 0) ? ADXL345_cobsDecode(out, encoded, decoded, sizeof(decoded)) : -1;
+            if (encoded == 0 || out[encoded] != COBS_GUARD || decodedLength != (int) length ||
+                memcmp(in, decoded, length) != 0) {
+                failed++;
+            }
+            checked++;
+        }
+    }
+    printf("COBS:      %d of %d boundary lengths failed\n", failed, checked);
+    return failed == 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * File:       ADXL345_trace_replay.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Captures a trace of the driver draining a simulated ADXL345 on a faulty
+ * bus, dumps it to a file, then feeds it back through the same drain loop
+ * and checks that every drain comes out the same.  Point ADXL345_TRACE at a
+ * dump to replay that instead.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "ADXL345_sim.h"
+#include "ADXL345_trace.h"
+#include "ADXL345_replay.h"
+
+#define DRAINS              100
+#define DRAIN_PERIOD_MS     20
+#define CHECK_EVERY_DRAINS  8
+#define STICK_EVERY_DRAINS  25
+#define BROWNOUT_AT_DRAIN   60
+#define RATE_800HZ          0x0D
+
+#define NACK_PERMILLE       20
+#define TIMEOUT_PERMILLE    5
+#define FAULT_TIMEOUT_US    2000
+
+// Roomy enough that nothing from the run is overwritten
+#define TRACE_CAPACITY      4096
+#define TRACE_FILE          "adxl345_trace.bin"
+
+typedef struct _drain {
+    esp_err_t result;
+    int count;
+    int16_t firstX;
+    uint32_t latencyUs;
+} DRAIN;
+
+typedef struct _dumpBuffer {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+} DUMP_BUFFER;
+
+ADXL345_SIM sim;
+ADXL345_TRACE trace;
+ADXL345_TRACE_ENTRY traceEntries[TRACE_CAPACITY];
+ADXL345_TRACE_ENTRY replayEntries[TRACE_CAPACITY];
+ADXL345_REPLAY replay;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ fifoRead;
+ADXL345_BLOCK block;
+DRAIN captured[DRAINS];
+DRAIN replayed[DRAINS];
+
+ADXL345_CONFIG accelConfig = {
+    .range = ADXL345_RANGE_2G,
+    .fullResolution = true,
+    .bwRate = RATE_800HZ,
+};
+
+// Function predefinition
+void run_drains(const ADXL345_TRANSPORT *transport, bool injectFaults, DRAIN *drains);
+esp_err_t append_dump(const uint8_t *data, size_t length, void *arg);
+uint8_t *load_file(const char *path, size_t *length);
+void summarize(const char *name, const DRAIN *drains);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&fifoRead));
+    DUMP_BUFFER dump = { 0 };
+    const char *path = getenv("ADXL345_TRACE");
+
+    if (path != NULL) {
+        dump.data = load_file(path, &dump.length);
+        if (dump.data == NULL) {
+            printf("Couldn't read %s\n", path);
+            return;
+        }
+        printf("Replaying %s\n", path);
+    } else {
+        ESP_ERROR_CHECK(ADXL345_simInit(&sim, 400000, 20));
+        ADXL345_TRANSPORT simTransport;
+        ADXL345_TRANSPORT traced;
+        ADXL345_simTransport(&simTransport, &sim);
+        ADXL345_traceInit(&trace, traceEntries, TRACE_CAPACITY, ADXL345_DEFAULT_ADDR);
+        ADXL345_traceTransport(&traced, &trace, &simTransport);
+
+        run_drains(&traced, true, captured);
+        ADXL345_traceSetEnabled(&trace, false);
+        ESP_ERROR_CHECK(ADXL345_traceDump(&trace, append_dump, &dump));
+
+        FILE *file = fopen(TRACE_FILE, "wb");
+        if (file != NULL) {
+            fwrite(dump.data, 1, dump.length, file);
+            fclose(file);
+            printf("Captured %lu transfers, %u bytes, to %s\n", (unsigned long) atomic_load(&trace.head),
+                   (unsigned) dump.length, TRACE_FILE);
+        }
+    }
+
+    // Replay from the dump rather than the ring, so the file format is exercised too
+    size_t count = ADXL345_traceDecode(dump.data, dump.length, replayEntries, TRACE_CAPACITY);
+    free(dump.data);
+    if (count == 0) {
+        printf("Not a trace, or an empty one\nFAIL\n");
+        return;
+    }
+    ESP_ERROR_CHECK(ADXL345_replayInit(&replay, replayEntries, count, true));
+    ADXL345_TRANSPORT replayTransport;
+    ADXL345_replayTransport(&replayTransport, &replay);
+    run_drains(&replayTransport, false, replayed);
+
+    bool finished = ADXL345_replayFinished(&replay);
+    printf("Replay:   %lu of %u transfers, %lu skipped, %lu mismatched, %lu dropped%s\n",
+           (unsigned long) replay.replayed, (unsigned) count, (unsigned long) replay.skipped,
+           (unsigned long) replay.mismatches, (unsigned long) replay.dropped, finished ? "" : ", unfinished");
+
+    bool identical = true;
+    if (path == NULL) {
+        summarize("Captured", captured);
+        for (int i = 0; i < DRAINS; i++) {
+            if (captured[i].result != replayed[i].result || captured[i].count != replayed[i].count ||
+                captured[i].firstX != replayed[i].firstX) {
+                printf("Drain %d differs: %s, %d samples captured, %s, %d replayed\n", i,
+                       esp_err_to_name(captured[i].result), captured[i].count,
+                       esp_err_to_name(replayed[i].result), replayed[i].count);
+                identical = false;
+            }
+        }
+    }
+    summarize("Replayed", replayed);
+
+    bool pass = replay.mismatches == 0 && finished && identical;
+    printf("%s\n", pass ? "PASS" : "FAIL");
+}
+
+/**
+ * Configures the sensor and drains its FIFO DRAINS times, checking the
+ * configuration now and then, and notes how each drain went.  The replay
+ * has to make the same calls in the same order as the capture, so both run
+ * through here.
+ *
+ * @param transport    ADXL345_TRANSPORT to run over
+ * @param injectFaults true to fault the simulated bus while capturing
+ * @param drains       DRAIN array to fill in
+ */
+void run_drains(const ADXL345_TRANSPORT *transport, bool injectFaults, DRAIN *drains) {
+    ESP_ERROR_CHECK(ADXL345_initTransport(&accel, transport, &accelConfig));
+    ESP_ERROR_CHECK(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, 0));
+    if (injectFaults) {
+        ADXL345_simSetFaults(&sim, NACK_PERMILLE, TIMEOUT_PERMILLE, FAULT_TIMEOUT_US);
+    }
+
+    for (int i = 0; i < DRAINS; i++) {
+        if (injectFaults && i % STICK_EVERY_DRAINS == STICK_EVERY_DRAINS - 1) {
+            ADXL345_simSetStuck(&sim, true);
+        }
+        if (injectFaults && i == BROWNOUT_AT_DRAIN) {
+            ADXL345_simPowerCycle(&sim);
+        }
+
+        int64_t startUs = esp_timer_get_time();
+        if (i % CHECK_EVERY_DRAINS == CHECK_EVERY_DRAINS - 1) {
+            ADXL345_checkConfig(&accel);
+        }
+        esp_err_t err = ADXL345_readFifoStart(&accel, &fifoRead);
+        if (err == ESP_OK) {
+            err = ADXL345_readFifoFinish(&accel, &fifoRead, &block);
+        }
+
+        drains[i].latencyUs = (uint32_t) (esp_timer_get_time() - startUs);
+        drains[i].result = err;
+        drains[i].count = (err == ESP_OK) ? block.count : 0;
+        drains[i].firstX = (err == ESP_OK && block.count > 0) ? block.x[0] : 0;
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+    }
+
+    if (injectFaults) {
+        ADXL345_simSetFaults(&sim, 0, 0, 0);
+    }
+}
+
+/**
+ * Trace writer that appends to a growing DUMP_BUFFER.
+ */
+esp_err_t append_dump(const uint8_t *data, size_t length, void *arg) {
+    DUMP_BUFFER *dump = (DUMP_BUFFER *) arg;
+    if (dump->length + length > dump->capacity) {
+        size_t capacity = (dump->capacity > 0) ? dump->capacity * 2 : 4096;
+        while (capacity < dump->length + length) {
+            capacity *= 2;
+        }
+        uint8_t *grown = realloc(dump->data, capacity);
+        if (grown == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        dump->data = grown;
+        dump->capacity = capacity;
+    }
+    memcpy(&dump->data[dump->length], data, length);
+    dump->length += length;
+    return ESP_OK;
+}
+
+/**
+ * Reads a whole file into a new buffer, or returns NULL.
+ */
+uint8_t *load_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t *data = (size > 0) ? malloc(size) : NULL;
+    if (data != NULL && fread(data, 1, size, file) != (size_t) size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *length = (data != NULL) ? (size_t) size : 0;
+    return data;
+}
+
+/**
+ * Prints the samples, failures and drain latencies of one run.
+ */
+void summarize(const char *name, const DRAIN *drains) {
+    uint32_t samples = 0;
+    uint32_t failed = 0;
+    uint64_t totalUs = 0;
+    uint32_t worstUs = 0;
+
+    for (int i = 0; i < DRAINS; i++) {
+        samples += drains[i].count;
+        failed += (drains[i].result != ESP_OK);
+        totalUs += drains[i].latencyUs;
+        if (drains[i].latencyUs > worstUs) {
+            worstUs = drains[i].latencyUs;
+        }
+    }
+    printf("%-9s %lu samples, %lu of %d drains failed, drain avg %lu us, worst %lu us\n", name,
+           (unsigned long) samples, (unsigned long) failed, DRAINS, (unsigned long) (totalUs / DRAINS),
+           (unsigned long) worstUs);
+}
@@ -0,0 +1,800 @@
+/**
+ * File:       ADXL345.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+#include "esp_rom_sys.h"
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_Transfer(ADXL345_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                                  size_t rxLength);
+static esp_err_t ADXL345_Attempt(ADXL345_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                                 size_t rxLength);
+static void ADXL345_CountError(ADXL345_DEVICE *dev, esp_err_t err);
+static esp_err_t ADXL345_Reconfigure(ADXL345_DEVICE *dev);
+static void ADXL345_Backoff(uint32_t delayUs);
+static int32_t ADXL345_ScaleForFormat(ADXL345_RANGE range, bool fullResolution);
+static int8_t ADXL345_ClampOffset(int32_t value);
+static void ADXL345_UnpackSample(const uint8_t *regData, int16_t *x, int16_t *y, int16_t *z);
+static bool ADXL345_FifoReadDone(esp_err_t result, void *arg);
+static uint8_t ADXL345_DataFormat(ADXL345_RANGE range, bool fullResolution);
+
+// DATA_FORMAT is always built from its range and resolution fields together
+ADXL345_FIELDS_SHARE_REG(ADXL345_F_RANGE, ADXL345_F_FULL_RES);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the param device on any register access backend.  Verifies the
+ * device ID, applies the data format and output data rate in the param
+ * config, and places the sensor in measure mode.
+ * NOTE: The device is usable even if this fails, the configuration is cached
+ *       and the first access afterwards tries to recover the sensor again.
+ *
+ * @param dev       ADXL345_DEVICE to initialize
+ * @param transport ADXL345_TRANSPORT to talk to the sensor through, copied
+ * @param config    ADXL345_CONFIG to apply to the sensor
+ */
+esp_err_t ADXL345_initTransport(ADXL345_DEVICE *dev, const ADXL345_TRANSPORT *transport, const ADXL345_CONFIG *config) {
+    memset(dev, 0, sizeof(*dev));
+    dev->transport = *transport;
+    dev->config = *config;
+    dev->fifoCtl = ADXL345_FIFO_BYPASS;
+    dev->measuring = true;
+    dev->mgPerLsbQ8 = ADXL345_ScaleForFormat(config->range, config->fullResolution);
+    dev->retry = (ADXL345_RETRY_POLICY) {
+        ADXL345_DEFAULT_ATTEMPTS, ADXL345_DEFAULT_BACKOFF_US, ADXL345_DEFAULT_DRAIN_TIMEOUT_MS
+    };
+
+    esp_err_t err = ESP_FAIL;
+    uint32_t backoffUs = dev->retry.backoffUs;
+    for (int attempt = 0; attempt < dev->retry.attempts; attempt++) {
+        if (attempt > 0) {
+            ADXL345_Backoff(backoffUs);
+            backoffUs *= 2;
+        }
+        err = ADXL345_Reconfigure(dev);
+        if (err == ESP_OK || err == ESP_ERR_NOT_FOUND) {
+            break;
+        }
+    }
+    dev->needsRecovery = (err != ESP_OK);
+    return err;
+}
+
+/**
+ * Sets the measurement range and resolution via the DATA_FORMAT register, and
+ * picks the matching integer scale factor for ADXL345_toMilliG.
+ * NOTE: In full resolution mode the scale is 3.9 mg/LSB at every range, the
+ *       sensor simply widens the output word as the range grows.  In 10 bit
+ *       mode the scale doubles with every step up in range.
+ *
+ * @param dev            ADXL345_DEVICE to configure
+ * @param range          ADXL345_RANGE to measure over
+ * @param fullResolution true to enable FULL_RES, false for fixed 10 bit output
+ * @return ESP_ERR_INVALID_ARG if range isn't an ADXL345_RANGE
+ */
+esp_err_t ADXL345_setDataFormat(ADXL345_DEVICE *dev, ADXL345_RANGE range, bool fullResolution) {
+    if ((unsigned) range > ADXL345_FIELD_MAX(ADXL345_F_RANGE)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t format = ADXL345_DataFormat(range, fullResolution);
+
+    // Cached first, so that a recovery applies it even if this write fails
+    dev->config.range = range;
+    dev->config.fullResolution = fullResolution;
+    dev->mgPerLsbQ8 = ADXL345_ScaleForFormat(range, fullResolution);
+    return ADXL345_writeRegister(dev, ADXL345_DATA_FORMAT, format);
+}
+
+/**
+ * Places the sensor into (or takes it out of) measure mode via POWER_CTL.
+ * NOTE: The sensor powers on in standby, so this must be called before any
+ *       data registers will update.
+ *
+ * @param dev     ADXL345_DEVICE to configure
+ * @param measure true for measure mode, false for standby
+ */
+esp_err_t ADXL345_setMeasure(ADXL345_DEVICE *dev, bool measure) {
+    dev->measuring = measure;
+    uint8_t powerCtl = ADXL345_FIELD_UPDATE(ADXL345_F_MEASURE, dev->powerCtl, measure);
+    return ADXL345_writeRegister(dev, ADXL345_POWER_CTL, powerCtl);
+}
+
+/**
+ * Sets the output data rate via the BW_RATE register.  Can be changed while
+ * measuring, the FIFO keeps whatever was sampled at the old rate.
+ * NOTE: ADXL345_LOW_POWER may be ORed in for rate codes 0x07 (12.5 Hz) to
+ *       0x0C (400 Hz), for lower current at the cost of more noise.
+ *
+ * @param dev    ADXL345_DEVICE to configure
+ * @param bwRate BW_RATE register value
+ * @return ESP_ERR_INVALID_ARG if any of the reserved bits 7:5 are set
+ */
+esp_err_t ADXL345_setRate(ADXL345_DEVICE *dev, uint8_t bwRate) {
+    if ((bwRate & (uint8_t) ~(ADXL345_RATE_MASK | ADXL345_LOW_POWER)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Cached first, so that a recovery applies it even if this write fails
+    dev->config.bwRate = bwRate;
+    return ADXL345_writeRegister(dev, ADXL345_BW_RATE, bwRate);
+}
+
+/**
+ * Sets the link, auto sleep, sleep and wakeup bits of POWER_CTL, leaving
+ * measure mode as it is.
+ * NOTE: The datasheet asks for a pass through standby when clearing
+ *       AUTO_SLEEP or LINK, so the bits are always written in standby first
+ *       and measure mode is put back with a second write.
+ *
+ * @param dev      ADXL345_DEVICE to configure
+ * @param powerCtl ADXL345_LINK, ADXL345_AUTO_SLEEP, ADXL345_SLEEP and ADXL345_WAKEUP_* bits
+ * @return ESP_ERR_INVALID_ARG if any of the reserved bits 7:6 are set
+ */
+esp_err_t ADXL345_setPowerControl(ADXL345_DEVICE *dev, uint8_t powerCtl) {
+    uint8_t known = ADXL345_LINK | ADXL345_AUTO_SLEEP | ADXL345_MEASURE | ADXL345_SLEEP | ADXL345_WAKEUP_MASK;
+    if ((powerCtl & (uint8_t) ~known) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dev->powerCtl = ADXL345_FIELD_UPDATE(ADXL345_F_MEASURE, powerCtl, 0);
+    esp_err_t err = ADXL345_writeRegister(dev, ADXL345_POWER_CTL, dev->powerCtl);
+    if (err != ESP_OK || !dev->measuring) {
+        return err;
+    }
+    uint8_t measuring = ADXL345_FIELD_UPDATE(ADXL345_F_MEASURE, dev->powerCtl, 1);
+    return ADXL345_writeRegister(dev, ADXL345_POWER_CTL, measuring);
+}
+
+/**
+ * Reads all three axes in a single six byte burst starting at DATAX0.
+ * NOTE: The datasheet recommends a multi-byte read here, as it guarantees
+ *       that all three axes come from the same conversion.
+ *
+ * @param dev    ADXL345_DEVICE to read from
+ * @param sample ADXL345_SAMPLE to store the raw counts in
+ */
+esp_err_t ADXL345_readSample(ADXL345_DEVICE *dev, ADXL345_SAMPLE *sample) {
+    uint8_t regData[ADXL345_DATA_BURST_LENGTH];
+    esp_err_t err = ADXL345_readRegisters(dev, ADXL345_DATAX0, regData, sizeof(regData));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ADXL345_UnpackSample(regData, &sample->x, &sample->y, &sample->z);
+    return ESP_OK;
+}
+
+/**
+ * Sets the FIFO mode and the watermark (number of samples) at which the
+ * watermark interrupt fires.
+ *
+ * @param dev       ADXL345_DEVICE to configure
+ * @param mode      ADXL345_FIFO_MODE to run the FIFO in, ADXL345_FIFO_INT2 may
+ *                  be ORed in to trigger from INT2
+ * @param watermark Watermark sample count, 0-31
+ * @return ESP_ERR_INVALID_ARG if mode has other bits set or watermark is over 31
+ */
+esp_err_t ADXL345_setFifoMode(ADXL345_DEVICE *dev, ADXL345_FIFO_MODE mode, uint8_t watermark) {
+    uint8_t modeBits = ADXL345_FIELD_MASK(ADXL345_F_FIFO_MODE) | ADXL345_FIFO_INT2;
+    if (((unsigned) mode & (uint8_t) ~modeBits) != 0 || watermark > ADXL345_FIELD_MAX(ADXL345_F_SAMPLES)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dev->fifoCtl = ADXL345_FIELD_UPDATE(ADXL345_F_SAMPLES, mode, watermark);
+    return ADXL345_writeRegister(dev, ADXL345_FIFO_CTL, dev->fifoCtl);
+}
+
+/**
+ * Reads the number of samples currently held in the FIFO.
+ *
+ * @param dev   ADXL345_DEVICE to read from
+ * @param count Pointer to store the number of FIFO entries in
+ */
+esp_err_t ADXL345_getFifoCount(ADXL345_DEVICE *dev, int *count) {
+    uint8_t status = 0;
+    esp_err_t err = ADXL345_readRegisters(dev, ADXL345_FIFO_STATUS, &status, 1);
+    if (err != ESP_OK) {
+        return err;
+    }
+    *count = ADXL345_FIELD_GET(ADXL345_F_ENTRIES, status);
+    return ESP_OK;
+}
+
+/**
+ * Drains every sample currently held in the FIFO into the param block.
+ * NOTE: Each six byte burst from DATAX0 pops exactly one FIFO entry, so the
+ *       drain is one burst per entry.  At most ADXL345_FIFO_DEPTH samples are
+ *       read, which is also the block capacity.
+ *
+ * @param dev   ADXL345_DEVICE to read from
+ * @param block ADXL345_BLOCK to fill, count is set to the number of samples read
+ */
+esp_err_t ADXL345_readFifo(ADXL345_DEVICE *dev, ADXL345_BLOCK *block) {
+    return ADXL345_readFifoAxes(dev, block->x, block->y, block->z, ADXL345_BLOCK_SIZE, &block->count);
+}
+
+/**
+ * Drains up to the param maxCount samples from the FIFO straight into
+ * caller owned per axis arrays, so buffers other than an ADXL345_BLOCK
+ * (rings, capture windows) can be filled in place without a copy.
+ *
+ * @param dev      ADXL345_DEVICE to read from
+ * @param x        Array to store X samples in, at least maxCount long
+ * @param y        Array to store Y samples in, at least maxCount long
+ * @param z        Array to store Z samples in, at least maxCount long
+ * @param maxCount Maximum number of samples to read
+ * @param count    Pointer to store the number of samples read in
+ */
+esp_err_t ADXL345_readFifoAxes(ADXL345_DEVICE *dev, int16_t *x, int16_t *y, int16_t *z, int maxCount, int *count) {
+    int entries = 0;
+    *count = 0;
+
+    esp_err_t err = ADXL345_getFifoCount(dev, &entries);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (entries > maxCount) {
+        entries = maxCount;
+    }
+
+    for (int i = 0; i < entries; i++) {
+        ADXL345_SAMPLE sample;
+        err = ADXL345_readSample(dev, &sample);
+        if (err != ESP_OK) {
+            return err;
+        }
+        x[i] = sample.x;
+        y[i] = sample.y;
+        z[i] = sample.z;
+        *count = i + 1;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Starts a FIFO drain into the param request without waiting for it.  On a
+ * transport that can queue transfers, one burst per FIFO entry is queued and
+ * the call returns while the bus works, so the previous block can be
+ * processed in the meantime:
+ *
+ *     ADXL345_readFifoStart(dev, &request);
+ *     ... process the previous block ...
+ *     ADXL345_readFifoFinish(dev, &request, block);
+ *
+ * On a synchronous transport the drain completes before returning.
+ * NOTE: Only one drain may be in flight per request.
+ *
+ * @param dev     ADXL345_DEVICE to read from
+ * @param request ADXL345_FIFO_READ set up with ADXL345_fifoReadInit
+ */
+esp_err_t ADXL345_readFifoStart(ADXL345_DEVICE *dev, ADXL345_FIFO_READ *request) {
+    int entries = 0;
+    request->count = 0;
+    request->result = ESP_OK;
+    // A completion that straggled in after an earlier drain timed out
+    xSemaphoreTake(request->done, 0);
+
+    esp_err_t err = ADXL345_getFifoCount(dev, &entries);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (entries > ADXL345_FIFO_DEPTH) {
+        entries = ADXL345_FIFO_DEPTH;
+    }
+    request->reg = ADXL345_DATAX0;
+    request->count = entries;
+
+    if (dev->transport.ops->submitWriteRead == NULL) {
+        for (int i = 0; i < entries; i++) {
+            err = ADXL345_readRegisters(dev, ADXL345_DATAX0, request->raw[i], ADXL345_SAMPLE_BYTES);
+            if (err != ESP_OK) {
+                request->count = i;
+                return err;
+            }
+        }
+        return ESP_OK;
+    }
+
+    atomic_store(&request->pending, entries);
+    atomic_store(&request->completed, 0);
+    atomic_store(&request->failedMask, 0);
+    for (int i = 0; i < entries; i++) {
+        err = dev->transport.ops->submitWriteRead(dev->transport.ctx, &request->reg, 1, request->raw[i],
+                                                  ADXL345_SAMPLE_BYTES, ADXL345_FifoReadDone, request);
+        if (err != ESP_OK) {
+            // Nothing will complete for the bursts that weren't queued, so
+            // finish can't wait on them
+            ADXL345_CountError(dev, err);
+            request->result = err;
+            request->count = i;
+            if (atomic_fetch_sub(&request->pending, entries - i) == entries - i) {
+                xSemaphoreGive(request->done);
+            }
+            break;
+        }
+    }
+    return err;
+}
+
+/**
+ * Waits for a drain started with ADXL345_readFifoStart and unpacks it into
+ * the param block.  The wait is bounded by the retry policy's drainTimeoutMs,
+ * after which the bus is assumed wedged and recovered on the next access.
+ * Bursts that failed are counted and skipped rather than failing the whole
+ * drain, the block holds every sample that was read.
+ *
+ * @param dev     ADXL345_DEVICE the drain was started on
+ * @param request ADXL345_FIFO_READ passed to ADXL345_readFifoStart
+ * @param block   ADXL345_BLOCK to fill, count is set to the number of samples read
+ */
+esp_err_t ADXL345_readFifoFinish(ADXL345_DEVICE *dev, ADXL345_FIFO_READ *request, ADXL345_BLOCK *block) {
+    uint32_t failed = 0;
+    block->count = 0;
+    if (dev->transport.ops->submitWriteRead != NULL && request->count > 0) {
+        if (xSemaphoreTake(request->done, pdMS_TO_TICKS(dev->retry.drainTimeoutMs)) != pdTRUE) {
+            // Bursts may still be landing in the request, so none can be trusted
+            ADXL345_CountError(dev, ESP_ERR_TIMEOUT);
+            return ESP_ERR_TIMEOUT;
+        }
+        failed = atomic_load(&request->failedMask);
+        for (uint32_t bits = failed; bits != 0; bits &= bits - 1) {
+            ADXL345_CountError(dev, request->result);
+        }
+    }
+
+    // A burst NACKed on its address never reached the data registers, so
+    // didn't pop its FIFO entry.  The bursts that succeeded still hold
+    // consecutive samples, and the rest wait in the FIFO for the next drain.
+    int count = 0;
+    for (int i = 0; i < request->count; i++) {
+        if ((failed & (1u << i)) == 0) {
+            ADXL345_UnpackSample(request->raw[i], &block->x[count], &block->y[count], &block->z[count]);
+            count++;
+        }
+    }
+    block->count = count;
+    return (count > 0 || request->result == ESP_OK) ? ESP_OK : request->result;
+}
+
+/**
+ * Prepares a FIFO read request for use with ADXL345_readFifoStart.
+ *
+ * @param request ADXL345_FIFO_READ to prepare
+ */
+esp_err_t ADXL345_fifoReadInit(ADXL345_FIFO_READ *request) {
+    memset(request, 0, sizeof(*request));
+    atomic_init(&request->pending, 0);
+    atomic_init(&request->completed, 0);
+    atomic_init(&request->failedMask, 0);
+    request->done = xSemaphoreCreateBinary();
+    return (request->done != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/**
+ * Calibrates the sensor by averaging the param number of at rest samples and
+ * programming the OFSX/OFSY/OFSZ registers, so that no per sample offset
+ * correction is required afterwards.
+ * NOTE: The sensor is expected to be lying flat and still with the Z axis
+ *       pointing up (X = 0g, Y = 0g, Z = +1g) for the duration of the call.
+ *
+ * @param dev        ADXL345_DEVICE to calibrate
+ * @param numSamples Number of samples to average
+ */
+esp_err_t ADXL345_calibrate(ADXL345_DEVICE *dev, int numSamples) {
+    if (numSamples <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Clear any existing offset, otherwise we'd be measuring our own correction
+    esp_err_t err = ADXL345_setOffsets(dev, 0, 0, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint32_t periodUs = ADXL345_samplePeriodUs(dev->config.bwRate);
+    TickType_t periodTicks = pdMS_TO_TICKS(periodUs / 1000);
+    if (periodTicks == 0) {
+        periodTicks = 1;
+    }
+
+    // Let one full conversion pass so the first sample reflects the cleared offsets
+    vTaskDelay(periodTicks);
+
+    int32_t sum[3] = { 0, 0, 0 };
+    for (int i = 0; i < numSamples; i++) {
+        ADXL345_SAMPLE sample;
+        err = ADXL345_readSample(dev, &sample);
+        if (err != ESP_OK) {
+            return err;
+        }
+        sum[0] += ADXL345_toMilliG(dev, sample.x);
+        sum[1] += ADXL345_toMilliG(dev, sample.y);
+        sum[2] += ADXL345_toMilliG(dev, sample.z);
+        vTaskDelay(periodTicks);
+    }
+
+    const int32_t expected[3] = { 0, 0, ADXL345_ONE_G_MILLI };
+    int8_t offset[3];
+    for (int axis = 0; axis < 3; axis++) {
+        // Error in tenths of a milli-g, rounded to the nearest 15.6 mg offset step
+        int32_t errorTenths = ((sum[axis] / numSamples) - expected[axis]) * 10;
+        int32_t half = (errorTenths >= 0) ? (ADXL345_OFS_TENTH_MG / 2) : -(ADXL345_OFS_TENTH_MG / 2);
+        offset[axis] = ADXL345_ClampOffset(-((errorTenths + half) / ADXL345_OFS_TENTH_MG));
+    }
+
+    return ADXL345_setOffsets(dev, offset[0], offset[1], offset[2]);
+}
+
+/**
+ * Writes the param offsets into OFSX, OFSY and OFSZ in a single burst.
+ * Each offset is a two's complement value at 15.6 mg/LSB, and is added by the
+ * sensor to every output sample.
+ *
+ * @param dev ADXL345_DEVICE to configure
+ * @param x   X axis offset
+ * @param y   Y axis offset
+ * @param z   Z axis offset
+ */
+esp_err_t ADXL345_setOffsets(ADXL345_DEVICE *dev, int8_t x, int8_t y, int8_t z) {
+    uint8_t offsets[ADXL345_OFS_BURST_LENGTH] = { (uint8_t) x, (uint8_t) y, (uint8_t) z };
+    dev->offset[0] = x;
+    dev->offset[1] = y;
+    dev->offset[2] = z;
+    return ADXL345_writeRegisters(dev, ADXL345_OFSX, offsets, sizeof(offsets));
+}
+
+/**
+ * Writes a single byte to the param register.
+ * NOTE: Read only and reserved registers are refused with ESP_ERR_INVALID_ARG
+ *       before anything goes out on the bus.
+ *
+ * @param dev   ADXL345_DEVICE to write to
+ * @param reg   Register address
+ * @param value Byte to write
+ */
+esp_err_t ADXL345_writeRegister(ADXL345_DEVICE *dev, uint8_t reg, uint8_t value) {
+    if (!ADXL345_regWritable(reg, 1)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t writeCmd[2] = { reg, value };
+    return ADXL345_Transfer(dev, writeCmd, sizeof(writeCmd), NULL, 0);
+}
+
+/**
+ * Writes the param bytes to consecutive registers starting at the param
+ * register address, as a single transaction.
+ * NOTE: The ADXL345 auto increments the register address on multi-byte writes.
+ *       The burst must only cover writable registers, as for ADXL345_writeRegister.
+ *
+ * @param dev    ADXL345_DEVICE to write to
+ * @param reg    First register address to write
+ * @param data   Bytes to write
+ * @param length Number of registers to write, at most ADXL345_MAX_BURST_WRITE
+ */
+esp_err_t ADXL345_writeRegisters(ADXL345_DEVICE *dev, uint8_t reg, const uint8_t *data, size_t length) {
+    if (length > ADXL345_MAX_BURST_WRITE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    if (!ADXL345_regWritable(reg, length)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint8_t writeCmd[ADXL345_MAX_BURST_WRITE + 1];
+    writeCmd[0] = reg;
+    memcpy(&writeCmd[1], data, length);
+    return ADXL345_Transfer(dev, writeCmd, length + 1, NULL, 0);
+}
+
+/**
+ * Reads the param number of consecutive registers starting at the param
+ * register address.
+ *
+ * @param dev    ADXL345_DEVICE to read from
+ * @param reg    First register address to read
+ * @param data   Buffer to store the register contents in
+ * @param length Number of registers to read
+ */
+esp_err_t ADXL345_readRegisters(ADXL345_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length) {
+    return ADXL345_Transfer(dev, &reg, 1, data, length);
+}
+
+/**
+ * Replaces the retry policy, the default is ADXL345_DEFAULT_ATTEMPTS tries
+ * with ADXL345_DEFAULT_BACKOFF_US of initial backoff.
+ *
+ * @param dev    ADXL345_DEVICE to configure
+ * @param policy ADXL345_RETRY_POLICY to use, copied
+ */
+void ADXL345_setRetryPolicy(ADXL345_DEVICE *dev, const ADXL345_RETRY_POLICY *policy) {
+    dev->retry = *policy;
+    if (dev->retry.attempts == 0) {
+        dev->retry.attempts = 1;
+    }
+}
+
+/**
+ * Recovers the bus through the transport, if it knows how (for I2C, clocking
+ * SCL until a slave holding SDA low lets go), then writes the cached
+ * configuration back to the sensor.  Called automatically on the access
+ * after a timeout or a transfer that failed every attempt, but can also be
+ * called directly.
+ * NOTE: Only the configuration set through this file is restored.  Interrupt
+ *       and event thresholds set with ADXL345_events need setting again.
+ *
+ * @param dev ADXL345_DEVICE to recover
+ */
+esp_err_t ADXL345_recover(ADXL345_DEVICE *dev) {
+    dev->health.recoveries++;
+    dev->needsRecovery = true;
+
+    if (dev->transport.ops->recover != NULL) {
+        esp_err_t err = dev->transport.ops->recover(dev->transport.ctx);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    esp_err_t err = ADXL345_Reconfigure(dev);
+    if (err != ESP_OK) {
+        return err;
+    }
+    dev->health.reinits++;
+    dev->needsRecovery = false;
+    return ESP_OK;
+}
+
+/**
+ * Checks that the sensor still holds the cached rate and power settings, and
+ * puts the whole configuration back if it doesn't.  A brownout or glitch on
+ * the sensor's supply resets it to standby without any bus error, so call
+ * this now and then from the acquisition loop.
+ *
+ * @param dev ADXL345_DEVICE to check
+ */
+esp_err_t ADXL345_checkConfig(ADXL345_DEVICE *dev) {
+    uint8_t regs[ADXL345_RATE_POWER_BURST_LENGTH];
+    esp_err_t err = ADXL345_readRegisters(dev, ADXL345_BW_RATE, regs, sizeof(regs));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t powerCtl = ADXL345_FIELD_UPDATE(ADXL345_F_MEASURE, dev->powerCtl, dev->measuring);
+    if (regs[0] == dev->config.bwRate && regs[1] == powerCtl) {
+        return ESP_OK;
+    }
+    return ADXL345_recover(dev);
+}
+
+/**
+ * Returns the sample period in microseconds for the param BW_RATE value.
+ * NOTE: Rate code 0x0F is 3200 Hz, and each step down halves the rate.
+ *
+ * @param bwRate BW_RATE register value
+ */
+uint32_t ADXL345_samplePeriodUs(uint8_t bwRate) {
+    uint8_t rateCode = ADXL345_FIELD_GET(ADXL345_F_RATE, bwRate);
+    return (uint32_t) ((1000000ull << (15 - rateCode)) / 3200u);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns the milli-g per LSB scale in Q8 fixed point for the param format.
+ * Nominal sensitivity is 256 LSB/g at +/-2g, which is 1000/256 mg/LSB, or
+ * exactly 1000 in Q8.
+ *
+ * @param range          ADXL345_RANGE in use
+ * @param fullResolution Whether FULL_RES is set
+ */
+static int32_t ADXL345_ScaleForFormat(ADXL345_RANGE range, bool fullResolution) {
+    if (fullResolution) {
+        return ADXL345_ONE_G_MILLI;
+    }
+    return ADXL345_ONE_G_MILLI << range;
+}
+
+
+/**
+ * Clamps the param value to the range of an offset register.
+ *
+ * @param value Offset to clamp
+ */
+static int8_t ADXL345_ClampOffset(int32_t value) {
+    if (value > INT8_MAX) {
+        return INT8_MAX;
+    }
+    if (value < INT8_MIN) {
+        return INT8_MIN;
+    }
+    return (int8_t) value;
+}
+
+/**
+ * Runs one register transfer under the device's retry policy.  Recovers
+ * first if an earlier access left the bus in doubt, and backs off between
+ * attempts so a noisy bus gets a moment to settle.
+ *
+ * @param dev      ADXL345_DEVICE to talk to
+ * @param tx       Bytes to write, starting with the register address
+ * @param txLength Number of bytes to write
+ * @param rx       Buffer to read into, NULL for a plain write
+ * @param rxLength Number of bytes to read, 0 for a plain write
+ */
+static esp_err_t ADXL345_Transfer(ADXL345_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                                  size_t rxLength) {
+    esp_err_t err = ESP_FAIL;
+    uint32_t backoffUs = dev->retry.backoffUs;
+
+    for (int attempt = 0; attempt < dev->retry.attempts; attempt++) {
+        if (attempt > 0) {
+            dev->health.retries++;
+            ADXL345_Backoff(backoffUs);
+            backoffUs *= 2;
+        }
+        if (dev->needsRecovery) {
+            err = ADXL345_recover(dev);
+            if (err != ESP_OK) {
+                continue;
+            }
+        }
+        err = ADXL345_Attempt(dev, tx, txLength, rx, rxLength);
+        if (err == ESP_OK) {
+            return ESP_OK;
+        }
+    }
+
+    // Out of attempts, whatever is wrong didn't clear by itself
+    dev->health.failures++;
+    dev->needsRecovery = true;
+    return err;
+}
+
+/**
+ * Makes a single transfer attempt through the transport, counting any
+ * failure.
+ */
+static esp_err_t ADXL345_Attempt(ADXL345_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                                 size_t rxLength) {
+    esp_err_t err;
+    if (rxLength > 0) {
+        err = dev->transport.ops->writeRead(dev->transport.ctx, tx, txLength, rx, rxLength);
+    } else {
+        err = dev->transport.ops->write(dev->transport.ctx, tx, txLength);
+    }
+    if (err != ESP_OK) {
+        ADXL345_CountError(dev, err);
+    }
+    return err;
+}
+
+/**
+ * Counts a failed transfer.  A NACK is usually a one off, but a timeout
+ * means the bus may be stuck, so the bus is recovered before it is used again.
+ *
+ * @param dev ADXL345_DEVICE the transfer was for
+ * @param err Error the transfer failed with
+ */
+static void ADXL345_CountError(ADXL345_DEVICE *dev, esp_err_t err) {
+    dev->health.errors++;
+    if (err == ESP_ERR_TIMEOUT) {
+        dev->health.timeouts++;
+        dev->needsRecovery = true;
+    } else if (err == ESP_ERR_INVALID_RESPONSE || err == ESP_ERR_INVALID_STATE) {
+        // The i2c_master driver reports a NACK as either, depending on version
+        dev->health.nacks++;
+    }
+}
+
+/**
+ * Writes the whole cached configuration to the sensor, making one attempt
+ * at each transfer.  Verifies the device ID first, so a sensor that has
+ * dropped off the bus isn't mistaken for one that's been configured.
+ *
+ * @param dev ADXL345_DEVICE to configure
+ */
+static esp_err_t ADXL345_Reconfigure(ADXL345_DEVICE *dev) {
+    uint8_t reg = ADXL345_DEVID;
+    uint8_t devId = 0;
+    esp_err_t err = ADXL345_Attempt(dev, &reg, 1, &devId, 1);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (devId != ADXL345_DEVID_VALUE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t format = ADXL345_DataFormat(dev->config.range, dev->config.fullResolution);
+    // Standby while reconfiguring, the link and sleep bits are set while still
+    // in standby, and measure mode goes back on last
+    const uint8_t writes[][4] = {
+        { 2, ADXL345_POWER_CTL, 0x00 },
+        { 2, ADXL345_BW_RATE, dev->config.bwRate },
+        { 2, ADXL345_DATA_FORMAT, format },
+        { 2, ADXL345_FIFO_CTL, dev->fifoCtl },
+        { 2, ADXL345_POWER_CTL, dev->powerCtl },
+        { 2, ADXL345_POWER_CTL, ADXL345_FIELD_UPDATE(ADXL345_F_MEASURE, dev->powerCtl, dev->measuring) },
+    };
+    for (size_t i = 0; i < sizeof(writes) / sizeof(writes[0]); i++) {
+        err = ADXL345_Attempt(dev, &writes[i][1], writes[i][0], NULL, 0);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    uint8_t offsets[1 + ADXL345_OFS_BURST_LENGTH] = {
+        ADXL345_OFSX,
+        (uint8_t) dev->offset[0],
+        (uint8_t) dev->offset[1],
+        (uint8_t) dev->offset[2]
+    };
+    return ADXL345_Attempt(dev, offsets, sizeof(offsets), NULL, 0);
+}
+
+/**
+ * Waits out a retry backoff, yielding to other tasks when the wait is at
+ * least a tick long.
+ *
+ * @param delayUs Time to wait
+ */
+static void ADXL345_Backoff(uint32_t delayUs) {
+    TickType_t ticks = pdMS_TO_TICKS(delayUs / 1000);
+    if (ticks > 0) {
+        vTaskDelay(ticks);
+    } else {
+        esp_rom_delay_us(delayUs);
+    }
+}
+
+/**
+ * Unpacks a six byte DATAX0..DATAZ1 burst.
+ * NOTE: Each axis is a little endian signed 16 bit number stored as two uint8_t
+ *
+ * @param regData Six register bytes starting at DATAX0
+ * @param x       Pointer to store the X count in
+ * @param y       Pointer to store the Y count in
+ * @param z       Pointer to store the Z count in
+ */
+static void ADXL345_UnpackSample(const uint8_t *regData, int16_t *x, int16_t *y, int16_t *z) {
+    *x = (int16_t) ((regData[1] << 8) | regData[0]);
+    *y = (int16_t) ((regData[3] << 8) | regData[2]);
+    *z = (int16_t) ((regData[5] << 8) | regData[4]);
+}
+
+/**
+ * Transport completion for one queued FIFO burst, may run in an ISR.  Wakes
+ * ADXL345_readFifoFinish once the last burst of the drain is in.
+ *
+ * @param result Result of the burst
+ * @param arg    ADXL345_FIFO_READ the burst belongs to
+ */
+static bool ADXL345_FifoReadDone(esp_err_t result, void *arg) {
+    ADXL345_FIFO_READ *request = (ADXL345_FIFO_READ *) arg;
+    BaseType_t woken = pdFALSE;
+
+    unsigned index = atomic_fetch_add(&request->completed, 1);
+    if (result != ESP_OK) {
+        request->result = result;
+        atomic_fetch_or(&request->failedMask, 1u << index);
+    }
+    if (atomic_fetch_sub(&request->pending, 1) == 1) {
+        xSemaphoreGiveFromISR(request->done, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+/**
+ * Returns the DATA_FORMAT value for the param range and resolution.
+ *
+ * @param range          ADXL345_RANGE to measure over
+ * @param fullResolution true for FULL_RES
+ */
+static uint8_t ADXL345_DataFormat(ADXL345_RANGE range, bool fullResolution) {
+    return ADXL345_FIELD_VALUE(ADXL345_F_RANGE, range) | ADXL345_FIELD_VALUE(ADXL345_F_FULL_RES, fullResolution);
+}
@@ -0,0 +1,202 @@
+/**
+ * File:       ADXL345.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ADXL345_transport.h"
+#include "ADXL345_regs.h"
+
+typedef enum _adxl345Range {
+    ADXL345_RANGE_2G  = 0,
+    ADXL345_RANGE_4G  = 1,
+    ADXL345_RANGE_8G  = 2,
+    ADXL345_RANGE_16G = 3
+} ADXL345_RANGE;
+
+typedef struct _adxl345Sample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} ADXL345_SAMPLE;
+
+typedef enum _adxl345FifoMode {
+    ADXL345_FIFO_BYPASS  = ADXL345_FIELD_VALUE(ADXL345_F_FIFO_MODE, 0),
+    ADXL345_FIFO_FIFO    = ADXL345_FIELD_VALUE(ADXL345_F_FIFO_MODE, 1),
+    ADXL345_FIFO_STREAM  = ADXL345_FIELD_VALUE(ADXL345_F_FIFO_MODE, 2),
+    ADXL345_FIFO_TRIGGER = ADXL345_FIELD_VALUE(ADXL345_F_FIFO_MODE, 3)
+} ADXL345_FIFO_MODE;
+
+// Blocks are laid out as a structure of arrays, so that per axis loops run
+// over contiguous int16_t and are easy for the compiler to vectorize.
+#define ADXL345_BLOCK_SIZE      32
+// Bytes in one DATAX0..DATAZ1 burst
+#define ADXL345_SAMPLE_BYTES    ADXL345_DATA_BURST_LENGTH
+
+typedef struct _adxl345Block {
+    int count;
+    int16_t x[ADXL345_BLOCK_SIZE];
+    int16_t y[ADXL345_BLOCK_SIZE];
+    int16_t z[ADXL345_BLOCK_SIZE];
+} ADXL345_BLOCK;
+
+typedef struct _adxl345Config {
+    ADXL345_RANGE range;
+    bool fullResolution;
+    uint8_t bwRate;
+} ADXL345_CONFIG;
+
+// How hard register access tries before giving up on a transfer.  Each try
+// is bounded by the transport's own per transaction timeout, so the worst
+// case for one call is roughly attempts * timeout plus the backoff total.
+typedef struct _adxl345RetryPolicy {
+    // Tries per transfer, including the first
+    uint8_t attempts;
+    // Wait before the first retry, doubled for every retry after it
+    uint32_t backoffUs;
+    // Longest wait for a queued FIFO drain to complete
+    uint32_t drainTimeoutMs;
+} ADXL345_RETRY_POLICY;
+
+// Failure counters.  Bus errors are counted and recovered from, never fatal.
+typedef struct _adxl345Health {
+    uint32_t errors;
+    uint32_t timeouts;
+    uint32_t nacks;
+    uint32_t retries;
+    // Transfers that failed every attempt
+    uint32_t failures;
+    uint32_t recoveries;
+    // Times the cached configuration was written back to the sensor
+    uint32_t reinits;
+} ADXL345_HEALTH;
+
+typedef struct _adxl345Device {
+    ADXL345_TRANSPORT transport;
+    // Cached configuration, this is what the sensor is put back into after a
+    // bus recovery or a brownout
+    ADXL345_CONFIG config;
+    uint8_t fifoCtl;
+    bool measuring;
+    // POWER_CTL link, auto sleep and wakeup bits, the measure bit follows measuring
+    uint8_t powerCtl;
+    // Milli-g per LSB in Q8 fixed point, chosen from range/resolution at config time
+    int32_t mgPerLsbQ8;
+    int8_t offset[3];
+
+    ADXL345_RETRY_POLICY retry;
+    ADXL345_HEALTH health;
+    // Set when the bus or the sensor may be in a bad state, the next access
+    // recovers before doing anything else
+    bool needsRecovery;
+} ADXL345_DEVICE;
+
+// An in flight FIFO drain, see ADXL345_readFifoStart
+typedef struct _adxl345FifoRead {
+    uint8_t reg;
+    int count;
+    atomic_int pending;
+    // Bursts complete in order, so the completion count identifies each one
+    atomic_uint completed;
+    atomic_uint failedMask;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+    uint8_t raw[ADXL345_BLOCK_SIZE][ADXL345_SAMPLE_BYTES];
+} ADXL345_FIFO_READ;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_initTransport(ADXL345_DEVICE *dev, const ADXL345_TRANSPORT *transport, const ADXL345_CONFIG *config);
+
+esp_err_t ADXL345_setDataFormat(ADXL345_DEVICE *dev, ADXL345_RANGE range, bool fullResolution);
+
+esp_err_t ADXL345_setMeasure(ADXL345_DEVICE *dev, bool measure);
+
+esp_err_t ADXL345_setRate(ADXL345_DEVICE *dev, uint8_t bwRate);
+
+esp_err_t ADXL345_setPowerControl(ADXL345_DEVICE *dev, uint8_t powerCtl);
+
+esp_err_t ADXL345_readSample(ADXL345_DEVICE *dev, ADXL345_SAMPLE *sample);
+
+esp_err_t ADXL345_setFifoMode(ADXL345_DEVICE *dev, ADXL345_FIFO_MODE mode, uint8_t watermark);
+
+esp_err_t ADXL345_getFifoCount(ADXL345_DEVICE *dev, int *count);
+
+esp_err_t ADXL345_readFifo(ADXL345_DEVICE *dev, ADXL345_BLOCK *block);
+
+esp_err_t ADXL345_readFifoAxes(ADXL345_DEVICE *dev, int16_t *x, int16_t *y, int16_t *z, int maxCount, int *count);
+
+esp_err_t ADXL345_fifoReadInit(ADXL345_FIFO_READ *request);
+
+esp_err_t ADXL345_readFifoStart(ADXL345_DEVICE *dev, ADXL345_FIFO_READ *request);
+
+esp_err_t ADXL345_readFifoFinish(ADXL345_DEVICE *dev, ADXL345_FIFO_READ *request, ADXL345_BLOCK *block);
+
+esp_err_t ADXL345_calibrate(ADXL345_DEVICE *dev, int numSamples);
+
+void ADXL345_setRetryPolicy(ADXL345_DEVICE *dev, const ADXL345_RETRY_POLICY *policy);
+
+esp_err_t ADXL345_recover(ADXL345_DEVICE *dev);
+
+esp_err_t ADXL345_checkConfig(ADXL345_DEVICE *dev);
+
+esp_err_t ADXL345_setOffsets(ADXL345_DEVICE *dev, int8_t x, int8_t y, int8_t z);
+
+esp_err_t ADXL345_writeRegister(ADXL345_DEVICE *dev, uint8_t reg, uint8_t value);
+
+esp_err_t ADXL345_writeRegisters(ADXL345_DEVICE *dev, uint8_t reg, const uint8_t *data, size_t length);
+
+esp_err_t ADXL345_readRegisters(ADXL345_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length);
+
+uint32_t ADXL345_samplePeriodUs(uint8_t bwRate);
+
+/**
+ * Converts a raw count from the param device to milli-g using the integer scale
+ * chosen when the data format was configured.
+ *
+ * @param dev ADXL345_DEVICE the count was read from
+ * @param raw Raw signed count as read from a DATAx register pair
+ */
+static inline int32_t ADXL345_toMilliG(const ADXL345_DEVICE *dev, int16_t raw) {
+    return (raw * dev->mgPerLsbQ8) / 256;
+}
+
+// Constants for calculations
+#define ADXL345_DEVID_VALUE     0xE5
+#define ADXL345_DEFAULT_ADDR    0x53
+// With the SDO pin tied low, so two sensors can share a bus
+#define ADXL345_ALT_ADDR        0x1D
+#define ADXL345_RATE_100HZ      0x0A
+// Sample rates while asleep, in the POWER_CTL wakeup bits
+#define ADXL345_WAKEUP_8HZ      0x00
+#define ADXL345_WAKEUP_4HZ      0x01
+#define ADXL345_WAKEUP_2HZ      0x02
+#define ADXL345_WAKEUP_1HZ      0x03
+#define ADXL345_FIFO_DEPTH      32
+#define ADXL345_MAX_BURST_WRITE 8
+#define ADXL345_ONE_G_MILLI     1000
+// Offset registers are 15.6 mg/LSB, kept here in tenths of a milli-g
+#define ADXL345_OFS_TENTH_MG    156
+#define ADXL345_DEFAULT_ATTEMPTS         3
+#define ADXL345_DEFAULT_BACKOFF_US       500
+#define ADXL345_DEFAULT_DRAIN_TIMEOUT_MS 100
+
+// The I2C backend, only where the target has an I2C master driver
+#if __has_include("driver/i2c_master.h")
+#include "ADXL345_i2c.h"
+#endif
+
+// The SPI backend, likewise only where there is an SPI master driver
+#if __has_include("driver/spi_master.h")
+#include "ADXL345_spi.h"
+#endif
@@ -0,0 +1,298 @@
+/**
+ * File:       ADXL345_capture.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Pre/post trigger capture, much like a storage oscilloscope.  While armed
+ * the FIFO is drained straight into a circular buffer of the last length
+ * samples at the full output data rate.  Once a trigger fires a further
+ * postTrigger samples are captured, then the buffer is frozen and handed to
+ * the callback as one contiguous window, without copying.
+ *
+ * The buffer is mirrored: every drained run is also written length samples
+ * further on, so the window always starts at head and never wraps.  That is
+ * one block copy per FIFO drain rather than any per sample work.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "ADXL345_capture.h"
+#if ADXL345_CAPTURE_HEAP_CAPS
+#include "esp_heap_caps.h"
+#endif
+
+// 'Private' helpers designed for internal use
+static int16_t *ADXL345_AllocAxis(int length);
+static void ADXL345_FreeAxis(int16_t *buffer);
+static int ADXL345_FindThreshold(const ADXL345_CAPTURE *capture, int start, int count);
+static void ADXL345_Freeze(ADXL345_CAPTURE *capture);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Allocates the capture buffer, in PSRAM when the target has it, and arms
+ * the capture.
+ *
+ * @param capture     ADXL345_CAPTURE to initialise
+ * @param length      Total window length in samples, at least ADXL345_CAPTURE_MIN_LENGTH
+ * @param postTrigger Samples to keep capturing after the trigger, less than length
+ * @param callback    Called with the frozen window, from the context calling ADXL345_captureDrain
+ * @param arg         User argument passed to the callback
+ */
+esp_err_t ADXL345_captureInit(ADXL345_CAPTURE *capture, int length, int postTrigger,
+                              ADXL345_CAPTURE_CALLBACK callback, void *arg) {
+    if (length < ADXL345_CAPTURE_MIN_LENGTH || postTrigger < 0 || postTrigger >= length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(capture, 0, sizeof(*capture));
+    capture->length = length;
+    capture->postTrigger = postTrigger;
+    capture->callback = callback;
+    capture->arg = arg;
+
+    capture->x = ADXL345_AllocAxis(length);
+    capture->y = ADXL345_AllocAxis(length);
+    capture->z = ADXL345_AllocAxis(length);
+    if (capture->x == NULL || capture->y == NULL || capture->z == NULL) {
+        ADXL345_captureFree(capture);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ADXL345_captureRearm(capture);
+    return ESP_OK;
+}
+
+/**
+ * Releases the capture buffer.
+ *
+ * @param capture ADXL345_CAPTURE to free
+ */
+void ADXL345_captureFree(ADXL345_CAPTURE *capture) {
+    ADXL345_FreeAxis(capture->x);
+    ADXL345_FreeAxis(capture->y);
+    ADXL345_FreeAxis(capture->z);
+    capture->x = NULL;
+    capture->y = NULL;
+    capture->z = NULL;
+}
+
+/**
+ * Sets the software trigger, which fires on the first sample whose magnitude
+ * on any of the param axes exceeds the threshold.
+ * NOTE: This scans every drained sample.  Where that matters, configure the
+ *       hardware activity detector instead and register
+ *       ADXL345_captureActivityTrigger for ADXL345_EVENT_ACTIVITY.
+ *
+ * @param capture     ADXL345_CAPTURE to set the trigger for
+ * @param dev         ADXL345_DEVICE the samples come from, for the scale
+ * @param thresholdMg Threshold in milli-g, 0 disables the software trigger
+ * @param axes        ADXL345_AXIS_* bits of the axes to watch
+ */
+void ADXL345_captureSetThreshold(ADXL345_CAPTURE *capture, const ADXL345_DEVICE *dev, uint16_t thresholdMg, uint8_t axes) {
+    int32_t raw = ((int32_t) thresholdMg * 256) / dev->mgPerLsbQ8;
+    if (raw > INT16_MAX) {
+        raw = INT16_MAX;
+    }
+    capture->threshold = (int16_t) raw;
+    capture->thresholdAxes = axes;
+}
+
+/**
+ * Requests a trigger.  Safe to call from any task or core, the trigger is
+ * taken at the newest sample of the next drain.
+ *
+ * @param capture ADXL345_CAPTURE to trigger
+ * @param source  ADXL345_CAPTURE_SOURCE to report in the window
+ */
+void ADXL345_captureTrigger(ADXL345_CAPTURE *capture, ADXL345_CAPTURE_SOURCE source) {
+    // Stored as source + 1 so that zero means no request
+    atomic_store(&capture->requested, (int) source + 1);
+}
+
+/**
+ * ADXL345_EVENT_CALLBACK that triggers the capture passed as arg.  Register
+ * it with ADXL345_eventsRegister for ADXL345_EVENT_ACTIVITY.
+ *
+ * @param dev   ADXL345_DEVICE that raised the event
+ * @param event ADXL345_EVENT raised
+ * @param arg   ADXL345_CAPTURE to trigger
+ */
+void ADXL345_captureActivityTrigger(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg) {
+    ADXL345_captureTrigger((ADXL345_CAPTURE *) arg, ADXL345_CAPTURE_SOURCE_ACTIVITY);
+}
+
+/**
+ * Drains the FIFO into the capture buffer and advances the trigger logic,
+ * calling the callback once the post trigger samples are in.  Call this in
+ * place of ADXL345_readFifo while the capture is in use.
+ * NOTE: Once complete the capture stops reading the FIFO until it is
+ *       rearmed, so the frozen window is never overwritten.
+ *
+ * @param capture ADXL345_CAPTURE to drain into
+ * @param dev     ADXL345_DEVICE to drain
+ */
+esp_err_t ADXL345_captureDrain(ADXL345_CAPTURE *capture, ADXL345_DEVICE *dev) {
+    int length = capture->length;
+
+    while (capture->state != ADXL345_CAPTURE_COMPLETE) {
+        int space = length - capture->head;
+        if (capture->state == ADXL345_CAPTURE_TRIGGERED && capture->remaining < space) {
+            space = capture->remaining;
+        }
+
+        int head = capture->head;
+        int count = 0;
+        esp_err_t err = ADXL345_readFifoAxes(dev, &capture->x[head], &capture->y[head], &capture->z[head],
+                                             space, &count);
+        if (err != ESP_OK) {
+            return err;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        memcpy(&capture->x[head + length], &capture->x[head], count * sizeof(int16_t));
+        memcpy(&capture->y[head + length], &capture->y[head], count * sizeof(int16_t));
+        memcpy(&capture->z[head + length], &capture->z[head], count * sizeof(int16_t));
+
+        capture->head = (head + count == length) ? 0 : head + count;
+        capture->written += count;
+
+        if (capture->state == ADXL345_CAPTURE_ARMED) {
+            int requested = atomic_exchange(&capture->requested, 0);
+            int hit = ADXL345_FindThreshold(capture, head, count);
+
+            if (hit >= 0) {
+                capture->source = ADXL345_CAPTURE_SOURCE_THRESHOLD;
+            } else if (requested != 0) {
+                capture->source = (ADXL345_CAPTURE_SOURCE) (requested - 1);
+                hit = count - 1;
+            }
+
+            if (hit >= 0) {
+                capture->state = ADXL345_CAPTURE_TRIGGERED;
+                capture->triggerSample = capture->written - count + hit;
+                // Samples after the trigger in this run already count as post trigger
+                capture->remaining = capture->postTrigger - (count - 1 - hit);
+            }
+        } else {
+            capture->remaining -= count;
+        }
+
+        if (capture->state == ADXL345_CAPTURE_TRIGGERED && capture->remaining <= 0) {
+            ADXL345_Freeze(capture);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * Releases the frozen window and arms the capture again.  The pre trigger
+ * history starts empty.
+ *
+ * @param capture ADXL345_CAPTURE to rearm
+ */
+void ADXL345_captureRearm(ADXL345_CAPTURE *capture) {
+    capture->head = 0;
+    capture->written = 0;
+    capture->remaining = 0;
+    atomic_store(&capture->requested, 0);
+    capture->state = ADXL345_CAPTURE_ARMED;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Allocates one mirrored axis buffer, preferring PSRAM and falling back to
+ * internal RAM.
+ *
+ * @param length Window length in samples
+ */
+static int16_t *ADXL345_AllocAxis(int length) {
+    size_t size = 2 * (size_t) length * sizeof(int16_t);
+#if ADXL345_CAPTURE_HEAP_CAPS
+    int16_t *buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == NULL) {
+        buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    return buffer;
+#else
+    return malloc(size);
+#endif
+}
+
+/**
+ * Frees one axis buffer from ADXL345_AllocAxis.
+ *
+ * @param buffer Buffer to free, may be NULL
+ */
+static void ADXL345_FreeAxis(int16_t *buffer) {
+#if ADXL345_CAPTURE_HEAP_CAPS
+    heap_caps_free(buffer);
+#else
+    free(buffer);
+#endif
+}
+
+/**
+ * Scans a freshly drained run for the software trigger.
+ *
+ * @param capture ADXL345_CAPTURE holding the run
+ * @param start   Buffer index of the first sample of the run
+ * @param count   Number of samples in the run
+ * @return Offset into the run of the first sample over threshold, or -1
+ */
+static int ADXL345_FindThreshold(const ADXL345_CAPTURE *capture, int start, int count) {
+    if (capture->threshold == 0) {
+        return -1;
+    }
+
+    const int16_t *axes[3] = { &capture->x[start], &capture->y[start], &capture->z[start] };
+    const uint8_t bits[3] = { ADXL345_AXIS_X, ADXL345_AXIS_Y, ADXL345_AXIS_Z };
+    int first = -1;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if ((capture->thresholdAxes & bits[axis]) == 0) {
+            continue;
+        }
+        int limit = (first >= 0) ? first : count;
+        for (int i = 0; i < limit; i++) {
+            int value = axes[axis][i];
+            if (value > capture->threshold || value < -capture->threshold) {
+                first = i;
+                break;
+            }
+        }
+    }
+    return first;
+}
+
+/**
+ * Freezes the buffer and hands the newest length samples to the callback.
+ *
+ * @param capture ADXL345_CAPTURE to freeze
+ */
+static void ADXL345_Freeze(ADXL345_CAPTURE *capture) {
+    int length = capture->length;
+    int count = (capture->written < (uint32_t) length) ? (int) capture->written : length;
+    // Oldest kept sample sits at head, or at 0 while the buffer is still filling
+    int start = (capture->written < (uint32_t) length) ? 0 : capture->head;
+    uint32_t firstSample = capture->written - count;
+
+    capture->state = ADXL345_CAPTURE_COMPLETE;
+    capture->window.x = &capture->x[start];
+    capture->window.y = &capture->y[start];
+    capture->window.z = &capture->z[start];
+    capture->window.count = count;
+    capture->window.triggerIndex = (int) (capture->triggerSample - firstSample);
+    capture->window.source = capture->source;
+
+    if (capture->callback != NULL) {
+        capture->callback(&capture->window, capture->arg);
+    }
+}
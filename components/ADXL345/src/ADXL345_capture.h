@@ -0,0 +1,93 @@
+/**
+ * File:       ADXL345_capture.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "ADXL345.h"
+#include "ADXL345_events.h"
+
+// Placing the buffer in PSRAM needs the heap capabilities API, which the
+// Linux target doesn't have.  There the buffer comes from malloc.
+#if __has_include("esp_heap_caps.h")
+#define ADXL345_CAPTURE_HEAP_CAPS   1
+#else
+#define ADXL345_CAPTURE_HEAP_CAPS   0
+#endif
+
+typedef enum _adxl345CaptureState {
+    ADXL345_CAPTURE_ARMED = 0,
+    ADXL345_CAPTURE_TRIGGERED,
+    ADXL345_CAPTURE_COMPLETE
+} ADXL345_CAPTURE_STATE;
+
+typedef enum _adxl345CaptureSource {
+    ADXL345_CAPTURE_SOURCE_API = 0,
+    ADXL345_CAPTURE_SOURCE_THRESHOLD,
+    ADXL345_CAPTURE_SOURCE_ACTIVITY
+} ADXL345_CAPTURE_SOURCE;
+
+// A frozen capture.  The pointers reference the capture buffer itself and
+// stay valid until ADXL345_captureRearm is called.
+typedef struct _adxl345CaptureWindow {
+    const int16_t *x;
+    const int16_t *y;
+    const int16_t *z;
+    int count;
+    // Index into the window of the sample the trigger fired on
+    int triggerIndex;
+    ADXL345_CAPTURE_SOURCE source;
+} ADXL345_CAPTURE_WINDOW;
+
+typedef void (*ADXL345_CAPTURE_CALLBACK)(const ADXL345_CAPTURE_WINDOW *window, void *arg);
+
+typedef struct _adxl345Capture {
+    // Each axis is 2 * length samples, the upper half mirroring the lower so
+    // that the newest length samples are always contiguous
+    int16_t *x;
+    int16_t *y;
+    int16_t *z;
+    int length;
+    int postTrigger;
+    int head;
+    uint32_t written;
+    uint32_t triggerSample;
+    int remaining;
+    // Raw count threshold for the software trigger, 0 to disable
+    int16_t threshold;
+    uint8_t thresholdAxes;
+    ADXL345_CAPTURE_STATE state;
+    ADXL345_CAPTURE_SOURCE source;
+    atomic_int requested;
+    ADXL345_CAPTURE_WINDOW window;
+    ADXL345_CAPTURE_CALLBACK callback;
+    void *arg;
+} ADXL345_CAPTURE;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_captureInit(ADXL345_CAPTURE *capture, int length, int postTrigger,
+                              ADXL345_CAPTURE_CALLBACK callback, void *arg);
+
+void ADXL345_captureFree(ADXL345_CAPTURE *capture);
+
+void ADXL345_captureSetThreshold(ADXL345_CAPTURE *capture, const ADXL345_DEVICE *dev, uint16_t thresholdMg, uint8_t axes);
+
+void ADXL345_captureTrigger(ADXL345_CAPTURE *capture, ADXL345_CAPTURE_SOURCE source);
+
+void ADXL345_captureActivityTrigger(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg);
+
+esp_err_t ADXL345_captureDrain(ADXL345_CAPTURE *capture, ADXL345_DEVICE *dev);
+
+void ADXL345_captureRearm(ADXL345_CAPTURE *capture);
+
+// Constants for calculations
+#define ADXL345_CAPTURE_MIN_LENGTH  (2 * ADXL345_FIFO_DEPTH)
@@ -0,0 +1,322 @@
+/**
+ * File:       ADXL345_events.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Configuration of the ADXL345's on chip event engine (tap, double tap,
+ * activity, inactivity and free-fall), and dispatch of its interrupts to
+ * typed callbacks.  The host only wakes when the sensor raises an interrupt
+ * pin, rather than polling sample data looking for rare events.
+ */
+#include <string.h>
+#include "esp_attr.h"
+#include "ADXL345_events.h"
+
+#define ADXL345_EVENTS_STACK_SIZE   3072
+// Upper bound on INT_SOURCE re-reads per wake, in case events keep arriving.
+// Anything left pending holds the pin high and interrupts again at once.
+#define ADXL345_MAX_SERVICE_PASSES  4
+// Wait after a failed read before letting a still high pin interrupt again
+#define ADXL345_SERVICE_RETRY_DELAY (10 / portTICK_PERIOD_MS)
+
+// 'Private' helpers designed for internal use
+static uint8_t ADXL345_ThresholdFromMg(uint16_t milliG);
+static uint8_t ADXL345_Saturate8(uint32_t value);
+#if ADXL345_EVENTS_GPIO
+static void ADXL345_EventsTask(void *arg);
+static void IRAM_ATTR ADXL345_EventsIsr(void *arg);
+#endif
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Programs the tap detection registers (THRESH_TAP, DUR, Latent, Window and
+ * TAP_AXES).  Setting latency or window to zero disables double tap.
+ * NOTE: Thresholds and timings beyond a register's range are clamped to its
+ *       maximum, but axes other than ADXL345_AXIS_* bits are refused.
+ *
+ * @param dev    ADXL345_DEVICE to configure
+ * @param config ADXL345_TAP_CONFIG with the thresholds and timings to use
+ * @return ESP_ERR_INVALID_ARG if axes has bits other than ADXL345_AXIS_*
+ */
+esp_err_t ADXL345_configureTap(ADXL345_DEVICE *dev, const ADXL345_TAP_CONFIG *config) {
+    if (config->axes > ADXL345_FIELD_MAX(ADXL345_F_TAP_AXES)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t err = ADXL345_writeRegister(dev, ADXL345_THRESH_TAP, ADXL345_ThresholdFromMg(config->thresholdMg));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // DUR, Latent and Window are consecutive, so write them as one burst
+    uint8_t timing[3] = {
+        ADXL345_Saturate8(config->durationUs / ADXL345_DUR_US_LSB),
+        ADXL345_Saturate8(config->latencyUs / ADXL345_LATENT_US_LSB),
+        ADXL345_Saturate8(config->windowUs / ADXL345_LATENT_US_LSB)
+    };
+    err = ADXL345_writeRegisters(dev, ADXL345_DUR, timing, sizeof(timing));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    uint8_t tapAxes = ADXL345_FIELD_VALUE(ADXL345_F_TAP_AXES, config->axes) |
+                      ADXL345_FIELD_VALUE(ADXL345_F_TAP_SUPPRESS, config->suppressDouble);
+    return ADXL345_writeRegister(dev, ADXL345_TAP_AXES, tapAxes);
+}
+
+/**
+ * Programs the activity and inactivity detection registers (THRESH_ACT,
+ * THRESH_INACT, TIME_INACT and ACT_INACT_CTL).
+ *
+ * @param dev    ADXL345_DEVICE to configure
+ * @param config ADXL345_ACTIVITY_CONFIG with the thresholds and axes to use
+ * @return ESP_ERR_INVALID_ARG if either axes has bits other than ADXL345_AXIS_*
+ */
+esp_err_t ADXL345_configureActivity(ADXL345_DEVICE *dev, const ADXL345_ACTIVITY_CONFIG *config) {
+    if (config->activityAxes > ADXL345_FIELD_MAX(ADXL345_F_ACT_AXES) ||
+        config->inactivityAxes > ADXL345_FIELD_MAX(ADXL345_F_INACT_AXES)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint8_t control = ADXL345_FIELD_VALUE(ADXL345_F_ACT_AXES, config->activityAxes) |
+                      ADXL345_FIELD_VALUE(ADXL345_F_ACT_AC, config->activityAcCoupled) |
+                      ADXL345_FIELD_VALUE(ADXL345_F_INACT_AXES, config->inactivityAxes) |
+                      ADXL345_FIELD_VALUE(ADXL345_F_INACT_AC, config->inactivityAcCoupled);
+
+    // THRESH_ACT through ACT_INACT_CTL are consecutive, so write them as one burst
+    uint8_t activity[4] = {
+        ADXL345_ThresholdFromMg(config->activityThresholdMg),
+        ADXL345_ThresholdFromMg(config->inactivityThresholdMg),
+        config->inactivitySeconds,
+        control
+    };
+    return ADXL345_writeRegisters(dev, ADXL345_THRESH_ACT, activity, sizeof(activity));
+}
+
+/**
+ * Programs the free-fall detection registers (THRESH_FF and TIME_FF).
+ * NOTE: The datasheet recommends 300-600 mg and 100-350 ms.
+ *
+ * @param dev    ADXL345_DEVICE to configure
+ * @param config ADXL345_FREE_FALL_CONFIG with the threshold and time to use
+ */
+esp_err_t ADXL345_configureFreeFall(ADXL345_DEVICE *dev, const ADXL345_FREE_FALL_CONFIG *config) {
+    uint8_t freeFall[2] = {
+        ADXL345_ThresholdFromMg(config->thresholdMg),
+        ADXL345_Saturate8(config->timeMs / ADXL345_TIME_FF_MS_LSB)
+    };
+    return ADXL345_writeRegisters(dev, ADXL345_THRESH_FF, freeFall, sizeof(freeFall));
+}
+
+/**
+ * Routes and enables interrupts.  Interrupts not in the INT2 mask go to INT1.
+ * NOTE: INT_MAP is written before INT_ENABLE, as the datasheet recommends,
+ *       so an event can never fire on the wrong pin.
+ *
+ * @param dev        ADXL345_DEVICE to configure
+ * @param enableMask ADXL345_INT_* bits to enable
+ * @param int2Mask   ADXL345_INT_* bits to route to INT2
+ */
+esp_err_t ADXL345_setInterrupts(ADXL345_DEVICE *dev, uint8_t enableMask, uint8_t int2Mask) {
+    esp_err_t err = ADXL345_writeRegister(dev, ADXL345_INT_MAP, int2Mask);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return ADXL345_writeRegister(dev, ADXL345_INT_ENABLE, enableMask);
+}
+
+/**
+ * Initializes an empty event dispatcher for the param device.
+ *
+ * @param events ADXL345_EVENTS to initialize
+ * @param dev    ADXL345_DEVICE whose interrupts will be dispatched
+ */
+void ADXL345_eventsInit(ADXL345_EVENTS *events, ADXL345_DEVICE *dev) {
+    memset(events, 0, sizeof(*events));
+    events->dev = dev;
+#if ADXL345_EVENTS_GPIO
+    events->pin = GPIO_NUM_NC;
+#endif
+}
+
+/**
+ * Registers the callback to run when an event of the param type is read.
+ * Callbacks run on the dispatcher task, not in interrupt context, so they
+ * may talk to the sensor or block.
+ *
+ * @param events   ADXL345_EVENTS dispatcher
+ * @param type     ADXL345_EVENT_TYPE to handle
+ * @param callback Function to call, or NULL to ignore the event
+ * @param arg      Argument passed through to the callback
+ */
+void ADXL345_eventsRegister(ADXL345_EVENTS *events, ADXL345_EVENT_TYPE type, ADXL345_EVENT_CALLBACK callback,
+                            void *arg) {
+    if (type < ADXL345_EVENT_COUNT) {
+        events->callbacks[type] = callback;
+        events->args[type] = arg;
+    }
+}
+
+#if ADXL345_EVENTS_GPIO
+/**
+ * Starts a dispatcher task that sleeps until the param GPIO (wired to the
+ * ADXL345 INT1 or INT2 pin) is high, then services the sensor's interrupts.
+ * The pin is level triggered, so an event the service didn't clear, because
+ * a read failed or more kept arriving, can't leave it high with no edge
+ * left to wake the task.
+ * NOTE: The ADXL345 interrupt pins are active high unless INT_INVERT is set
+ *       in DATA_FORMAT.  Data ready, watermark and overrun only clear once
+ *       the FIFO has been read, so their callbacks must drain it.
+ *
+ * @param events   ADXL345_EVENTS dispatcher
+ * @param pin      GPIO connected to the sensor interrupt pin
+ * @param priority FreeRTOS priority of the dispatcher task
+ * @param core     Core to pin the dispatcher task to, or tskNO_AFFINITY
+ */
+esp_err_t ADXL345_eventsStart(ADXL345_EVENTS *events, gpio_num_t pin, UBaseType_t priority, BaseType_t core) {
+    events->pin = pin;
+
+    gpio_config_t pinConfig = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_HIGH_LEVEL,
+    };
+    esp_err_t err = gpio_config(&pinConfig);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The ISR service may already be installed by another driver, which is fine
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+
+    // The ISR notifies the task, so it has to exist before the handler is attached
+    if (xTaskCreatePinnedToCore(ADXL345_EventsTask, "adxl345_events", ADXL345_EVENTS_STACK_SIZE,
+                                events, priority, &events->task, core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    err = gpio_isr_handler_add(pin, ADXL345_EventsIsr, events);
+    if (err != ESP_OK) {
+        vTaskDelete(events->task);
+        events->task = NULL;
+        return err;
+    }
+
+    // Anything latched before the handler was attached
+    xTaskNotifyGive(events->task);
+    return ESP_OK;
+}
+#endif
+
+/**
+ * Reads and clears the sensor's pending interrupts, and runs the registered
+ * callback for each one.  Called by the dispatcher task, but can also be
+ * called directly to poll.
+ * NOTE: ACT_TAP_STATUS must be read before INT_SOURCE clears the event, so
+ *       0x2B through 0x30 are read as one burst, which covers both.
+ *
+ * @param events ADXL345_EVENTS dispatcher
+ */
+esp_err_t ADXL345_eventsService(ADXL345_EVENTS *events) {
+    for (int pass = 0; pass < ADXL345_MAX_SERVICE_PASSES; pass++) {
+        uint8_t regs[ADXL345_BURST_LENGTH(ADXL345_ACT_TAP_STATUS, ADXL345_INT_SOURCE)];
+        esp_err_t err = ADXL345_readRegisters(events->dev, ADXL345_ACT_TAP_STATUS, regs, sizeof(regs));
+        if (err != ESP_OK) {
+            return err;
+        }
+
+        uint8_t status = regs[0];
+        uint8_t enabled = regs[ADXL345_INT_ENABLE - ADXL345_ACT_TAP_STATUS];
+        uint8_t source = regs[ADXL345_INT_SOURCE - ADXL345_ACT_TAP_STATUS] & enabled;
+        events->enabled = enabled;
+        if (source == 0) {
+            return ESP_OK;
+        }
+
+        for (int type = ADXL345_EVENT_COUNT - 1; type >= 0; type--) {
+            if ((source & (1 << type)) == 0) {
+                continue;
+            }
+
+            ADXL345_EVENT event = {
+                .type = (ADXL345_EVENT_TYPE) type,
+                .axes = 0,
+                .asleep = (status & ADXL345_STATUS_ASLEEP) != 0,
+            };
+            if (type == ADXL345_EVENT_SINGLE_TAP || type == ADXL345_EVENT_DOUBLE_TAP) {
+                event.axes = status & ADXL345_AXIS_ALL;
+            } else if (type == ADXL345_EVENT_ACTIVITY) {
+                event.axes = (status >> 4) & ADXL345_AXIS_ALL;
+            }
+
+            events->counts[type]++;
+            if (events->callbacks[type] != NULL) {
+                events->callbacks[type](events->dev, &event, events->args[type]);
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Converts milli-g to a 62.5 mg/LSB threshold register value, rounding to
+ * the nearest step.
+ *
+ * @param milliG Threshold in milli-g
+ */
+static uint8_t ADXL345_ThresholdFromMg(uint16_t milliG) {
+    return ADXL345_Saturate8(((uint32_t) milliG * 2 + ADXL345_THRESH_HALF_MG / 2) / ADXL345_THRESH_HALF_MG);
+}
+
+/**
+ * Clamps the param value to the range of an 8 bit register.
+ *
+ * @param value Value to clamp
+ */
+static uint8_t ADXL345_Saturate8(uint32_t value) {
+    return (value > UINT8_MAX) ? UINT8_MAX : (uint8_t) value;
+}
+
+#if ADXL345_EVENTS_GPIO
+/**
+ * Dispatcher task, blocks until the interrupt pin is high, services the
+ * sensor and then lets the pin interrupt again.
+ *
+ * @param arg ADXL345_EVENTS dispatcher
+ */
+static void ADXL345_EventsTask(void *arg) {
+    ADXL345_EVENTS *events = (ADXL345_EVENTS *) arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (ADXL345_eventsService(events) != ESP_OK) {
+            vTaskDelay(ADXL345_SERVICE_RETRY_DELAY);
+        }
+        gpio_intr_enable(events->pin);
+    }
+}
+
+/**
+ * GPIO interrupt handler, hands off to the dispatcher task as I2C can't be
+ * used from interrupt context.  The pin stays high until the task has read
+ * INT_SOURCE, so the interrupt is masked until then.
+ *
+ * @param arg ADXL345_EVENTS dispatcher
+ */
+static void IRAM_ATTR ADXL345_EventsIsr(void *arg) {
+    ADXL345_EVENTS *events = (ADXL345_EVENTS *) arg;
+    BaseType_t higherPriorityWoken = pdFALSE;
+    gpio_intr_disable(events->pin);
+    vTaskNotifyGiveFromISR(events->task, &higherPriorityWoken);
+    portYIELD_FROM_ISR(higherPriorityWoken);
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+ * File:       ADXL345_events.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ADXL345.h"
+
+// Dispatching from an interrupt pin needs the GPIO driver, which the Linux
+// target doesn't have.  Configuration and ADXL345_eventsService still work.
+#if __has_include("driver/gpio.h")
+#include "driver/gpio.h"
+#define ADXL345_EVENTS_GPIO     1
+#else
+#define ADXL345_EVENTS_GPIO     0
+#endif
+
+// Event types are numbered by their bit position in INT_SOURCE.  Data ready,
+// watermark and overrun follow the FIFO rather than latching, so reading
+// INT_SOURCE doesn't clear them.  Their callbacks have to drain the FIFO, or
+// with the level triggered pin of ADXL345_eventsStart it fires again at once.
+typedef enum _adxl345EventType {
+    ADXL345_EVENT_OVERRUN = 0,
+    ADXL345_EVENT_WATERMARK,
+    ADXL345_EVENT_FREE_FALL,
+    ADXL345_EVENT_INACTIVITY,
+    ADXL345_EVENT_ACTIVITY,
+    ADXL345_EVENT_DOUBLE_TAP,
+    ADXL345_EVENT_SINGLE_TAP,
+    ADXL345_EVENT_DATA_READY,
+    ADXL345_EVENT_COUNT
+} ADXL345_EVENT_TYPE;
+
+typedef struct _adxl345Event {
+    ADXL345_EVENT_TYPE type;
+    // ADXL345_AXIS_* bits of the axes involved, for taps and activity
+    uint8_t axes;
+    // Whether the device reported itself asleep when the event was read
+    bool asleep;
+} ADXL345_EVENT;
+
+typedef void (*ADXL345_EVENT_CALLBACK)(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg);
+
+typedef struct _adxl345TapConfig {
+    uint16_t thresholdMg;
+    uint32_t durationUs;
+    uint32_t latencyUs;
+    uint32_t windowUs;
+    uint8_t axes;
+    bool suppressDouble;
+} ADXL345_TAP_CONFIG;
+
+typedef struct _adxl345ActivityConfig {
+    uint16_t activityThresholdMg;
+    uint16_t inactivityThresholdMg;
+    uint8_t inactivitySeconds;
+    uint8_t activityAxes;
+    uint8_t inactivityAxes;
+    bool activityAcCoupled;
+    bool inactivityAcCoupled;
+} ADXL345_ACTIVITY_CONFIG;
+
+typedef struct _adxl345FreeFallConfig {
+    uint16_t thresholdMg;
+    uint16_t timeMs;
+} ADXL345_FREE_FALL_CONFIG;
+
+typedef struct _adxl345Events {
+    ADXL345_DEVICE *dev;
+#if ADXL345_EVENTS_GPIO
+    gpio_num_t pin;
+#endif
+    TaskHandle_t task;
+    uint8_t enabled;
+    ADXL345_EVENT_CALLBACK callbacks[ADXL345_EVENT_COUNT];
+    void *args[ADXL345_EVENT_COUNT];
+    uint32_t counts[ADXL345_EVENT_COUNT];
+} ADXL345_EVENTS;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_configureTap(ADXL345_DEVICE *dev, const ADXL345_TAP_CONFIG *config);
+
+esp_err_t ADXL345_configureActivity(ADXL345_DEVICE *dev, const ADXL345_ACTIVITY_CONFIG *config);
+
+esp_err_t ADXL345_configureFreeFall(ADXL345_DEVICE *dev, const ADXL345_FREE_FALL_CONFIG *config);
+
+esp_err_t ADXL345_setInterrupts(ADXL345_DEVICE *dev, uint8_t enableMask, uint8_t int2Mask);
+
+void ADXL345_eventsInit(ADXL345_EVENTS *events, ADXL345_DEVICE *dev);
+
+void ADXL345_eventsRegister(ADXL345_EVENTS *events, ADXL345_EVENT_TYPE type, ADXL345_EVENT_CALLBACK callback, void *arg);
+
+#if ADXL345_EVENTS_GPIO
+esp_err_t ADXL345_eventsStart(ADXL345_EVENTS *events, gpio_num_t pin, UBaseType_t priority, BaseType_t core);
+#endif
+
+esp_err_t ADXL345_eventsService(ADXL345_EVENTS *events);
+
+// Interrupt bits, shared by INT_ENABLE, INT_MAP and INT_SOURCE
+#define ADXL345_INT_DATA_READY  0x80
+#define ADXL345_INT_SINGLE_TAP  0x40
+#define ADXL345_INT_DOUBLE_TAP  0x20
+#define ADXL345_INT_ACTIVITY    0x10
+#define ADXL345_INT_INACTIVITY  0x08
+#define ADXL345_INT_FREE_FALL   0x04
+#define ADXL345_INT_WATERMARK   0x02
+#define ADXL345_INT_OVERRUN     0x01
+
+// Axis bits, as used by TAP_AXES and the low nibble of ACT_INACT_CTL
+#define ADXL345_AXIS_X          0x04
+#define ADXL345_AXIS_Y          0x02
+#define ADXL345_AXIS_Z          0x01
+#define ADXL345_AXIS_ALL        0x07
+
+// Register scale factors
+// Thresholds are 62.5 mg/LSB, kept here in half milli-g
+#define ADXL345_THRESH_HALF_MG  125
+#define ADXL345_DUR_US_LSB      625
+#define ADXL345_LATENT_US_LSB   1250
+#define ADXL345_TIME_FF_MS_LSB  5
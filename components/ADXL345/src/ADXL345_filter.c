@@ -0,0 +1,351 @@
+/**
+ * File:       ADXL345_filter.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Streaming fixed point filters that run over ADXL345_BLOCKs.  Coefficients
+ * are designed in floating point once, every per sample path is integer only.
+ *
+ * The kernels are written so the compiler can vectorize them (fixed axis
+ * counts, restrict qualified pointers, no data dependent branches) rather
+ * than with target specific intrinsics, so the same source builds for the
+ * Xtensa and RISC-V ESP32 variants as well as for a Linux host.
+ */
+#include <string.h>
+#include <math.h>
+#include "ADXL345_filter.h"
+
+#define ADXL345_BUTTERWORTH_Q   0.70710678
+
+// 'Private' helpers designed for internal use
+static int ADXL345_Log2(int value);
+static void ADXL345_BiquadDesign(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz, bool highPass);
+static void ADXL345_AverageAxis(int16_t *restrict data, int count, int16_t *restrict history,
+                                int32_t *sum, int window, int shift);
+static int ADXL345_DecimateAxis(const int16_t *in, int count, int16_t *out, int32_t *acc,
+                                int phase, int factor, int shift);
+
+/**
+ * Saturates the param value to the int16_t range without branching.
+ *
+ * @param value Value to saturate
+ */
+static inline int16_t ADXL345_Sat16(int32_t value) {
+    value = (value > INT16_MAX) ? INT16_MAX : value;
+    value = (value < INT16_MIN) ? INT16_MIN : value;
+    return (int16_t) value;
+}
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes a moving average filter over the param window of samples.
+ * NOTE: The window must be a power of two no larger than
+ *       ADXL345_MAX_AVG_WINDOW, so that the average is a shift.
+ *
+ * @param filter ADXL345_MOVING_AVERAGE to initialize
+ * @param window Number of samples to average over
+ * @return true if the window was valid and the filter was initialized
+ */
+bool ADXL345_movingAverageInit(ADXL345_MOVING_AVERAGE *filter, int window) {
+    int shift = ADXL345_Log2(window);
+    if (shift < 0 || window > ADXL345_MAX_AVG_WINDOW) {
+        return false;
+    }
+
+    memset(filter, 0, sizeof(*filter));
+    filter->window = window;
+    filter->shift = shift;
+    return true;
+}
+
+/**
+ * Runs the param block through the moving average, in place.
+ *
+ * @param filter ADXL345_MOVING_AVERAGE holding the running state
+ * @param block  ADXL345_BLOCK to filter
+ */
+void ADXL345_movingAverageProcess(ADXL345_MOVING_AVERAGE *filter, ADXL345_BLOCK *block) {
+    ADXL345_AverageAxis(block->x, block->count, filter->history[0], &filter->sum[0], filter->window, filter->shift);
+    ADXL345_AverageAxis(block->y, block->count, filter->history[1], &filter->sum[1], filter->window, filter->shift);
+    ADXL345_AverageAxis(block->z, block->count, filter->history[2], &filter->sum[2], filter->window, filter->shift);
+}
+
+/**
+ * Designs a second order Butterworth low-pass section and resets its state.
+ *
+ * @param filter       ADXL345_BIQUAD to design
+ * @param sampleRateHz Rate the blocks are sampled at
+ * @param cutoffHz     -3dB cutoff frequency
+ */
+void ADXL345_biquadLowPass(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz) {
+    ADXL345_BiquadDesign(filter, sampleRateHz, cutoffHz, false);
+}
+
+/**
+ * Designs a second order Butterworth high-pass section and resets its state.
+ * Useful for stripping gravity out of vibration data.
+ *
+ * @param filter       ADXL345_BIQUAD to design
+ * @param sampleRateHz Rate the blocks are sampled at
+ * @param cutoffHz     -3dB cutoff frequency
+ */
+void ADXL345_biquadHighPass(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz) {
+    ADXL345_BiquadDesign(filter, sampleRateHz, cutoffHz, true);
+}
+
+/**
+ * Runs the param block through the biquad section, in place.
+ * NOTE: The recursion is serial in time, so the three axes are advanced
+ *       together in one loop instead; they are independent and give the
+ *       compiler three lanes of work per sample.  The output history keeps
+ *       ADXL345_BIQUAD_STATE_Q fraction bits, as rounding it to whole counts
+ *       leaves a DC error of several counts at low cutoffs.  The bits dropped
+ *       below that are fed back into the next output rather than rounded
+ *       away, otherwise a high-pass settles on a constant input to a small
+ *       offset (a deadband) instead of zero.
+ *
+ * @param filter ADXL345_BIQUAD holding the coefficients and state
+ * @param block  ADXL345_BLOCK to filter
+ */
+void ADXL345_biquadProcess(ADXL345_BIQUAD *filter, ADXL345_BLOCK *block) {
+    int16_t *axes[3] = { block->x, block->y, block->z };
+    const int64_t b0 = filter->b0;
+    const int64_t b1 = filter->b1;
+    const int64_t b2 = filter->b2;
+    const int64_t a1 = filter->a1;
+    const int64_t a2 = filter->a2;
+    const int64_t fraction = (1ll << ADXL345_BIQUAD_Q) - 1;
+    const int32_t outRounding = 1 << (ADXL345_BIQUAD_STATE_Q - 1);
+
+    for (int i = 0; i < block->count; i++) {
+        for (int axis = 0; axis < 3; axis++) {
+            int32_t x0 = axes[axis][i];
+            int64_t feedForward = (b0 * x0) + (b1 * filter->x1[axis]) + (b2 * filter->x2[axis]);
+            int64_t acc = (feedForward << ADXL345_BIQUAD_STATE_Q)
+                        - (a1 * filter->y1[axis]) - (a2 * filter->y2[axis]) + filter->error[axis];
+            int32_t y0 = (int32_t) (acc >> ADXL345_BIQUAD_Q);
+            filter->error[axis] = acc & fraction;
+
+            filter->x2[axis] = filter->x1[axis];
+            filter->x1[axis] = x0;
+            filter->y2[axis] = filter->y1[axis];
+            filter->y1[axis] = y0;
+            axes[axis][i] = ADXL345_Sat16((y0 + outRounding) >> ADXL345_BIQUAD_STATE_Q);
+        }
+    }
+}
+
+/**
+ * Initializes an N:1 averaging decimator.
+ * NOTE: The factor must be a power of two no larger than ADXL345_BLOCK_SIZE.
+ *
+ * @param decimator ADXL345_DECIMATOR to initialize
+ * @param factor    Number of input samples per output sample
+ * @return true if the factor was valid and the decimator was initialized
+ */
+bool ADXL345_decimatorInit(ADXL345_DECIMATOR *decimator, int factor) {
+    int shift = ADXL345_Log2(factor);
+    if (shift < 0 || factor > ADXL345_BLOCK_SIZE) {
+        return false;
+    }
+
+    memset(decimator, 0, sizeof(*decimator));
+    decimator->factor = factor;
+    decimator->shift = shift;
+    return true;
+}
+
+/**
+ * Decimates the param input block into the param output block.  Partial
+ * groups are carried over to the next call, so output is continuous across
+ * blocks.
+ * NOTE: in and out may be the same block, outputs never overtake inputs.
+ *
+ * @param decimator ADXL345_DECIMATOR holding the running state
+ * @param in        ADXL345_BLOCK to decimate
+ * @param out       ADXL345_BLOCK to store the decimated samples in
+ */
+void ADXL345_decimatorProcess(ADXL345_DECIMATOR *decimator, const ADXL345_BLOCK *in, ADXL345_BLOCK *out) {
+    int count = in->count;
+    int phase = decimator->phase;
+
+    ADXL345_DecimateAxis(in->x, count, out->x, &decimator->acc[0], phase, decimator->factor, decimator->shift);
+    ADXL345_DecimateAxis(in->y, count, out->y, &decimator->acc[1], phase, decimator->factor, decimator->shift);
+    out->count = ADXL345_DecimateAxis(in->z, count, out->z, &decimator->acc[2], phase,
+                                      decimator->factor, decimator->shift);
+
+    decimator->phase = (phase + count) & (decimator->factor - 1);
+}
+
+/**
+ * Initializes an empty pipeline, with every stage disabled.  Stages are
+ * enabled by initializing them in place and setting the matching flag/count.
+ *
+ * @param pipeline ADXL345_FILTER_PIPELINE to initialize
+ */
+void ADXL345_pipelineInit(ADXL345_FILTER_PIPELINE *pipeline) {
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+/**
+ * Runs the param block through every enabled stage, in place.  Stages run in
+ * the order moving average, biquads, decimator.
+ *
+ * @param pipeline ADXL345_FILTER_PIPELINE to run
+ * @param block    ADXL345_BLOCK to filter
+ */
+void ADXL345_pipelineProcess(ADXL345_FILTER_PIPELINE *pipeline, ADXL345_BLOCK *block) {
+    if (pipeline->averageEnabled) {
+        ADXL345_movingAverageProcess(&pipeline->average, block);
+    }
+    for (int i = 0; i < pipeline->numBiquads; i++) {
+        ADXL345_biquadProcess(&pipeline->biquads[i], block);
+    }
+    if (pipeline->decimatorEnabled) {
+        ADXL345_decimatorProcess(&pipeline->decimator, block, block);
+    }
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns log2 of the param value, or -1 if it is not a positive power of two.
+ *
+ * @param value Value to take the log of
+ */
+static int ADXL345_Log2(int value) {
+    if (value <= 0 || (value & (value - 1)) != 0) {
+        return -1;
+    }
+    int shift = 0;
+    while ((1 << shift) < value) {
+        shift++;
+    }
+    return shift;
+}
+
+/**
+ * Designs a Butterworth biquad using the RBJ audio EQ cookbook formulas, and
+ * quantizes the normalized coefficients to Q28.  The design is done in
+ * double precision, as single precision cosine loses the distance of low
+ * cutoff poles from the unit circle.
+ *
+ * @param filter       ADXL345_BIQUAD to design
+ * @param sampleRateHz Sample rate
+ * @param cutoffHz     Cutoff frequency
+ * @param highPass     true for high-pass, false for low-pass
+ */
+static void ADXL345_BiquadDesign(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz, bool highPass) {
+    double w0 = 2.0 * M_PI * cutoffHz / sampleRateHz;
+    double cosW0 = cos(w0);
+    double alpha = sin(w0) / (2.0 * ADXL345_BUTTERWORTH_Q);
+    double a0 = 1.0 + alpha;
+
+    double b0 = highPass ? (1.0 + cosW0) / 2.0 : (1.0 - cosW0) / 2.0;
+
+    const double scale = (double) (1 << ADXL345_BIQUAD_Q) / a0;
+    memset(filter, 0, sizeof(*filter));
+    filter->b0 = (int32_t) llround(b0 * scale);
+    filter->b2 = filter->b0;
+    filter->a1 = (int32_t) llround(-2.0 * cosW0 * scale);
+    filter->a2 = (int32_t) llround((1.0 - alpha) * scale);
+
+    // Rounding each coefficient on its own skews the DC gain noticeably at low
+    // cutoffs, so b1 absorbs the error: unity at DC for low-pass, zero for high-pass.
+    if (highPass) {
+        filter->b1 = -2 * filter->b0;
+    } else {
+        filter->b1 = (1 << ADXL345_BIQUAD_Q) + filter->a1 + filter->a2 - 2 * filter->b0;
+    }
+}
+
+/**
+ * Moving average over one axis.  The history and the new samples are laid
+ * end to end, the per sample change to the running sum is computed in one
+ * vectorizable pass, and a short serial prefix sum finishes the job.
+ *
+ * @param data    Axis samples, filtered in place
+ * @param count   Number of samples
+ * @param history Last window samples of the previous block, oldest first
+ * @param sum     Running sum of the history
+ * @param window  Window length
+ * @param shift   log2 of the window length
+ */
+static void ADXL345_AverageAxis(int16_t *restrict data, int count, int16_t *restrict history,
+                                int32_t *sum, int window, int shift) {
+    int16_t extended[ADXL345_MAX_AVG_WINDOW + ADXL345_BLOCK_SIZE];
+    int32_t delta[ADXL345_BLOCK_SIZE];
+
+    memcpy(extended, history, window * sizeof(int16_t));
+    memcpy(&extended[window], data, count * sizeof(int16_t));
+
+    for (int i = 0; i < count; i++) {
+        delta[i] = (int32_t) extended[i + window] - extended[i];
+    }
+
+    int32_t running = *sum;
+    for (int i = 0; i < count; i++) {
+        running += delta[i];
+        data[i] = (int16_t) (running >> shift);
+    }
+    *sum = running;
+
+    memcpy(history, &extended[count], window * sizeof(int16_t));
+}
+
+/**
+ * Decimates one axis.  A partial group left over from the previous block is
+ * completed first, then whole groups are summed with a fixed length inner
+ * loop, and any tail is carried in the accumulator.
+ *
+ * @param in     Input axis samples
+ * @param count  Number of input samples
+ * @param out    Output axis samples
+ * @param acc    Accumulator for the partial group carried between blocks
+ * @param phase  Number of samples already in the accumulator
+ * @param factor Decimation factor
+ * @param shift  log2 of the decimation factor
+ * @return Number of output samples written
+ */
+static int ADXL345_DecimateAxis(const int16_t *in, int count, int16_t *out, int32_t *acc,
+                                int phase, int factor, int shift) {
+    int produced = 0;
+    int i = 0;
+    int32_t partial = *acc;
+
+    if (phase > 0) {
+        int need = factor - phase;
+        if (need > count) {
+            need = count;
+        }
+        for (; i < need; i++) {
+            partial += in[i];
+        }
+        if (phase + need < factor) {
+            *acc = partial;
+            return 0;
+        }
+        out[produced++] = (int16_t) (partial >> shift);
+        partial = 0;
+    }
+
+    for (; i + factor <= count; i += factor) {
+        int32_t groupSum = 0;
+        for (int j = 0; j < factor; j++) {
+            groupSum += in[i + j];
+        }
+        out[produced++] = (int16_t) (groupSum >> shift);
+    }
+
+    for (; i < count; i++) {
+        partial += in[i];
+    }
+    *acc = partial;
+    return produced;
+}
@@ -0,0 +1,79 @@
+/**
+ * File:       ADXL345_filter.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ADXL345.h"
+
+// Biquad coefficients are Q28, which covers the +/-2 range the feedback
+// coefficients need for any stable second order section, and still places
+// the poles of a 0.5 Hz section at 3200 Hz inside the unit circle.
+#define ADXL345_BIQUAD_Q        28
+#define ADXL345_BIQUAD_STATE_Q  8
+#define ADXL345_MAX_AVG_WINDOW  32
+#define ADXL345_MAX_BIQUADS     2
+
+typedef struct _adxl345MovingAverage {
+    int window;
+    int shift;
+    int32_t sum[3];
+    int16_t history[3][ADXL345_MAX_AVG_WINDOW];
+} ADXL345_MOVING_AVERAGE;
+
+typedef struct _adxl345Biquad {
+    int32_t b0;
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;
+    int32_t a2;
+    // Direct form I history per axis, outputs carry ADXL345_BIQUAD_STATE_Q fraction bits
+    int32_t x1[3];
+    int32_t x2[3];
+    int32_t y1[3];
+    int32_t y2[3];
+    // Fraction bits the last output dropped, added back into the next one
+    int32_t error[3];
+} ADXL345_BIQUAD;
+
+typedef struct _adxl345Decimator {
+    int factor;
+    int shift;
+    int phase;
+    int32_t acc[3];
+} ADXL345_DECIMATOR;
+
+typedef struct _adxl345FilterPipeline {
+    bool averageEnabled;
+    ADXL345_MOVING_AVERAGE average;
+    int numBiquads;
+    ADXL345_BIQUAD biquads[ADXL345_MAX_BIQUADS];
+    bool decimatorEnabled;
+    ADXL345_DECIMATOR decimator;
+} ADXL345_FILTER_PIPELINE;
+
+
+// Public methods designed for the user to call
+bool ADXL345_movingAverageInit(ADXL345_MOVING_AVERAGE *filter, int window);
+
+void ADXL345_movingAverageProcess(ADXL345_MOVING_AVERAGE *filter, ADXL345_BLOCK *block);
+
+void ADXL345_biquadLowPass(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz);
+
+void ADXL345_biquadHighPass(ADXL345_BIQUAD *filter, float sampleRateHz, float cutoffHz);
+
+void ADXL345_biquadProcess(ADXL345_BIQUAD *filter, ADXL345_BLOCK *block);
+
+bool ADXL345_decimatorInit(ADXL345_DECIMATOR *decimator, int factor);
+
+void ADXL345_decimatorProcess(ADXL345_DECIMATOR *decimator, const ADXL345_BLOCK *in, ADXL345_BLOCK *out);
+
+void ADXL345_pipelineInit(ADXL345_FILTER_PIPELINE *pipeline);
+
+void ADXL345_pipelineProcess(ADXL345_FILTER_PIPELINE *pipeline, ADXL345_BLOCK *block);
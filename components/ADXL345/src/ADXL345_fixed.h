@@ -0,0 +1,63 @@
+/**
+ * File:       ADXL345_fixed.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Integer square root, rounded down.  Bit by bit method, one step per pair
+ * of bits from the highest set one down, so at most 32 steps and fewer for
+ * small values.
+ *
+ * @param value Value to take the square root of
+ */
+static inline uint32_t ADXL345_isqrt64(uint64_t value) {
+    uint64_t result = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t) result;
+}
+
+/**
+ * Integer square root of a 32 bit value, rounded down.  Cheaper than
+ * ADXL345_isqrt64 on 32 bit cores, where 64 bit shifts and compares are
+ * synthesized from pairs of instructions.
+ *
+ * @param value Value to take the square root of
+ */
+static inline uint32_t ADXL345_isqrt32(uint32_t value) {
+    uint32_t result = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
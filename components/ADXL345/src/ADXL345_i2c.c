@@ -0,0 +1,344 @@
+/**
+ * File:       ADXL345_i2c.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * I2C backends for ADXL345_TRANSPORT, on the ESP-IDF i2c_master driver.
+ *
+ * The synchronous backend is a thin wrapper around i2c_master_transmit and
+ * i2c_master_transmit_receive.  The async backend needs a bus created with
+ * trans_queue_depth, which puts the driver into queued mode for every
+ * device on the bus: each transfer returns immediately and completes from
+ * the I2C ISR.  The backend registers an on_trans_done callback on its
+ * device to learn when its own transfers complete.  Synchronous calls on an
+ * async device queue a transfer and wait for it.
+ *
+ * Every transfer is bounded by ADXL345_I2C_TIMEOUT_MS, and a synchronous
+ * wait on an async device by that for every transfer queued ahead of it.
+ * A synchronous transfer on an async device goes through buffers the
+ * transport owns, so when its wait times out the transfer can still finish
+ * without writing to the caller's memory.  The async backend
+ * can also recover the bus with i2c_master_bus_reset, which clocks SCL until
+ * a slave holding SDA low lets go and then resets the controller.  The
+ * synchronous backend only has the device handle, so recovering its bus is
+ * left to whoever owns the bus.
+ */
+#include <string.h>
+#include "ADXL345_i2c.h"
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_I2cWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_I2cWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_I2cAsyncWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_I2cAsyncWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_I2cAsyncSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                        ADXL345_TRANSPORT_DONE done, void *arg);
+static esp_err_t ADXL345_I2cAsyncWait(ADXL345_I2C_ASYNC *async, const uint8_t *tx, size_t txLength,
+                                      uint8_t *rx, size_t rxLength);
+static bool ADXL345_I2cAsyncAwait(ADXL345_I2C_ASYNC *async, uint32_t ticket);
+static TickType_t ADXL345_I2cAsyncBudget(ADXL345_I2C_ASYNC *async);
+static esp_err_t ADXL345_I2cAsyncRecover(void *ctx);
+static bool ADXL345_I2cSyncDone(esp_err_t result, void *arg);
+static bool ADXL345_I2cTransDone(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *event, void *arg);
+
+static const ADXL345_TRANSPORT_OPS ADXL345_I2C_OPS = {
+    .write = ADXL345_I2cWrite,
+    .writeRead = ADXL345_I2cWriteRead,
+    .submitWriteRead = NULL,
+    .recover = NULL,
+};
+
+static const ADXL345_TRANSPORT_OPS ADXL345_I2C_ASYNC_OPS = {
+    .write = ADXL345_I2cAsyncWrite,
+    .writeRead = ADXL345_I2cAsyncWriteRead,
+    .submitWriteRead = ADXL345_I2cAsyncSubmit,
+    .recover = ADXL345_I2cAsyncRecover,
+};
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the param device on an already registered I2C device handle,
+ * using a synchronous I2C transport.
+ *
+ * @param dev    ADXL345_DEVICE to initialize
+ * @param handle I2C device handle from i2c_master_bus_add_device
+ * @param config ADXL345_CONFIG to apply to the sensor
+ */
+esp_err_t ADXL345_init(ADXL345_DEVICE *dev, i2c_master_dev_handle_t handle, const ADXL345_CONFIG *config) {
+    ADXL345_TRANSPORT transport;
+    ADXL345_i2cTransport(&transport, handle);
+    return ADXL345_initTransport(dev, &transport, config);
+}
+
+/**
+ * Sets up a synchronous transport on an I2C device handle.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param handle    I2C device handle from i2c_master_bus_add_device
+ */
+void ADXL345_i2cTransport(ADXL345_TRANSPORT *transport, i2c_master_dev_handle_t handle) {
+    transport->ops = &ADXL345_I2C_OPS;
+    transport->ctx = handle;
+}
+
+/**
+ * Sets up an asynchronous transport on an I2C device handle, so that FIFO
+ * drains can be queued with ADXL345_readFifoStart while the CPU does other
+ * work.
+ * NOTE: The bus must have been created with trans_queue_depth of at least
+ *       ADXL345_I2C_QUEUE_DEPTH, and the device handle must not be used
+ *       outside this transport afterwards.  Every other device on the bus is
+ *       queued too, so their drivers have to wait for their own transfers.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param async     ADXL345_I2C_ASYNC state, must outlive the transport
+ * @param bus       I2C bus handle the device is on, reset to recover the bus
+ * @param handle    I2C device handle from i2c_master_bus_add_device
+ */
+esp_err_t ADXL345_i2cAsyncTransport(ADXL345_TRANSPORT *transport, ADXL345_I2C_ASYNC *async,
+                                    i2c_master_bus_handle_t bus, i2c_master_dev_handle_t handle) {
+    memset(async, 0, sizeof(*async));
+    async->bus = bus;
+    async->handle = handle;
+    atomic_init(&async->head, 0);
+    atomic_init(&async->tail, 0);
+    atomic_init(&async->syncCompleted, 0);
+
+    async->lock = xSemaphoreCreateMutex();
+    async->waitLock = xSemaphoreCreateMutex();
+    async->syncDone = xSemaphoreCreateBinary();
+    if (async->lock == NULL || async->waitLock == NULL || async->syncDone == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2c_master_event_callbacks_t callbacks = {
+        .on_trans_done = ADXL345_I2cTransDone,
+    };
+    esp_err_t err = i2c_master_register_event_callbacks(handle, &callbacks, async);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    transport->ops = &ADXL345_I2C_ASYNC_OPS;
+    transport->ctx = async;
+    return ESP_OK;
+}
+
+/**
+ * Moves an async transport over to a new handle for the same device, e.g.
+ * after the bus speed has been changed by re-adding it.
+ * NOTE: Nothing may be queued on the old handle, which has already gone.
+ *
+ * @param async  ADXL345_I2C_ASYNC state of the transport
+ * @param handle New I2C device handle, or NULL if the device was lost, after
+ *               which every transfer fails with ESP_ERR_INVALID_STATE
+ */
+esp_err_t ADXL345_i2cAsyncRebind(ADXL345_I2C_ASYNC *async, i2c_master_dev_handle_t handle) {
+    i2c_master_event_callbacks_t callbacks = {
+        .on_trans_done = ADXL345_I2cTransDone,
+    };
+
+    xSemaphoreTake(async->lock, portMAX_DELAY);
+    esp_err_t err = (handle != NULL) ? i2c_master_register_event_callbacks(handle, &callbacks, async) : ESP_OK;
+    if (err == ESP_OK) {
+        async->handle = handle;
+    }
+    xSemaphoreGive(async->lock);
+    return err;
+}
+
+
+// 'Private' functions designed for internal use
+
+// Transport ops, synchronous calls on an async device go through ADXL345_I2cAsyncWait
+static esp_err_t ADXL345_I2cWrite(void *ctx, const uint8_t *data, size_t length) {
+    return i2c_master_transmit((i2c_master_dev_handle_t) ctx, data, length, ADXL345_I2C_TIMEOUT_MS);
+}
+
+static esp_err_t ADXL345_I2cWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    return i2c_master_transmit_receive((i2c_master_dev_handle_t) ctx, tx, txLength, rx, rxLength,
+                                       ADXL345_I2C_TIMEOUT_MS);
+}
+
+static esp_err_t ADXL345_I2cAsyncWrite(void *ctx, const uint8_t *data, size_t length) {
+    return ADXL345_I2cAsyncWait((ADXL345_I2C_ASYNC *) ctx, data, length, NULL, 0);
+}
+
+static esp_err_t ADXL345_I2cAsyncWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    return ADXL345_I2cAsyncWait((ADXL345_I2C_ASYNC *) ctx, tx, txLength, rx, rxLength);
+}
+
+/**
+ * Queues a transfer with the I2C driver, recording its completion callback
+ * in the pending ring first, as the transfer may finish before the driver
+ * call returns.
+ */
+static esp_err_t ADXL345_I2cAsyncSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                        ADXL345_TRANSPORT_DONE done, void *arg) {
+    ADXL345_I2C_ASYNC *async = (ADXL345_I2C_ASYNC *) ctx;
+    esp_err_t err;
+
+    xSemaphoreTake(async->lock, portMAX_DELAY);
+    if (async->handle == NULL) {
+        xSemaphoreGive(async->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    unsigned head = atomic_load_explicit(&async->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&async->tail, memory_order_acquire) >= ADXL345_I2C_QUEUE_DEPTH) {
+        xSemaphoreGive(async->lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    async->pending[head % ADXL345_I2C_QUEUE_DEPTH] = (ADXL345_I2C_PENDING) { done, arg };
+    atomic_store_explicit(&async->head, head + 1, memory_order_release);
+
+    if (rxLength > 0) {
+        err = i2c_master_transmit_receive(async->handle, tx, txLength, rx, rxLength, ADXL345_I2C_TIMEOUT_MS);
+    } else {
+        err = i2c_master_transmit(async->handle, tx, txLength, ADXL345_I2C_TIMEOUT_MS);
+    }
+    if (err != ESP_OK) {
+        // Never queued, so no completion will arrive for it
+        atomic_store_explicit(&async->head, head, memory_order_release);
+    }
+    xSemaphoreGive(async->lock);
+    return err;
+}
+
+/**
+ * Queues a transfer and blocks until it completes.  Only one synchronous
+ * transfer is waited on at a time, async submissions may still be queued
+ * around it.  The transfer is made from the transport's own buffers, which
+ * an earlier transfer that timed out may still hold, so that one is waited
+ * for first.
+ */
+static esp_err_t ADXL345_I2cAsyncWait(ADXL345_I2C_ASYNC *async, const uint8_t *tx, size_t txLength,
+                                      uint8_t *rx, size_t rxLength) {
+    if (txLength > sizeof(async->syncTx) || rxLength > sizeof(async->syncRx)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(async->waitLock, portMAX_DELAY);
+    esp_err_t err = ESP_ERR_TIMEOUT;
+    if (ADXL345_I2cAsyncAwait(async, async->syncIssued)) {
+        memcpy(async->syncTx, tx, txLength);
+        err = ADXL345_I2cAsyncSubmit(async, async->syncTx, txLength, async->syncRx, rxLength,
+                                     ADXL345_I2cSyncDone, async);
+    }
+    if (err == ESP_OK) {
+        uint32_t ticket = ++async->syncIssued;
+        if (!ADXL345_I2cAsyncAwait(async, ticket)) {
+            err = ESP_ERR_TIMEOUT;
+        } else {
+            err = async->syncResult;
+            if (err == ESP_OK && rxLength > 0) {
+                memcpy(rx, async->syncRx, rxLength);
+            }
+        }
+    }
+    xSemaphoreGive(async->waitLock);
+    return err;
+}
+
+/**
+ * Blocks until the synchronous transfer with the param ticket has completed,
+ * for no longer than everything queued could take.  Completions of earlier
+ * transfers that timed out also wake the wait, and are skipped.
+ *
+ * @param async  ADXL345_I2C_ASYNC state, with waitLock held
+ * @param ticket Number of the transfer, 0 before the first
+ * @return true if it completed, false if the wait timed out
+ */
+static bool ADXL345_I2cAsyncAwait(ADXL345_I2C_ASYNC *async, uint32_t ticket) {
+    TickType_t budget = ADXL345_I2cAsyncBudget(async);
+    TickType_t start = xTaskGetTickCount();
+    while ((int32_t) (atomic_load_explicit(&async->syncCompleted, memory_order_acquire) - ticket) < 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= budget || xSemaphoreTake(async->syncDone, budget - elapsed) != pdTRUE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns how long everything queued could take to finish, as the driver
+ * bounds each queued transfer by ADXL345_I2C_TIMEOUT_MS on its own.
+ */
+static TickType_t ADXL345_I2cAsyncBudget(ADXL345_I2C_ASYNC *async) {
+    unsigned queued = atomic_load_explicit(&async->head, memory_order_relaxed) -
+                      atomic_load_explicit(&async->tail, memory_order_acquire);
+    if (queued == 0) {
+        queued = 1;
+    }
+    return pdMS_TO_TICKS(queued * ADXL345_I2C_TIMEOUT_MS);
+}
+
+/**
+ * Lets anything still queued finish or time out, then resets the bus.  Any
+ * transfer the reset cut short is forgotten, so that a late completion
+ * can't be handed to a transfer queued afterwards.  Holds waitLock too, so
+ * that no synchronous wait is left looking for a forgotten transfer.
+ */
+static esp_err_t ADXL345_I2cAsyncRecover(void *ctx) {
+    ADXL345_I2C_ASYNC *async = (ADXL345_I2C_ASYNC *) ctx;
+
+    xSemaphoreTake(async->waitLock, portMAX_DELAY);
+    xSemaphoreTake(async->lock, portMAX_DELAY);
+    i2c_master_bus_wait_all_done(async->bus, ADXL345_I2cAsyncBudget(async) * portTICK_PERIOD_MS);
+    esp_err_t err = i2c_master_bus_reset(async->bus);
+    atomic_store_explicit(&async->tail, atomic_load_explicit(&async->head, memory_order_relaxed),
+                          memory_order_release);
+    atomic_store_explicit(&async->syncCompleted, async->syncIssued, memory_order_release);
+    xSemaphoreGive(async->lock);
+    xSemaphoreGive(async->waitLock);
+    return err;
+}
+
+static bool ADXL345_I2cSyncDone(esp_err_t result, void *arg) {
+    ADXL345_I2C_ASYNC *async = (ADXL345_I2C_ASYNC *) arg;
+    BaseType_t woken = pdFALSE;
+
+    async->syncResult = result;
+    atomic_fetch_add_explicit(&async->syncCompleted, 1, memory_order_release);
+    xSemaphoreGiveFromISR(async->syncDone, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * I2C driver completion callback, runs in the I2C ISR.  Hands the result to
+ * the oldest pending transfer.
+ */
+static bool ADXL345_I2cTransDone(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *event, void *arg) {
+    ADXL345_I2C_ASYNC *async = (ADXL345_I2C_ASYNC *) arg;
+
+    esp_err_t result;
+    switch (event->event) {
+        case I2C_EVENT_DONE:
+            result = ESP_OK;
+            break;
+        case I2C_EVENT_TIMEOUT:
+            result = ESP_ERR_TIMEOUT;
+            break;
+        case I2C_EVENT_NACK:
+            result = ESP_ERR_INVALID_RESPONSE;
+            break;
+        default:
+            // Progress notifications, the transfer isn't finished yet
+            return false;
+    }
+
+    unsigned tail = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&async->head, memory_order_acquire)) {
+        return false;
+    }
+    ADXL345_I2C_PENDING pending = async->pending[tail % ADXL345_I2C_QUEUE_DEPTH];
+    atomic_store_explicit(&async->tail, tail + 1, memory_order_release);
+
+    return pending.done(result, pending.arg);
+}
@@ -0,0 +1,68 @@
+/**
+ * File:       ADXL345_i2c.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ADXL345_transport.h"
+#include "ADXL345.h"
+
+// Transfers that can be in flight at once on an async device.  The bus must
+// be created with trans_queue_depth of at least this.
+#define ADXL345_I2C_QUEUE_DEPTH 34
+// Largest synchronous transfer on an async device, a register address and a
+// full burst write, or a read of the whole register map
+#define ADXL345_I2C_SYNC_MAX_TX (ADXL345_MAX_BURST_WRITE + 1)
+#define ADXL345_I2C_SYNC_MAX_RX ADXL345_REGISTER_COUNT
+
+typedef struct _adxl345I2cPending {
+    ADXL345_TRANSPORT_DONE done;
+    void *arg;
+} ADXL345_I2C_PENDING;
+
+typedef struct _adxl345I2cAsync {
+    i2c_master_bus_handle_t bus;
+    i2c_master_dev_handle_t handle;
+    // Completions arrive in submission order, so a ring is enough to match
+    // each one to its caller
+    ADXL345_I2C_PENDING pending[ADXL345_I2C_QUEUE_DEPTH];
+    atomic_uint head;
+    atomic_uint tail;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t waitLock;
+    SemaphoreHandle_t syncDone;
+    esp_err_t syncResult;
+    // Synchronous transfers are queued from these rather than the caller's
+    // buffers, so one that times out can't touch memory its caller has
+    // since reused.  They stay the transfer's until it completes.
+    uint8_t syncTx[ADXL345_I2C_SYNC_MAX_TX];
+    uint8_t syncRx[ADXL345_I2C_SYNC_MAX_RX];
+    // Synchronous transfers queued and completed, each wait looks for its own
+    uint32_t syncIssued;
+    atomic_uint syncCompleted;
+} ADXL345_I2C_ASYNC;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_init(ADXL345_DEVICE *dev, i2c_master_dev_handle_t handle, const ADXL345_CONFIG *config);
+
+void ADXL345_i2cTransport(ADXL345_TRANSPORT *transport, i2c_master_dev_handle_t handle);
+
+esp_err_t ADXL345_i2cAsyncTransport(ADXL345_TRANSPORT *transport, ADXL345_I2C_ASYNC *async,
+                                    i2c_master_bus_handle_t bus, i2c_master_dev_handle_t handle);
+
+esp_err_t ADXL345_i2cAsyncRebind(ADXL345_I2C_ASYNC *async, i2c_master_dev_handle_t handle);
+
+// Constants for calculations
+// Deadline for a single transaction.  The longest the driver makes is a 32
+// byte read, about 3 ms at 100 kHz.  A wait on an async device allows this
+// for every transfer queued ahead of it too.
+#define ADXL345_I2C_TIMEOUT_MS  20
@@ -0,0 +1,714 @@
+/**
+ * File:       ADXL345_logformat.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include <stdbool.h>
+#include "ADXL345_logformat.h"
+
+#define ADXL345_LOG_MODE_K          0x1F
+#define ADXL345_LOG_MODE_SHIFT      0x60
+#define ADXL345_LOG_MODE_SHIFT_POS  5
+#define ADXL345_LOG_MODE_PREDICTED  0x80
+// Offset, first and second order, the best fit, and the best fit oscillator at each smoothing gain
+#define ADXL345_LOG_CANDIDATES      (4 + ADXL345_LOG_MAX_GAIN_SHIFT)
+// Rice parameters either side of the one the mean suggests that are costed
+#define ADXL345_LOG_K_SEARCH        2
+
+typedef struct _adxl345LogPredictor {
+    bool predicted;
+    // Offset records code each sample against base
+    int16_t base;
+    // Predicted records code each sample against a1 and a2 times the two
+    // estimates before it, each estimate moving 1 / 2^shift of the way to its sample
+    int16_t a1;
+    int16_t a2;
+    int shift;
+} ADXL345_LOG_PREDICTOR;
+
+typedef struct _adxl345BitWriter {
+    uint8_t *out;
+    size_t capacity;
+    size_t length;
+    uint32_t acc;
+    int bits;
+} ADXL345_BIT_WRITER;
+
+typedef struct _adxl345BitReader {
+    const uint8_t *in;
+    size_t length;
+    size_t offset;
+    uint32_t acc;
+    int bits;
+} ADXL345_BIT_READER;
+
+// 'Private' helpers designed for internal use
+static int ADXL345_EncodeAxis(const int16_t *samples, int count, uint8_t *out, size_t capacity);
+static int ADXL345_DecodeAxis(const uint8_t *in, size_t length, int count, int16_t *samples);
+static int ADXL345_Residuals(const int16_t *samples, int count, const ADXL345_LOG_PREDICTOR *predictor,
+                             uint32_t *values);
+static uint32_t ADXL345_RiceCost(const uint32_t *values, int count, int *k);
+static bool ADXL345_FitPredictor(const int16_t *samples, int count, ADXL345_LOG_PREDICTOR *predictor);
+static bool ADXL345_FitOscillator(const int16_t *samples, int count, ADXL345_LOG_PREDICTOR *predictor);
+static int ADXL345_BitWidth(uint32_t value);
+static int ADXL345_PutBits(ADXL345_BIT_WRITER *writer, uint32_t value, int width);
+static int ADXL345_FlushBits(ADXL345_BIT_WRITER *writer);
+static int ADXL345_GetBits(ADXL345_BIT_READER *reader, int width, uint32_t *value);
+static int ADXL345_PutRice(ADXL345_BIT_WRITER *writer, uint32_t value, int k);
+static int ADXL345_GetRice(ADXL345_BIT_READER *reader, int k, uint32_t *value);
+
+/**
+ * Maps a signed value to unsigned so small magnitudes of either sign stay small.
+ *
+ * @param value Value to encode
+ */
+static inline uint32_t ADXL345_ZigZag(int32_t value) {
+    return ((uint32_t) value << 1) ^ (uint32_t) (value >> 31);
+}
+
+/**
+ * Inverse of ADXL345_ZigZag.
+ *
+ * @param value Value to decode
+ */
+static inline int32_t ADXL345_UnZigZag(uint32_t value) {
+    return (int32_t) (value >> 1) ^ -(int32_t) (value & 1);
+}
+
+/**
+ * Predicts the next sample from the two estimates before it.  The encoder and
+ * decoder both use this and ADXL345_Update, so their arithmetic is part of
+ * the format.
+ *
+ * @param predictor ADXL345_LOG_PREDICTOR with the coefficients
+ * @param estimates The last two estimates, newest first, in Q4
+ * @param estimate  Pointer to store the unrounded prediction in, in Q4
+ * @return The prediction, within the int16_t range
+ */
+static inline int32_t ADXL345_Predict(const ADXL345_LOG_PREDICTOR *predictor, const int32_t *estimates,
+                                      int32_t *estimate) {
+    int64_t sum = (int64_t) predictor->a1 * estimates[0] + (int64_t) predictor->a2 * estimates[1];
+    int64_t next = (sum + (1 << (ADXL345_LOG_COEFF_Q - 1))) >> ADXL345_LOG_COEFF_Q;
+    const int64_t lowest = (int64_t) INT16_MIN * (1 << ADXL345_LOG_ESTIMATE_Q);
+    const int64_t highest = (int64_t) INT16_MAX * (1 << ADXL345_LOG_ESTIMATE_Q);
+    *estimate = (int32_t) ((next < lowest) ? lowest : (next > highest) ? highest : next);
+    return (*estimate + (1 << (ADXL345_LOG_ESTIMATE_Q - 1))) >> ADXL345_LOG_ESTIMATE_Q;
+}
+
+/**
+ * Moves the estimates on by one sample, the new estimate 1 / 2^shift of the
+ * way from the prediction to the sample.
+ *
+ * @param predictor ADXL345_LOG_PREDICTOR with the shift
+ * @param estimates The last two estimates, newest first, in Q4
+ * @param estimate  Unrounded prediction from ADXL345_Predict
+ * @param sample    The sample that was predicted
+ */
+static inline void ADXL345_Update(const ADXL345_LOG_PREDICTOR *predictor, int32_t *estimates, int32_t estimate,
+                                  int16_t sample) {
+    estimates[1] = estimates[0];
+    estimates[0] = estimate + ((sample * (1 << ADXL345_LOG_ESTIMATE_Q) - estimate) >> predictor->shift);
+}
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Encodes the param frame into the param buffer.
+ *
+ * @param frame    ADXL345_LOG_FRAME to encode, with 1 to ADXL345_LOG_FRAME_SAMPLES samples
+ * @param out      Buffer to encode into
+ * @param capacity Size of the buffer
+ * @return Number of bytes written, or 0 if the frame did not fit
+ */
+size_t ADXL345_logEncodeFrame(const ADXL345_LOG_FRAME *frame, uint8_t *out, size_t capacity) {
+    if (frame->count <= 0 || frame->count > ADXL345_LOG_FRAME_SAMPLES ||
+        capacity < ADXL345_LOG_HEADER_SIZE + ADXL345_LOG_CRC_SIZE) {
+        return 0;
+    }
+
+    size_t payloadCapacity = capacity - ADXL345_LOG_HEADER_SIZE - ADXL345_LOG_CRC_SIZE;
+    size_t payloadLength = 0;
+    const int16_t *axes[3] = { frame->x, frame->y, frame->z };
+    for (int axis = 0; axis < 3; axis++) {
+        int written = ADXL345_EncodeAxis(axes[axis], frame->count, &out[ADXL345_LOG_HEADER_SIZE + payloadLength],
+                                         payloadCapacity - payloadLength);
+        if (written < 0) {
+            return 0;
+        }
+        payloadLength += written;
+    }
+
+    uint64_t timestamp = (uint64_t) frame->timestampUs;
+    out[0] = ADXL345_LOG_MAGIC;
+    out[1] = ADXL345_LOG_VERSION;
+    out[2] = frame->rateCode;
+    out[3] = (uint8_t) frame->count;
+    for (int i = 0; i < 8; i++) {
+        out[4 + i] = (uint8_t) (timestamp >> (8 * i));
+    }
+    out[12] = (uint8_t) payloadLength;
+    out[13] = (uint8_t) (payloadLength >> 8);
+
+    size_t crcOffset = ADXL345_LOG_HEADER_SIZE + payloadLength;
+    uint16_t crc = ADXL345_logCrc16(0xFFFF, out, crcOffset);
+    out[crcOffset] = (uint8_t) crc;
+    out[crcOffset + 1] = (uint8_t) (crc >> 8);
+    return crcOffset + ADXL345_LOG_CRC_SIZE;
+}
+
+/**
+ * Decodes a single frame from the start of the param buffer.
+ *
+ * @param data   Buffer starting at a frame's magic byte
+ * @param length Bytes available in the buffer
+ * @param frame  ADXL345_LOG_FRAME to decode into
+ * @param stats  ADXL345_LOG_DECODE_STATS to count errors in, may be NULL
+ * @return Length of the frame in bytes, or 0 if no valid frame was found
+ */
+size_t ADXL345_logDecodeFrame(const uint8_t *data, size_t length, ADXL345_LOG_FRAME *frame, ADXL345_LOG_DECODE_STATS *stats) {
+    if (length < ADXL345_LOG_HEADER_SIZE + ADXL345_LOG_CRC_SIZE || data[0] != ADXL345_LOG_MAGIC ||
+        data[1] != ADXL345_LOG_VERSION || data[3] == 0 || data[3] > ADXL345_LOG_FRAME_SAMPLES) {
+        if (stats != NULL) {
+            stats->formatErrors++;
+        }
+        return 0;
+    }
+
+    size_t payloadLength = data[12] | ((size_t) data[13] << 8);
+    size_t crcOffset = ADXL345_LOG_HEADER_SIZE + payloadLength;
+    if (crcOffset + ADXL345_LOG_CRC_SIZE > length) {
+        if (stats != NULL) {
+            stats->formatErrors++;
+        }
+        return 0;
+    }
+
+    uint16_t crc = data[crcOffset] | ((uint16_t) data[crcOffset + 1] << 8);
+    if (ADXL345_logCrc16(0xFFFF, data, crcOffset) != crc) {
+        if (stats != NULL) {
+            stats->crcErrors++;
+        }
+        return 0;
+    }
+
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 8; i++) {
+        timestamp |= (uint64_t) data[4 + i] << (8 * i);
+    }
+    frame->timestampUs = (int64_t) timestamp;
+    frame->rateCode = data[2];
+    frame->count = data[3];
+
+    const uint8_t *payload = &data[ADXL345_LOG_HEADER_SIZE];
+    size_t used = 0;
+    int16_t *axes[3] = { frame->x, frame->y, frame->z };
+    for (int axis = 0; axis < 3; axis++) {
+        int consumed = ADXL345_DecodeAxis(&payload[used], payloadLength - used, frame->count, axes[axis]);
+        if (consumed < 0) {
+            if (stats != NULL) {
+                stats->formatErrors++;
+            }
+            return 0;
+        }
+        used += consumed;
+    }
+
+    if (stats != NULL) {
+        stats->frames++;
+        stats->samples += frame->count;
+    }
+    return crcOffset + ADXL345_LOG_CRC_SIZE;
+}
+
+/**
+ * Decodes every frame in a buffer of whole log pages, calling the param
+ * callback for each.  Padding is skipped, and a corrupt frame costs only the
+ * rest of its page, as decoding resumes at the next page boundary.
+ *
+ * @param data     Buffer starting on a page boundary
+ * @param length   Bytes in the buffer
+ * @param callback Called for each decoded frame
+ * @param arg      Argument passed through to the callback
+ * @param stats    ADXL345_LOG_DECODE_STATS to accumulate into, may be NULL
+ */
+void ADXL345_logDecodePages(const uint8_t *data, size_t length, ADXL345_LOG_FRAME_CALLBACK callback, void *arg,
+                            ADXL345_LOG_DECODE_STATS *stats) {
+    ADXL345_LOG_FRAME frame;
+    size_t offset = 0;
+
+    while (offset < length) {
+        size_t pageEnd = ((offset / ADXL345_LOG_PAGE_SIZE) + 1) * ADXL345_LOG_PAGE_SIZE;
+        if (pageEnd > length) {
+            pageEnd = length;
+        }
+
+        if (data[offset] == ADXL345_LOG_PAD) {
+            offset = pageEnd;
+            continue;
+        }
+
+        size_t frameLength = ADXL345_logDecodeFrame(&data[offset], pageEnd - offset, &frame, stats);
+        if (frameLength == 0) {
+            offset = pageEnd;
+            continue;
+        }
+
+        callback(&frame, arg);
+        offset += frameLength;
+    }
+}
+
+/**
+ * CRC-16/CCITT (polynomial 0x1021), computed a nibble at a time from a 16
+ * entry table to keep the table small.  Start with 0xFFFF.
+ *
+ * @param crc    Running CRC
+ * @param data   Bytes to add
+ * @param length Number of bytes
+ */
+uint16_t ADXL345_logCrc16(uint16_t crc, const uint8_t *data, size_t length) {
+    static const uint16_t NIBBLE_TABLE[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+
+    for (size_t i = 0; i < length; i++) {
+        crc = (uint16_t) ((crc << 4) ^ NIBBLE_TABLE[(crc >> 12) ^ (data[i] >> 4)]);
+        crc = (uint16_t) ((crc << 4) ^ NIBBLE_TABLE[(crc >> 12) ^ (data[i] & 0x0F)]);
+    }
+    return crc;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Encodes one axis record.  An offset record and the predicted records,
+ * first order, second order, the second order predictor that fits this
+ * record best, and the oscillator that fits it best smoothed by each gain
+ * shift, are costed at the Rice parameters either side of the one their
+ * mean suggests, and at ADXL345_LOG_RAW_BITS, and the smallest is written.
+ * Smoothing keeps a noisy vibration's noise from being amplified by the
+ * prediction, and costing the raw width keeps every record within the bound
+ * in ADXL345_LOG_MAX_FRAME, however noisy.
+ *
+ * @param samples  Axis samples
+ * @param count    Number of samples
+ * @param out      Buffer to encode into
+ * @param capacity Size of the buffer
+ * @return Bytes written, or -1 if the record did not fit
+ */
+static int ADXL345_EncodeAxis(const int16_t *samples, int count, uint8_t *out, size_t capacity) {
+    uint32_t values[ADXL345_LOG_FRAME_SAMPLES];
+    ADXL345_LOG_PREDICTOR candidates[ADXL345_LOG_CANDIDATES] = {
+        { .predicted = false },
+        { .predicted = true, .a1 = 1 << ADXL345_LOG_COEFF_Q, .a2 = 0 },
+        { .predicted = true, .a1 = 2 << ADXL345_LOG_COEFF_Q, .a2 = -(1 << ADXL345_LOG_COEFF_Q) },
+    };
+    int32_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += samples[i];
+    }
+    candidates[0].base = (int16_t) ((sum + (sum >= 0 ? count / 2 : -count / 2)) / count);
+    int candidateCount = 3;
+    if (ADXL345_FitPredictor(samples, count, &candidates[candidateCount])) {
+        candidateCount++;
+    }
+    ADXL345_LOG_PREDICTOR oscillator;
+    if (ADXL345_FitOscillator(samples, count, &oscillator)) {
+        for (int shift = 1; shift <= ADXL345_LOG_MAX_GAIN_SHIFT; shift++) {
+            candidates[candidateCount] = oscillator;
+            candidates[candidateCount++].shift = shift;
+        }
+    }
+
+    int best = 0;
+    int bestK = 0;
+    uint32_t bestBits = UINT32_MAX;
+    for (int c = 0; c < candidateCount; c++) {
+        int seeds = ADXL345_Residuals(samples, count, &candidates[c], values);
+        int k;
+        // The offset record carries its base, a predicted one its coefficients and seed samples
+        uint32_t bits = ADXL345_RiceCost(&values[seeds], count - seeds, &k) +
+                        (candidates[c].predicted ? 32 + 16 * seeds : 16);
+        if (bits < bestBits) {
+            best = c;
+            bestK = k;
+            bestBits = bits;
+        }
+    }
+
+    const ADXL345_LOG_PREDICTOR *predictor = &candidates[best];
+    int seeds = ADXL345_Residuals(samples, count, predictor, values);
+    int16_t fields[4] = { predictor->base };
+    int fieldCount = 1;
+    if (predictor->predicted) {
+        fields[0] = predictor->a1;
+        fields[1] = predictor->a2;
+        for (int i = 0; i < seeds; i++) {
+            fields[2 + i] = samples[i];
+        }
+        fieldCount = 2 + seeds;
+    }
+
+    size_t header = 1 + 2 * fieldCount;
+    if (capacity < header) {
+        return -1;
+    }
+    out[0] = (uint8_t) (bestK | (predictor->shift << ADXL345_LOG_MODE_SHIFT_POS) |
+                        (predictor->predicted ? ADXL345_LOG_MODE_PREDICTED : 0));
+    for (int i = 0; i < fieldCount; i++) {
+        out[1 + 2 * i] = (uint8_t) fields[i];
+        out[2 + 2 * i] = (uint8_t) ((uint16_t) fields[i] >> 8);
+    }
+
+    ADXL345_BIT_WRITER writer = { &out[header], capacity - header, 0, 0, 0 };
+    for (int i = seeds; i < count; i++) {
+        if (ADXL345_PutRice(&writer, values[i], bestK) != 0) {
+            return -1;
+        }
+    }
+    if (ADXL345_FlushBits(&writer) != 0) {
+        return -1;
+    }
+    return (int) (header + writer.length);
+}
+
+/**
+ * Decodes one axis record.
+ *
+ * @param in      Buffer starting at the record's mode byte
+ * @param length  Bytes available
+ * @param count   Number of samples to decode
+ * @param samples Output axis samples
+ * @return Bytes consumed, or -1 if the record was malformed
+ */
+static int ADXL345_DecodeAxis(const uint8_t *in, size_t length, int count, int16_t *samples) {
+    if (length < 1) {
+        return -1;
+    }
+
+    int k = in[0] & ADXL345_LOG_MODE_K;
+    ADXL345_LOG_PREDICTOR predictor = {
+        .predicted = (in[0] & ADXL345_LOG_MODE_PREDICTED) != 0,
+        .shift = (in[0] & ADXL345_LOG_MODE_SHIFT) >> ADXL345_LOG_MODE_SHIFT_POS,
+    };
+    int seeds = predictor.predicted ? ((count < 2) ? count : 2) : 0;
+    int fieldCount = predictor.predicted ? 2 + seeds : 1;
+    size_t header = 1 + 2 * fieldCount;
+    if (k > ADXL345_LOG_RAW_BITS || length < header) {
+        return -1;
+    }
+
+    int16_t fields[4] = { 0 };
+    for (int i = 0; i < fieldCount; i++) {
+        fields[i] = (int16_t) (in[1 + 2 * i] | (in[2 + 2 * i] << 8));
+    }
+    predictor.base = fields[0];
+    predictor.a1 = fields[0];
+    predictor.a2 = fields[1];
+    int32_t estimates[2] = { 0 };
+    for (int i = 0; i < seeds; i++) {
+        samples[i] = fields[2 + i];
+        estimates[1] = estimates[0];
+        estimates[0] = samples[i] * (1 << ADXL345_LOG_ESTIMATE_Q);
+    }
+
+    ADXL345_BIT_READER reader = { &in[header], length - header, 0, 0, 0 };
+    for (int i = seeds; i < count; i++) {
+        uint32_t value;
+        if (ADXL345_GetRice(&reader, k, &value) != 0) {
+            return -1;
+        }
+        if (!predictor.predicted) {
+            samples[i] = (int16_t) (predictor.base + ADXL345_UnZigZag(value));
+            continue;
+        }
+        int32_t estimate;
+        samples[i] = (int16_t) (ADXL345_Predict(&predictor, estimates, &estimate) + ADXL345_UnZigZag(value));
+        ADXL345_Update(&predictor, estimates, estimate, samples[i]);
+    }
+    return (int) (header + reader.offset);
+}
+
+/**
+ * Fills the param values with each sample's zig-zag encoded difference from
+ * what the param predictor expects of it.  A predicted record's first two
+ * samples are stored whole and have no value.
+ *
+ * @param samples   Axis samples
+ * @param count     Number of samples
+ * @param predictor ADXL345_LOG_PREDICTOR to difference against
+ * @param values    Output, count entries
+ * @return Number of seed samples at the start of values to skip
+ */
+static int ADXL345_Residuals(const int16_t *samples, int count, const ADXL345_LOG_PREDICTOR *predictor,
+                             uint32_t *values) {
+    if (!predictor->predicted) {
+        for (int i = 0; i < count; i++) {
+            values[i] = ADXL345_ZigZag(samples[i] - predictor->base);
+        }
+        return 0;
+    }
+
+    int seeds = (count < 2) ? count : 2;
+    int32_t estimates[2] = { 0 };
+    for (int i = 0; i < seeds; i++) {
+        estimates[1] = estimates[0];
+        estimates[0] = samples[i] * (1 << ADXL345_LOG_ESTIMATE_Q);
+    }
+    for (int i = seeds; i < count; i++) {
+        int32_t estimate;
+        values[i] = ADXL345_ZigZag(samples[i] - ADXL345_Predict(predictor, estimates, &estimate));
+        ADXL345_Update(predictor, estimates, estimate, samples[i]);
+    }
+    return seeds;
+}
+
+/**
+ * Returns the bits the param values take Rice coded at the best parameter,
+ * trying a few either side of the width of their mean and the raw width.
+ *
+ * @param values Zig-zag encoded differences
+ * @param count  Number of values
+ * @param k      Pointer to store the best parameter in
+ */
+static uint32_t ADXL345_RiceCost(const uint32_t *values, int count, int *k) {
+    uint32_t sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    int guess = (count > 0) ? ADXL345_BitWidth(sum / count) : 0;
+
+    *k = ADXL345_LOG_RAW_BITS;
+    uint32_t bestBits = (uint32_t) count * (ADXL345_LOG_RAW_BITS + 1);
+    for (int trial = guess - ADXL345_LOG_K_SEARCH; trial <= guess + ADXL345_LOG_K_SEARCH; trial++) {
+        if (trial < 0 || trial >= ADXL345_LOG_RAW_BITS) {
+            continue;
+        }
+        uint32_t bits = 0;
+        for (int i = 0; i < count; i++) {
+            uint32_t quotient = values[i] >> trial;
+            bits += (quotient >= ADXL345_LOG_RICE_ESCAPE) ? ADXL345_LOG_RICE_ESCAPE + ADXL345_LOG_RAW_BITS
+                                                          : quotient + 1 + trial;
+        }
+        if (bits < bestBits) {
+            *k = trial;
+            bestBits = bits;
+        }
+    }
+    return bestBits;
+}
+
+/**
+ * Fits a second order predictor to the param samples by least squares, so a
+ * vibration at any frequency is predicted about as well as its noise allows.
+ *
+ * @param samples   Axis samples
+ * @param count     Number of samples
+ * @param predictor ADXL345_LOG_PREDICTOR to store the coefficients in
+ * @return false if there were too few samples, or they don't pin a fit down
+ */
+static bool ADXL345_FitPredictor(const int16_t *samples, int count, ADXL345_LOG_PREDICTOR *predictor) {
+    if (count < 5) {
+        return false;
+    }
+
+    int64_t r11 = 0, r12 = 0, r22 = 0, b1 = 0, b2 = 0;
+    for (int i = 2; i < count; i++) {
+        int32_t s0 = samples[i], s1 = samples[i - 1], s2 = samples[i - 2];
+        r11 += s1 * s1;
+        r12 += s1 * s2;
+        r22 += s2 * s2;
+        b1 += s0 * s1;
+        b2 += s0 * s2;
+    }
+    double det = (double) r11 * r22 - (double) r12 * r12;
+    if (det <= 1e-9 * (double) r11 * r22) {
+        return false;
+    }
+
+    double scale = (double) (1 << ADXL345_LOG_COEFF_Q) / det;
+    double a1 = ((double) b1 * r22 - (double) b2 * r12) * scale;
+    double a2 = ((double) b2 * r11 - (double) b1 * r12) * scale;
+    if (a1 < INT16_MIN || a1 > INT16_MAX || a2 < INT16_MIN || a2 > INT16_MAX) {
+        return false;
+    }
+    *predictor = (ADXL345_LOG_PREDICTOR) {
+        .predicted = true,
+        .a1 = (int16_t) (a1 + (a1 >= 0 ? 0.5 : -0.5)),
+        .a2 = (int16_t) (a2 + (a2 >= 0 ? 0.5 : -0.5)),
+    };
+    return true;
+}
+
+/**
+ * Fits an undamped oscillator, a2 of -1, to the param samples by least
+ * squares.  Its coefficients describe the vibration rather than the noise on
+ * it, so it keeps predicting well from smoothed estimates.
+ *
+ * @param samples   Axis samples
+ * @param count     Number of samples
+ * @param predictor ADXL345_LOG_PREDICTOR to store the coefficients in
+ * @return false if there were too few samples, or they don't pin a fit down
+ */
+static bool ADXL345_FitOscillator(const int16_t *samples, int count, ADXL345_LOG_PREDICTOR *predictor) {
+    if (count < 5) {
+        return false;
+    }
+
+    int64_t num = 0, den = 0;
+    for (int i = 2; i < count; i++) {
+        int32_t s1 = samples[i - 1];
+        num += (int64_t) (samples[i] + samples[i - 2]) * s1;
+        den += s1 * s1;
+    }
+    if (den == 0) {
+        return false;
+    }
+
+    double a1 = (double) num * (1 << ADXL345_LOG_COEFF_Q) / (double) den;
+    if (a1 < INT16_MIN || a1 > INT16_MAX) {
+        return false;
+    }
+    *predictor = (ADXL345_LOG_PREDICTOR) {
+        .predicted = true,
+        .a1 = (int16_t) (a1 + (a1 >= 0 ? 0.5 : -0.5)),
+        .a2 = -(1 << ADXL345_LOG_COEFF_Q),
+    };
+    return true;
+}
+
+/**
+ * Returns the number of bits needed to hold the param value.
+ *
+ * @param value Value to measure
+ */
+static int ADXL345_BitWidth(uint32_t value) {
+    return (value == 0) ? 0 : 32 - __builtin_clz(value);
+}
+
+/**
+ * Appends the low width bits of the param value to the bit stream.
+ *
+ * @param writer ADXL345_BIT_WRITER to append to
+ * @param value  Bits to append
+ * @param width  Number of bits, at most ADXL345_LOG_RAW_BITS
+ * @return 0 on success, -1 if the buffer is full
+ */
+static int ADXL345_PutBits(ADXL345_BIT_WRITER *writer, uint32_t value, int width) {
+    if (width == 0) {
+        return 0;
+    }
+    writer->acc |= (value & ((1u << width) - 1)) << writer->bits;
+    writer->bits += width;
+    while (writer->bits >= 8) {
+        if (writer->length >= writer->capacity) {
+            return -1;
+        }
+        writer->out[writer->length++] = (uint8_t) writer->acc;
+        writer->acc >>= 8;
+        writer->bits -= 8;
+    }
+    return 0;
+}
+
+/**
+ * Writes out any partial byte left in the bit stream.
+ *
+ * @param writer ADXL345_BIT_WRITER to flush
+ * @return 0 on success, -1 if the buffer is full
+ */
+static int ADXL345_FlushBits(ADXL345_BIT_WRITER *writer) {
+    if (writer->bits > 0) {
+        if (writer->length >= writer->capacity) {
+            return -1;
+        }
+        writer->out[writer->length++] = (uint8_t) writer->acc;
+        writer->acc = 0;
+        writer->bits = 0;
+    }
+    return 0;
+}
+
+/**
+ * Reads the next width bits from the bit stream.
+ *
+ * @param reader ADXL345_BIT_READER to read from
+ * @param width  Number of bits, at most ADXL345_LOG_RAW_BITS
+ * @param value  Pointer to store the bits in
+ * @return 0 on success, -1 if the stream ran out
+ */
+static int ADXL345_GetBits(ADXL345_BIT_READER *reader, int width, uint32_t *value) {
+    while (reader->bits < width) {
+        if (reader->offset >= reader->length) {
+            return -1;
+        }
+        reader->acc |= (uint32_t) reader->in[reader->offset++] << reader->bits;
+        reader->bits += 8;
+    }
+    *value = (width == 0) ? 0 : (reader->acc & ((1u << width) - 1));
+    reader->acc = (width == 0) ? reader->acc : (reader->acc >> width);
+    reader->bits -= width;
+    return 0;
+}
+
+/**
+ * Appends the param value Rice coded: its high bits in unary, ones ended by
+ * a zero, then its low k bits.  A value whose high bits would take
+ * ADXL345_LOG_RICE_ESCAPE ones or more is written as that many ones and the
+ * value in ADXL345_LOG_RAW_BITS bits.
+ *
+ * @param writer ADXL345_BIT_WRITER to append to
+ * @param value  Value to code
+ * @param k      Rice parameter
+ * @return 0 on success, -1 if the buffer is full
+ */
+static int ADXL345_PutRice(ADXL345_BIT_WRITER *writer, uint32_t value, int k) {
+    uint32_t quotient = value >> k;
+    if (quotient >= ADXL345_LOG_RICE_ESCAPE) {
+        if (ADXL345_PutBits(writer, (1u << ADXL345_LOG_RICE_ESCAPE) - 1, ADXL345_LOG_RICE_ESCAPE) != 0) {
+            return -1;
+        }
+        return ADXL345_PutBits(writer, value, ADXL345_LOG_RAW_BITS);
+    }
+    if (ADXL345_PutBits(writer, (1u << quotient) - 1, (int) quotient + 1) != 0) {
+        return -1;
+    }
+    return ADXL345_PutBits(writer, value, k);
+}
+
+/**
+ * Reads the next Rice coded value from the bit stream.
+ *
+ * @param reader ADXL345_BIT_READER to read from
+ * @param k      Rice parameter
+ * @param value  Pointer to store the value in
+ * @return 0 on success, -1 if the stream ran out
+ */
+static int ADXL345_GetRice(ADXL345_BIT_READER *reader, int k, uint32_t *value) {
+    uint32_t quotient = 0;
+    while (quotient < ADXL345_LOG_RICE_ESCAPE) {
+        uint32_t bit;
+        if (ADXL345_GetBits(reader, 1, &bit) != 0) {
+            return -1;
+        }
+        if (bit == 0) {
+            break;
+        }
+        quotient++;
+    }
+    if (quotient == ADXL345_LOG_RICE_ESCAPE) {
+        return ADXL345_GetBits(reader, ADXL345_LOG_RAW_BITS, value);
+    }
+
+    uint32_t low;
+    if (ADXL345_GetBits(reader, k, &low) != 0) {
+        return -1;
+    }
+    *value = (quotient << k) | low;
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * File:       ADXL345_logformat.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * On flash sample log format.  The log is a sequence of ADXL345_LOG_PAGE_SIZE
+ * pages, each holding whole frames followed by 0xFF padding.  A frame is:
+ *
+ *   offset  size  field
+ *   0       1     magic (ADXL345_LOG_MAGIC)
+ *   1       1     format version
+ *   2       1     BW_RATE code the samples were captured at
+ *   3       1     sample count
+ *   4       8     timestamp of the first sample, microseconds, little endian
+ *   12      2     payload length, little endian
+ *   14      n     payload: X, Y and Z axis records back to back
+ *   14+n    2     CRC-16/CCITT of bytes 0 to 14+n, little endian
+ *
+ * Each axis record is a mode byte (bits 0-4 the Rice parameter k, bits 5-6
+ * a gain shift g, bit 7 set for a predicted record), then little endian
+ * int16_t fields:
+ *
+ *   offset record     base; every sample is coded as its difference from base
+ *   predicted record  a1, a2, then the first two samples; every later sample
+ *                     is coded as its difference from a prediction made from
+ *                     a running estimate of the signal, kept in Q4 so the
+ *                     noise in each sample can be smoothed out of it:
+ *
+ *                       y[0], y[1] = s[0] << 4, s[1] << 4
+ *                       e[i] = clamp((a1 * y[i-1] + a2 * y[i-2] + 4096) >> 13)
+ *                       prediction = (e[i] + 8) >> 4
+ *                       y[i] = e[i] + (((s[i] << 4) - e[i]) >> g)
+ *
+ *                     e[i] is clamped to the int16_t range in Q4, and with g
+ *                     of 0 the estimate is just the samples.
+ *
+ * The differences are zig-zag encoded and Rice coded LSB first: v >> k in
+ * unary as that many 1 bits and a 0, then the low k bits of v.  A value
+ * whose unary part would reach ADXL345_LOG_RICE_ESCAPE bits is written as
+ * that many 1 bits and the value in ADXL345_LOG_RAW_BITS bits instead.
+ *
+ * This header and ADXL345_logformat.c have no ESP-IDF dependencies, so the
+ * decoder can be built as-is on a host to read logs pulled off a device, see
+ * tools/adxl345_log_decode.c.
+ */
+
+#define ADXL345_LOG_MAGIC           0x58
+#define ADXL345_LOG_VERSION         2
+#define ADXL345_LOG_PAGE_SIZE       4096
+#define ADXL345_LOG_FRAME_SAMPLES   128
+#define ADXL345_LOG_HEADER_SIZE     14
+#define ADXL345_LOG_CRC_SIZE        2
+#define ADXL345_LOG_PAD             0xFF
+// Predictor coefficients are Q13, which covers the +/-2 a sinusoid needs
+#define ADXL345_LOG_COEFF_Q         13
+#define ADXL345_LOG_ESTIMATE_Q      4
+#define ADXL345_LOG_MAX_GAIN_SHIFT  3
+#define ADXL345_LOG_RICE_ESCAPE     16
+// Wide enough for any difference between an int16_t and a clamped prediction
+#define ADXL345_LOG_RAW_BITS        17
+// The encoder never picks a k that costs more than coding every value in
+// ADXL345_LOG_RAW_BITS + 1 bits, so a frame is at most the header, three
+// records of mode + four int16_t fields + those bits, and the CRC
+#define ADXL345_LOG_MAX_FRAME       (ADXL345_LOG_HEADER_SIZE + ADXL345_LOG_CRC_SIZE + \
+                                     3 * (9 + ((ADXL345_LOG_FRAME_SAMPLES * (ADXL345_LOG_RAW_BITS + 1)) + 7) / 8))
+
+typedef struct _adxl345LogFrame {
+    int64_t timestampUs;
+    uint8_t rateCode;
+    int count;
+    int16_t x[ADXL345_LOG_FRAME_SAMPLES];
+    int16_t y[ADXL345_LOG_FRAME_SAMPLES];
+    int16_t z[ADXL345_LOG_FRAME_SAMPLES];
+} ADXL345_LOG_FRAME;
+
+typedef struct _adxl345LogDecodeStats {
+    uint32_t frames;
+    uint32_t samples;
+    uint32_t crcErrors;
+    uint32_t formatErrors;
+} ADXL345_LOG_DECODE_STATS;
+
+typedef void (*ADXL345_LOG_FRAME_CALLBACK)(const ADXL345_LOG_FRAME *frame, void *arg);
+
+
+// Public methods designed for the user to call
+size_t ADXL345_logEncodeFrame(const ADXL345_LOG_FRAME *frame, uint8_t *out, size_t capacity);
+
+size_t ADXL345_logDecodeFrame(const uint8_t *data, size_t length, ADXL345_LOG_FRAME *frame, ADXL345_LOG_DECODE_STATS *stats);
+
+void ADXL345_logDecodePages(const uint8_t *data, size_t length, ADXL345_LOG_FRAME_CALLBACK callback, void *arg,
+                            ADXL345_LOG_DECODE_STATS *stats);
+
+uint16_t ADXL345_logCrc16(uint16_t crc, const uint8_t *data, size_t length);
@@ -0,0 +1,334 @@
+/**
+ * File:       ADXL345_logger.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Sample logger.  Blocks are gathered into frames of up to
+ * ADXL345_LOG_FRAME_SAMPLES samples, compressed into a RAM page buffer, and
+ * whole pages are handed to a writer task through a small ring of page
+ * buffers.  The acquisition side never waits on flash: if every page is
+ * still queued for writing the frame is dropped and counted instead.
+ *
+ * The log is written through the VFS, so any mounted LittleFS or SPIFFS
+ * partition works, and on a Linux host a plain file stands in for it.
+ * Every write is a whole page at a page aligned offset: a log left with a
+ * torn last page, by a power cut mid write, is padded back out to a page
+ * boundary before anything more is appended to it.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "ADXL345_logger.h"
+
+#define ADXL345_LOGGER_STACK_SIZE   4096
+#define ADXL345_LOGGER_DRAIN_DELAY  (10 / portTICK_PERIOD_MS)
+
+static const char *TAG = "ADXL345_logger";
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_AlignFile(ADXL345_LOGGER *logger);
+static void ADXL345_Release(ADXL345_LOGGER *logger);
+static esp_err_t ADXL345_EmitFrame(ADXL345_LOGGER *logger);
+static esp_err_t ADXL345_ClaimPage(ADXL345_LOGGER *logger);
+static void ADXL345_SubmitPage(ADXL345_LOGGER *logger);
+static void ADXL345_WriterTask(void *arg);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Opens (or appends to) the log file at the param path, allocates the page
+ * ring and starts the writer task.  Everything is released again if any
+ * step fails.
+ *
+ * @param logger   ADXL345_LOGGER to start
+ * @param path     VFS path of the log file, e.g. "/littlefs/accel.log"
+ * @param rateCode BW_RATE code the logged samples are captured at
+ * @param priority FreeRTOS priority of the writer task
+ * @param core     Core to pin the writer task to, or tskNO_AFFINITY
+ */
+esp_err_t ADXL345_loggerStart(ADXL345_LOGGER *logger, const char *path, uint8_t rateCode,
+                              UBaseType_t priority, BaseType_t core) {
+    memset(logger, 0, sizeof(*logger));
+    logger->rateCode = rateCode;
+    logger->activePage = -1;
+
+    logger->file = fopen(path, "ab");
+    if (logger->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        return ESP_FAIL;
+    }
+    esp_err_t err = ADXL345_AlignFile(logger);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to pad %s to a page boundary", path);
+        ADXL345_Release(logger);
+        return err;
+    }
+
+    logger->freePages = xQueueCreate(ADXL345_LOGGER_PAGES, sizeof(int));
+    logger->fullPages = xQueueCreate(ADXL345_LOGGER_PAGES, sizeof(int));
+    if (logger->freePages == NULL || logger->fullPages == NULL) {
+        ADXL345_Release(logger);
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (int i = 0; i < ADXL345_LOGGER_PAGES; i++) {
+        logger->pages[i] = malloc(ADXL345_LOG_PAGE_SIZE);
+        if (logger->pages[i] == NULL) {
+            ADXL345_Release(logger);
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(logger->freePages, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(ADXL345_WriterTask, "adxl345_log", ADXL345_LOGGER_STACK_SIZE,
+                                logger, priority, &logger->writer, core) != pdPASS) {
+        logger->writer = NULL;
+        ADXL345_Release(logger);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Appends a block of samples to the log.  Never blocks.
+ * NOTE: Blocks appended to the same frame are assumed to be back to back at
+ *       the logged rate, so only the first block's timestamp is stored.  A
+ *       change of the logger's rateCode starts a new frame.
+ *
+ * @param logger      ADXL345_LOGGER to append to
+ * @param block       ADXL345_BLOCK of samples
+ * @param timestampUs Time the first sample of the block was taken
+ * @return ESP_OK, or ESP_ERR_NO_MEM if a frame had to be dropped
+ */
+esp_err_t ADXL345_loggerAppend(ADXL345_LOGGER *logger, const ADXL345_BLOCK *block, int64_t timestampUs) {
+    esp_err_t result = ESP_OK;
+    ADXL345_LOG_FRAME *staging = &logger->staging;
+
+    if (staging->count > 0 && (staging->count + block->count > ADXL345_LOG_FRAME_SAMPLES ||
+                               staging->rateCode != logger->rateCode)) {
+        result = ADXL345_EmitFrame(logger);
+    }
+
+    if (staging->count == 0) {
+        staging->timestampUs = timestampUs;
+        staging->rateCode = logger->rateCode;
+    }
+    memcpy(&staging->x[staging->count], block->x, block->count * sizeof(int16_t));
+    memcpy(&staging->y[staging->count], block->y, block->count * sizeof(int16_t));
+    memcpy(&staging->z[staging->count], block->z, block->count * sizeof(int16_t));
+    staging->count += block->count;
+    logger->stats.blocksLogged++;
+
+    if (staging->count == ADXL345_LOG_FRAME_SAMPLES) {
+        esp_err_t err = ADXL345_EmitFrame(logger);
+        if (err != ESP_OK) {
+            result = err;
+        }
+    }
+    return result;
+}
+
+/**
+ * Encodes any partially filled frame, pads the current page and queues it
+ * for writing.  Call before power down, or to bound the age of logged data.
+ *
+ * @param logger ADXL345_LOGGER to flush
+ */
+esp_err_t ADXL345_loggerFlush(ADXL345_LOGGER *logger) {
+    esp_err_t err = ESP_OK;
+    if (logger->staging.count > 0) {
+        err = ADXL345_EmitFrame(logger);
+    }
+    if (logger->activePage >= 0 && logger->activeOffset > 0) {
+        ADXL345_SubmitPage(logger);
+    }
+    return err;
+}
+
+/**
+ * Flushes the logger, waits for the writer to finish every queued page, and
+ * then stops the writer and closes the log file.  The logger can be started
+ * again on the same file afterwards.
+ * NOTE: Nothing may append to the logger while it stops.
+ *
+ * @param logger ADXL345_LOGGER to stop
+ */
+esp_err_t ADXL345_loggerStop(ADXL345_LOGGER *logger) {
+    esp_err_t err = ADXL345_loggerFlush(logger);
+    while (uxQueueMessagesWaiting(logger->freePages) < ADXL345_LOGGER_PAGES) {
+        vTaskDelay(ADXL345_LOGGER_DRAIN_DELAY);
+    }
+
+    // Every page is back, so the writer is waiting on an empty queue
+    vTaskDelete(logger->writer);
+    logger->writer = NULL;
+    if (fclose(logger->file) != 0) {
+        logger->stats.writeErrors++;
+        err = ESP_FAIL;
+    }
+    logger->file = NULL;
+    ADXL345_Release(logger);
+    return err;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Pads the log file out to a page boundary, so what's appended to a log
+ * left with a torn page starts on one.
+ *
+ * @param logger ADXL345_LOGGER with the file open for appending
+ */
+static esp_err_t ADXL345_AlignFile(ADXL345_LOGGER *logger) {
+    if (fseek(logger->file, 0, SEEK_END) != 0) {
+        return ESP_FAIL;
+    }
+    long length = ftell(logger->file);
+    if (length < 0) {
+        return ESP_FAIL;
+    }
+
+    size_t partial = (size_t) length % ADXL345_LOG_PAGE_SIZE;
+    if (partial == 0) {
+        return ESP_OK;
+    }
+    ESP_LOGW(TAG, "Log ends %u bytes into a page, padding it out", (unsigned) partial);
+    for (size_t i = partial; i < ADXL345_LOG_PAGE_SIZE; i++) {
+        if (fputc(ADXL345_LOG_PAD, logger->file) == EOF) {
+            return ESP_FAIL;
+        }
+    }
+    return (fflush(logger->file) == 0) ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * Frees whatever the logger has allocated so far and closes its file.
+ *
+ * @param logger ADXL345_LOGGER to release
+ */
+static void ADXL345_Release(ADXL345_LOGGER *logger) {
+    for (int i = 0; i < ADXL345_LOGGER_PAGES; i++) {
+        free(logger->pages[i]);
+        logger->pages[i] = NULL;
+    }
+    if (logger->freePages != NULL) {
+        vQueueDelete(logger->freePages);
+        logger->freePages = NULL;
+    }
+    if (logger->fullPages != NULL) {
+        vQueueDelete(logger->fullPages);
+        logger->fullPages = NULL;
+    }
+    if (logger->file != NULL) {
+        fclose(logger->file);
+        logger->file = NULL;
+    }
+    logger->activePage = -1;
+    logger->activeOffset = 0;
+}
+
+/**
+ * Encodes the staged frame into the active page, moving on to a fresh page
+ * if it doesn't fit.  The staging buffer is always emptied.
+ *
+ * @param logger ADXL345_LOGGER to emit from
+ */
+static esp_err_t ADXL345_EmitFrame(ADXL345_LOGGER *logger) {
+    ADXL345_LOG_FRAME *staging = &logger->staging;
+    esp_err_t err = ESP_OK;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        err = ADXL345_ClaimPage(logger);
+        if (err != ESP_OK) {
+            break;
+        }
+
+        uint8_t *page = logger->pages[logger->activePage];
+        size_t written = ADXL345_logEncodeFrame(staging, &page[logger->activeOffset],
+                                                ADXL345_LOG_PAGE_SIZE - logger->activeOffset);
+        if (written > 0) {
+            logger->activeOffset += written;
+            logger->stats.framesWritten++;
+            logger->stats.samplesLogged += staging->count;
+            logger->stats.rawBytes += staging->count * sizeof(ADXL345_SAMPLE);
+            logger->stats.encodedBytes += written;
+            staging->count = 0;
+            return ESP_OK;
+        }
+
+        // Frame didn't fit in what's left of this page, start a new one
+        ADXL345_SubmitPage(logger);
+        err = ESP_ERR_NO_MEM;
+    }
+
+    logger->stats.samplesDropped += staging->count;
+    staging->count = 0;
+    return err;
+}
+
+/**
+ * Makes sure there is an active page to encode into, taking one from the
+ * free ring without waiting.
+ *
+ * @param logger ADXL345_LOGGER to claim a page for
+ * @return ESP_OK, or ESP_ERR_NO_MEM if every page is waiting on the writer
+ */
+static esp_err_t ADXL345_ClaimPage(ADXL345_LOGGER *logger) {
+    if (logger->activePage >= 0) {
+        return ESP_OK;
+    }
+
+    int page;
+    if (xQueueReceive(logger->freePages, &page, 0) != pdTRUE) {
+        return ESP_ERR_NO_MEM;
+    }
+    logger->activePage = page;
+    logger->activeOffset = 0;
+    return ESP_OK;
+}
+
+/**
+ * Pads the active page out to its full size and hands it to the writer.
+ *
+ * @param logger ADXL345_LOGGER owning the page
+ */
+static void ADXL345_SubmitPage(ADXL345_LOGGER *logger) {
+    uint8_t *page = logger->pages[logger->activePage];
+    memset(&page[logger->activeOffset], ADXL345_LOG_PAD, ADXL345_LOG_PAGE_SIZE - logger->activeOffset);
+
+    // Can't fail, the full queue has room for every page
+    xQueueSend(logger->fullPages, &logger->activePage, 0);
+    logger->activePage = -1;
+    logger->activeOffset = 0;
+}
+
+/**
+ * Writer task, writes full pages out to the log file as they arrive and
+ * returns them to the free ring.
+ *
+ * @param arg ADXL345_LOGGER to write for
+ */
+static void ADXL345_WriterTask(void *arg) {
+    ADXL345_LOGGER *logger = (ADXL345_LOGGER *) arg;
+    int page;
+
+    while (1) {
+        xQueueReceive(logger->fullPages, &page, portMAX_DELAY);
+
+        size_t written = fwrite(logger->pages[page], 1, ADXL345_LOG_PAGE_SIZE, logger->file);
+        if (written != ADXL345_LOG_PAGE_SIZE || fflush(logger->file) != 0) {
+            logger->stats.writeErrors++;
+        } else {
+            fsync(fileno(logger->file));
+            logger->stats.pagesWritten++;
+        }
+
+        xQueueSend(logger->freePages, &page, 0);
+    }
+}
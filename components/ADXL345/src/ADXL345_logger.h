@@ -0,0 +1,56 @@
+/**
+ * File:       ADXL345_logger.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "ADXL345.h"
+#include "ADXL345_logformat.h"
+
+// Number of page buffers in the RAM ring between acquisition and the writer
+#define ADXL345_LOGGER_PAGES    4
+
+typedef struct _adxl345LoggerStats {
+    uint32_t blocksLogged;
+    uint32_t samplesLogged;
+    uint32_t samplesDropped;
+    uint32_t framesWritten;
+    uint32_t pagesWritten;
+    uint32_t writeErrors;
+    uint64_t rawBytes;
+    uint64_t encodedBytes;
+} ADXL345_LOGGER_STATS;
+
+typedef struct _adxl345Logger {
+    FILE *file;
+    uint8_t rateCode;
+    uint8_t *pages[ADXL345_LOGGER_PAGES];
+    int activePage;
+    size_t activeOffset;
+    ADXL345_LOG_FRAME staging;
+    QueueHandle_t freePages;
+    QueueHandle_t fullPages;
+    TaskHandle_t writer;
+    ADXL345_LOGGER_STATS stats;
+} ADXL345_LOGGER;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_loggerStart(ADXL345_LOGGER *logger, const char *path, uint8_t rateCode,
+                              UBaseType_t priority, BaseType_t core);
+
+esp_err_t ADXL345_loggerAppend(ADXL345_LOGGER *logger, const ADXL345_BLOCK *block, int64_t timestampUs);
+
+esp_err_t ADXL345_loggerFlush(ADXL345_LOGGER *logger);
+
+esp_err_t ADXL345_loggerStop(ADXL345_LOGGER *logger);
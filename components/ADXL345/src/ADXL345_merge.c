@@ -0,0 +1,131 @@
+/**
+ * File:       ADXL345_merge.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Time ordered merge of several sample rings.
+ *
+ * Each ring is filled in timestamp order by one bus task, so the oldest
+ * block overall is always at the front of one of them.  It's only safe to
+ * hand it on once no other ring can still produce an older one, which is
+ * once every other ring has a block waiting (their fronts are all newer), or
+ * once it's older than the longest a block can take from its first sample
+ * to being published.  A source that's stopped therefore holds the stream
+ * up by no more than that skew.  A block published later than the skew
+ * allows is merged as soon as it's seen and counted as late.
+ *
+ * Blocks are ordered by the time of their first sample rather than when
+ * they were read, since two sources drained at the same moment can hold
+ * very different spans of samples.  The merge doesn't split blocks, so the
+ * samples of blocks that overlap in time still come out one block at a
+ * time.
+ */
+#include <string.h>
+#include "ADXL345_merge.h"
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Sets up an empty merge.
+ *
+ * @param merge     ADXL345_MERGE to set up
+ * @param maxSkewUs Longest a producer can take from a block's first sample
+ *                  to publishing it, e.g. a full FIFO at the output data
+ *                  rate plus ADXL345_MERGE_DEFAULT_SKEW_US
+ */
+void ADXL345_mergeInit(ADXL345_MERGE *merge, uint32_t maxSkewUs) {
+    memset(merge, 0, sizeof(*merge));
+    merge->maxSkewUs = maxSkewUs;
+    merge->peeked = -1;
+}
+
+/**
+ * Adds a ring to take blocks from.  Sources should all be added before the
+ * first ADXL345_mergePeek.
+ *
+ * @param merge  ADXL345_MERGE to add to
+ * @param ring   ADXL345_RING its producer publishes to
+ * @param source Pointer to store the source number in, may be NULL
+ * @return ESP_ERR_NO_MEM if there are already ADXL345_MERGE_MAX_SOURCES
+ */
+esp_err_t ADXL345_mergeAddSource(ADXL345_MERGE *merge, ADXL345_RING *ring, int *source) {
+    if (merge->numSources >= ADXL345_MERGE_MAX_SOURCES) {
+        return ESP_ERR_NO_MEM;
+    }
+    if (source != NULL) {
+        *source = merge->numSources;
+    }
+    merge->sources[merge->numSources++] = ring;
+    return ESP_OK;
+}
+
+/**
+ * Returns the oldest block across all sources, once it's certain no older
+ * one is still to come, or NULL if there isn't one yet.  It may be
+ * processed in place until ADXL345_mergeRelease is called.
+ *
+ * @param merge       ADXL345_MERGE to read from
+ * @param nowUs       Current time, on the same clock as the block timestamps
+ * @param timestampUs Pointer to store the block timestamp in, may be NULL
+ * @param source      Pointer to store the block's source number in, may be NULL
+ */
+ADXL345_BLOCK *ADXL345_mergePeek(ADXL345_MERGE *merge, int64_t nowUs, int64_t *timestampUs, int *source) {
+    ADXL345_BLOCK *oldest = NULL;
+    int64_t oldestUs = 0;
+    int oldestSource = -1;
+    bool allWaiting = true;
+
+    for (int i = 0; i < merge->numSources; i++) {
+        int64_t blockUs;
+        ADXL345_BLOCK *block = ADXL345_ringPeek(merge->sources[i], &blockUs);
+        if (block == NULL) {
+            allWaiting = false;
+        } else if (oldest == NULL || blockUs < oldestUs) {
+            oldest = block;
+            oldestUs = blockUs;
+            oldestSource = i;
+        }
+    }
+
+    if (oldest == NULL || (!allWaiting && nowUs - oldestUs < (int64_t) merge->maxSkewUs)) {
+        return NULL;
+    }
+
+    merge->peeked = oldestSource;
+    if (timestampUs != NULL) {
+        *timestampUs = oldestUs;
+    }
+    if (source != NULL) {
+        *source = oldestSource;
+    }
+    return oldest;
+}
+
+/**
+ * Returns the block from ADXL345_mergePeek to its producer.
+ *
+ * @param merge ADXL345_MERGE to release a block to
+ */
+void ADXL345_mergeRelease(ADXL345_MERGE *merge) {
+    if (merge->peeked < 0) {
+        return;
+    }
+
+    int64_t blockUs;
+    ADXL345_RING *ring = merge->sources[merge->peeked];
+    if (ADXL345_ringPeek(ring, &blockUs) != NULL) {
+        if (merge->merged > 0 && blockUs < merge->lastTimestampUs) {
+            merge->late++;
+        } else {
+            merge->lastTimestampUs = blockUs;
+        }
+        ADXL345_ringRelease(ring);
+        merge->merged++;
+        merge->perSource[merge->peeked]++;
+    }
+    merge->peeked = -1;
+}
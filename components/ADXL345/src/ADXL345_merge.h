@@ -0,0 +1,60 @@
+/**
+ * File:       ADXL345_merge.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ADXL345.h"
+#include "ADXL345_ring.h"
+
+// Sample rings one merge can take blocks from, e.g. two sensors on each of
+// up to four buses
+#define ADXL345_MERGE_MAX_SOURCES   8
+
+/**
+ * Merges the blocks of several sample rings, each filled by its own bus
+ * task, into one stream in timestamp order.  Only the consumer side of each
+ * ring is used, so producers are unaware of the merge.  Producers should
+ * stamp each block with the time of its first sample.
+ * NOTE: The order is per block.  Where blocks from two sources overlap in
+ *       time, all of the older block is handed on before any of the other,
+ *       so a consumer that needs the samples themselves interleaved has to
+ *       do it from each block's timestamp and sample period.
+ */
+typedef struct _adxl345Merge {
+    ADXL345_RING *sources[ADXL345_MERGE_MAX_SOURCES];
+    int numSources;
+    // Longest from a block's first sample to it being published, the span
+    // of a full FIFO plus the drain
+    uint32_t maxSkewUs;
+    // Source of the block last returned by ADXL345_mergePeek, or -1
+    int peeked;
+
+    int64_t lastTimestampUs;
+    uint32_t merged;
+    // Blocks that turned up stamped before one already merged, merged anyway
+    uint32_t late;
+    uint32_t perSource[ADXL345_MERGE_MAX_SOURCES];
+} ADXL345_MERGE;
+
+
+// Public methods designed for the user to call
+void ADXL345_mergeInit(ADXL345_MERGE *merge, uint32_t maxSkewUs);
+
+esp_err_t ADXL345_mergeAddSource(ADXL345_MERGE *merge, ADXL345_RING *ring, int *source);
+
+ADXL345_BLOCK *ADXL345_mergePeek(ADXL345_MERGE *merge, int64_t nowUs, int64_t *timestampUs, int *source);
+
+void ADXL345_mergeRelease(ADXL345_MERGE *merge);
+
+// Constants for calculations
+// A bus task publishes right after draining, so beyond the span of the block
+// itself only preemption in between delays it.  A few scheduler ticks covers
+// that.
+#define ADXL345_MERGE_DEFAULT_SKEW_US   30000
@@ -0,0 +1,167 @@
+/**
+ * File:       ADXL345_orientation.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Pitch, roll and magnitude from raw accelerometer counts, using integer math
+ * only.  atan2 is reduced to the first octant and looked up in a 65 entry
+ * arctangent table with linear interpolation, and square roots use the 32 bit
+ * integer routine in ADXL345_fixed.h.
+ *
+ * Error bound: the table is exact to 0.0005 degrees, linear interpolation
+ * between 1/64 steps adds at most 0.0012 degrees, and forming the ratio from
+ * 16 bit operands adds at most 0.0035 degrees.  With the final rounding to
+ * hundredths (0.005 degrees) every angle is within 0.01 degrees, one output
+ * LSB, of the libm result.  Magnitude is within one count.
+ */
+#include <stdlib.h>
+#include "ADXL345_orientation.h"
+#include "ADXL345_fixed.h"
+
+#define ADXL345_ATAN_STEPS_LOG2  6
+#define ADXL345_RATIO_Q          16
+
+// atan(i / 64) in thousandths of a degree, for i = 0..64
+static const int32_t ATAN_TABLE[(1 << ADXL345_ATAN_STEPS_LOG2) + 1] = {
+        0,   895,  1790,  2684,  3576,  4467,  5356,  6242,
+     7125,  8005,  8881,  9752, 10620, 11482, 12339, 13191,
+    14036, 14876, 15709, 16535, 17354, 18166, 18970, 19767,
+    20556, 21337, 22109, 22874, 23629, 24376, 25115, 25844,
+    26565, 27277, 27979, 28673, 29358, 30033, 30700, 31357,
+    32005, 32645, 33275, 33896, 34509, 35112, 35707, 36293,
+    36870, 37439, 37999, 38550, 39094, 39629, 40156, 40675,
+    41186, 41689, 42184, 42672, 43152, 43625, 44091, 44549,
+    45000,
+};
+
+// 'Private' helpers designed for internal use
+static int32_t ADXL345_AtanFirstOctant(uint32_t numerator, uint32_t denominator);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Integer atan2, returning the angle of (x, y) in hundredths of a degree in
+ * the range -18000 to 18000.  Returns 0 for (0, 0), like atan2f.
+ *
+ * @param y Y component
+ * @param x X component
+ */
+int32_t ADXL345_atan2Centi(int32_t y, int32_t x) {
+    uint32_t ax = (uint32_t) abs(x);
+    uint32_t ay = (uint32_t) abs(y);
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+
+    // Reduce to the first octant, then unfold the result
+    int32_t milliDeg;
+    if (ax >= ay) {
+        milliDeg = ADXL345_AtanFirstOctant(ay, ax);
+    } else {
+        milliDeg = 90000 - ADXL345_AtanFirstOctant(ax, ay);
+    }
+    if (x < 0) {
+        milliDeg = 180000 - milliDeg;
+    }
+    if (y < 0) {
+        milliDeg = -milliDeg;
+    }
+
+    return (milliDeg >= 0) ? (milliDeg + 5) / 10 : (milliDeg - 5) / 10;
+}
+
+/**
+ * Computes pitch, roll and magnitude for a single sample.
+ * NOTE: Pitch is rotation about Y (nose up positive when X tips down) and
+ *       roll is rotation about X, the usual convention for a board lying flat
+ *       with Z up.  Pitch is taken against the Y/Z magnitude so it stays well
+ *       defined at any roll angle.
+ *
+ * @param sample      ADXL345_SAMPLE of raw counts
+ * @param orientation ADXL345_ORIENTATION to store the result in
+ */
+void ADXL345_orientationFromSample(const ADXL345_SAMPLE *sample, ADXL345_ORIENTATION *orientation) {
+    int32_t x = sample->x;
+    int32_t y = sample->y;
+    int32_t z = sample->z;
+    uint32_t yzSq = (uint32_t) (y * y) + (uint32_t) (z * z);
+
+    // Normalize the Y/Z magnitude up to the top of the word before the square
+    // root and scale X to match, otherwise truncating it to whole counts costs
+    // a few tenths of a degree at low ranges.
+    int32_t pitchDenominator = 0;
+    int32_t pitchNumerator = -x;
+    if (yzSq != 0) {
+        int shift = (__builtin_clz(yzSq) & ~1) - 2;
+        if (shift > 0) {
+            pitchDenominator = (int32_t) ADXL345_isqrt32(yzSq << shift);
+            pitchNumerator *= (1 << (shift / 2));
+        } else {
+            pitchDenominator = (int32_t) ADXL345_isqrt32(yzSq);
+        }
+    }
+
+    orientation->pitch = (int16_t) ADXL345_atan2Centi(pitchNumerator, pitchDenominator);
+    orientation->roll = (int16_t) ADXL345_atan2Centi(y, z);
+    orientation->magnitude = (uint16_t) ADXL345_isqrt32(yzSq + (uint32_t) (x * x));
+}
+
+/**
+ * Computes pitch, roll and magnitude for an array of samples.
+ *
+ * @param samples      Array of ADXL345_SAMPLE
+ * @param count        Number of samples
+ * @param orientations Array of at least count ADXL345_ORIENTATION to fill
+ */
+void ADXL345_orientationFromSamples(const ADXL345_SAMPLE *samples, int count, ADXL345_ORIENTATION *orientations) {
+    for (int i = 0; i < count; i++) {
+        ADXL345_orientationFromSample(&samples[i], &orientations[i]);
+    }
+}
+
+/**
+ * Computes pitch, roll and magnitude for every sample in a block.
+ *
+ * @param block        ADXL345_BLOCK of raw counts
+ * @param orientations Array of at least block->count ADXL345_ORIENTATION to fill
+ */
+void ADXL345_orientationFromBlock(const ADXL345_BLOCK *block, ADXL345_ORIENTATION *orientations) {
+    for (int i = 0; i < block->count; i++) {
+        ADXL345_SAMPLE sample = { block->x[i], block->y[i], block->z[i] };
+        ADXL345_orientationFromSample(&sample, &orientations[i]);
+    }
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns atan(numerator / denominator) in thousandths of a degree, for
+ * numerator <= denominator.
+ *
+ * @param numerator   Smaller of the two magnitudes
+ * @param denominator Larger of the two magnitudes, non-zero
+ */
+static int32_t ADXL345_AtanFirstOctant(uint32_t numerator, uint32_t denominator) {
+    // Scale both down so the Q16 ratio can be formed with a 32 bit divide
+    int excess = (32 - __builtin_clz(denominator)) - 16;
+    if (excess > 0) {
+        numerator >>= excess;
+        denominator >>= excess;
+    }
+
+    uint32_t ratio = (numerator << ADXL345_RATIO_Q) / denominator;
+    uint32_t index = ratio >> (ADXL345_RATIO_Q - ADXL345_ATAN_STEPS_LOG2);
+    int32_t fraction = (int32_t) (ratio & ((1u << (ADXL345_RATIO_Q - ADXL345_ATAN_STEPS_LOG2)) - 1));
+
+    if (index >= (1u << ADXL345_ATAN_STEPS_LOG2)) {
+        return ATAN_TABLE[1 << ADXL345_ATAN_STEPS_LOG2];
+    }
+
+    int32_t step = ATAN_TABLE[index + 1] - ATAN_TABLE[index];
+    return ATAN_TABLE[index] + ((step * fraction) >> (ADXL345_RATIO_Q - ADXL345_ATAN_STEPS_LOG2));
+}
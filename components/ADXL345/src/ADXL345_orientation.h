@@ -0,0 +1,28 @@
+/**
+ * File:       ADXL345_orientation.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "ADXL345.h"
+
+typedef struct _adxl345Orientation {
+    int16_t pitch;          // Hundredths of a degree, -9000 to 9000
+    int16_t roll;           // Hundredths of a degree, -18000 to 18000
+    uint16_t magnitude;     // Raw counts, same scale as the sample
+} ADXL345_ORIENTATION;
+
+
+// Public methods designed for the user to call
+int32_t ADXL345_atan2Centi(int32_t y, int32_t x);
+
+void ADXL345_orientationFromSample(const ADXL345_SAMPLE *sample, ADXL345_ORIENTATION *orientation);
+
+void ADXL345_orientationFromSamples(const ADXL345_SAMPLE *samples, int count, ADXL345_ORIENTATION *orientations);
+
+void ADXL345_orientationFromBlock(const ADXL345_BLOCK *block, ADXL345_ORIENTATION *orientations);
@@ -0,0 +1,516 @@
+/**
+ * File:       ADXL345_power.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Power manager.  The sensor's linked activity and inactivity detection
+ * drive a two state machine: while moving the sensor samples at the active
+ * rate, and once it has been still for a while it drops to the idle rate,
+ * in LOW_POWER mode and optionally auto sleeping, until activity wakes it.
+ *
+ * Interrupts wake the host rather than it polling.  With ADXL345_powerStart
+ * the INT pin is a level triggered light sleep wakeup source, so with
+ * automatic light sleep enabled the ESP32 sleeps between FIFO watermarks
+ * and state changes.
+ *
+ * Energy is estimated from the datasheet's supply current for each rate and
+ * mode, and from the host's active and sleep currents over the time it
+ * spends servicing the sensor, so the rates and watermarks can be tuned for
+ * samples per joule against wake latency.
+ */
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "ADXL345_power.h"
+#if ADXL345_POWER_PM
+#include "esp_pm.h"
+#endif
+#if ADXL345_EVENTS_GPIO
+#include "esp_sleep.h"
+#endif
+
+#define ADXL345_POWER_STACK_SIZE    3072
+
+// Typical supply current in uA at VS = 2.5 V by rate code, datasheet tables 7 and 8
+static const uint8_t ADXL345_NORMAL_UA[16] = { 23, 23, 23, 23, 34, 40, 45, 50, 60, 90, 140, 140, 140, 140, 90, 140 };
+static const uint8_t ADXL345_LOW_POWER_UA[16] = { 0, 0, 0, 0, 0, 0, 0, 34, 40, 45, 50, 60, 90, 0, 0, 0 };
+// Asleep the sensor samples at the wakeup rate, costed as the next slower rate
+// code, 0x06 (6.25 Hz) for 8 Hz
+#define ADXL345_WAKEUP_RATE_CODE    0x06
+
+// 'Private' helpers designed for internal use
+static void ADXL345_PowerActivity(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg);
+static void ADXL345_PowerInactivity(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg);
+static void ADXL345_PowerWatermark(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg);
+static esp_err_t ADXL345_PowerEnter(ADXL345_POWER *power, ADXL345_POWER_STATE state);
+static esp_err_t ADXL345_PowerProgram(ADXL345_POWER *power);
+static uint8_t ADXL345_PowerStateRate(const ADXL345_POWER *power);
+static void ADXL345_PowerDrain(ADXL345_POWER *power);
+static void ADXL345_PowerAccount(ADXL345_POWER *power, int64_t nowUs);
+static uint32_t ADXL345_PowerStateCurrentUa(const ADXL345_POWER *power);
+static uint32_t ADXL345_PowerStatePeriodUs(const ADXL345_POWER *power);
+#if ADXL345_EVENTS_GPIO
+static void ADXL345_PowerTask(void *arg);
+static void IRAM_ATTR ADXL345_PowerIsr(void *arg);
+#endif
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Fills the param config with a starting point: 100 Hz while moving, 12.5 Hz
+ * low power while still, idle after five seconds under 125 mg, and woken
+ * by 250 mg of movement.
+ *
+ * @param config ADXL345_POWER_CONFIG to fill
+ */
+void ADXL345_powerConfigInit(ADXL345_POWER_CONFIG *config) {
+    *config = (ADXL345_POWER_CONFIG) {
+        .activeRate = ADXL345_RATE_100HZ,
+        .idleRate = 0x07,
+        .idleLowPower = true,
+        .activeWatermark = 16,
+        .idleWatermark = 30,
+        .activityMg = 250,
+        .inactivityMg = 125,
+        .inactivitySeconds = 5,
+        .autoSleep = false,
+        .wakeupRate = ADXL345_WAKEUP_8HZ,
+        .supplyMv = 2500,
+        .hostActiveUa = 0,
+        .hostSleepUa = 0,
+    };
+}
+
+/**
+ * Programs the sensor for the param config and starts it in the active
+ * state.  Activity and inactivity are linked and AC coupled, so the sensor
+ * looks for inactivity while active and for activity while idle.
+ * NOTE: With an onBlock callback the manager owns the FIFO, draining it on
+ *       each watermark and before each rate change.  Without one the caller
+ *       drains it, and the manager only changes the rate.
+ *
+ * @param power   ADXL345_POWER to initialize
+ * @param dev     ADXL345_DEVICE to manage, already initialized
+ * @param config  ADXL345_POWER_CONFIG to apply, copied
+ * @param onBlock Called with each drained block, or NULL
+ * @param onState Called after each state change, or NULL
+ * @param arg     Argument passed through to both callbacks
+ */
+esp_err_t ADXL345_powerInit(ADXL345_POWER *power, ADXL345_DEVICE *dev, const ADXL345_POWER_CONFIG *config,
+                            ADXL345_POWER_BLOCK_CALLBACK onBlock, ADXL345_POWER_STATE_CALLBACK onState, void *arg) {
+    memset(power, 0, sizeof(*power));
+    power->dev = dev;
+    power->config = *config;
+    power->state = ADXL345_POWER_ACTIVE;
+    power->onBlock = onBlock;
+    power->onState = onState;
+    power->arg = arg;
+#if ADXL345_EVENTS_GPIO
+    power->pin = GPIO_NUM_NC;
+#endif
+    power->lock = xSemaphoreCreateMutex();
+    if (power->lock == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ADXL345_eventsInit(&power->events, dev);
+    ADXL345_eventsRegister(&power->events, ADXL345_EVENT_ACTIVITY, ADXL345_PowerActivity, power);
+    ADXL345_eventsRegister(&power->events, ADXL345_EVENT_INACTIVITY, ADXL345_PowerInactivity, power);
+    if (onBlock != NULL) {
+        ADXL345_eventsRegister(&power->events, ADXL345_EVENT_WATERMARK, ADXL345_PowerWatermark, power);
+    }
+
+    esp_err_t err = ADXL345_PowerProgram(power);
+
+    int64_t nowUs = esp_timer_get_time();
+    power->accountedUs = nowUs;
+    power->awakeUntilUs = nowUs;
+    return err;
+}
+
+/**
+ * Reads the sensor's pending interrupts and acts on them: a change of state
+ * on activity or inactivity, and a drain on a watermark.  Called by the task
+ * ADXL345_powerStart sets up, or directly by a caller that has its own way
+ * of waiting for the interrupt pin.
+ *
+ * @param power  ADXL345_POWER to service
+ * @param edgeUs When the interrupt pin was raised, or 0 for now
+ */
+esp_err_t ADXL345_powerService(ADXL345_POWER *power, int64_t edgeUs) {
+    if (edgeUs <= 0) {
+        edgeUs = esp_timer_get_time();
+    }
+    power->edgeUs = edgeUs;
+    esp_err_t err = ADXL345_eventsService(&power->events);
+
+    // The host was awake from the edge until now, less anything already counted
+    int64_t nowUs = esp_timer_get_time();
+    xSemaphoreTake(power->lock, portMAX_DELAY);
+    ADXL345_PowerAccount(power, nowUs);
+    int64_t awakeFromUs = (edgeUs > power->awakeUntilUs) ? edgeUs : power->awakeUntilUs;
+    if (nowUs > awakeFromUs) {
+        uint64_t awakeUs = (uint64_t) (nowUs - awakeFromUs);
+        power->stats.hostAwakeUs += awakeUs;
+        if (power->config.hostActiveUa > power->config.hostSleepUa) {
+            power->hostPj += (uint64_t) power->config.supplyMv *
+                             (power->config.hostActiveUa - power->config.hostSleepUa) * awakeUs / 1000;
+        }
+        power->awakeUntilUs = nowUs;
+    }
+    xSemaphoreGive(power->lock);
+    return err;
+}
+
+/**
+ * Programs the activity detection, rate, watermark, power and interrupt
+ * registers for the current state again.  The driver's own recovery only
+ * restores the basic configuration, so call this after the sensor has been
+ * re-initialized, e.g. when ADXL345_HEALTH reinits goes up.
+ *
+ * @param power ADXL345_POWER to restore
+ */
+esp_err_t ADXL345_powerRestore(ADXL345_POWER *power) {
+    return ADXL345_PowerProgram(power);
+}
+
+#if ADXL345_EVENTS_GPIO
+/**
+ * Starts a task that services the sensor whenever the param GPIO (wired to
+ * the ADXL345 INT1 pin) is high.  The pin is also a light sleep wakeup
+ * source, so with ADXL345_powerEnableLightSleep the chip sleeps until the
+ * sensor has something to say.
+ * NOTE: Light sleep can only be woken by a level, so the pin interrupt is
+ *       level triggered and held off until the task has cleared the source.
+ *
+ * @param power    ADXL345_POWER to service
+ * @param pin      GPIO connected to the sensor INT1 pin
+ * @param priority FreeRTOS priority of the service task
+ * @param core     Core to pin the service task to, or tskNO_AFFINITY
+ */
+esp_err_t ADXL345_powerStart(ADXL345_POWER *power, gpio_num_t pin, UBaseType_t priority, BaseType_t core) {
+    power->pin = pin;
+
+    if (xTaskCreatePinnedToCore(ADXL345_PowerTask, "adxl345_power", ADXL345_POWER_STACK_SIZE,
+                                power, priority, &power->task, core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    gpio_config_t pinConfig = {
+        .pin_bit_mask = 1ULL << pin,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_HIGH_LEVEL,
+    };
+    esp_err_t err = gpio_config(&pinConfig);
+    if (err == ESP_OK) {
+        err = gpio_wakeup_enable(pin, GPIO_INTR_HIGH_LEVEL);
+    }
+    if (err == ESP_OK) {
+        err = esp_sleep_enable_gpio_wakeup();
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The ISR service may already be installed by another driver, which is fine
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+    err = gpio_isr_handler_add(pin, ADXL345_PowerIsr, power);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // Anything latched before the handler was attached
+    xTaskNotifyGive(power->task);
+    return ESP_OK;
+}
+#endif
+
+/**
+ * Turns on automatic light sleep, so the chip sleeps whenever every task is
+ * blocked.  Needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE in
+ * menuconfig.
+ *
+ * @param maxFreqMhz CPU frequency while running, e.g. 240
+ * @param minFreqMhz CPU frequency while idle but not asleep, e.g. 40
+ * @return ESP_ERR_NOT_SUPPORTED if power management isn't built in
+ */
+esp_err_t ADXL345_powerEnableLightSleep(int maxFreqMhz, int minFreqMhz) {
+#if ADXL345_POWER_PM
+    esp_pm_config_t config = {
+        .max_freq_mhz = maxFreqMhz,
+        .min_freq_mhz = minFreqMhz,
+        .light_sleep_enable = true,
+    };
+    return esp_pm_configure(&config);
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+/**
+ * Copies out the statistics, with time, samples and energy brought up to
+ * now.  Safe to call from any task.
+ *
+ * @param power ADXL345_POWER to read
+ * @param stats ADXL345_POWER_STATS to fill
+ */
+void ADXL345_powerGetStats(ADXL345_POWER *power, ADXL345_POWER_STATS *stats) {
+    xSemaphoreTake(power->lock, portMAX_DELAY);
+    ADXL345_PowerAccount(power, esp_timer_get_time());
+    power->stats.sensorUj = power->sensorPj / 1000000;
+    power->stats.hostUj = power->hostPj / 1000000;
+    uint64_t totalPj = power->sensorPj + power->hostPj;
+    power->stats.samplesPerJoule = (totalPj > 0) ? (uint32_t) (power->stats.samples * 1e12 / totalPj) : 0;
+    *stats = power->stats;
+    xSemaphoreGive(power->lock);
+}
+
+/**
+ * Returns the sensor's typical supply current in uA at the param BW_RATE,
+ * in LOW_POWER mode if its bit is set and the rate supports it.
+ *
+ * @param bwRate BW_RATE register value
+ */
+uint32_t ADXL345_powerSensorCurrentUa(uint8_t bwRate) {
+    uint8_t rateCode = bwRate & ADXL345_RATE_MASK;
+    if ((bwRate & ADXL345_LOW_POWER) && ADXL345_LOW_POWER_UA[rateCode] > 0) {
+        return ADXL345_LOW_POWER_UA[rateCode];
+    }
+    return ADXL345_NORMAL_UA[rateCode];
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Activity while idle, back to the active rate.
+ */
+static void ADXL345_PowerActivity(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg) {
+    ADXL345_PowerEnter((ADXL345_POWER *) arg, ADXL345_POWER_ACTIVE);
+}
+
+/**
+ * Inactivity while active, down to the idle rate.
+ */
+static void ADXL345_PowerInactivity(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg) {
+    ADXL345_PowerEnter((ADXL345_POWER *) arg, ADXL345_POWER_IDLE);
+}
+
+static void ADXL345_PowerWatermark(ADXL345_DEVICE *dev, const ADXL345_EVENT *event, void *arg) {
+    ADXL345_PowerDrain((ADXL345_POWER *) arg);
+}
+
+/**
+ * Switches the sensor's rate and watermark to the param state.  The rate is
+ * cached by the driver before it's written, so if the write fails the next
+ * recovery still puts the sensor in the new state.
+ *
+ * @param power ADXL345_POWER to switch
+ * @param state ADXL345_POWER_STATE to enter
+ */
+static esp_err_t ADXL345_PowerEnter(ADXL345_POWER *power, ADXL345_POWER_STATE state) {
+    if (state == power->state) {
+        return ESP_OK;
+    }
+
+    // Whatever is in the FIFO was sampled at the old rate
+    if (power->onBlock != NULL) {
+        ADXL345_PowerDrain(power);
+    }
+
+    const ADXL345_POWER_CONFIG *config = &power->config;
+    bool active = (state == ADXL345_POWER_ACTIVE);
+    int64_t switchUs = esp_timer_get_time();
+    xSemaphoreTake(power->lock, portMAX_DELAY);
+    ADXL345_PowerAccount(power, switchUs);
+    power->state = state;
+    xSemaphoreGive(power->lock);
+
+    esp_err_t err = ADXL345_setRate(power->dev, ADXL345_PowerStateRate(power));
+    if (err == ESP_OK && power->onBlock != NULL) {
+        err = ADXL345_setFifoMode(power->dev, ADXL345_FIFO_STREAM, active ? config->activeWatermark
+                                                                          : config->idleWatermark);
+    }
+
+    int64_t nowUs = esp_timer_get_time();
+    xSemaphoreTake(power->lock, portMAX_DELAY);
+    if (active) {
+        uint32_t latencyUs = (uint32_t) (nowUs - power->edgeUs);
+        power->stats.wakes++;
+        power->stats.lastWakeLatencyUs = latencyUs;
+        power->stats.totalWakeLatencyUs += latencyUs;
+        if (latencyUs > power->stats.maxWakeLatencyUs) {
+            power->stats.maxWakeLatencyUs = latencyUs;
+        }
+    } else {
+        power->stats.sleeps++;
+    }
+    xSemaphoreGive(power->lock);
+
+    if (power->onState != NULL) {
+        power->onState(state, power->arg);
+    }
+    return err;
+}
+
+/**
+ * Writes every register the manager owns for the current state.
+ */
+static esp_err_t ADXL345_PowerProgram(ADXL345_POWER *power) {
+    const ADXL345_POWER_CONFIG *config = &power->config;
+    ADXL345_DEVICE *dev = power->dev;
+    bool active = (power->state == ADXL345_POWER_ACTIVE);
+
+    ADXL345_ACTIVITY_CONFIG activity = {
+        .activityThresholdMg = config->activityMg,
+        .inactivityThresholdMg = config->inactivityMg,
+        .inactivitySeconds = config->inactivitySeconds,
+        .activityAxes = ADXL345_AXIS_ALL,
+        .inactivityAxes = ADXL345_AXIS_ALL,
+        .activityAcCoupled = true,
+        .inactivityAcCoupled = true,
+    };
+    esp_err_t err = ADXL345_configureActivity(dev, &activity);
+    if (err == ESP_OK) {
+        err = ADXL345_setRate(dev, ADXL345_PowerStateRate(power));
+    }
+    if (err == ESP_OK && power->onBlock != NULL) {
+        err = ADXL345_setFifoMode(dev, ADXL345_FIFO_STREAM, active ? config->activeWatermark : config->idleWatermark);
+    }
+    if (err == ESP_OK) {
+        uint8_t powerCtl = ADXL345_LINK;
+        if (config->autoSleep) {
+            powerCtl |= ADXL345_AUTO_SLEEP | (config->wakeupRate & ADXL345_WAKEUP_MASK);
+        }
+        err = ADXL345_setPowerControl(dev, powerCtl);
+    }
+    if (err == ESP_OK) {
+        uint8_t interrupts = ADXL345_INT_ACTIVITY | ADXL345_INT_INACTIVITY;
+        if (power->onBlock != NULL) {
+            interrupts |= ADXL345_INT_WATERMARK;
+        }
+        err = ADXL345_setInterrupts(dev, interrupts, 0);
+    }
+    return err;
+}
+
+/**
+ * Returns the BW_RATE value for the current state.
+ */
+static uint8_t ADXL345_PowerStateRate(const ADXL345_POWER *power) {
+    const ADXL345_POWER_CONFIG *config = &power->config;
+    if (power->state == ADXL345_POWER_ACTIVE) {
+        return config->activeRate & ADXL345_RATE_MASK;
+    }
+    return (config->idleRate & ADXL345_RATE_MASK) | (config->idleLowPower ? ADXL345_LOW_POWER : 0);
+}
+
+/**
+ * Empties the FIFO and hands the samples to the block callback.
+ */
+static void ADXL345_PowerDrain(ADXL345_POWER *power) {
+    if (ADXL345_readFifo(power->dev, &power->block) == ESP_OK && power->block.count > 0) {
+        power->onBlock(&power->block, power->dev->config.bwRate, power->arg);
+    }
+}
+
+/**
+ * Integrates time, samples and energy in the current state up to the param
+ * time.  Called with the lock held.
+ */
+static void ADXL345_PowerAccount(ADXL345_POWER *power, int64_t nowUs) {
+    if (nowUs <= power->accountedUs) {
+        return;
+    }
+    uint64_t elapsedUs = (uint64_t) (nowUs - power->accountedUs);
+    power->accountedUs = nowUs;
+
+    if (power->state == ADXL345_POWER_ACTIVE) {
+        power->stats.activeUs += elapsedUs;
+    } else {
+        power->stats.idleUs += elapsedUs;
+    }
+
+    // The remainder carries over, so samples aren't lost to rounding
+    uint32_t periodUs = ADXL345_PowerStatePeriodUs(power);
+    power->sampleTimeUs += elapsedUs;
+    power->stats.samples += power->sampleTimeUs / periodUs;
+    power->sampleTimeUs %= periodUs;
+
+    // mV * uA * us is femto-joules
+    uint64_t supplyMv = power->config.supplyMv;
+    power->sensorPj += supplyMv * ADXL345_PowerStateCurrentUa(power) * elapsedUs / 1000;
+    power->hostPj += supplyMv * power->config.hostSleepUa * elapsedUs / 1000;
+}
+
+/**
+ * Returns the sensor's supply current in the current state.
+ */
+static uint32_t ADXL345_PowerStateCurrentUa(const ADXL345_POWER *power) {
+    const ADXL345_POWER_CONFIG *config = &power->config;
+    if (power->state == ADXL345_POWER_ACTIVE) {
+        return ADXL345_powerSensorCurrentUa(config->activeRate);
+    }
+    if (config->autoSleep) {
+        return ADXL345_NORMAL_UA[ADXL345_WAKEUP_RATE_CODE - (config->wakeupRate & ADXL345_WAKEUP_MASK)];
+    }
+    return ADXL345_powerSensorCurrentUa((config->idleRate & ADXL345_RATE_MASK) |
+                                        (config->idleLowPower ? ADXL345_LOW_POWER : 0));
+}
+
+/**
+ * Returns the sample period in the current state.
+ */
+static uint32_t ADXL345_PowerStatePeriodUs(const ADXL345_POWER *power) {
+    const ADXL345_POWER_CONFIG *config = &power->config;
+    if (power->state == ADXL345_POWER_ACTIVE) {
+        return ADXL345_samplePeriodUs(config->activeRate);
+    }
+    if (config->autoSleep) {
+        // 8 Hz, halving with each step of the wakeup bits
+        return 125000u << (config->wakeupRate & ADXL345_WAKEUP_MASK);
+    }
+    return ADXL345_samplePeriodUs(config->idleRate);
+}
+
+#if ADXL345_EVENTS_GPIO
+/**
+ * Service task, blocks until the interrupt pin is high, services the sensor
+ * and then lets the pin interrupt again.
+ *
+ * @param arg ADXL345_POWER to service
+ */
+static void ADXL345_PowerTask(void *arg) {
+    ADXL345_POWER *power = (ADXL345_POWER *) arg;
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        ADXL345_powerService(power, power->edgeUs);
+        power->edgeUs = 0;
+        gpio_intr_enable(power->pin);
+    }
+}
+
+/**
+ * GPIO interrupt handler.  The pin stays high until the task has read
+ * INT_SOURCE, so the interrupt is masked until then.
+ *
+ * @param arg ADXL345_POWER to service
+ */
+static void IRAM_ATTR ADXL345_PowerIsr(void *arg) {
+    ADXL345_POWER *power = (ADXL345_POWER *) arg;
+    BaseType_t higherPriorityWoken = pdFALSE;
+    power->edgeUs = esp_timer_get_time();
+    gpio_intr_disable(power->pin);
+    vTaskNotifyGiveFromISR(power->task, &higherPriorityWoken);
+    portYIELD_FROM_ISR(higherPriorityWoken);
+}
+#endif
@@ -0,0 +1,129 @@
+/**
+ * File:       ADXL345_power.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "ADXL345.h"
+#include "ADXL345_events.h"
+
+// Automatic light sleep needs the power management component, which the
+// Linux target doesn't have
+#if __has_include("esp_pm.h")
+#define ADXL345_POWER_PM        1
+#else
+#define ADXL345_POWER_PM        0
+#endif
+
+typedef enum _adxl345PowerState {
+    ADXL345_POWER_ACTIVE = 0,
+    ADXL345_POWER_IDLE
+} ADXL345_POWER_STATE;
+
+// Called with each block drained on a watermark, and the BW_RATE it was sampled at
+typedef void (*ADXL345_POWER_BLOCK_CALLBACK)(const ADXL345_BLOCK *block, uint8_t bwRate, void *arg);
+
+// Called after the sensor has been switched to the param state
+typedef void (*ADXL345_POWER_STATE_CALLBACK)(ADXL345_POWER_STATE state, void *arg);
+
+typedef struct _adxl345PowerConfig {
+    // BW_RATE rate codes while moving and while still
+    uint8_t activeRate;
+    uint8_t idleRate;
+    // Set LOW_POWER while still, only honoured by the sensor from 12.5 to 400 Hz
+    bool idleLowPower;
+    // FIFO watermarks, only used when the manager drains the FIFO itself
+    uint8_t activeWatermark;
+    uint8_t idleWatermark;
+
+    // Activity and inactivity are always AC coupled on every axis
+    uint16_t activityMg;
+    uint16_t inactivityMg;
+    uint8_t inactivitySeconds;
+    // Let the sensor sleep at the wakeup rate once still
+    bool autoSleep;
+    uint8_t wakeupRate;
+
+    // Energy model.  Host currents of zero leave the host out of the figures.
+    uint16_t supplyMv;
+    uint32_t hostActiveUa;
+    uint32_t hostSleepUa;
+} ADXL345_POWER_CONFIG;
+
+typedef struct _adxl345PowerStats {
+    // Idle to active and active to idle transitions
+    uint32_t wakes;
+    uint32_t sleeps;
+    uint64_t activeUs;
+    uint64_t idleUs;
+    // Samples the sensor produced, from the rate in force over time
+    uint64_t samples;
+    uint64_t sensorUj;
+    // Host time spent servicing the sensor, and the host energy around it
+    uint64_t hostAwakeUs;
+    uint64_t hostUj;
+    uint32_t samplesPerJoule;
+    // From the activity interrupt to the active rate being in force
+    uint32_t lastWakeLatencyUs;
+    uint32_t maxWakeLatencyUs;
+    uint64_t totalWakeLatencyUs;
+} ADXL345_POWER_STATS;
+
+typedef struct _adxl345Power {
+    ADXL345_DEVICE *dev;
+    ADXL345_EVENTS events;
+    ADXL345_POWER_CONFIG config;
+    ADXL345_POWER_STATE state;
+    ADXL345_POWER_BLOCK_CALLBACK onBlock;
+    ADXL345_POWER_STATE_CALLBACK onState;
+    void *arg;
+    ADXL345_BLOCK block;
+
+    // When the interrupt being serviced was raised, and the end of the
+    // host time already counted as awake
+    int64_t edgeUs;
+    int64_t awakeUntilUs;
+    // Energy and samples are integrated up to here, energy in pico-joules
+    int64_t accountedUs;
+    uint64_t sampleTimeUs;
+    uint64_t sensorPj;
+    uint64_t hostPj;
+    SemaphoreHandle_t lock;
+    ADXL345_POWER_STATS stats;
+
+#if ADXL345_EVENTS_GPIO
+    gpio_num_t pin;
+    TaskHandle_t task;
+#endif
+} ADXL345_POWER;
+
+
+// Public methods designed for the user to call
+void ADXL345_powerConfigInit(ADXL345_POWER_CONFIG *config);
+
+esp_err_t ADXL345_powerInit(ADXL345_POWER *power, ADXL345_DEVICE *dev, const ADXL345_POWER_CONFIG *config,
+                            ADXL345_POWER_BLOCK_CALLBACK onBlock, ADXL345_POWER_STATE_CALLBACK onState, void *arg);
+
+esp_err_t ADXL345_powerService(ADXL345_POWER *power, int64_t edgeUs);
+
+esp_err_t ADXL345_powerRestore(ADXL345_POWER *power);
+
+#if ADXL345_EVENTS_GPIO
+esp_err_t ADXL345_powerStart(ADXL345_POWER *power, gpio_num_t pin, UBaseType_t priority, BaseType_t core);
+#endif
+
+esp_err_t ADXL345_powerEnableLightSleep(int maxFreqMhz, int minFreqMhz);
+
+void ADXL345_powerGetStats(ADXL345_POWER *power, ADXL345_POWER_STATS *stats);
+
+uint32_t ADXL345_powerSensorCurrentUa(uint8_t bwRate);
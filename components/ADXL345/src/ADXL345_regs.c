@@ -0,0 +1,59 @@
+/**
+ * File:       ADXL345_regs.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include "ADXL345_regs.h"
+
+// Indexed by address, with the reset values from the datasheet.  Addresses
+// that aren't listed are reserved, and can be neither read nor written.
+const ADXL345_REGISTER ADXL345_REGISTERS[ADXL345_REGISTER_COUNT] = {
+    [ADXL345_DEVID]          = { "DEVID",          ADXL345_ACCESS_R,  0xE5 },
+    [ADXL345_THRESH_TAP]     = { "THRESH_TAP",     ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_OFSX]           = { "OFSX",           ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_OFSY]           = { "OFSY",           ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_OFSZ]           = { "OFSZ",           ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_DUR]            = { "DUR",            ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_LATENT]         = { "LATENT",         ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_WINDOW]         = { "WINDOW",         ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_THRESH_ACT]     = { "THRESH_ACT",     ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_THRESH_INACT]   = { "THRESH_INACT",   ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_TIME_INACT]     = { "TIME_INACT",     ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_ACT_INACT_CTL]  = { "ACT_INACT_CTL",  ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_THRESH_FF]      = { "THRESH_FF",      ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_TIME_FF]        = { "TIME_FF",        ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_TAP_AXES]       = { "TAP_AXES",       ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_ACT_TAP_STATUS] = { "ACT_TAP_STATUS", ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_BW_RATE]        = { "BW_RATE",        ADXL345_ACCESS_RW, 0x0A },
+    [ADXL345_POWER_CTL]      = { "POWER_CTL",      ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_INT_ENABLE]     = { "INT_ENABLE",     ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_INT_MAP]        = { "INT_MAP",        ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_INT_SOURCE]     = { "INT_SOURCE",     ADXL345_ACCESS_R,  0x02 },
+    [ADXL345_DATA_FORMAT]    = { "DATA_FORMAT",    ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_DATAX0]         = { "DATAX0",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_DATAX1]         = { "DATAX1",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_DATAY0]         = { "DATAY0",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_DATAY1]         = { "DATAY1",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_DATAZ0]         = { "DATAZ0",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_DATAZ1]         = { "DATAZ1",         ADXL345_ACCESS_R,  0x00 },
+    [ADXL345_FIFO_CTL]       = { "FIFO_CTL",       ADXL345_ACCESS_RW, 0x00 },
+    [ADXL345_FIFO_STATUS]    = { "FIFO_STATUS",    ADXL345_ACCESS_R,  0x00 },
+};
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Returns the datasheet name of the param register, or NULL for a reserved
+ * address.
+ *
+ * @param reg Register address
+ */
+const char *ADXL345_regName(uint8_t reg) {
+    if (reg >= ADXL345_REGISTER_COUNT) {
+        return NULL;
+    }
+    return ADXL345_REGISTERS[reg].name;
+}
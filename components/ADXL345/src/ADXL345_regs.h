@@ -0,0 +1,184 @@
+/**
+ * File:       ADXL345_regs.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Register map of the ADXL345.  Every register's address, and every field's
+ * register, bit offset and width, is a constant here, so the macros below
+ * that build and pick apart register values fold down to a constant mask
+ * and shift, and several fields ORed into one register value fold down to
+ * a single constant wherever their values are constant.  The access mode
+ * and reset value of each register live in ADXL345_REGISTERS, which the
+ * driver checks before it writes.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct _adxl345Register {
+    const char *name;
+    uint8_t access;
+    uint8_t resetValue;
+} ADXL345_REGISTER;
+
+// ADXL345 Register Definitions
+#define ADXL345_DEVID           0x00
+#define ADXL345_THRESH_TAP      0x1D
+#define ADXL345_OFSX            0x1E
+#define ADXL345_OFSY            0x1F
+#define ADXL345_OFSZ            0x20
+#define ADXL345_DUR             0x21
+#define ADXL345_LATENT          0x22
+#define ADXL345_WINDOW          0x23
+#define ADXL345_THRESH_ACT      0x24
+#define ADXL345_THRESH_INACT    0x25
+#define ADXL345_TIME_INACT      0x26
+#define ADXL345_ACT_INACT_CTL   0x27
+#define ADXL345_THRESH_FF       0x28
+#define ADXL345_TIME_FF         0x29
+#define ADXL345_TAP_AXES        0x2A
+#define ADXL345_ACT_TAP_STATUS  0x2B
+#define ADXL345_BW_RATE         0x2C
+#define ADXL345_POWER_CTL       0x2D
+#define ADXL345_INT_ENABLE      0x2E
+#define ADXL345_INT_MAP         0x2F
+#define ADXL345_INT_SOURCE      0x30
+#define ADXL345_DATA_FORMAT     0x31
+#define ADXL345_DATAX0          0x32
+#define ADXL345_DATAX1          0x33
+#define ADXL345_DATAY0          0x34
+#define ADXL345_DATAY1          0x35
+#define ADXL345_DATAZ0          0x36
+#define ADXL345_DATAZ1          0x37
+#define ADXL345_FIFO_CTL        0x38
+#define ADXL345_FIFO_STATUS     0x39
+
+// Register access modes, reserved addresses have neither
+#define ADXL345_ACCESS_NONE     0x00
+#define ADXL345_ACCESS_R        0x01
+#define ADXL345_ACCESS_W        0x02
+#define ADXL345_ACCESS_RW       (ADXL345_ACCESS_R | ADXL345_ACCESS_W)
+
+// Register fields, each a register, bit offset, width triple that's passed
+// whole to the ADXL345_FIELD_* macros
+#define ADXL345_F_INACT_AXES    ADXL345_ACT_INACT_CTL, 0, 3
+#define ADXL345_F_INACT_AC      ADXL345_ACT_INACT_CTL, 3, 1
+#define ADXL345_F_ACT_AXES      ADXL345_ACT_INACT_CTL, 4, 3
+#define ADXL345_F_ACT_AC        ADXL345_ACT_INACT_CTL, 7, 1
+#define ADXL345_F_TAP_AXES      ADXL345_TAP_AXES, 0, 3
+#define ADXL345_F_TAP_SUPPRESS  ADXL345_TAP_AXES, 3, 1
+#define ADXL345_F_ASLEEP        ADXL345_ACT_TAP_STATUS, 3, 1
+#define ADXL345_F_RATE          ADXL345_BW_RATE, 0, 4
+#define ADXL345_F_LOW_POWER     ADXL345_BW_RATE, 4, 1
+#define ADXL345_F_WAKEUP        ADXL345_POWER_CTL, 0, 2
+#define ADXL345_F_SLEEP         ADXL345_POWER_CTL, 2, 1
+#define ADXL345_F_MEASURE       ADXL345_POWER_CTL, 3, 1
+#define ADXL345_F_AUTO_SLEEP    ADXL345_POWER_CTL, 4, 1
+#define ADXL345_F_LINK          ADXL345_POWER_CTL, 5, 1
+#define ADXL345_F_RANGE         ADXL345_DATA_FORMAT, 0, 2
+#define ADXL345_F_JUSTIFY       ADXL345_DATA_FORMAT, 2, 1
+#define ADXL345_F_FULL_RES      ADXL345_DATA_FORMAT, 3, 1
+#define ADXL345_F_INT_INVERT    ADXL345_DATA_FORMAT, 5, 1
+#define ADXL345_F_SPI_3WIRE     ADXL345_DATA_FORMAT, 6, 1
+#define ADXL345_F_SELF_TEST     ADXL345_DATA_FORMAT, 7, 1
+#define ADXL345_F_SAMPLES       ADXL345_FIFO_CTL, 0, 5
+#define ADXL345_F_TRIGGER_INT2  ADXL345_FIFO_CTL, 5, 1
+#define ADXL345_F_FIFO_MODE     ADXL345_FIFO_CTL, 6, 2
+#define ADXL345_F_ENTRIES       ADXL345_FIFO_STATUS, 0, 6
+#define ADXL345_F_FIFO_TRIG     ADXL345_FIFO_STATUS, 7, 1
+
+// The single field macros also take a field's triple already expanded, so
+// they can be used inside other macros
+// Register holding the param field
+#define ADXL345_FIELD_REG(...)                      ADXL345_FIELD_REG_(__VA_ARGS__)
+// Bits of its register the param field covers
+#define ADXL345_FIELD_MASK(...)                     ADXL345_FIELD_MASK_(__VA_ARGS__)
+// Largest value the param field holds
+#define ADXL345_FIELD_MAX(...)                      ADXL345_FIELD_MAX_(__VA_ARGS__)
+// The param value moved into the param field's bits, to OR with other fields
+// of the same register
+#define ADXL345_FIELD_VALUE(field, value)           ADXL345_FIELD_VALUE_(field, value)
+// The param field's value out of the param register value
+#define ADXL345_FIELD_GET(field, regValue)          ADXL345_FIELD_GET_(field, regValue)
+// The param register value with the param field replaced by the param value
+#define ADXL345_FIELD_UPDATE(field, regValue, value) ADXL345_FIELD_UPDATE_(field, regValue, value)
+// Fails the build unless the param fields share a register, for values that
+// combine them
+#define ADXL345_FIELDS_SHARE_REG(first, second) \
+    _Static_assert(ADXL345_FIELD_REG(first) == ADXL345_FIELD_REG(second), "Fields are in different registers")
+
+// Registers from the param first to the param last inclusive, for bursts
+#define ADXL345_BURST_LENGTH(first, last)           ((last) - (first) + 1)
+// The three axes, read in one burst so they come from the same conversion
+#define ADXL345_DATA_BURST_LENGTH                   ADXL345_BURST_LENGTH(ADXL345_DATAX0, ADXL345_DATAZ1)
+#define ADXL345_OFS_BURST_LENGTH                    ADXL345_BURST_LENGTH(ADXL345_OFSX, ADXL345_OFSZ)
+// BW_RATE and POWER_CTL, read together to check the sensor hasn't reset
+#define ADXL345_RATE_POWER_BURST_LENGTH             ADXL345_BURST_LENGTH(ADXL345_BW_RATE, ADXL345_POWER_CTL)
+
+_Static_assert(ADXL345_DATA_BURST_LENGTH == 6, "DATAX0 to DATAZ1 must be contiguous");
+_Static_assert(ADXL345_OFS_BURST_LENGTH == 3, "OFSX to OFSZ must be contiguous");
+_Static_assert(ADXL345_RATE_POWER_BURST_LENGTH == 2, "BW_RATE and POWER_CTL must be adjacent");
+
+// Bitmasks for various registers
+#define ADXL345_LINK            ADXL345_FIELD_MASK(ADXL345_F_LINK)
+#define ADXL345_AUTO_SLEEP      ADXL345_FIELD_MASK(ADXL345_F_AUTO_SLEEP)
+#define ADXL345_MEASURE         ADXL345_FIELD_MASK(ADXL345_F_MEASURE)
+#define ADXL345_SLEEP           ADXL345_FIELD_MASK(ADXL345_F_SLEEP)
+#define ADXL345_WAKEUP_MASK     ADXL345_FIELD_MASK(ADXL345_F_WAKEUP)
+#define ADXL345_LOW_POWER       ADXL345_FIELD_MASK(ADXL345_F_LOW_POWER)
+#define ADXL345_RATE_MASK       ADXL345_FIELD_MASK(ADXL345_F_RATE)
+#define ADXL345_FULL_RES        ADXL345_FIELD_MASK(ADXL345_F_FULL_RES)
+#define ADXL345_JUSTIFY         ADXL345_FIELD_MASK(ADXL345_F_JUSTIFY)
+#define ADXL345_INT_INVERT      ADXL345_FIELD_MASK(ADXL345_F_INT_INVERT)
+#define ADXL345_RANGE_MASK      ADXL345_FIELD_MASK(ADXL345_F_RANGE)
+#define ADXL345_FIFO_SAMPLES    ADXL345_FIELD_MASK(ADXL345_F_SAMPLES)
+#define ADXL345_FIFO_ENTRIES    ADXL345_FIELD_MASK(ADXL345_F_ENTRIES)
+#define ADXL345_FIFO_INT2       ADXL345_FIELD_MASK(ADXL345_F_TRIGGER_INT2)
+#define ADXL345_FIFO_TRIG       ADXL345_FIELD_MASK(ADXL345_F_FIFO_TRIG)
+#define ADXL345_TAP_SUPPRESS    ADXL345_FIELD_MASK(ADXL345_F_TAP_SUPPRESS)
+#define ADXL345_ACT_AC          ADXL345_FIELD_MASK(ADXL345_F_ACT_AC)
+#define ADXL345_INACT_AC        ADXL345_FIELD_MASK(ADXL345_F_INACT_AC)
+#define ADXL345_STATUS_ASLEEP   ADXL345_FIELD_MASK(ADXL345_F_ASLEEP)
+
+// One past the last register, the size of ADXL345_REGISTERS
+#define ADXL345_REGISTER_COUNT  (ADXL345_FIFO_STATUS + 1)
+
+extern const ADXL345_REGISTER ADXL345_REGISTERS[ADXL345_REGISTER_COUNT];
+
+
+// Public methods designed for the user to call
+const char *ADXL345_regName(uint8_t reg);
+
+/**
+ * Returns whether every register from the param reg for the param length
+ * can be written.
+ *
+ * @param reg    First register
+ * @param length Number of registers
+ */
+static inline bool ADXL345_regWritable(uint8_t reg, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (reg + i >= ADXL345_REGISTER_COUNT || !(ADXL345_REGISTERS[reg + i].access & ADXL345_ACCESS_W)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Expansions of the field macros, with the field's triple as separate arguments
+#define ADXL345_FIELD_REG_(reg, shift, width)       (reg)
+#define ADXL345_FIELD_MAX_(reg, shift, width)       ((uint8_t) ((1u << (width)) - 1u))
+#define ADXL345_FIELD_MASK_(reg, shift, width)      ((uint8_t) (((1u << (width)) - 1u) << (shift)))
+#define ADXL345_FIELD_VALUE_(reg, shift, width, value) \
+    ((uint8_t) ((((unsigned) (value)) << (shift)) & ADXL345_FIELD_MASK_(reg, shift, width)))
+#define ADXL345_FIELD_GET_(reg, shift, width, regValue) \
+    ((uint8_t) ((((unsigned) (regValue)) & ADXL345_FIELD_MASK_(reg, shift, width)) >> (shift)))
+#define ADXL345_FIELD_UPDATE_(reg, shift, width, regValue, value) \
+    ((uint8_t) ((((unsigned) (regValue)) & (uint8_t) ~ADXL345_FIELD_MASK_(reg, shift, width)) | \
+                ADXL345_FIELD_VALUE_(reg, shift, width, value)))
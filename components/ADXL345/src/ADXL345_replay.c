@@ -0,0 +1,343 @@
+/**
+ * File:       ADXL345_replay.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Replays a captured trace (see ADXL345_trace.c) to the driver in place of a
+ * sensor.  Each transfer the driver makes is matched to the next recorded
+ * one with the same direction, register and lengths, and gets that one's
+ * result and bytes back.  The driver only reacts to what the bus tells it,
+ * so it takes the same path it took in the field, retries and recoveries
+ * included.
+ *
+ * In real time mode each transfer also holds the replayed bus for as long
+ * as it held the real one, counted from when the bus came free so queueing
+ * isn't counted twice.  Otherwise transfers complete as soon as the timer
+ * task gets to them, for quick deterministic runs.  Either way a transfer
+ * that never completed in the field holds the bus until the driver recovers
+ * it, so the driver's timeouts fire just as they did.  A synchronous
+ * transfer whose wait times out stays on the replayed bus, but detached from
+ * its caller, so the timer never writes to a buffer the caller has reused.
+ */
+#include <string.h>
+#include "ADXL345_replay.h"
+
+// Values of syncState: no synchronous transfer, one still queued, and one
+// the timer has played whose completion is on its way
+#define ADXL345_REPLAY_SYNC_IDLE        0
+#define ADXL345_REPLAY_SYNC_QUEUED      1
+#define ADXL345_REPLAY_SYNC_COMPLETING  2
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_ReplayWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_ReplayWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_ReplaySubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                      ADXL345_TRANSPORT_DONE done, void *arg);
+static esp_err_t ADXL345_ReplayRecover(void *ctx);
+static bool ADXL345_ReplaySyncDone(esp_err_t result, void *arg);
+static bool ADXL345_ReplayAbandon(ADXL345_REPLAY *replay);
+static bool ADXL345_ReplayDropped(esp_err_t result, void *arg);
+static void ADXL345_ReplayTimer(void *arg);
+static void ADXL345_ReplayStart(ADXL345_REPLAY *replay, ADXL345_REPLAY_REQUEST *request);
+static const ADXL345_TRACE_ENTRY *ADXL345_ReplayMatch(ADXL345_REPLAY *replay, ADXL345_TRACE_OP op, const uint8_t *tx,
+                                                      size_t txLength, size_t rxLength);
+static bool ADXL345_ReplaySameOp(uint8_t recorded, ADXL345_TRACE_OP op);
+
+static const ADXL345_TRANSPORT_OPS ADXL345_REPLAY_OPS = {
+    .write = ADXL345_ReplayWrite,
+    .writeRead = ADXL345_ReplayWriteRead,
+    .submitWriteRead = ADXL345_ReplaySubmit,
+    .recover = ADXL345_ReplayRecover,
+};
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Sets up a replay of the param recorded transfers.
+ *
+ * @param replay   ADXL345_REPLAY to initialize
+ * @param entries  Recorded transfers, oldest first, must outlive the replay
+ * @param count    Number of recorded transfers
+ * @param realTime true to reproduce the recorded timing
+ */
+esp_err_t ADXL345_replayInit(ADXL345_REPLAY *replay, const ADXL345_TRACE_ENTRY *entries, size_t count, bool realTime) {
+    memset(replay, 0, sizeof(*replay));
+    replay->entries = entries;
+    replay->count = count;
+    replay->realTime = realTime;
+    replay->lastEndUs = (count > 0) ? entries[0].startUs : 0;
+
+    replay->lock = xSemaphoreCreateMutex();
+    replay->waitLock = xSemaphoreCreateMutex();
+    replay->syncDone = xSemaphoreCreateBinary();
+    if (replay->lock == NULL || replay->waitLock == NULL || replay->syncDone == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t timerArgs = {
+        .callback = ADXL345_ReplayTimer,
+        .arg = replay,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "adxl345_replay",
+    };
+    return esp_timer_create(&timerArgs, &replay->timer);
+}
+
+/**
+ * Sets up a transport that plays back the param replay.  It is always
+ * asynchronous, whatever the recorded transport was.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param replay    ADXL345_REPLAY to play, must outlive the transport
+ */
+void ADXL345_replayTransport(ADXL345_TRANSPORT *transport, ADXL345_REPLAY *replay) {
+    transport->ops = &ADXL345_REPLAY_OPS;
+    transport->ctx = replay;
+}
+
+/**
+ * Returns whether every recorded transfer has been played back.
+ *
+ * @param replay ADXL345_REPLAY to check
+ */
+bool ADXL345_replayFinished(ADXL345_REPLAY *replay) {
+    xSemaphoreTake(replay->lock, portMAX_DELAY);
+    bool finished = replay->next >= replay->count;
+    xSemaphoreGive(replay->lock);
+    return finished;
+}
+
+
+// 'Private' functions designed for internal use
+
+static esp_err_t ADXL345_ReplayWrite(void *ctx, const uint8_t *data, size_t length) {
+    return ADXL345_ReplayWriteRead(ctx, data, length, NULL, 0);
+}
+
+/**
+ * Queues a transfer and blocks until it completes.  If the wait times out
+ * while the transfer is still queued it is detached from the caller, and if
+ * the timer has just played it, its completion is taken after all.
+ */
+static esp_err_t ADXL345_ReplayWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    ADXL345_REPLAY *replay = (ADXL345_REPLAY *) ctx;
+
+    xSemaphoreTake(replay->waitLock, portMAX_DELAY);
+    esp_err_t err = ADXL345_ReplaySubmit(replay, tx, txLength, rx, rxLength, ADXL345_ReplaySyncDone, replay);
+    if (err == ESP_OK) {
+        bool completed = xSemaphoreTake(replay->syncDone, pdMS_TO_TICKS(ADXL345_REPLAY_TIMEOUT_MS)) == pdTRUE;
+        if (!completed && !ADXL345_ReplayAbandon(replay)) {
+            xSemaphoreTake(replay->syncDone, portMAX_DELAY);
+            completed = true;
+        }
+        err = completed ? replay->syncResult : ESP_ERR_TIMEOUT;
+    }
+    replay->syncState = ADXL345_REPLAY_SYNC_IDLE;
+    xSemaphoreGive(replay->waitLock);
+    return err;
+}
+
+/**
+ * Matches the transfer to the recording and queues it, starting the bus if
+ * it was idle.  Writes with no read are matched against recorded writes, and
+ * reads against recorded reads whether they were queued or not.
+ */
+static esp_err_t ADXL345_ReplaySubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                      ADXL345_TRANSPORT_DONE done, void *arg) {
+    ADXL345_REPLAY *replay = (ADXL345_REPLAY *) ctx;
+    ADXL345_TRACE_OP op = (rxLength > 0) ? ADXL345_TRACE_READ : ADXL345_TRACE_WRITE;
+
+    xSemaphoreTake(replay->lock, portMAX_DELAY);
+    if (replay->queueCount == ADXL345_REPLAY_QUEUE_DEPTH) {
+        xSemaphoreGive(replay->lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ADXL345_REPLAY_REQUEST *request = &replay->queue[(replay->queueHead + replay->queueCount) % ADXL345_REPLAY_QUEUE_DEPTH];
+    request->entry = ADXL345_ReplayMatch(replay, op, tx, txLength, rxLength);
+    request->rx = rx;
+    request->rxLength = rxLength;
+    request->durationUs = 0;
+    request->done = done;
+    request->arg = arg;
+    if (done == ADXL345_ReplaySyncDone) {
+        replay->syncState = ADXL345_REPLAY_SYNC_QUEUED;
+    }
+
+    // Time on the wire, from when the recorded bus came free
+    const ADXL345_TRACE_ENTRY *entry = request->entry;
+    if (replay->realTime && entry != NULL && entry->endUs >= entry->startUs) {
+        int64_t fromUs = (entry->startUs > replay->lastEndUs) ? entry->startUs : replay->lastEndUs;
+        request->durationUs = (entry->endUs > fromUs) ? (uint32_t) (entry->endUs - fromUs) : 0;
+        replay->lastEndUs = entry->endUs;
+    }
+
+    replay->queueCount++;
+    if (replay->queueCount == 1) {
+        ADXL345_ReplayStart(replay, request);
+    }
+    xSemaphoreGive(replay->lock);
+    return ESP_OK;
+}
+
+/**
+ * Drops everything queued without a completion, as a real recovery would,
+ * and consumes the recorded recovery.
+ */
+static esp_err_t ADXL345_ReplayRecover(void *ctx) {
+    ADXL345_REPLAY *replay = (ADXL345_REPLAY *) ctx;
+
+    xSemaphoreTake(replay->lock, portMAX_DELAY);
+    const ADXL345_TRACE_ENTRY *entry = ADXL345_ReplayMatch(replay, ADXL345_TRACE_RECOVER, NULL, 0, 0);
+    esp_timer_stop(replay->timer);
+    replay->dropped += replay->queueCount;
+    replay->queueCount = 0;
+    if (replay->syncState == ADXL345_REPLAY_SYNC_QUEUED) {
+        // Dropped with the rest, its wait will time out
+        replay->syncState = ADXL345_REPLAY_SYNC_IDLE;
+    }
+    replay->busFreeUs = 0;
+    if (entry != NULL) {
+        replay->lastEndUs = entry->endUs;
+    }
+    xSemaphoreGive(replay->lock);
+    return (entry != NULL) ? entry->result : ESP_OK;
+}
+
+static bool ADXL345_ReplaySyncDone(esp_err_t result, void *arg) {
+    ADXL345_REPLAY *replay = (ADXL345_REPLAY *) arg;
+    replay->syncResult = result;
+    xSemaphoreGive(replay->syncDone);
+    return false;
+}
+
+/**
+ * Detaches the synchronous transfer that's being waited on from its caller
+ * if it's still queued, leaving it to hold the replayed bus as it would
+ * have held the real one.  Takes the lock.
+ *
+ * @param replay ADXL345_REPLAY the transfer was queued on
+ * @return false if the timer has already played it, so its completion is
+ *         on its way and must be taken
+ */
+static bool ADXL345_ReplayAbandon(ADXL345_REPLAY *replay) {
+    xSemaphoreTake(replay->lock, portMAX_DELAY);
+    bool abandoned = replay->syncState != ADXL345_REPLAY_SYNC_COMPLETING;
+    for (int i = 0; i < replay->queueCount; i++) {
+        ADXL345_REPLAY_REQUEST *request = &replay->queue[(replay->queueHead + i) % ADXL345_REPLAY_QUEUE_DEPTH];
+        if (request->done == ADXL345_ReplaySyncDone) {
+            request->rx = NULL;
+            request->rxLength = 0;
+            request->done = ADXL345_ReplayDropped;
+        }
+    }
+    replay->syncState = ADXL345_REPLAY_SYNC_IDLE;
+    xSemaphoreGive(replay->lock);
+    return abandoned;
+}
+
+// Completion of a synchronous transfer whose caller stopped waiting
+static bool ADXL345_ReplayDropped(esp_err_t result, void *arg) {
+    return false;
+}
+
+/**
+ * Fires when the transfer at the head of the queue has held the replayed bus
+ * for its recorded time.  Hands back the recorded bytes and result, and
+ * starts the next one.  The bytes are copied under the lock, so a caller
+ * that gave up on the transfer has either detached it or will take its
+ * completion.
+ */
+static void ADXL345_ReplayTimer(void *arg) {
+    ADXL345_REPLAY *replay = (ADXL345_REPLAY *) arg;
+
+    xSemaphoreTake(replay->lock, portMAX_DELAY);
+    if (replay->queueCount == 0) {
+        // Dropped by a recovery while this was waiting for the lock
+        xSemaphoreGive(replay->lock);
+        return;
+    }
+    ADXL345_REPLAY_REQUEST request = replay->queue[replay->queueHead];
+    replay->queueHead = (replay->queueHead + 1) % ADXL345_REPLAY_QUEUE_DEPTH;
+    replay->queueCount--;
+    if (replay->queueCount > 0) {
+        ADXL345_ReplayStart(replay, &replay->queue[replay->queueHead]);
+    }
+    if (request.done == ADXL345_ReplaySyncDone) {
+        replay->syncState = ADXL345_REPLAY_SYNC_COMPLETING;
+    }
+
+    esp_err_t result = ESP_ERR_NOT_FOUND;
+    if (request.entry != NULL) {
+        const ADXL345_TRACE_ENTRY *entry = request.entry;
+        result = entry->result;
+        if (request.rxLength > 0) {
+            // Bytes past what the trace had room for read back as zero
+            size_t recorded = (entry->txLength < ADXL345_TRACE_DATA_BYTES) ? ADXL345_TRACE_DATA_BYTES - entry->txLength : 0;
+            if (recorded > request.rxLength) {
+                recorded = request.rxLength;
+            }
+            memset(request.rx, 0, request.rxLength);
+            memcpy(request.rx, &entry->data[entry->txLength], recorded);
+        }
+    }
+    xSemaphoreGive(replay->lock);
+    request.done(result, request.arg);
+}
+
+/**
+ * Puts the param transfer on the replayed bus.  One that never completed in
+ * the field holds the bus until a recovery.  Called with the lock held.
+ */
+static void ADXL345_ReplayStart(ADXL345_REPLAY *replay, ADXL345_REPLAY_REQUEST *request) {
+    const ADXL345_TRACE_ENTRY *entry = request->entry;
+    if (entry != NULL && entry->endUs < entry->startUs) {
+        return;
+    }
+    // Back to back transfers run to the replayed bus's own clock, so timer
+    // latency on one doesn't push back all the rest
+    int64_t now = esp_timer_get_time();
+    int64_t startUs = (replay->busFreeUs > now) ? replay->busFreeUs : now;
+    replay->busFreeUs = startUs + request->durationUs;
+    esp_timer_start_once(replay->timer, (uint64_t) (replay->busFreeUs - now));
+}
+
+/**
+ * Finds the next recorded transfer that matches, skipping at most
+ * ADXL345_REPLAY_SEARCH that don't.  Returns NULL and counts a mismatch if
+ * there is none.  Called with the lock held.
+ */
+static const ADXL345_TRACE_ENTRY *ADXL345_ReplayMatch(ADXL345_REPLAY *replay, ADXL345_TRACE_OP op, const uint8_t *tx,
+                                                      size_t txLength, size_t rxLength) {
+    for (size_t i = replay->next; i < replay->count && i <= replay->next + ADXL345_REPLAY_SEARCH; i++) {
+        const ADXL345_TRACE_ENTRY *entry = &replay->entries[i];
+        if (!ADXL345_ReplaySameOp(entry->op, op) || entry->txLength != txLength || entry->rxLength != rxLength) {
+            continue;
+        }
+        if (txLength > 0 && entry->data[0] != tx[0]) {
+            continue;
+        }
+
+        replay->skipped += i - replay->next;
+        replay->next = i + 1;
+        replay->replayed++;
+        return entry;
+    }
+    replay->mismatches++;
+    return NULL;
+}
+
+/**
+ * Whether a recorded op plays back the param one.  Queued and synchronous
+ * reads are interchangeable.
+ */
+static bool ADXL345_ReplaySameOp(uint8_t recorded, ADXL345_TRACE_OP op) {
+    if (op == ADXL345_TRACE_READ) {
+        return recorded == ADXL345_TRACE_READ || recorded == ADXL345_TRACE_SUBMIT;
+    }
+    return recorded == op;
+}
@@ -0,0 +1,72 @@
+/**
+ * File:       ADXL345_replay.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ADXL345_transport.h"
+#include "ADXL345_trace.h"
+
+// Transfers that can be queued on the replayed bus at once
+#define ADXL345_REPLAY_QUEUE_DEPTH  40
+// How many recorded transfers may be skipped looking for a match
+#define ADXL345_REPLAY_SEARCH       8
+// Longest a synchronous transfer waits, including time queued behind others
+#define ADXL345_REPLAY_TIMEOUT_MS   100
+
+typedef struct _adxl345ReplayRequest {
+    // The recorded transfer this one plays back, NULL if none matched
+    const ADXL345_TRACE_ENTRY *entry;
+    uint8_t *rx;
+    size_t rxLength;
+    uint32_t durationUs;
+    ADXL345_TRANSPORT_DONE done;
+    void *arg;
+} ADXL345_REPLAY_REQUEST;
+
+typedef struct _adxl345Replay {
+    const ADXL345_TRACE_ENTRY *entries;
+    size_t count;
+    size_t next;
+    bool realTime;
+    // Recorded end of the last transfer matched, and when the replayed bus comes free
+    int64_t lastEndUs;
+    int64_t busFreeUs;
+
+    ADXL345_REPLAY_REQUEST queue[ADXL345_REPLAY_QUEUE_DEPTH];
+    int queueHead;
+    int queueCount;
+    esp_timer_handle_t timer;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t waitLock;
+    SemaphoreHandle_t syncDone;
+    esp_err_t syncResult;
+    // Where the synchronous transfer being waited on is, so a wait that
+    // times out knows whether the timer can still write to its buffer
+    uint8_t syncState;
+
+    // Statistics
+    uint32_t replayed;
+    uint32_t skipped;
+    uint32_t mismatches;
+    uint32_t dropped;
+} ADXL345_REPLAY;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_replayInit(ADXL345_REPLAY *replay, const ADXL345_TRACE_ENTRY *entries, size_t count, bool realTime);
+
+void ADXL345_replayTransport(ADXL345_TRANSPORT *transport, ADXL345_REPLAY *replay);
+
+bool ADXL345_replayFinished(ADXL345_REPLAY *replay);
@@ -0,0 +1,105 @@
+/**
+ * File:       ADXL345_ring.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include <string.h>
+#include "ADXL345_ring.h"
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Empties the ring and clears its statistics.
+ *
+ * @param ring ADXL345_RING to initialise
+ */
+void ADXL345_ringInit(ADXL345_RING *ring) {
+    memset(ring, 0, sizeof(*ring));
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+/**
+ * Producer side.  Returns the next free slot to fill in place, or NULL if the
+ * consumer has fallen behind and every slot is still in use.
+ * NOTE: A NULL return is counted as an overrun, the caller is expected to
+ *       leave the samples in the FIFO and try again later.
+ *
+ * @param ring ADXL345_RING to acquire a slot from
+ */
+ADXL345_BLOCK *ADXL345_ringAcquire(ADXL345_RING *ring) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= ADXL345_RING_SLOTS) {
+        ring->overruns++;
+        return NULL;
+    }
+    return &ring->slots[head & (ADXL345_RING_SLOTS - 1)];
+}
+
+/**
+ * Producer side.  Hands the slot returned by ADXL345_ringAcquire to the
+ * consumer.
+ *
+ * @param ring        ADXL345_RING to publish to
+ * @param timestampUs Time the block was taken, e.g. when the FIFO was drained
+ */
+void ADXL345_ringPublish(ADXL345_RING *ring, int64_t timestampUs) {
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    ring->timestampUs[head & (ADXL345_RING_SLOTS - 1)] = timestampUs;
+
+    // Release orders the slot contents before the new head is visible
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    ring->published++;
+
+    unsigned fill = head + 1 - atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (fill > ring->highWater) {
+        ring->highWater = fill;
+    }
+}
+
+/**
+ * Consumer side.  Returns the oldest published block, which may be processed
+ * in place until ADXL345_ringRelease is called, or NULL if the ring is empty.
+ *
+ * @param ring        ADXL345_RING to read from
+ * @param timestampUs Pointer to store the block timestamp in, may be NULL
+ */
+ADXL345_BLOCK *ADXL345_ringPeek(ADXL345_RING *ring, int64_t *timestampUs) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (head == tail) {
+        return NULL;
+    }
+    if (timestampUs != NULL) {
+        *timestampUs = ring->timestampUs[tail & (ADXL345_RING_SLOTS - 1)];
+    }
+    return &ring->slots[tail & (ADXL345_RING_SLOTS - 1)];
+}
+
+/**
+ * Consumer side.  Returns the block from ADXL345_ringPeek to the producer.
+ *
+ * @param ring ADXL345_RING to release a slot to
+ */
+void ADXL345_ringRelease(ADXL345_RING *ring) {
+    unsigned tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    // Release orders our reads of the slot before the producer can reuse it
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+/**
+ * Number of published blocks waiting for the consumer.  Only a snapshot when
+ * called from the producer side.
+ *
+ * @param ring ADXL345_RING to count
+ */
+uint32_t ADXL345_ringCount(ADXL345_RING *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
@@ -0,0 +1,48 @@
+/**
+ * File:       ADXL345_ring.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "ADXL345.h"
+
+// Number of block slots in the ring, must be a power of two
+#define ADXL345_RING_SLOTS      8
+
+/**
+ * Lock free single producer, single consumer ring of ADXL345_BLOCK slots.
+ * The producer fills a slot in place (e.g. straight from ADXL345_readFifo)
+ * and publishes it, the consumer reads and processes it in place and then
+ * releases it, so blocks are never copied and no mutex is taken.
+ */
+typedef struct _adxl345Ring {
+    ADXL345_BLOCK slots[ADXL345_RING_SLOTS];
+    int64_t timestampUs[ADXL345_RING_SLOTS];
+    // Free running counters, only ever written by one side each
+    atomic_uint head;
+    atomic_uint tail;
+    // Producer side statistics
+    uint32_t published;
+    uint32_t overruns;
+    uint32_t highWater;
+} ADXL345_RING;
+
+
+// Public methods designed for the user to call
+void ADXL345_ringInit(ADXL345_RING *ring);
+
+ADXL345_BLOCK *ADXL345_ringAcquire(ADXL345_RING *ring);
+
+void ADXL345_ringPublish(ADXL345_RING *ring, int64_t timestampUs);
+
+ADXL345_BLOCK *ADXL345_ringPeek(ADXL345_RING *ring, int64_t *timestampUs);
+
+void ADXL345_ringRelease(ADXL345_RING *ring);
+
+uint32_t ADXL345_ringCount(ADXL345_RING *ring);
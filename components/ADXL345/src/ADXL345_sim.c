@@ -0,0 +1,892 @@
+/**
+ * File:       ADXL345_sim.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Simulated ADXL345 behind an ADXL345_TRANSPORT, for exercising the driver
+ * and measuring pipelining on the Linux target or without hardware.
+ *
+ * The device model is a register file plus a FIFO that fills at the rate set
+ * in BW_RATE while measuring, with samples in milli-g from a pluggable
+ * generator (see ADXL345_simwave.h).  It follows the datasheet where the
+ * driver can tell the difference:
+ *
+ *   - Reads and writes auto increment from the addressed register, and
+ *     writes to read only registers are ignored.
+ *   - Samples are scaled, clipped and justified as DATA_FORMAT says, after
+ *     adding the offset registers at 15.6 mg/LSB.
+ *   - Bypass keeps only the newest sample, FIFO mode stops when full, stream
+ *     mode drops the oldest, and trigger mode streams until a mapped event
+ *     then keeps FIFO_CTL's sample count from before it and fills up.
+ *   - Activity, inactivity, free-fall and single tap are detected against
+ *     their threshold and time registers, and latch in INT_SOURCE until it
+ *     is read.  AC coupled activity compares against the sample it was armed
+ *     on, and AC coupled inactivity against the last sample over threshold.
+ *     Double tap is not modelled.
+ *   - LINK alternates activity and inactivity detection, and AUTO_SLEEP (or
+ *     the SLEEP bit) drops sampling to the wakeup rate until activity.
+ *   - INT_ENABLE, INT_MAP and INT_INVERT drive two interrupt pins, reported
+ *     through ADXL345_simSetInterruptCallback.
+ *
+ * The bus model serializes transfers and completes each one after the time it
+ * would take on the wire (nine clocks per byte including the address bytes,
+ * plus a fixed per transfer overhead), using a one shot esp_timer, so the
+ * caller's CPU really is free while a transfer is in flight.
+ *
+ * Faults can be injected to exercise the driver's recovery paths: random
+ * NACKs and timeouts, a slave holding the bus until it is recovered, and a
+ * brownout that silently puts the registers back to their power on values.
+ */
+#include <string.h>
+#include <stdlib.h>
+#include "ADXL345_sim.h"
+
+// Longest run of samples generated in one go, anything older is skipped
+#define ADXL345_SIM_MAX_CATCH_UP    (2 * ADXL345_FIFO_DEPTH)
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_SimWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_SimWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_SimSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                   ADXL345_TRANSPORT_DONE done, void *arg);
+static esp_err_t ADXL345_SimRecover(void *ctx);
+static bool ADXL345_SimSyncDone(esp_err_t result, void *arg);
+static void ADXL345_SimTimer(void *arg);
+static void ADXL345_SimSampleTimer(void *arg);
+static void ADXL345_SimUnlock(ADXL345_SIM *sim);
+static void ADXL345_SimStart(ADXL345_SIM *sim, ADXL345_SIM_REQUEST *request);
+static uint32_t ADXL345_SimRandomPermille(ADXL345_SIM *sim);
+static void ADXL345_SimPowerOn(ADXL345_SIM *sim);
+static void ADXL345_SimExecute(ADXL345_SIM *sim, ADXL345_SIM_REQUEST *request);
+static void ADXL345_SimWriteRegister(ADXL345_SIM *sim, uint8_t reg, uint8_t value);
+static void ADXL345_SimScheduleSamples(ADXL345_SIM *sim);
+static uint32_t ADXL345_SimPeriodUs(const ADXL345_SIM *sim);
+static void ADXL345_SimAdvance(ADXL345_SIM *sim, int64_t nowUs);
+static void ADXL345_SimDetect(ADXL345_SIM *sim, int64_t timeUs, const ADXL345_SAMPLE *milliG);
+static void ADXL345_SimPush(ADXL345_SIM *sim, const ADXL345_SAMPLE *sample);
+static int16_t ADXL345_SimToCounts(const ADXL345_SIM *sim, int axis, int32_t milliG);
+static uint8_t ADXL345_SimSources(const ADXL345_SIM *sim);
+static uint8_t ADXL345_SimPins(const ADXL345_SIM *sim);
+static void ADXL345_SimDefaultGenerator(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+
+static const ADXL345_TRANSPORT_OPS ADXL345_SIM_OPS = {
+    .write = ADXL345_SimWrite,
+    .writeRead = ADXL345_SimWriteRead,
+    .submitWriteRead = ADXL345_SimSubmit,
+    .recover = ADXL345_SimRecover,
+};
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Resets the simulated device to its power on state and sets up the bus
+ * model.
+ *
+ * @param sim        ADXL345_SIM to initialise
+ * @param busHz      Simulated SCL frequency
+ * @param overheadUs Fixed cost added to every transfer, for driver and ISR time
+ */
+esp_err_t ADXL345_simInit(ADXL345_SIM *sim, uint32_t busHz, uint32_t overheadUs) {
+    memset(sim, 0, sizeof(*sim));
+    sim->busHz = busHz;
+    sim->overheadUs = overheadUs;
+    sim->generator = ADXL345_SimDefaultGenerator;
+    sim->seed = 0x2545F491;
+    ADXL345_SimPowerOn(sim);
+
+    sim->lock = xSemaphoreCreateMutex();
+    sim->waitLock = xSemaphoreCreateMutex();
+    sim->syncDone = xSemaphoreCreateBinary();
+    if (sim->lock == NULL || sim->waitLock == NULL || sim->syncDone == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t timerArgs = {
+        .callback = ADXL345_SimTimer,
+        .arg = sim,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "adxl345_sim",
+    };
+    return esp_timer_create(&timerArgs, &sim->timer);
+}
+
+/**
+ * Replaces the source of simulated acceleration.  The default is the sensor
+ * lying flat and still, +1g on Z.  ADXL345_simwave.h has generators for
+ * sine, noise, shock and recorded motion.
+ *
+ * @param sim       ADXL345_SIM to set the generator on
+ * @param generator ADXL345_SIM_GENERATOR to call for each new sample
+ * @param arg       User argument passed to the generator
+ */
+void ADXL345_simSetGenerator(ADXL345_SIM *sim, ADXL345_SIM_GENERATOR generator, void *arg) {
+    sim->generator = generator;
+    sim->generatorArg = arg;
+}
+
+/**
+ * Sets up a transport that talks to the simulated device.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param sim       ADXL345_SIM to talk to, must outlive the transport
+ */
+void ADXL345_simTransport(ADXL345_TRANSPORT *transport, ADXL345_SIM *sim) {
+    transport->ops = &ADXL345_SIM_OPS;
+    transport->ctx = sim;
+}
+
+/**
+ * Changes the bus model, taking effect from the next transfer to start.
+ *
+ * @param sim        ADXL345_SIM to change
+ * @param busHz      Simulated SCL frequency
+ * @param overheadUs Fixed cost added to every transfer, for driver and ISR time
+ */
+void ADXL345_simSetBus(ADXL345_SIM *sim, uint32_t busHz, uint32_t overheadUs) {
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    sim->busHz = busHz;
+    sim->spi = false;
+    sim->overheadUs = overheadUs;
+    xSemaphoreGive(sim->lock);
+}
+
+/**
+ * Changes the bus model to 4-wire SPI, taking effect from the next transfer
+ * to start.  Faults are still injected as set, a NACK standing in for a
+ * transfer the sensor didn't answer.
+ *
+ * @param sim        ADXL345_SIM to change
+ * @param clockHz    Simulated SCLK frequency
+ * @param overheadUs Fixed cost added to every transfer, for driver and ISR time
+ */
+void ADXL345_simSetSpi(ADXL345_SIM *sim, uint32_t clockHz, uint32_t overheadUs) {
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    sim->busHz = clockHz;
+    sim->spi = true;
+    sim->overheadUs = overheadUs;
+    xSemaphoreGive(sim->lock);
+}
+
+/**
+ * Returns the simulated wire time of a transfer.
+ *
+ * @param sim      ADXL345_SIM to use the bus model of
+ * @param txLength Bytes written
+ * @param rxLength Bytes read back, 0 for a plain write
+ */
+uint32_t ADXL345_simTransferUs(const ADXL345_SIM *sim, size_t txLength, size_t rxLength) {
+    uint64_t bits;
+    if (sim->spi) {
+        // Eight clocks a byte, the register address being the first byte written
+        bits = (txLength + rxLength) * 8;
+    } else {
+        // Address byte for the write, and a repeated start plus address for the read
+        size_t bytes = 1 + txLength + ((rxLength > 0) ? 1 + rxLength : 0);
+        bits = bytes * 9 + 2;
+    }
+    return (uint32_t) ((bits * 1000000ull) / sim->busHz) + sim->overheadUs;
+}
+
+
+/**
+ * Sets the rate of injected transfer failures.  A NACKed transfer fails
+ * after its address byte, a timed out one holds the bus for the param
+ * timeout first, as the I2C controller's own timeout would.  Neither
+ * touches the register file.
+ *
+ * @param sim             ADXL345_SIM to inject faults into
+ * @param nackPermille    Chance of each transfer being NACKed, per thousand
+ * @param timeoutPermille Chance of each transfer timing out, per thousand
+ * @param timeoutUs       Bus time a timed out transfer takes
+ */
+void ADXL345_simSetFaults(ADXL345_SIM *sim, uint16_t nackPermille, uint16_t timeoutPermille, uint32_t timeoutUs) {
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    sim->nackPermille = nackPermille;
+    sim->timeoutPermille = timeoutPermille;
+    sim->timeoutUs = timeoutUs;
+    xSemaphoreGive(sim->lock);
+}
+
+/**
+ * Simulates a slave holding SDA low.  Every transfer times out until the
+ * transport's recover op clocks the bus free.
+ *
+ * @param sim   ADXL345_SIM to wedge
+ * @param stuck true to wedge the bus, false to let it go again
+ */
+void ADXL345_simSetStuck(ADXL345_SIM *sim, bool stuck) {
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    sim->stuck = stuck;
+    xSemaphoreGive(sim->lock);
+}
+
+/**
+ * Simulates a brownout: the registers go back to their power on values and
+ * the FIFO is emptied, with no error on the bus.
+ *
+ * @param sim ADXL345_SIM to power cycle
+ */
+void ADXL345_simPowerCycle(ADXL345_SIM *sim) {
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    ADXL345_SimPowerOn(sim);
+    ADXL345_SimUnlock(sim);
+}
+
+/**
+ * Sets the function told about changes on the simulated INT1 and INT2 pins,
+ * and starts sampling at the output data rate on a periodic timer, so that
+ * events and data ready are raised on time rather than on the next access.
+ * NOTE: Only changes are reported.  A pin that is already active when the
+ *       callback is set won't be, so service the device once afterwards.
+ *
+ * @param sim      ADXL345_SIM to watch the pins of
+ * @param callback ADXL345_SIM_INT_CALLBACK to call, or NULL to stop
+ * @param arg      User argument passed to the callback
+ */
+esp_err_t ADXL345_simSetInterruptCallback(ADXL345_SIM *sim, ADXL345_SIM_INT_CALLBACK callback, void *arg) {
+    if (sim->sampleTimer == NULL) {
+        esp_timer_create_args_t timerArgs = {
+            .callback = ADXL345_SimSampleTimer,
+            .arg = sim,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "adxl345_sim_odr",
+        };
+        esp_err_t err = esp_timer_create(&timerArgs, &sim->sampleTimer);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    sim->intCallback = callback;
+    sim->intArg = arg;
+    ADXL345_SimScheduleSamples(sim);
+    ADXL345_SimUnlock(sim);
+    return ESP_OK;
+}
+
+
+// 'Private' functions designed for internal use
+
+// Synchronous ops queue behind any async transfers and wait their turn
+static esp_err_t ADXL345_SimWrite(void *ctx, const uint8_t *data, size_t length) {
+    return ADXL345_SimWriteRead(ctx, data, length, NULL, 0);
+}
+
+static esp_err_t ADXL345_SimWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) ctx;
+
+    xSemaphoreTake(sim->waitLock, portMAX_DELAY);
+    // A completion that straggled in after an earlier wait timed out
+    xSemaphoreTake(sim->syncDone, 0);
+    esp_err_t err = ADXL345_SimSubmit(sim, tx, txLength, rx, rxLength, ADXL345_SimSyncDone, sim);
+    if (err == ESP_OK) {
+        if (xSemaphoreTake(sim->syncDone, pdMS_TO_TICKS(ADXL345_SIM_TIMEOUT_MS)) == pdTRUE) {
+            err = sim->syncResult;
+        } else {
+            err = ESP_ERR_TIMEOUT;
+        }
+    }
+    xSemaphoreGive(sim->waitLock);
+    return err;
+}
+
+/**
+ * Queues a transfer on the simulated bus, starting the bus if it was idle.
+ */
+static esp_err_t ADXL345_SimSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                   ADXL345_TRANSPORT_DONE done, void *arg) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) ctx;
+    if (txLength == 0 || txLength > ADXL345_SIM_MAX_TX) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    if (sim->queueCount == ADXL345_SIM_QUEUE_DEPTH) {
+        xSemaphoreGive(sim->lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ADXL345_SIM_REQUEST *request = &sim->queue[(sim->queueHead + sim->queueCount) % ADXL345_SIM_QUEUE_DEPTH];
+    memcpy(request->tx, tx, txLength);
+    request->txLength = txLength;
+    request->rx = rx;
+    request->rxLength = rxLength;
+    request->done = done;
+    request->arg = arg;
+
+    sim->queueCount++;
+    if (sim->queueCount == 1) {
+        ADXL345_SimStart(sim, request);
+    }
+    xSemaphoreGive(sim->lock);
+    return ESP_OK;
+}
+
+/**
+ * Clocks the simulated bus free.  Everything queued is dropped without a
+ * completion, as a controller reset would abort it.
+ */
+static esp_err_t ADXL345_SimRecover(void *ctx) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) ctx;
+
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    esp_timer_stop(sim->timer);
+    sim->queueCount = 0;
+    sim->stuck = false;
+    sim->recoveries++;
+    xSemaphoreGive(sim->lock);
+    return ESP_OK;
+}
+
+static bool ADXL345_SimSyncDone(esp_err_t result, void *arg) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) arg;
+    sim->syncResult = result;
+    xSemaphoreGive(sim->syncDone);
+    return false;
+}
+
+/**
+ * Fires when the transfer at the head of the queue has spent its time on
+ * the simulated wire.  Applies it to the device model, completes it, and
+ * starts the next one.
+ */
+static void ADXL345_SimTimer(void *arg) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) arg;
+
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    if (sim->queueCount == 0) {
+        // Dropped by a recovery while this was waiting for the lock
+        xSemaphoreGive(sim->lock);
+        return;
+    }
+    ADXL345_SIM_REQUEST request = sim->queue[sim->queueHead];
+    if (request.result == ESP_OK) {
+        ADXL345_SimExecute(sim, &request);
+    }
+    sim->transfers++;
+    sim->busyUs += request.durationUs;
+
+    sim->queueHead = (sim->queueHead + 1) % ADXL345_SIM_QUEUE_DEPTH;
+    sim->queueCount--;
+    if (sim->queueCount > 0) {
+        ADXL345_SimStart(sim, &sim->queue[sim->queueHead]);
+    }
+    ADXL345_SimUnlock(sim);
+
+    request.done(request.result, request.arg);
+}
+
+/**
+ * Fires at the output data rate while an interrupt callback is set.
+ */
+static void ADXL345_SimSampleTimer(void *arg) {
+    ADXL345_SIM *sim = (ADXL345_SIM *) arg;
+
+    xSemaphoreTake(sim->lock, portMAX_DELAY);
+    ADXL345_SimAdvance(sim, esp_timer_get_time());
+    ADXL345_SimUnlock(sim);
+}
+
+/**
+ * Releases the lock, then reports any interrupt pin that changed level while
+ * it was held.  The callback runs unlocked, so it may talk to the device.
+ */
+static void ADXL345_SimUnlock(ADXL345_SIM *sim) {
+    uint8_t pins = ADXL345_SimPins(sim);
+    uint8_t changed = pins ^ sim->pins;
+    ADXL345_SIM_INT_CALLBACK callback = sim->intCallback;
+    void *arg = sim->intArg;
+    sim->pins = pins;
+    xSemaphoreGive(sim->lock);
+
+    if (callback == NULL) {
+        return;
+    }
+    for (int pin = ADXL345_SIM_INT1; pin <= ADXL345_SIM_INT2; pin++) {
+        if (changed & (1 << pin)) {
+            callback(pin, (pins & (1 << pin)) != 0, arg);
+        }
+    }
+}
+
+/**
+ * Puts the param transfer on the wire, deciding up front whether it will
+ * fail, as that changes how long it holds the bus.  Called with the lock held.
+ */
+static void ADXL345_SimStart(ADXL345_SIM *sim, ADXL345_SIM_REQUEST *request) {
+    uint32_t roll = ADXL345_SimRandomPermille(sim);
+
+    if (sim->stuck || roll < sim->timeoutPermille) {
+        request->result = ESP_ERR_TIMEOUT;
+        request->durationUs = sim->timeoutUs;
+        sim->faults++;
+    } else if (roll < (uint32_t) sim->timeoutPermille + sim->nackPermille) {
+        // NACKed on the address byte
+        request->result = ESP_ERR_INVALID_RESPONSE;
+        request->durationUs = ADXL345_simTransferUs(sim, 0, 0);
+        sim->faults++;
+    } else {
+        request->result = ESP_OK;
+        request->durationUs = ADXL345_simTransferUs(sim, request->txLength, request->rxLength);
+    }
+    esp_timer_start_once(sim->timer, request->durationUs);
+}
+
+/**
+ * Returns a pseudo random number from 0 to 999, from a small xorshift
+ * generator so that fault runs are repeatable.
+ */
+static uint32_t ADXL345_SimRandomPermille(ADXL345_SIM *sim) {
+    sim->seed ^= sim->seed << 13;
+    sim->seed ^= sim->seed >> 17;
+    sim->seed ^= sim->seed << 5;
+    return sim->seed % 1000;
+}
+
+/**
+ * Puts the register file, FIFO and event engine in their power on state.
+ */
+static void ADXL345_SimPowerOn(ADXL345_SIM *sim) {
+    memset(sim->regs, 0, sizeof(sim->regs));
+    sim->regs[ADXL345_DEVID] = ADXL345_DEVID_VALUE;
+    sim->regs[ADXL345_BW_RATE] = ADXL345_RATE_100HZ;
+    sim->fifoHead = 0;
+    sim->fifoCount = 0;
+    sim->latched = 0;
+    sim->overrun = false;
+    sim->triggered = false;
+    sim->quietSinceUs = -1;
+    sim->fallingSinceUs = -1;
+    sim->tapSinceUs = -1;
+    sim->inactive = false;
+    sim->fallen = false;
+    sim->activityRefValid = false;
+    sim->inactivityRefValid = false;
+    sim->asleep = false;
+    ADXL345_SimScheduleSamples(sim);
+}
+
+/**
+ * Applies one transfer to the register file.  Both directions auto increment
+ * from the addressed register.  A read starting in the data registers latches
+ * the oldest FIFO entry into them, and pops it once the read gets past
+ * DATAZ1, just as on the real part.  Reading INT_SOURCE clears the latched
+ * events.
+ */
+static void ADXL345_SimExecute(ADXL345_SIM *sim, ADXL345_SIM_REQUEST *request) {
+    ADXL345_SimAdvance(sim, esp_timer_get_time());
+
+    // Bit 6 is the SPI multi-byte flag, an I2C address never has it
+    uint8_t reg = request->tx[0] % ADXL345_SIM_REGISTERS;
+    for (size_t i = 1; i < request->txLength; i++) {
+        ADXL345_SimWriteRegister(sim, (reg + i - 1) % ADXL345_SIM_REGISTERS, request->tx[i]);
+    }
+
+    if (request->rxLength == 0) {
+        return;
+    }
+
+    size_t end = reg + request->rxLength;
+    if (reg >= ADXL345_DATAX0 && reg <= ADXL345_DATAZ1 && sim->fifoCount > 0) {
+        ADXL345_SAMPLE sample = sim->fifo[sim->fifoHead];
+        sim->regs[ADXL345_DATAX0] = (uint8_t) sample.x;
+        sim->regs[ADXL345_DATAX1] = (uint8_t) (sample.x >> 8);
+        sim->regs[ADXL345_DATAY0] = (uint8_t) sample.y;
+        sim->regs[ADXL345_DATAY1] = (uint8_t) (sample.y >> 8);
+        sim->regs[ADXL345_DATAZ0] = (uint8_t) sample.z;
+        sim->regs[ADXL345_DATAZ1] = (uint8_t) (sample.z >> 8);
+        if (end > ADXL345_DATAZ1) {
+            sim->fifoHead = (sim->fifoHead + 1) % ADXL345_FIFO_DEPTH;
+            sim->fifoCount--;
+            sim->overrun = false;
+        }
+    }
+    sim->regs[ADXL345_FIFO_STATUS] = (uint8_t) sim->fifoCount | (sim->triggered ? ADXL345_FIFO_TRIG : 0);
+    sim->regs[ADXL345_INT_SOURCE] = ADXL345_SimSources(sim);
+
+    for (size_t i = 0; i < request->rxLength; i++) {
+        request->rx[i] = sim->regs[(reg + i) % ADXL345_SIM_REGISTERS];
+    }
+
+    if (reg <= ADXL345_INT_SOURCE && end > ADXL345_INT_SOURCE) {
+        sim->latched = 0;
+    }
+}
+
+/**
+ * Writes one register, applying any side effect it has on the model.
+ */
+static void ADXL345_SimWriteRegister(ADXL345_SIM *sim, uint8_t reg, uint8_t value) {
+    switch (reg) {
+        case ADXL345_DEVID:
+        case ADXL345_ACT_TAP_STATUS:
+        case ADXL345_INT_SOURCE:
+        case ADXL345_DATAX0:
+        case ADXL345_DATAX1:
+        case ADXL345_DATAY0:
+        case ADXL345_DATAY1:
+        case ADXL345_DATAZ0:
+        case ADXL345_DATAZ1:
+        case ADXL345_FIFO_STATUS:
+            // Read only
+            return;
+
+        case ADXL345_FIFO_CTL:
+            // Any mode change re-arms the trigger, and bypass empties the FIFO
+            if ((value & ADXL345_FIFO_TRIGGER) != (sim->regs[ADXL345_FIFO_CTL] & ADXL345_FIFO_TRIGGER)) {
+                sim->triggered = false;
+            }
+            if ((value & ADXL345_FIFO_TRIGGER) == ADXL345_FIFO_BYPASS) {
+                sim->fifoCount = 0;
+                sim->overrun = false;
+            }
+            break;
+
+        case ADXL345_THRESH_ACT:
+        case ADXL345_THRESH_INACT:
+        case ADXL345_ACT_INACT_CTL:
+            // AC coupled detection re-arms on its next sample
+            sim->activityRefValid = false;
+            sim->inactivityRefValid = false;
+            break;
+
+        case ADXL345_POWER_CTL:
+            if ((value & (ADXL345_LINK | ADXL345_AUTO_SLEEP)) != (ADXL345_LINK | ADXL345_AUTO_SLEEP)) {
+                sim->asleep = false;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    sim->regs[reg] = value;
+    if (reg == ADXL345_BW_RATE || reg == ADXL345_POWER_CTL) {
+        ADXL345_SimScheduleSamples(sim);
+    }
+}
+
+/**
+ * Runs the sample timer at the output data rate while measuring with an
+ * interrupt callback set, and stops it otherwise.  Called with the lock held.
+ */
+static void ADXL345_SimScheduleSamples(ADXL345_SIM *sim) {
+    if (sim->sampleTimer == NULL) {
+        return;
+    }
+
+    uint32_t periodUs = 0;
+    if (sim->intCallback != NULL && (sim->regs[ADXL345_POWER_CTL] & ADXL345_MEASURE)) {
+        periodUs = ADXL345_SimPeriodUs(sim);
+    }
+    if (periodUs == sim->sampleTimerUs) {
+        return;
+    }
+
+    esp_timer_stop(sim->sampleTimer);
+    if (periodUs > 0) {
+        esp_timer_start_periodic(sim->sampleTimer, periodUs);
+    }
+    sim->sampleTimerUs = periodUs;
+}
+
+/**
+ * Produces every sample due between the last call and the param time, runs
+ * each through the event engine and into the FIFO.
+ */
+static void ADXL345_SimAdvance(ADXL345_SIM *sim, int64_t nowUs) {
+    if ((sim->regs[ADXL345_POWER_CTL] & ADXL345_MEASURE) == 0) {
+        sim->nextSampleUs = nowUs;
+        return;
+    }
+
+    uint32_t periodUs = ADXL345_SimPeriodUs(sim);
+    bool asleep = sim->asleep;
+
+    // After a long gap the FIFO has overflowed whatever the mode
+    if (nowUs - sim->nextSampleUs > (int64_t) periodUs * ADXL345_SIM_MAX_CATCH_UP) {
+        int64_t skipped = (nowUs - sim->nextSampleUs) / periodUs - ADXL345_SIM_MAX_CATCH_UP;
+        sim->nextSampleUs += skipped * periodUs;
+        sim->samples += (uint32_t) skipped;
+        sim->overruns += (uint32_t) skipped;
+        sim->overrun = true;
+    }
+
+    while (sim->nextSampleUs <= nowUs) {
+        ADXL345_SAMPLE milliG;
+        sim->generator(sim->nextSampleUs, &milliG, sim->generatorArg);
+        ADXL345_SimDetect(sim, sim->nextSampleUs, &milliG);
+
+        ADXL345_SAMPLE sample = {
+            .x = ADXL345_SimToCounts(sim, 0, milliG.x),
+            .y = ADXL345_SimToCounts(sim, 1, milliG.y),
+            .z = ADXL345_SimToCounts(sim, 2, milliG.z),
+        };
+        ADXL345_SimPush(sim, &sample);
+        sim->samples++;
+        sim->nextSampleUs += periodUs;
+        // Falling asleep or waking changes the rate from the next sample on
+        periodUs = ADXL345_SimPeriodUs(sim);
+    }
+    if (sim->asleep != asleep) {
+        ADXL345_SimScheduleSamples(sim);
+    }
+}
+
+/**
+ * Returns the time between samples, at the wakeup rate while asleep and the
+ * BW_RATE rate otherwise.
+ */
+static uint32_t ADXL345_SimPeriodUs(const ADXL345_SIM *sim) {
+    if (sim->asleep || (sim->regs[ADXL345_POWER_CTL] & ADXL345_SLEEP)) {
+        // 8 Hz, halving with each step of the wakeup bits
+        return 125000u << (sim->regs[ADXL345_POWER_CTL] & ADXL345_WAKEUP_MASK);
+    }
+    return ADXL345_samplePeriodUs(sim->regs[ADXL345_BW_RATE]);
+}
+
+/**
+ * Event engine, run on every sample before it reaches the FIFO.  Thresholds
+ * are compared against the magnitude on each enabled axis.
+ */
+static void ADXL345_SimDetect(ADXL345_SIM *sim, int64_t timeUs, const ADXL345_SAMPLE *milliG) {
+    uint8_t *regs = sim->regs;
+    int32_t magnitude[3] = { abs(milliG->x), abs(milliG->y), abs(milliG->z) };
+    int32_t actMg = regs[ADXL345_THRESH_ACT] * ADXL345_THRESH_HALF_MG / 2;
+    int32_t inactMg = regs[ADXL345_THRESH_INACT] * ADXL345_THRESH_HALF_MG / 2;
+    int32_t freeFallMg = regs[ADXL345_THRESH_FF] * ADXL345_THRESH_HALF_MG / 2;
+    // A zero DUR disables tap detection
+    int32_t tapMg = regs[ADXL345_DUR] ? regs[ADXL345_THRESH_TAP] * ADXL345_THRESH_HALF_MG / 2 : 0;
+    uint8_t actAxes = (regs[ADXL345_ACT_INACT_CTL] >> 4) & ADXL345_AXIS_ALL;
+    uint8_t inactAxes = regs[ADXL345_ACT_INACT_CTL] & ADXL345_AXIS_ALL;
+    uint8_t tapAxes = regs[ADXL345_TAP_AXES] & ADXL345_AXIS_ALL;
+    bool link = (regs[ADXL345_POWER_CTL] & ADXL345_LINK) != 0;
+    bool autoSleep = link && (regs[ADXL345_POWER_CTL] & ADXL345_AUTO_SLEEP);
+
+    // AC coupling takes its reference from the first sample after arming
+    if (!sim->activityRefValid) {
+        sim->activityRef = *milliG;
+        sim->activityRefValid = true;
+    }
+    if (!sim->inactivityRefValid) {
+        sim->inactivityRef = *milliG;
+        sim->inactivityRefValid = true;
+    }
+    const int32_t value[3] = { milliG->x, milliG->y, milliG->z };
+    const int32_t activityRef[3] = { sim->activityRef.x, sim->activityRef.y, sim->activityRef.z };
+    const int32_t inactivityRef[3] = { sim->inactivityRef.x, sim->inactivityRef.y, sim->inactivityRef.z };
+    bool activityAc = (regs[ADXL345_ACT_INACT_CTL] & ADXL345_ACT_AC) != 0;
+    bool inactivityAc = (regs[ADXL345_ACT_INACT_CTL] & ADXL345_INACT_AC) != 0;
+
+    uint8_t active = 0;
+    uint8_t loud = 0;
+    uint8_t tapping = 0;
+    bool falling = true;
+    for (int axis = 0; axis < 3; axis++) {
+        // ADXL345_AXIS_X is the high bit
+        uint8_t bit = ADXL345_AXIS_X >> axis;
+        int32_t activity = activityAc ? abs(value[axis] - activityRef[axis]) : magnitude[axis];
+        int32_t inactivity = inactivityAc ? abs(value[axis] - inactivityRef[axis]) : magnitude[axis];
+        if ((actAxes & bit) && actMg > 0 && activity > actMg) {
+            active |= bit;
+        }
+        if ((inactAxes & bit) && inactivity > inactMg) {
+            loud |= bit;
+        }
+        if ((tapAxes & bit) && tapMg > 0 && magnitude[axis] > tapMg) {
+            tapping |= bit;
+        }
+        if (magnitude[axis] >= freeFallMg) {
+            falling = false;
+        }
+    }
+
+    // Linked, activity is only looked for once inactivity has been detected
+    if (active && (!link || sim->inactive)) {
+        sim->latched |= ADXL345_INT_ACTIVITY;
+        regs[ADXL345_ACT_TAP_STATUS] = (regs[ADXL345_ACT_TAP_STATUS] & ~(ADXL345_AXIS_ALL << 4)) | (active << 4);
+        if (link) {
+            sim->inactive = false;
+            sim->quietSinceUs = -1;
+            sim->inactivityRef = *milliG;
+            sim->asleep = false;
+        }
+    }
+
+    // Inactivity fires once per quiet spell, after TIME_INACT seconds of it.
+    // AC coupled, the reference follows the signal while it's over threshold.
+    if (inactAxes == 0 || loud) {
+        sim->quietSinceUs = -1;
+        if (!link) {
+            sim->inactive = false;
+        }
+        if (loud) {
+            sim->inactivityRef = *milliG;
+        }
+    } else {
+        if (sim->quietSinceUs < 0) {
+            sim->quietSinceUs = timeUs;
+        }
+        if (!sim->inactive && timeUs - sim->quietSinceUs >= regs[ADXL345_TIME_INACT] * 1000000ll) {
+            sim->latched |= ADXL345_INT_INACTIVITY;
+            sim->inactive = true;
+            if (link) {
+                // Activity detection starts here, AC coupled against this sample
+                sim->activityRef = *milliG;
+                sim->asleep = autoSleep;
+            }
+        }
+    }
+    regs[ADXL345_ACT_TAP_STATUS] = (regs[ADXL345_ACT_TAP_STATUS] & ~ADXL345_STATUS_ASLEEP) |
+                                   (sim->asleep ? ADXL345_STATUS_ASLEEP : 0);
+
+    // Free-fall likewise, after TIME_FF with every axis under THRESH_FF
+    if (freeFallMg == 0 || !falling) {
+        sim->fallingSinceUs = -1;
+        sim->fallen = false;
+    } else {
+        if (sim->fallingSinceUs < 0) {
+            sim->fallingSinceUs = timeUs;
+        }
+        if (!sim->fallen && timeUs - sim->fallingSinceUs >= regs[ADXL345_TIME_FF] * ADXL345_TIME_FF_MS_LSB * 1000ll) {
+            sim->latched |= ADXL345_INT_FREE_FALL;
+            sim->fallen = true;
+        }
+    }
+
+    // A tap is a spike above THRESH_TAP that falls back within DUR
+    if (tapping) {
+        if (sim->tapSinceUs < 0) {
+            sim->tapSinceUs = timeUs;
+        }
+        sim->tapAxes |= tapping;
+    } else if (sim->tapSinceUs >= 0) {
+        if (timeUs - sim->tapSinceUs <= regs[ADXL345_DUR] * ADXL345_DUR_US_LSB) {
+            sim->latched |= ADXL345_INT_SINGLE_TAP;
+            regs[ADXL345_ACT_TAP_STATUS] = (regs[ADXL345_ACT_TAP_STATUS] & ~ADXL345_AXIS_ALL) | sim->tapAxes;
+        }
+        sim->tapSinceUs = -1;
+        sim->tapAxes = 0;
+    }
+
+    // Trigger mode keeps FIFO_CTL's sample count from before a mapped event
+    uint8_t fifoCtl = regs[ADXL345_FIFO_CTL];
+    if ((fifoCtl & ADXL345_FIFO_TRIGGER) == ADXL345_FIFO_TRIGGER && !sim->triggered) {
+        uint8_t mapped = (fifoCtl & ADXL345_FIFO_INT2) ? regs[ADXL345_INT_MAP] : (uint8_t) ~regs[ADXL345_INT_MAP];
+        if (sim->latched & regs[ADXL345_INT_ENABLE] & mapped) {
+            sim->triggered = true;
+            while (sim->fifoCount > (fifoCtl & ADXL345_FIFO_SAMPLES)) {
+                sim->fifoHead = (sim->fifoHead + 1) % ADXL345_FIFO_DEPTH;
+                sim->fifoCount--;
+            }
+        }
+    }
+}
+
+/**
+ * Adds a sample to the FIFO as the FIFO mode says.  Bypass holds one sample,
+ * stream and trigger mode before its event drop the oldest when full, and
+ * FIFO mode and trigger mode after its event drop the new one.
+ */
+static void ADXL345_SimPush(ADXL345_SIM *sim, const ADXL345_SAMPLE *sample) {
+    uint8_t mode = sim->regs[ADXL345_FIFO_CTL] & ADXL345_FIFO_TRIGGER;
+    int depth = (mode == ADXL345_FIFO_BYPASS) ? 1 : ADXL345_FIFO_DEPTH;
+    bool keepOldest = (mode == ADXL345_FIFO_FIFO) || (mode == ADXL345_FIFO_TRIGGER && sim->triggered);
+
+    if (sim->fifoCount == depth) {
+        sim->overrun = true;
+        sim->overruns++;
+        if (keepOldest) {
+            return;
+        }
+        sim->fifoHead = (sim->fifoHead + 1) % ADXL345_FIFO_DEPTH;
+        sim->fifoCount--;
+    }
+    sim->fifo[(sim->fifoHead + sim->fifoCount) % ADXL345_FIFO_DEPTH] = *sample;
+    sim->fifoCount++;
+}
+
+/**
+ * Converts milli-g on one axis to the count the part would report.  Full
+ * resolution keeps 4 mg/LSB and widens to 13 bits at 16g, otherwise the
+ * count is 10 bits scaled to the range.
+ *
+ * @param sim    ADXL345_SIM to use DATA_FORMAT and the offsets of
+ * @param axis   0 for X, 1 for Y and 2 for Z
+ * @param milliG Acceleration on the axis in milli-g
+ */
+static int16_t ADXL345_SimToCounts(const ADXL345_SIM *sim, int axis, int32_t milliG) {
+    uint8_t format = sim->regs[ADXL345_DATA_FORMAT];
+    int range = format & ADXL345_RANGE_MASK;
+    bool fullResolution = (format & ADXL345_FULL_RES) != 0;
+    int bits = fullResolution ? 10 + range : 10;
+    int32_t lsbPerG = fullResolution ? 256 : (256 >> range);
+
+    milliG += ((int8_t) sim->regs[ADXL345_OFSX + axis] * ADXL345_OFS_TENTH_MG) / 10;
+    int32_t scaled = milliG * lsbPerG;
+    int32_t counts = (scaled + ((scaled < 0) ? -ADXL345_ONE_G_MILLI : ADXL345_ONE_G_MILLI) / 2) / ADXL345_ONE_G_MILLI;
+
+    int32_t limit = 1 << (bits - 1);
+    if (counts >= limit) {
+        counts = limit - 1;
+    } else if (counts < -limit) {
+        counts = -limit;
+    }
+
+    // Left justified puts the sign bit in bit 15
+    if (format & ADXL345_JUSTIFY) {
+        counts *= 1 << (16 - bits);
+    }
+    return (int16_t) counts;
+}
+
+/**
+ * Returns what INT_SOURCE reads as right now, latched events plus the FIFO
+ * conditions.
+ */
+static uint8_t ADXL345_SimSources(const ADXL345_SIM *sim) {
+    uint8_t source = sim->latched;
+    uint8_t fifoCtl = sim->regs[ADXL345_FIFO_CTL];
+
+    if (sim->fifoCount > 0) {
+        source |= ADXL345_INT_DATA_READY;
+    }
+    if ((fifoCtl & ADXL345_FIFO_TRIGGER) != ADXL345_FIFO_BYPASS && sim->fifoCount >= (fifoCtl & ADXL345_FIFO_SAMPLES)) {
+        source |= ADXL345_INT_WATERMARK;
+    }
+    if (sim->overrun) {
+        source |= ADXL345_INT_OVERRUN;
+    }
+    return source;
+}
+
+/**
+ * Returns the level of each interrupt pin, INT1 in bit 0 and INT2 in bit 1.
+ */
+static uint8_t ADXL345_SimPins(const ADXL345_SIM *sim) {
+    uint8_t active = ADXL345_SimSources(sim) & sim->regs[ADXL345_INT_ENABLE];
+    uint8_t pins = 0;
+
+    if (active & ~sim->regs[ADXL345_INT_MAP]) {
+        pins |= 1 << ADXL345_SIM_INT1;
+    }
+    if (active & sim->regs[ADXL345_INT_MAP]) {
+        pins |= 1 << ADXL345_SIM_INT2;
+    }
+    // INT_INVERT makes both pins active low
+    if (sim->regs[ADXL345_DATA_FORMAT] & ADXL345_INT_INVERT) {
+        pins ^= (1 << ADXL345_SIM_INT1) | (1 << ADXL345_SIM_INT2);
+    }
+    return pins;
+}
+
+static void ADXL345_SimDefaultGenerator(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg) {
+    sample->x = 0;
+    sample->y = 0;
+    sample->z = ADXL345_ONE_G_MILLI;
+}
@@ -0,0 +1,136 @@
+/**
+ * File:       ADXL345_sim.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ADXL345.h"
+#include "ADXL345_transport.h"
+#include "ADXL345_events.h"
+
+// Transfers that can be queued on the simulated bus at once
+#define ADXL345_SIM_QUEUE_DEPTH 40
+#define ADXL345_SIM_REGISTERS   64
+#define ADXL345_SIM_MAX_TX      (ADXL345_MAX_BURST_WRITE + 1)
+// Longest a synchronous transfer waits, including time queued behind others
+#define ADXL345_SIM_TIMEOUT_MS  50
+
+// Simulated interrupt pins
+#define ADXL345_SIM_INT1        0
+#define ADXL345_SIM_INT2        1
+
+// Produces the simulated acceleration, in milli-g, at the param time.  The
+// device model turns it into counts as DATA_FORMAT and the offsets say.
+typedef void (*ADXL345_SIM_GENERATOR)(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+
+// Called from the esp_timer task when a simulated interrupt pin changes level
+typedef void (*ADXL345_SIM_INT_CALLBACK)(int pin, bool level, void *arg);
+
+typedef struct _adxl345SimRequest {
+    uint8_t tx[ADXL345_SIM_MAX_TX];
+    size_t txLength;
+    uint8_t *rx;
+    size_t rxLength;
+    ADXL345_TRANSPORT_DONE done;
+    void *arg;
+    // Decided when the transfer reaches the wire
+    esp_err_t result;
+    uint32_t durationUs;
+} ADXL345_SIM_REQUEST;
+
+typedef struct _adxl345Sim {
+    // Device model
+    uint8_t regs[ADXL345_SIM_REGISTERS];
+    ADXL345_SAMPLE fifo[ADXL345_FIFO_DEPTH];
+    int fifoHead;
+    int fifoCount;
+    int64_t nextSampleUs;
+    ADXL345_SIM_GENERATOR generator;
+    void *generatorArg;
+
+    // Event engine, see ADXL345_SimDetect.  The since times are -1 while the
+    // condition doesn't hold.
+    uint8_t latched;
+    bool overrun;
+    bool triggered;
+    int64_t quietSinceUs;
+    int64_t fallingSinceUs;
+    int64_t tapSinceUs;
+    bool inactive;
+    bool fallen;
+    uint8_t tapAxes;
+    // AC coupled activity and inactivity compare against these, in milli-g
+    ADXL345_SAMPLE activityRef;
+    ADXL345_SAMPLE inactivityRef;
+    bool activityRefValid;
+    bool inactivityRefValid;
+    // Auto sleep, sampling at the wakeup rate until activity
+    bool asleep;
+
+    // Interrupt pins, only driven while a callback is set
+    uint8_t pins;
+    ADXL345_SIM_INT_CALLBACK intCallback;
+    void *intArg;
+    esp_timer_handle_t sampleTimer;
+    uint32_t sampleTimerUs;
+
+    // Bus latency model, SCL or SCLK frequency
+    uint32_t busHz;
+    bool spi;
+    uint32_t overheadUs;
+    ADXL345_SIM_REQUEST queue[ADXL345_SIM_QUEUE_DEPTH];
+    int queueHead;
+    int queueCount;
+    esp_timer_handle_t timer;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t waitLock;
+    SemaphoreHandle_t syncDone;
+    esp_err_t syncResult;
+
+    // Fault injection, see ADXL345_simSetFaults
+    uint16_t nackPermille;
+    uint16_t timeoutPermille;
+    uint32_t timeoutUs;
+    bool stuck;
+    uint32_t seed;
+
+    // Statistics
+    uint32_t transfers;
+    uint64_t busyUs;
+    uint32_t faults;
+    uint32_t recoveries;
+    uint32_t samples;
+    uint32_t overruns;
+} ADXL345_SIM;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_simInit(ADXL345_SIM *sim, uint32_t busHz, uint32_t overheadUs);
+
+void ADXL345_simSetGenerator(ADXL345_SIM *sim, ADXL345_SIM_GENERATOR generator, void *arg);
+
+void ADXL345_simTransport(ADXL345_TRANSPORT *transport, ADXL345_SIM *sim);
+
+void ADXL345_simSetBus(ADXL345_SIM *sim, uint32_t busHz, uint32_t overheadUs);
+
+void ADXL345_simSetSpi(ADXL345_SIM *sim, uint32_t clockHz, uint32_t overheadUs);
+
+uint32_t ADXL345_simTransferUs(const ADXL345_SIM *sim, size_t txLength, size_t rxLength);
+
+void ADXL345_simSetFaults(ADXL345_SIM *sim, uint16_t nackPermille, uint16_t timeoutPermille, uint32_t timeoutUs);
+
+void ADXL345_simSetStuck(ADXL345_SIM *sim, bool stuck);
+
+void ADXL345_simPowerCycle(ADXL345_SIM *sim);
+
+esp_err_t ADXL345_simSetInterruptCallback(ADXL345_SIM *sim, ADXL345_SIM_INT_CALLBACK callback, void *arg);
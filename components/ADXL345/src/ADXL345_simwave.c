@@ -0,0 +1,208 @@
+/**
+ * File:       ADXL345_simwave.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Motion generators for the simulated ADXL345 (see ADXL345_simSetGenerator).
+ * They produce milli-g, and are deterministic for a given seed or file, so a
+ * benchmark or fault run sees the same motion every time.
+ *
+ * Recordings are CSV files with one row per sample, "t_us,x_mg,y_mg,z_mg".
+ * Lines that don't start with a number, such as a header, are skipped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ADXL345_simwave.h"
+
+#define ADXL345_SIM_LINE_LENGTH     128
+#define ADXL345_SIM_INITIAL_ROWS    1024
+
+// 'Private' helpers designed for internal use
+static int32_t ADXL345_WaveAxis(int16_t gravityMg, int16_t sineMg, int16_t shockMg, float sine, float shock, int32_t noise);
+static int32_t ADXL345_WaveNoise(ADXL345_SIM_WAVE *wave);
+static int16_t ADXL345_Saturate16(int32_t value);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Sets the param wave to a still sensor lying flat, +1g on Z, with nothing
+ * else mixed in.
+ *
+ * @param wave ADXL345_SIM_WAVE to initialize
+ */
+void ADXL345_simWaveInit(ADXL345_SIM_WAVE *wave) {
+    memset(wave, 0, sizeof(*wave));
+    wave->gravityMg.z = ADXL345_ONE_G_MILLI;
+    wave->seed = ADXL345_SIM_WAVE_SEED;
+}
+
+/**
+ * ADXL345_SIM_GENERATOR for synthetic motion.
+ *
+ * @param timeUs Time of the sample
+ * @param sample Filled with the acceleration in milli-g
+ * @param arg    ADXL345_SIM_WAVE to play
+ */
+void ADXL345_simWave(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg) {
+    ADXL345_SIM_WAVE *wave = (ADXL345_SIM_WAVE *) arg;
+
+    // Phase from the fractional cycle count, so long runs don't lose precision
+    float sine = 0.0f;
+    if (wave->sineMilliHz > 0) {
+        uint64_t cycleNs = ((uint64_t) timeUs * wave->sineMilliHz) % 1000000000ull;
+        sine = sinf(2.0f * (float) M_PI * ((float) cycleNs / 1e9f));
+    }
+
+    float shock = 0.0f;
+    if (wave->shockPeriodUs > 0 && wave->shockUs > 0) {
+        uint32_t intoPeriodUs = (uint32_t) (timeUs % wave->shockPeriodUs);
+        if (intoPeriodUs < wave->shockUs) {
+            shock = sinf((float) M_PI * (float) intoPeriodUs / (float) wave->shockUs);
+        }
+    }
+
+    sample->x = ADXL345_Saturate16(ADXL345_WaveAxis(wave->gravityMg.x, wave->sineMg.x, wave->shockMg.x, sine, shock,
+                                                    ADXL345_WaveNoise(wave)));
+    sample->y = ADXL345_Saturate16(ADXL345_WaveAxis(wave->gravityMg.y, wave->sineMg.y, wave->shockMg.y, sine, shock,
+                                                    ADXL345_WaveNoise(wave)));
+    sample->z = ADXL345_Saturate16(ADXL345_WaveAxis(wave->gravityMg.z, wave->sineMg.z, wave->shockMg.z, sine, shock,
+                                                    ADXL345_WaveNoise(wave)));
+}
+
+/**
+ * Loads a recording from a CSV file.
+ *
+ * @param recording ADXL345_SIM_RECORDING to load into
+ * @param path      File to read
+ */
+esp_err_t ADXL345_simLoadRecording(ADXL345_SIM_RECORDING *recording, const char *path) {
+    memset(recording, 0, sizeof(*recording));
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    size_t capacity = 0;
+    char line[ADXL345_SIM_LINE_LENGTH];
+    esp_err_t err = ESP_OK;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        long long timeUs;
+        int x, y, z;
+        if (sscanf(line, "%lld,%d,%d,%d", &timeUs, &x, &y, &z) != 4) {
+            continue;
+        }
+
+        if (recording->count == capacity) {
+            capacity = (capacity == 0) ? ADXL345_SIM_INITIAL_ROWS : capacity * 2;
+            int64_t *times = realloc(recording->timeUs, capacity * sizeof(*times));
+            if (times != NULL) {
+                recording->timeUs = times;
+            }
+            ADXL345_SAMPLE *samples = realloc(recording->samples, capacity * sizeof(*samples));
+            if (samples != NULL) {
+                recording->samples = samples;
+            }
+            if (times == NULL || samples == NULL) {
+                err = ESP_ERR_NO_MEM;
+                break;
+            }
+        }
+
+        recording->timeUs[recording->count] = timeUs;
+        recording->samples[recording->count] = (ADXL345_SAMPLE) {
+            ADXL345_Saturate16(x), ADXL345_Saturate16(y), ADXL345_Saturate16(z)
+        };
+        recording->count++;
+    }
+    fclose(file);
+
+    if (err == ESP_OK && recording->count == 0) {
+        err = ESP_ERR_INVALID_SIZE;
+    }
+    if (err != ESP_OK) {
+        ADXL345_simFreeRecording(recording);
+        return err;
+    }
+
+    // The loop restarts one row interval after the last row
+    int64_t lastStepUs = (recording->count > 1) ?
+        recording->timeUs[recording->count - 1] - recording->timeUs[recording->count - 2] : 1;
+    recording->durationUs = recording->timeUs[recording->count - 1] - recording->timeUs[0] + lastStepUs;
+    return ESP_OK;
+}
+
+/**
+ * Frees the rows of a loaded recording.
+ *
+ * @param recording ADXL345_SIM_RECORDING to free
+ */
+void ADXL345_simFreeRecording(ADXL345_SIM_RECORDING *recording) {
+    free(recording->timeUs);
+    free(recording->samples);
+    memset(recording, 0, sizeof(*recording));
+}
+
+/**
+ * ADXL345_SIM_GENERATOR for a loaded recording.  Returns the row in effect
+ * at the param time, measured from the first row and looped.
+ * NOTE: Playback is fastest when time moves forwards, as the model does.
+ *
+ * @param timeUs Time of the sample
+ * @param sample Filled with the acceleration in milli-g
+ * @param arg    ADXL345_SIM_RECORDING to play
+ */
+void ADXL345_simRecording(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg) {
+    ADXL345_SIM_RECORDING *recording = (ADXL345_SIM_RECORDING *) arg;
+    int64_t atUs = recording->timeUs[0] + (timeUs % recording->durationUs);
+
+    if (recording->timeUs[recording->cursor] > atUs) {
+        recording->cursor = 0;
+    }
+    while (recording->cursor + 1 < recording->count && recording->timeUs[recording->cursor + 1] <= atUs) {
+        recording->cursor++;
+    }
+    *sample = recording->samples[recording->cursor];
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Sums the parts of a wave on one axis.
+ */
+static int32_t ADXL345_WaveAxis(int16_t gravityMg, int16_t sineMg, int16_t shockMg, float sine, float shock, int32_t noise) {
+    return gravityMg + (int32_t) lroundf(sineMg * sine + shockMg * shock) + noise;
+}
+
+/**
+ * Returns uniform noise within +/- noiseMg, from a small xorshift generator.
+ */
+static int32_t ADXL345_WaveNoise(ADXL345_SIM_WAVE *wave) {
+    if (wave->noiseMg == 0) {
+        return 0;
+    }
+    wave->seed ^= wave->seed << 13;
+    wave->seed ^= wave->seed >> 17;
+    wave->seed ^= wave->seed << 5;
+    return (int32_t) (wave->seed % (2u * wave->noiseMg + 1)) - wave->noiseMg;
+}
+
+/**
+ * Clamps the param value to the range of an int16_t.
+ */
+static int16_t ADXL345_Saturate16(int32_t value) {
+    if (value > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (value < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return (int16_t) value;
+}
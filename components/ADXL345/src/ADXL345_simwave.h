@@ -0,0 +1,54 @@
+/**
+ * File:       ADXL345_simwave.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "ADXL345.h"
+
+// Synthetic motion, the sum of every part that is set.  Zeroed parts are
+// left out, so a zeroed wave plus gravityMg is a still sensor.
+typedef struct _adxl345SimWave {
+    ADXL345_SAMPLE gravityMg;
+    // Sine vibration, amplitude per axis
+    ADXL345_SAMPLE sineMg;
+    uint32_t sineMilliHz;
+    // White noise, uniform within +/- noiseMg on every axis
+    uint16_t noiseMg;
+    // Half sine shock pulses, shockUs long, every shockPeriodUs
+    ADXL345_SAMPLE shockMg;
+    uint32_t shockUs;
+    uint32_t shockPeriodUs;
+    uint32_t seed;
+} ADXL345_SIM_WAVE;
+
+// Motion played back from a file, held between rows and looped at the end
+typedef struct _adxl345SimRecording {
+    int64_t *timeUs;
+    ADXL345_SAMPLE *samples;
+    size_t count;
+    int64_t durationUs;
+    size_t cursor;
+} ADXL345_SIM_RECORDING;
+
+
+// Public methods designed for the user to call
+void ADXL345_simWaveInit(ADXL345_SIM_WAVE *wave);
+
+void ADXL345_simWave(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+
+esp_err_t ADXL345_simLoadRecording(ADXL345_SIM_RECORDING *recording, const char *path);
+
+void ADXL345_simFreeRecording(ADXL345_SIM_RECORDING *recording);
+
+void ADXL345_simRecording(int64_t timeUs, ADXL345_SAMPLE *sample, void *arg);
+
+// Constants for calculations
+#define ADXL345_SIM_WAVE_SEED   0x9E3779B9
@@ -0,0 +1,337 @@
+/**
+ * File:       ADXL345_spectrum.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Vibration spectrum stage.  Frames of N samples per axis are collected from
+ * ADXL345_BLOCKs, Hann windowed, and transformed with a fixed point real FFT
+ * (an N/2 point complex radix-2 FFT on the packed even/odd samples, followed
+ * by the usual split step).  Each butterfly stage halves its output, so the
+ * transform can never overflow, and ADXL345_SPECTRUM_GUARD_BITS of headroom
+ * are added to the input so small vibrations are not lost to that scaling.
+ */
+#include <string.h>
+#include <math.h>
+#include "ADXL345_spectrum.h"
+#include "ADXL345_fixed.h"
+
+#define ADXL345_SPECTRUM_GUARD_BITS 8
+#define ADXL345_Q15                 15
+
+// 'Private' helpers designed for internal use
+static void ADXL345_BitReverse(int32_t *data, int points);
+static void ADXL345_ComplexFft(ADXL345_SPECTRUM *spectrum, int points);
+static void ADXL345_RealSplit(ADXL345_SPECTRUM *spectrum, uint32_t *bins);
+static void ADXL345_FindPeak(ADXL345_SPECTRUM *spectrum, int axis);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the spectrum stage and precomputes its window and twiddle tables.
+ * NOTE: The size must be a power of two between ADXL345_SPECTRUM_MIN_SIZE and
+ *       ADXL345_SPECTRUM_MAX_SIZE.  Frames do not overlap, so a 1024 point
+ *       frame at 3200 Hz completes a little more than three times a second.
+ *
+ * @param spectrum     ADXL345_SPECTRUM to initialize
+ * @param size         Samples per axis in each frame
+ * @param sampleRateHz Output data rate the samples were captured at
+ * @return true if the size was valid and the stage was initialized
+ */
+bool ADXL345_spectrumInit(ADXL345_SPECTRUM *spectrum, int size, uint32_t sampleRateHz) {
+    if (size < ADXL345_SPECTRUM_MIN_SIZE || size > ADXL345_SPECTRUM_MAX_SIZE ||
+        (size & (size - 1)) != 0 || sampleRateHz == 0) {
+        return false;
+    }
+
+    memset(spectrum, 0, sizeof(*spectrum));
+    spectrum->size = size;
+    spectrum->sampleRateHz = sampleRateHz;
+    while ((1 << spectrum->log2Size) < size) {
+        spectrum->log2Size++;
+    }
+
+    for (int n = 0; n < size; n++) {
+        float w = 0.5f - 0.5f * cosf(2.0f * (float) M_PI * n / size);
+        spectrum->window[n] = (int16_t) lroundf(w * 32767.0f);
+        spectrum->windowSum += spectrum->window[n];
+        spectrum->windowSumSq += (int64_t) spectrum->window[n] * spectrum->window[n];
+    }
+
+    // W_N^k = cos(2 pi k / N) - j sin(2 pi k / N), for k < N/2
+    for (int k = 0; k < size / 2; k++) {
+        float angle = 2.0f * (float) M_PI * k / size;
+        spectrum->cosTable[k] = (int16_t) lroundf(cosf(angle) * 32767.0f);
+        spectrum->sinTable[k] = (int16_t) lroundf(sinf(angle) * 32767.0f);
+    }
+
+    // Sum of squared bin amplitudes to mean square, accounting for the window's
+    // spreading of each tone across neighbouring bins (1/3 for Hann).
+    double sumW = (double) spectrum->windowSum;
+    double ratio = (sumW * sumW) / (2.0 * size * (double) spectrum->windowSumSq);
+    spectrum->rmsScaleQ16 = (uint32_t) lround(ratio * 65536.0);
+    return true;
+}
+
+/**
+ * Appends the param block to the frame being collected, and analyzes every
+ * axis as soon as a frame fills up.  Any samples past the end of the frame
+ * start the next one.
+ *
+ * @param spectrum ADXL345_SPECTRUM to feed
+ * @param block    ADXL345_BLOCK of new samples
+ * @return Number of frames analyzed during this call
+ */
+int ADXL345_spectrumFeed(ADXL345_SPECTRUM *spectrum, const ADXL345_BLOCK *block) {
+    int analyzed = 0;
+    int used = 0;
+
+    while (used < block->count) {
+        int space = spectrum->size - spectrum->fill;
+        int take = block->count - used;
+        if (take > space) {
+            take = space;
+        }
+
+        memcpy(&spectrum->input[0][spectrum->fill], &block->x[used], take * sizeof(int16_t));
+        memcpy(&spectrum->input[1][spectrum->fill], &block->y[used], take * sizeof(int16_t));
+        memcpy(&spectrum->input[2][spectrum->fill], &block->z[used], take * sizeof(int16_t));
+        spectrum->fill += take;
+        used += take;
+
+        if (spectrum->fill == spectrum->size) {
+            for (int axis = 0; axis < 3; axis++) {
+                ADXL345_spectrumAnalyze(spectrum, axis, spectrum->input[axis]);
+            }
+            spectrum->fill = 0;
+            spectrum->frames++;
+            analyzed++;
+        }
+    }
+    return analyzed;
+}
+
+/**
+ * Removes the mean from, windows and transforms one frame of samples, storing
+ * the amplitude of every bin and the peak/RMS summary under the param axis.
+ * NOTE: Bin amplitudes are the peak amplitude of a tone centred on that bin,
+ *       in raw counts with ADXL345_SPECTRUM_AMP_Q fraction bits.
+ *
+ * @param spectrum ADXL345_SPECTRUM to analyze with
+ * @param axis     Axis index (0 = x, 1 = y, 2 = z) to store the result under
+ * @param samples  spectrum->size samples to analyze
+ */
+void ADXL345_spectrumAnalyze(ADXL345_SPECTRUM *spectrum, int axis, const int16_t *samples) {
+    int points = spectrum->size / 2;
+    int32_t *work = spectrum->work;
+
+    // Remove the frame mean first, otherwise gravity leaks through the window
+    // into the lowest bins and swamps any low frequency vibration.
+    int32_t sum = 0;
+    for (int n = 0; n < spectrum->size; n++) {
+        sum += samples[n];
+    }
+    int32_t mean = sum >> spectrum->log2Size;
+
+    // Pack even samples as real and odd samples as imaginary parts
+    for (int n = 0; n < spectrum->size; n++) {
+        int32_t centred = samples[n] - mean;
+        work[n] = (centred * spectrum->window[n]) >> (ADXL345_Q15 - ADXL345_SPECTRUM_GUARD_BITS);
+    }
+
+    ADXL345_BitReverse(work, points);
+    ADXL345_ComplexFft(spectrum, points);
+    ADXL345_RealSplit(spectrum, spectrum->bins[axis]);
+    ADXL345_FindPeak(spectrum, axis);
+}
+
+/**
+ * Returns the RMS of the param axis over the param frequency band of the last
+ * analyzed frame, in raw counts with ADXL345_SPECTRUM_AMP_Q fraction bits.
+ * The DC bin is always excluded.
+ *
+ * @param spectrum ADXL345_SPECTRUM to read from
+ * @param axis     Axis index (0 = x, 1 = y, 2 = z)
+ * @param lowHz    Lower edge of the band, inclusive
+ * @param highHz   Upper edge of the band, inclusive
+ */
+uint32_t ADXL345_spectrumBandRms(const ADXL345_SPECTRUM *spectrum, int axis, uint32_t lowHz, uint32_t highHz) {
+    uint32_t bins = spectrum->size / 2;
+    uint32_t lowBin = (uint32_t) (((uint64_t) lowHz * spectrum->size) / spectrum->sampleRateHz);
+    uint32_t highBin = (uint32_t) (((uint64_t) highHz * spectrum->size) / spectrum->sampleRateHz);
+    if (lowBin < 1) {
+        lowBin = 1;
+    }
+    if (highBin >= bins) {
+        highBin = bins - 1;
+    }
+
+    uint64_t sumSq = 0;
+    for (uint32_t k = lowBin; k <= highBin; k++) {
+        uint64_t amplitude = spectrum->bins[axis][k];
+        sumSq += amplitude * amplitude;
+    }
+
+    // sumSq * scale in Q16, split so the product cannot overflow 64 bits
+    uint64_t scale = spectrum->rmsScaleQ16;
+    uint64_t meanSq = (sumSq >> 16) * scale + (((sumSq & 0xFFFF) * scale) >> 16);
+    return ADXL345_isqrt64(meanSq);
+}
+
+/**
+ * Returns the centre frequency of the param bin in hundredths of a Hz.
+ *
+ * @param spectrum ADXL345_SPECTRUM the bin belongs to
+ * @param bin      Bin index
+ */
+uint32_t ADXL345_spectrumBinFreqCentiHz(const ADXL345_SPECTRUM *spectrum, uint32_t bin) {
+    return (uint32_t) (((uint64_t) bin * spectrum->sampleRateHz * 100) >> spectrum->log2Size);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Reorders the param interleaved complex buffer into bit reversed order.
+ *
+ * @param data   Interleaved re/im buffer
+ * @param points Number of complex points
+ */
+static void ADXL345_BitReverse(int32_t *data, int points) {
+    int j = 0;
+    for (int i = 0; i < points - 1; i++) {
+        if (i < j) {
+            int32_t re = data[2 * i];
+            int32_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+        int bit = points >> 1;
+        while (j & bit) {
+            j ^= bit;
+            bit >>= 1;
+        }
+        j |= bit;
+    }
+}
+
+/**
+ * In place iterative radix-2 decimation in time FFT over the work buffer.
+ * Every stage halves its output, so the result is the DFT divided by the
+ * number of points.
+ *
+ * @param spectrum ADXL345_SPECTRUM holding the work buffer and twiddles
+ * @param points   Number of complex points, N/2
+ */
+static void ADXL345_ComplexFft(ADXL345_SPECTRUM *spectrum, int points) {
+    int32_t *data = spectrum->work;
+
+    for (int length = 2; length <= points; length <<= 1) {
+        int half = length >> 1;
+        // W_length^k is W_N^(k * N / length), and the table is indexed in W_N
+        int stride = spectrum->size / length;
+
+        for (int start = 0; start < points; start += length) {
+            for (int k = 0; k < half; k++) {
+                int64_t c = spectrum->cosTable[k * stride];
+                int64_t s = spectrum->sinTable[k * stride];
+                int32_t *top = &data[2 * (start + k)];
+                int32_t *bottom = &data[2 * (start + k + half)];
+
+                // t = bottom * (c - js)
+                int32_t tRe = (int32_t) ((bottom[0] * c + bottom[1] * s) >> ADXL345_Q15);
+                int32_t tIm = (int32_t) ((bottom[1] * c - bottom[0] * s) >> ADXL345_Q15);
+
+                bottom[0] = (top[0] - tRe) >> 1;
+                bottom[1] = (top[1] - tIm) >> 1;
+                top[0] = (top[0] + tRe) >> 1;
+                top[1] = (top[1] + tIm) >> 1;
+            }
+        }
+    }
+}
+
+/**
+ * Splits the N/2 point complex transform of the packed samples into the first
+ * N/2 bins of the N point real transform, and stores the amplitude of each.
+ *
+ *   X[k] = E[k] + W_N^k O[k], where
+ *   E[k] = (Z[k] + conj(Z[N/2 - k])) / 2 and O[k] = -j (Z[k] - conj(Z[N/2 - k])) / 2
+ *
+ * @param spectrum ADXL345_SPECTRUM holding the transformed work buffer
+ * @param bins     Output amplitude per bin
+ */
+static void ADXL345_RealSplit(ADXL345_SPECTRUM *spectrum, uint32_t *bins) {
+    const int32_t *data = spectrum->work;
+    int points = spectrum->size / 2;
+
+    // amplitude = 2 |X| / sum(w), and the work buffer holds X / (N/2) with guard bits
+    uint64_t ampNumerator = (uint64_t) spectrum->size << (ADXL345_Q15 + ADXL345_SPECTRUM_AMP_Q);
+    uint64_t ampDenominator = (uint64_t) spectrum->windowSum << ADXL345_SPECTRUM_GUARD_BITS;
+
+    for (int k = 0; k < points; k++) {
+        int mirror = (points - k) & (points - 1);
+        int64_t zRe = data[2 * k];
+        int64_t zIm = data[2 * k + 1];
+        int64_t cRe = data[2 * mirror];
+        int64_t cIm = -data[2 * mirror + 1];
+
+        int64_t eRe = (zRe + cRe) >> 1;
+        int64_t eIm = (zIm + cIm) >> 1;
+        // -j (a + jb) = b - ja
+        int64_t oRe = (zIm - cIm) >> 1;
+        int64_t oIm = -((zRe - cRe) >> 1);
+
+        int64_t c = spectrum->cosTable[k];
+        int64_t s = spectrum->sinTable[k];
+        int64_t xRe = eRe + ((oRe * c + oIm * s) >> ADXL345_Q15);
+        int64_t xIm = eIm + ((oIm * c - oRe * s) >> ADXL345_Q15);
+
+        uint32_t magnitude = ADXL345_isqrt64((uint64_t) (xRe * xRe) + (uint64_t) (xIm * xIm));
+        bins[k] = (uint32_t) ((magnitude * ampNumerator) / ampDenominator);
+    }
+}
+
+/**
+ * Finds the strongest non DC bin of the param axis, refines its frequency by
+ * fitting a parabola through it and its neighbours, and records the overall
+ * RMS of the frame.
+ *
+ * @param spectrum ADXL345_SPECTRUM holding the bins
+ * @param axis     Axis index
+ */
+static void ADXL345_FindPeak(ADXL345_SPECTRUM *spectrum, int axis) {
+    const uint32_t *bins = spectrum->bins[axis];
+    int points = spectrum->size / 2;
+    ADXL345_SPECTRUM_RESULT *result = &spectrum->result[axis];
+
+    int peak = 1;
+    for (int k = 2; k < points; k++) {
+        if (bins[k] > bins[peak]) {
+            peak = k;
+        }
+    }
+
+    // Parabolic interpolation, offset from the peak bin in 1/100ths of a bin
+    int64_t offsetCentiBins = 0;
+    if (peak < points - 1) {
+        int64_t left = bins[peak - 1];
+        int64_t centre = bins[peak];
+        int64_t right = bins[peak + 1];
+        int64_t curvature = 2 * centre - left - right;
+        if (curvature > 0) {
+            offsetCentiBins = (50 * (right - left)) / curvature;
+        }
+    }
+
+    int64_t centiBins = (int64_t) peak * 100 + offsetCentiBins;
+    result->peakBin = peak;
+    result->peakFreqCentiHz = (uint32_t) ((centiBins * spectrum->sampleRateHz) >> spectrum->log2Size);
+    result->peakAmplitude = bins[peak];
+    result->rms = ADXL345_spectrumBandRms(spectrum, axis, 0, spectrum->sampleRateHz / 2);
+}
@@ -0,0 +1,66 @@
+/**
+ * File:       ADXL345_spectrum.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ADXL345.h"
+
+#define ADXL345_SPECTRUM_MIN_SIZE   256
+#define ADXL345_SPECTRUM_MAX_SIZE   1024
+#define ADXL345_SPECTRUM_MAX_BINS   (ADXL345_SPECTRUM_MAX_SIZE / 2)
+// Amplitudes and RMS values are reported in raw counts with 4 fraction bits
+#define ADXL345_SPECTRUM_AMP_Q      4
+
+typedef struct _adxl345SpectrumResult {
+    uint32_t peakBin;
+    uint32_t peakFreqCentiHz;
+    uint32_t peakAmplitude;
+    uint32_t rms;
+} ADXL345_SPECTRUM_RESULT;
+
+/**
+ * All working memory for the spectrum stage lives in this struct, sized for
+ * the largest supported frame, so memory use is fixed no matter how long the
+ * capture runs.  It is roughly 20KB, so declare it static or allocate it
+ * rather than putting it on a task stack.
+ */
+typedef struct _adxl345Spectrum {
+    int size;
+    int log2Size;
+    uint32_t sampleRateHz;
+    int fill;
+    uint32_t frames;
+    // Precomputed tables, Q15
+    int16_t window[ADXL345_SPECTRUM_MAX_SIZE];
+    int16_t cosTable[ADXL345_SPECTRUM_MAX_BINS];
+    int16_t sinTable[ADXL345_SPECTRUM_MAX_BINS];
+    int64_t windowSum;
+    int64_t windowSumSq;
+    uint32_t rmsScaleQ16;
+    // Frame being collected, one row per axis
+    int16_t input[3][ADXL345_SPECTRUM_MAX_SIZE];
+    // Complex work buffer, interleaved re/im
+    int32_t work[ADXL345_SPECTRUM_MAX_SIZE];
+    // Amplitude per bin of the last analyzed frame, one row per axis
+    uint32_t bins[3][ADXL345_SPECTRUM_MAX_BINS];
+    ADXL345_SPECTRUM_RESULT result[3];
+} ADXL345_SPECTRUM;
+
+
+// Public methods designed for the user to call
+bool ADXL345_spectrumInit(ADXL345_SPECTRUM *spectrum, int size, uint32_t sampleRateHz);
+
+int ADXL345_spectrumFeed(ADXL345_SPECTRUM *spectrum, const ADXL345_BLOCK *block);
+
+void ADXL345_spectrumAnalyze(ADXL345_SPECTRUM *spectrum, int axis, const int16_t *samples);
+
+uint32_t ADXL345_spectrumBandRms(const ADXL345_SPECTRUM *spectrum, int axis, uint32_t lowHz, uint32_t highHz);
+
+uint32_t ADXL345_spectrumBinFreqCentiHz(const ADXL345_SPECTRUM *spectrum, uint32_t bin);
@@ -0,0 +1,367 @@
+/**
+ * File:       ADXL345_spi.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * SPI backends for ADXL345_TRANSPORT, on the ESP-IDF spi_master driver, for
+ * the sensor's 4-wire SPI mode at up to 5 MHz.
+ *
+ * Every transfer is a half duplex transaction: the register address goes out
+ * in the address phase with the read and multi-byte bits set as needed, then
+ * the data is written or read.  One FIFO entry takes 56 clocks, about 11 us
+ * at 5 MHz, against roughly 830 us for the same read over 100 kHz I2C.
+ *
+ * The synchronous backend uses polling transactions, which skip the
+ * interrupt and suit the short register accesses.  The async backend queues
+ * transactions through DMA and hands each result to its caller from the
+ * post transaction callback.  Synchronous calls on an async device queue a
+ * transfer and wait for it, as polling and queued transactions can't be
+ * mixed on one device.  Their reads go through a buffer the transport owns,
+ * so a transfer whose wait timed out can still finish safely.
+ *
+ * The spi_master driver has no per transaction error, a queued transaction
+ * is always clocked out.  What the completion callback can check is that
+ * the transaction finishing is the one its ring expects, and anything else
+ * is reported as ESP_ERR_INVALID_STATE rather than handing one caller
+ * another's data.
+ *
+ * SPI has no acknowledge and no bus state to wedge, so neither backend can
+ * report a missing sensor or needs recovering; the driver's configuration
+ * check is what notices a sensor that isn't there.
+ */
+#include <string.h>
+#include "ADXL345_spi.h"
+
+// The sensor pops the FIFO when CS rises, and wants 5 us before the next
+// read.  Holding CS for 16 clocks before the address covers most of that, the
+// driver's own gap between transactions the rest.
+#define ADXL345_SPI_CS_SETUP_CLOCKS 16
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_SpiWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_SpiWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_SpiPolling(spi_device_handle_t handle, const uint8_t *tx, size_t txLength,
+                                    uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_SpiAsyncWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_SpiAsyncWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_SpiAsyncSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                        ADXL345_TRANSPORT_DONE done, void *arg);
+static esp_err_t ADXL345_SpiAsyncWait(ADXL345_SPI_ASYNC *async, const uint8_t *tx, size_t txLength,
+                                      uint8_t *rx, size_t rxLength);
+static bool ADXL345_SpiAsyncAwait(ADXL345_SPI_ASYNC *async, uint32_t ticket);
+static esp_err_t ADXL345_SpiPrepare(spi_transaction_t *trans, uint8_t *data, const uint8_t *tx, size_t txLength,
+                                    size_t rxLength);
+static bool ADXL345_SpiSyncDone(esp_err_t result, void *arg);
+static void IRAM_ATTR ADXL345_SpiTransDone(spi_transaction_t *trans);
+
+static const ADXL345_TRANSPORT_OPS ADXL345_SPI_OPS = {
+    .write = ADXL345_SpiWrite,
+    .writeRead = ADXL345_SpiWriteRead,
+    .submitWriteRead = NULL,
+    .recover = NULL,
+};
+
+static const ADXL345_TRANSPORT_OPS ADXL345_SPI_ASYNC_OPS = {
+    .write = ADXL345_SpiAsyncWrite,
+    .writeRead = ADXL345_SpiAsyncWriteRead,
+    .submitWriteRead = ADXL345_SpiAsyncSubmit,
+    .recover = NULL,
+};
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the param device on an already added SPI device handle, using
+ * a synchronous SPI transport.
+ *
+ * @param dev    ADXL345_DEVICE to initialize
+ * @param handle SPI device handle from spi_bus_add_device, configured with
+ *               ADXL345_spiDeviceConfig
+ * @param config ADXL345_CONFIG to apply to the sensor
+ */
+esp_err_t ADXL345_initSpi(ADXL345_DEVICE *dev, spi_device_handle_t handle, const ADXL345_CONFIG *config) {
+    ADXL345_TRANSPORT transport;
+    ADXL345_spiTransport(&transport, handle);
+    return ADXL345_initTransport(dev, &transport, config);
+}
+
+/**
+ * Fills in an SPI device configuration for the sensor: mode 3, an 8 bit
+ * address phase and half duplex transfers.
+ *
+ * @param config  spi_device_interface_config_t to fill
+ * @param csPin   GPIO wired to the sensor's CS pin
+ * @param clockHz SCLK frequency, capped at ADXL345_SPI_MAX_HZ
+ */
+void ADXL345_spiDeviceConfig(spi_device_interface_config_t *config, int csPin, int clockHz) {
+    *config = (spi_device_interface_config_t) {
+        .address_bits = 8,
+        .mode = 3,
+        .clock_speed_hz = (clockHz > ADXL345_SPI_MAX_HZ) ? ADXL345_SPI_MAX_HZ : clockHz,
+        .spics_io_num = csPin,
+        .flags = SPI_DEVICE_HALFDUPLEX,
+        .cs_ena_pretrans = ADXL345_SPI_CS_SETUP_CLOCKS,
+        .queue_size = ADXL345_SPI_QUEUE_DEPTH,
+    };
+}
+
+/**
+ * Sets up a synchronous transport on an SPI device handle.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param handle    SPI device handle from spi_bus_add_device, configured with
+ *                  ADXL345_spiDeviceConfig
+ */
+void ADXL345_spiTransport(ADXL345_TRANSPORT *transport, spi_device_handle_t handle) {
+    transport->ops = &ADXL345_SPI_OPS;
+    transport->ctx = handle;
+}
+
+/**
+ * Adds the sensor to an SPI bus and sets up an asynchronous transport on it,
+ * so that FIFO drains can be queued with ADXL345_readFifoStart while the CPU
+ * does other work.  The device is added here, as the completion callback is
+ * part of its configuration.
+ * NOTE: The bus should be initialized with a DMA channel, and the param
+ *       async must be in internal RAM, as the transfers run out of its
+ *       buffers.  With CONFIG_SPI_MASTER_ISR_IN_IRAM completions can arrive
+ *       while the flash cache is disabled, so turn on
+ *       CONFIG_ADXL345_ISR_IRAM_SAFE to put the callbacks in IRAM too.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param async     ADXL345_SPI_ASYNC state, must outlive the transport
+ * @param host      SPI host the bus was initialized on
+ * @param csPin     GPIO wired to the sensor's CS pin
+ * @param clockHz   SCLK frequency, capped at ADXL345_SPI_MAX_HZ
+ */
+esp_err_t ADXL345_spiAsyncTransport(ADXL345_TRANSPORT *transport, ADXL345_SPI_ASYNC *async, spi_host_device_t host,
+                                    int csPin, int clockHz) {
+    memset(async, 0, sizeof(*async));
+    atomic_init(&async->head, 0);
+    atomic_init(&async->tail, 0);
+    atomic_init(&async->syncCompleted, 0);
+
+    async->lock = xSemaphoreCreateMutex();
+    async->waitLock = xSemaphoreCreateMutex();
+    async->syncDone = xSemaphoreCreateBinary();
+    if (async->lock == NULL || async->waitLock == NULL || async->syncDone == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Results come back through the callback, so the driver needn't queue them too
+    spi_device_interface_config_t config;
+    ADXL345_spiDeviceConfig(&config, csPin, clockHz);
+    config.flags |= SPI_DEVICE_NO_RETURN_RESULT;
+    config.post_cb = ADXL345_SpiTransDone;
+    esp_err_t err = spi_bus_add_device(host, &config, &async->handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    transport->ops = &ADXL345_SPI_ASYNC_OPS;
+    transport->ctx = async;
+    return ESP_OK;
+}
+
+
+// 'Private' functions designed for internal use
+
+// Transport ops, synchronous calls on an async device go through ADXL345_SpiAsyncWait
+static esp_err_t ADXL345_SpiWrite(void *ctx, const uint8_t *data, size_t length) {
+    return ADXL345_SpiPolling((spi_device_handle_t) ctx, data, length, NULL, 0);
+}
+
+static esp_err_t ADXL345_SpiWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    return ADXL345_SpiPolling((spi_device_handle_t) ctx, tx, txLength, rx, rxLength);
+}
+
+/**
+ * Runs one polling transaction, bounded by ADXL345_SPI_TIMEOUT_MS both to
+ * get the bus and to finish.
+ */
+static esp_err_t ADXL345_SpiPolling(spi_device_handle_t handle, const uint8_t *tx, size_t txLength,
+                                    uint8_t *rx, size_t rxLength) {
+    WORD_ALIGNED_ATTR uint8_t data[ADXL345_SPI_MAX_DATA];
+    spi_transaction_t trans;
+
+    esp_err_t err = ADXL345_SpiPrepare(&trans, data, tx, txLength, rxLength);
+    if (err == ESP_OK) {
+        err = spi_device_polling_start(handle, &trans, pdMS_TO_TICKS(ADXL345_SPI_TIMEOUT_MS));
+    }
+    if (err == ESP_OK) {
+        err = spi_device_polling_end(handle, pdMS_TO_TICKS(ADXL345_SPI_TIMEOUT_MS));
+    }
+    if (err == ESP_OK && rxLength > 0) {
+        memcpy(rx, data, rxLength);
+    }
+    return err;
+}
+
+static esp_err_t ADXL345_SpiAsyncWrite(void *ctx, const uint8_t *data, size_t length) {
+    return ADXL345_SpiAsyncWait((ADXL345_SPI_ASYNC *) ctx, data, length, NULL, 0);
+}
+
+static esp_err_t ADXL345_SpiAsyncWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    return ADXL345_SpiAsyncWait((ADXL345_SPI_ASYNC *) ctx, tx, txLength, rx, rxLength);
+}
+
+/**
+ * Queues a transaction with the SPI driver out of the next free slot,
+ * recording its completion callback first, as the transaction may finish
+ * before the driver call returns.
+ */
+static esp_err_t ADXL345_SpiAsyncSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                        ADXL345_TRANSPORT_DONE done, void *arg) {
+    ADXL345_SPI_ASYNC *async = (ADXL345_SPI_ASYNC *) ctx;
+
+    xSemaphoreTake(async->lock, portMAX_DELAY);
+    unsigned head = atomic_load_explicit(&async->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&async->tail, memory_order_acquire) >= ADXL345_SPI_QUEUE_DEPTH) {
+        xSemaphoreGive(async->lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ADXL345_SPI_PENDING *pending = &async->pending[head % ADXL345_SPI_QUEUE_DEPTH];
+    esp_err_t err = ADXL345_SpiPrepare(&pending->trans, pending->data, tx, txLength, rxLength);
+    if (err != ESP_OK) {
+        xSemaphoreGive(async->lock);
+        return err;
+    }
+    pending->trans.user = async;
+    pending->done = done;
+    pending->arg = arg;
+    pending->rx = rx;
+    pending->rxLength = rxLength;
+    atomic_store_explicit(&async->head, head + 1, memory_order_release);
+
+    // The slots and the driver's queue are the same depth, so this never waits
+    err = spi_device_queue_trans(async->handle, &pending->trans, 0);
+    if (err != ESP_OK) {
+        // Never queued, so no completion will arrive for it
+        atomic_store_explicit(&async->head, head, memory_order_release);
+    }
+    xSemaphoreGive(async->lock);
+    return err;
+}
+
+/**
+ * Queues a transaction and blocks until it completes.  Only one synchronous
+ * transfer is waited on at a time, async submissions may still be queued
+ * around it.  A read is copied out of syncRx only once its own transaction
+ * has completed; one that timed out earlier still lands there first, as
+ * transactions complete in order.
+ */
+static esp_err_t ADXL345_SpiAsyncWait(ADXL345_SPI_ASYNC *async, const uint8_t *tx, size_t txLength,
+                                      uint8_t *rx, size_t rxLength) {
+    xSemaphoreTake(async->waitLock, portMAX_DELAY);
+    esp_err_t err = ADXL345_SpiAsyncSubmit(async, tx, txLength, async->syncRx, rxLength, ADXL345_SpiSyncDone, async);
+    if (err == ESP_OK) {
+        uint32_t ticket = ++async->syncIssued;
+        if (!ADXL345_SpiAsyncAwait(async, ticket)) {
+            err = ESP_ERR_TIMEOUT;
+        } else {
+            err = async->syncResult;
+            if (err == ESP_OK && rxLength > 0) {
+                memcpy(rx, async->syncRx, rxLength);
+            }
+        }
+    }
+    xSemaphoreGive(async->waitLock);
+    return err;
+}
+
+/**
+ * Blocks until the synchronous transfer with the param ticket has completed,
+ * allowing ADXL345_SPI_TIMEOUT_MS for it and for every transaction queued
+ * ahead of it.  Completions of earlier transfers that timed out also wake
+ * the wait, and are skipped.
+ *
+ * @param async  ADXL345_SPI_ASYNC state, with waitLock held
+ * @param ticket Number of the transfer
+ * @return true if it completed, false if the wait timed out
+ */
+static bool ADXL345_SpiAsyncAwait(ADXL345_SPI_ASYNC *async, uint32_t ticket) {
+    unsigned queued = atomic_load_explicit(&async->head, memory_order_relaxed) -
+                      atomic_load_explicit(&async->tail, memory_order_acquire);
+    if (queued == 0) {
+        queued = 1;
+    }
+    TickType_t budget = pdMS_TO_TICKS(queued * ADXL345_SPI_TIMEOUT_MS);
+    TickType_t start = xTaskGetTickCount();
+    while ((int32_t) (atomic_load_explicit(&async->syncCompleted, memory_order_acquire) - ticket) < 0) {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= budget || xSemaphoreTake(async->syncDone, budget - elapsed) != pdTRUE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Turns a driver transfer into a transaction on the param data buffer.  The
+ * driver only ever writes an address and data, or writes an address and
+ * reads, so the first byte of tx always goes in the address phase.
+ */
+static esp_err_t ADXL345_SpiPrepare(spi_transaction_t *trans, uint8_t *data, const uint8_t *tx, size_t txLength,
+                                    size_t rxLength) {
+    size_t dataLength = (rxLength > 0) ? rxLength : txLength - 1;
+    if (txLength == 0 || (rxLength > 0 && txLength != 1) || dataLength > ADXL345_SPI_MAX_DATA) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    memset(trans, 0, sizeof(*trans));
+    trans->addr = tx[0];
+    if (dataLength > 1) {
+        trans->addr |= ADXL345_SPI_MULTI_BYTE;
+    }
+    if (rxLength > 0) {
+        trans->addr |= ADXL345_SPI_READ;
+        trans->rxlength = rxLength * 8;
+        trans->rx_buffer = data;
+    } else {
+        memcpy(data, tx + 1, dataLength);
+        trans->length = dataLength * 8;
+        trans->tx_buffer = data;
+    }
+    return ESP_OK;
+}
+
+static bool ADXL345_SpiSyncDone(esp_err_t result, void *arg) {
+    ADXL345_SPI_ASYNC *async = (ADXL345_SPI_ASYNC *) arg;
+    BaseType_t woken = pdFALSE;
+
+    async->syncResult = result;
+    atomic_fetch_add_explicit(&async->syncCompleted, 1, memory_order_release);
+    xSemaphoreGiveFromISR(async->syncDone, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * SPI driver post transaction callback, runs in the SPI ISR.  Copies a read
+ * out of its bounce buffer and hands the result to the oldest pending
+ * transfer, which fails if the driver finished some other transaction.
+ */
+static void IRAM_ATTR ADXL345_SpiTransDone(spi_transaction_t *trans) {
+    ADXL345_SPI_ASYNC *async = (ADXL345_SPI_ASYNC *) trans->user;
+
+    unsigned tail = atomic_load_explicit(&async->tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&async->head, memory_order_acquire)) {
+        return;
+    }
+    ADXL345_SPI_PENDING *pending = &async->pending[tail % ADXL345_SPI_QUEUE_DEPTH];
+    esp_err_t result = (trans == &pending->trans) ? ESP_OK : ESP_ERR_INVALID_STATE;
+    if (result == ESP_OK && pending->rxLength > 0) {
+        memcpy(pending->rx, pending->data, pending->rxLength);
+    }
+    ADXL345_TRANSPORT_DONE done = pending->done;
+    void *arg = pending->arg;
+    atomic_store_explicit(&async->tail, tail + 1, memory_order_release);
+
+    if (done(result, arg)) {
+        portYIELD_FROM_ISR();
+    }
+}
@@ -0,0 +1,73 @@
+/**
+ * File:       ADXL345_spi.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include "driver/spi_master.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "ADXL345_transport.h"
+#include "ADXL345.h"
+
+// Transfers that can be in flight at once on an async device, a full FIFO
+// drain plus a synchronous access
+#define ADXL345_SPI_QUEUE_DEPTH 34
+// Longest data phase of one transfer, after the address byte
+#define ADXL345_SPI_MAX_DATA    32
+
+typedef struct _adxl345SpiPending {
+    spi_transaction_t trans;
+    ADXL345_TRANSPORT_DONE done;
+    void *arg;
+    // Where a read is copied to once it lands in data
+    uint8_t *rx;
+    size_t rxLength;
+    // DMA bounce buffer, so the caller's buffers need no particular alignment
+    WORD_ALIGNED_ATTR uint8_t data[ADXL345_SPI_MAX_DATA];
+} ADXL345_SPI_PENDING;
+
+typedef struct _adxl345SpiAsync {
+    spi_device_handle_t handle;
+    // Transfers complete in submission order, so the slots are used as a ring
+    ADXL345_SPI_PENDING pending[ADXL345_SPI_QUEUE_DEPTH];
+    atomic_uint head;
+    atomic_uint tail;
+    SemaphoreHandle_t lock;
+    SemaphoreHandle_t waitLock;
+    SemaphoreHandle_t syncDone;
+    esp_err_t syncResult;
+    // Synchronous reads land here rather than in the caller's buffer, so one
+    // that times out can't write to memory its caller has since reused
+    uint8_t syncRx[ADXL345_SPI_MAX_DATA];
+    // Synchronous transfers queued and completed, each wait looks for its own
+    uint32_t syncIssued;
+    atomic_uint syncCompleted;
+} ADXL345_SPI_ASYNC;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_initSpi(ADXL345_DEVICE *dev, spi_device_handle_t handle, const ADXL345_CONFIG *config);
+
+void ADXL345_spiDeviceConfig(spi_device_interface_config_t *config, int csPin, int clockHz);
+
+void ADXL345_spiTransport(ADXL345_TRANSPORT *transport, spi_device_handle_t handle);
+
+esp_err_t ADXL345_spiAsyncTransport(ADXL345_TRANSPORT *transport, ADXL345_SPI_ASYNC *async, spi_host_device_t host,
+                                    int csPin, int clockHz);
+
+// Constants for calculations
+// Fastest SCLK the sensor supports
+#define ADXL345_SPI_MAX_HZ      5000000
+// Deadline for a single transaction, including waiting for a shared bus.  A
+// wait on an async device allows this for every transfer queued ahead of it.
+#define ADXL345_SPI_TIMEOUT_MS  20
+// First byte of every transfer, the register address and these two bits
+#define ADXL345_SPI_READ        0x80
+#define ADXL345_SPI_MULTI_BYTE  0x40
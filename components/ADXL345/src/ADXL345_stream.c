@@ -0,0 +1,178 @@
+/**
+ * File:       ADXL345_stream.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Telemetry stream.  Each block is encoded straight into one of a small pool
+ * of frame buffers and queued for a sender task, which hands it to the link.
+ * The acquisition side never waits on the link: if every buffer is still
+ * queued the block is dropped and counted, and the receiver sees the gap in
+ * the sequence numbers.
+ *
+ * The link is a writer callback.  ADXL345_stream_uart.c provides one for a
+ * UART, and ADXL345_streamFdWriter writes to a file descriptor such as a
+ * pseudo-terminal on a Linux host.
+ */
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "ADXL345_stream.h"
+
+#define ADXL345_STREAM_STACK_SIZE   3072
+
+static const char *TAG = "ADXL345_stream";
+
+// 'Private' helpers designed for internal use
+static void ADXL345_Release(ADXL345_STREAM *stream);
+static void ADXL345_SenderTask(void *arg);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Sets up the buffer pool and starts the sender task.  The queues are freed
+ * again if either step fails.
+ *
+ * @param stream   ADXL345_STREAM to start
+ * @param writer   Sends encoded frames over the link
+ * @param arg      Argument passed through to the writer
+ * @param rateCode BW_RATE code the streamed samples are captured at
+ * @param priority FreeRTOS priority of the sender task
+ * @param core     Core to pin the sender task to, or tskNO_AFFINITY
+ */
+esp_err_t ADXL345_streamStart(ADXL345_STREAM *stream, ADXL345_STREAM_WRITER writer, void *arg, uint8_t rateCode,
+                              UBaseType_t priority, BaseType_t core) {
+    memset(stream, 0, sizeof(*stream));
+    stream->writer = writer;
+    stream->arg = arg;
+    stream->rateCode = rateCode;
+
+    stream->freeBuffers = xQueueCreate(ADXL345_STREAM_BUFFERS, sizeof(int));
+    stream->fullBuffers = xQueueCreate(ADXL345_STREAM_BUFFERS, sizeof(int));
+    if (stream->freeBuffers == NULL || stream->fullBuffers == NULL) {
+        ADXL345_Release(stream);
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < ADXL345_STREAM_BUFFERS; i++) {
+        xQueueSend(stream->freeBuffers, &i, 0);
+    }
+
+    if (xTaskCreatePinnedToCore(ADXL345_SenderTask, "adxl345_stream", ADXL345_STREAM_STACK_SIZE,
+                                stream, priority, &stream->sender, core) != pdPASS) {
+        stream->sender = NULL;
+        ADXL345_Release(stream);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Encodes a block of samples and queues it to be sent.  Never blocks, so it
+ * can be called from the acquisition task.  Only one task may append to a
+ * stream.
+ *
+ * @param stream      ADXL345_STREAM to append to
+ * @param block       ADXL345_BLOCK of samples, empty blocks are skipped
+ * @param timestampUs Timestamp of the first sample in the block
+ * @return ESP_ERR_NO_MEM if the block was dropped because the link is behind
+ */
+esp_err_t ADXL345_streamAppend(ADXL345_STREAM *stream, const ADXL345_BLOCK *block, int64_t timestampUs) {
+    if (block->count <= 0) {
+        return ESP_OK;
+    }
+
+    // Numbered even if dropped, so the receiver can tell
+    ADXL345_STREAM_FRAME *frame = &stream->staging;
+    frame->sequence = stream->sequence++;
+
+    int index;
+    if (xQueueReceive(stream->freeBuffers, &index, 0) != pdTRUE) {
+        stream->stats.framesDropped++;
+        stream->stats.samplesDropped += block->count;
+        return ESP_ERR_NO_MEM;
+    }
+
+    int count = (block->count < ADXL345_STREAM_MAX_SAMPLES) ? block->count : ADXL345_STREAM_MAX_SAMPLES;
+    frame->timestampUs = timestampUs;
+    frame->rateCode = stream->rateCode;
+    frame->count = count;
+    memcpy(frame->x, block->x, count * sizeof(frame->x[0]));
+    memcpy(frame->y, block->y, count * sizeof(frame->y[0]));
+    memcpy(frame->z, block->z, count * sizeof(frame->z[0]));
+
+    stream->counts[index] = count;
+    stream->lengths[index] = ADXL345_streamEncodeFrame(frame, stream->buffers[index], ADXL345_STREAM_MAX_FRAME);
+    xQueueSend(stream->fullBuffers, &index, 0);
+    return ESP_OK;
+}
+
+/**
+ * Stream writer for a file descriptor, passed as the writer's arg with
+ * (void *) (intptr_t) fd.  A non-blocking descriptor that fills up is retried
+ * a tick later, so on the Linux target a full pseudo-terminal doesn't stall
+ * every other task.
+ */
+esp_err_t ADXL345_streamFdWriter(const uint8_t *data, size_t length, void *arg) {
+    int fd = (int) (intptr_t) arg;
+    size_t written = 0;
+
+    while (written < length) {
+        ssize_t result = write(fd, &data[written], length - written);
+        if (result > 0) {
+            written += result;
+        } else if (result < 0 && (errno == EAGAIN || errno == EINTR)) {
+            vTaskDelay(1);
+        } else {
+            return ESP_FAIL;
+        }
+    }
+    return ESP_OK;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Frees whatever queues the stream has created so far.
+ *
+ * @param stream ADXL345_STREAM to release
+ */
+static void ADXL345_Release(ADXL345_STREAM *stream) {
+    if (stream->freeBuffers != NULL) {
+        vQueueDelete(stream->freeBuffers);
+        stream->freeBuffers = NULL;
+    }
+    if (stream->fullBuffers != NULL) {
+        vQueueDelete(stream->fullBuffers);
+        stream->fullBuffers = NULL;
+    }
+}
+
+/**
+ * Sends each queued frame over the link and returns its buffer to the pool.
+ *
+ * @param arg ADXL345_STREAM being sent
+ */
+static void ADXL345_SenderTask(void *arg) {
+    ADXL345_STREAM *stream = (ADXL345_STREAM *) arg;
+    int index;
+
+    while (1) {
+        xQueueReceive(stream->fullBuffers, &index, portMAX_DELAY);
+        size_t length = stream->lengths[index];
+
+        if (length > 0 && stream->writer(stream->buffers[index], length, stream->arg) == ESP_OK) {
+            stream->stats.framesSent++;
+            stream->stats.samplesSent += stream->counts[index];
+            stream->stats.bytesSent += length;
+        } else {
+            stream->stats.writeErrors++;
+            ESP_LOGW(TAG, "Failed to send frame");
+        }
+        xQueueSend(stream->freeBuffers, &index, portMAX_DELAY);
+    }
+}
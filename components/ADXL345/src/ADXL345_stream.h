@@ -0,0 +1,57 @@
+/**
+ * File:       ADXL345_stream.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "ADXL345.h"
+#include "ADXL345_streamformat.h"
+
+// Encoded frames that can wait for the link, about 50 ms of 3200 Hz data
+#define ADXL345_STREAM_BUFFERS      16
+
+// Sends one encoded frame, blocking until the link has taken it
+typedef esp_err_t (*ADXL345_STREAM_WRITER)(const uint8_t *data, size_t length, void *arg);
+
+typedef struct _adxl345StreamStats {
+    uint32_t framesSent;
+    uint32_t samplesSent;
+    uint32_t framesDropped;
+    uint32_t samplesDropped;
+    uint32_t writeErrors;
+    uint64_t bytesSent;
+} ADXL345_STREAM_STATS;
+
+typedef struct _adxl345Stream {
+    ADXL345_STREAM_WRITER writer;
+    void *arg;
+    uint8_t rateCode;
+    uint32_t sequence;
+    uint8_t buffers[ADXL345_STREAM_BUFFERS][ADXL345_STREAM_MAX_FRAME];
+    size_t lengths[ADXL345_STREAM_BUFFERS];
+    int counts[ADXL345_STREAM_BUFFERS];
+    ADXL345_STREAM_FRAME staging;
+    QueueHandle_t freeBuffers;
+    QueueHandle_t fullBuffers;
+    TaskHandle_t sender;
+    ADXL345_STREAM_STATS stats;
+} ADXL345_STREAM;
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_streamStart(ADXL345_STREAM *stream, ADXL345_STREAM_WRITER writer, void *arg, uint8_t rateCode,
+                              UBaseType_t priority, BaseType_t core);
+
+esp_err_t ADXL345_streamAppend(ADXL345_STREAM *stream, const ADXL345_BLOCK *block, int64_t timestampUs);
+
+esp_err_t ADXL345_streamFdWriter(const uint8_t *data, size_t length, void *arg);
@@ -0,0 +1,25 @@
+/**
+ * File:       ADXL345_stream_uart.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/uart.h"
+#include "ADXL345_stream.h"
+
+// Room for a third of a second of 3200 Hz frames in the driver's TX ring buffer
+#define ADXL345_STREAM_UART_TX_BUFFER   8192
+#define ADXL345_STREAM_UART_BAUD        2000000
+
+
+// Public methods designed for the user to call
+esp_err_t ADXL345_streamUartInit(uart_port_t port, int txPin, int baudRate);
+
+esp_err_t ADXL345_streamUartWriter(const uint8_t *data, size_t length, void *arg);
@@ -0,0 +1,271 @@
+/**
+ * File:       ADXL345_streamformat.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include "ADXL345_streamformat.h"
+#include "ADXL345_logformat.h"
+
+// 'Private' helpers designed for internal use
+static void ADXL345_StreamFrameEnd(ADXL345_STREAM_DECODER *decoder);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Encodes the param frame, COBS stuffed and delimited, ready to send.
+ *
+ * @param frame    ADXL345_STREAM_FRAME to encode, with 1 to ADXL345_STREAM_MAX_SAMPLES samples
+ * @param out      Buffer to encode into, ADXL345_STREAM_MAX_FRAME bytes is always enough
+ * @param capacity Size of the buffer
+ * @return Number of bytes written, delimiter included, or 0 if the frame did not fit
+ */
+size_t ADXL345_streamEncodeFrame(const ADXL345_STREAM_FRAME *frame, uint8_t *out, size_t capacity) {
+    if (frame->count <= 0 || frame->count > ADXL345_STREAM_MAX_SAMPLES) {
+        return 0;
+    }
+
+    uint8_t raw[ADXL345_STREAM_MAX_RAW];
+    uint64_t timestamp = (uint64_t) frame->timestampUs;
+    raw[0] = ADXL345_STREAM_MAGIC;
+    raw[1] = ADXL345_STREAM_VERSION;
+    raw[2] = frame->rateCode;
+    raw[3] = (uint8_t) frame->count;
+    for (int i = 0; i < 4; i++) {
+        raw[4 + i] = (uint8_t) (frame->sequence >> (8 * i));
+    }
+    for (int i = 0; i < 8; i++) {
+        raw[8 + i] = (uint8_t) (timestamp >> (8 * i));
+    }
+
+    size_t offset = ADXL345_STREAM_HEADER_SIZE;
+    for (int i = 0; i < frame->count; i++) {
+        const int16_t axes[3] = { frame->x[i], frame->y[i], frame->z[i] };
+        for (int axis = 0; axis < 3; axis++) {
+            raw[offset++] = (uint8_t) axes[axis];
+            raw[offset++] = (uint8_t) ((uint16_t) axes[axis] >> 8);
+        }
+    }
+    uint16_t crc = ADXL345_logCrc16(0xFFFF, raw, offset);
+    raw[offset++] = (uint8_t) crc;
+    raw[offset++] = (uint8_t) (crc >> 8);
+
+    size_t encoded = ADXL345_cobsEncode(raw, offset, out, capacity);
+    if (encoded == 0 || encoded >= capacity) {
+        return 0;
+    }
+    out[encoded] = 0x00;
+    return encoded + 1;
+}
+
+/**
+ * Decodes one frame that has already been un-stuffed.
+ *
+ * @param data   Frame bytes, without the delimiter
+ * @param length Number of bytes
+ * @param frame  ADXL345_STREAM_FRAME to decode into
+ * @param stats  ADXL345_STREAM_DECODE_STATS to count errors in, may be NULL
+ * @return true if a valid frame was decoded
+ */
+bool ADXL345_streamDecodeFrame(const uint8_t *data, size_t length, ADXL345_STREAM_FRAME *frame,
+                               ADXL345_STREAM_DECODE_STATS *stats) {
+    if (length < ADXL345_STREAM_HEADER_SIZE + ADXL345_STREAM_CRC_SIZE || data[0] != ADXL345_STREAM_MAGIC ||
+        data[1] != ADXL345_STREAM_VERSION || data[3] == 0 || data[3] > ADXL345_STREAM_MAX_SAMPLES ||
+        length != ADXL345_STREAM_HEADER_SIZE + 6u * data[3] + ADXL345_STREAM_CRC_SIZE) {
+        if (stats != NULL) {
+            stats->formatErrors++;
+        }
+        return false;
+    }
+
+    size_t crcOffset = length - ADXL345_STREAM_CRC_SIZE;
+    uint16_t crc = data[crcOffset] | ((uint16_t) data[crcOffset + 1] << 8);
+    if (ADXL345_logCrc16(0xFFFF, data, crcOffset) != crc) {
+        if (stats != NULL) {
+            stats->crcErrors++;
+        }
+        return false;
+    }
+
+    uint64_t timestamp = 0;
+    frame->sequence = 0;
+    for (int i = 0; i < 4; i++) {
+        frame->sequence |= (uint32_t) data[4 + i] << (8 * i);
+    }
+    for (int i = 0; i < 8; i++) {
+        timestamp |= (uint64_t) data[8 + i] << (8 * i);
+    }
+    frame->timestampUs = (int64_t) timestamp;
+    frame->rateCode = data[2];
+    frame->count = data[3];
+
+    const uint8_t *sample = &data[ADXL345_STREAM_HEADER_SIZE];
+    for (int i = 0; i < frame->count; i++, sample += 6) {
+        frame->x[i] = (int16_t) (sample[0] | (sample[1] << 8));
+        frame->y[i] = (int16_t) (sample[2] | (sample[3] << 8));
+        frame->z[i] = (int16_t) (sample[4] | (sample[5] << 8));
+    }
+    return true;
+}
+
+/**
+ * Initializes a receiver that calls the param callback with each valid
+ * frame.  A receiver that joins mid-stream counts the partial frame it
+ * starts in as an error.
+ *
+ * @param decoder  ADXL345_STREAM_DECODER to initialize
+ * @param callback Called for each decoded frame
+ * @param arg      Argument passed through to the callback
+ */
+void ADXL345_streamDecoderInit(ADXL345_STREAM_DECODER *decoder, ADXL345_STREAM_FRAME_CALLBACK callback, void *arg) {
+    decoder->length = 0;
+    decoder->overflow = false;
+    decoder->haveSequence = false;
+    decoder->nextSequence = 0;
+    decoder->callback = callback;
+    decoder->arg = arg;
+    decoder->stats = (ADXL345_STREAM_DECODE_STATS) { 0 };
+}
+
+/**
+ * Feeds received bytes to the decoder, calling back for each frame they
+ * complete.
+ *
+ * @param decoder ADXL345_STREAM_DECODER to feed
+ * @param data    Bytes received
+ * @param length  Number of bytes
+ */
+void ADXL345_streamFeed(ADXL345_STREAM_DECODER *decoder, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] == 0x00) {
+            ADXL345_StreamFrameEnd(decoder);
+        } else if (decoder->length < sizeof(decoder->buffer)) {
+            decoder->buffer[decoder->length++] = data[i];
+        } else {
+            decoder->overflow = true;
+        }
+    }
+}
+
+/**
+ * Consistent Overhead Byte Stuffing.  Rewrites the param bytes without any
+ * zeros, at a cost of one byte per 254 plus one.
+ *
+ * @param in       Bytes to encode
+ * @param length   Number of bytes
+ * @param out      Buffer to encode into, must not overlap the input
+ * @param capacity Size of the buffer
+ * @return Number of bytes written, or 0 if they did not fit
+ */
+size_t ADXL345_cobsEncode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity) {
+    if (capacity < length + length / 254 + 1) {
+        return 0;
+    }
+
+    size_t write = 1;
+    size_t codeIndex = 0;
+    uint8_t code = 1;
+    for (size_t read = 0; read < length; read++) {
+        if (in[read] != 0x00) {
+            out[write++] = in[read];
+            code++;
+        }
+        // A zero, or a full run of 254 non-zero bytes, ends the block
+        if (in[read] == 0x00 || code == 0xFF) {
+            out[codeIndex] = code;
+            code = 1;
+            codeIndex = write;
+            if (in[read] == 0x00 || read + 1 < length) {
+                write++;
+            }
+        }
+    }
+    // A full run that ends the input has already been closed, with no
+    // code byte reserved after it
+    if (codeIndex < write) {
+        out[codeIndex] = code;
+    }
+    return write;
+}
+
+/**
+ * Reverses ADXL345_cobsEncode.
+ *
+ * @param in       Encoded bytes, without the delimiter
+ * @param length   Number of bytes
+ * @param out      Buffer to decode into
+ * @param capacity Size of the buffer
+ * @return Number of bytes decoded, or -1 if the input was malformed or did not fit
+ */
+int ADXL345_cobsDecode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity) {
+    size_t read = 0;
+    size_t write = 0;
+
+    while (read < length) {
+        uint8_t code = in[read++];
+        if (code == 0x00 || read + code - 1 > length) {
+            return -1;
+        }
+        for (int i = 1; i < code; i++) {
+            if (in[read] == 0x00 || write >= capacity) {
+                return -1;
+            }
+            out[write++] = in[read++];
+        }
+        // Every block but a full one ends in a zero, the last block's is implied
+        if (code != 0xFF && read < length) {
+            if (write >= capacity) {
+                return -1;
+            }
+            out[write++] = 0x00;
+        }
+    }
+    return (int) write;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Handles a delimiter: un-stuffs and checks the bytes gathered since the
+ * last one, counts any frames skipped in the sequence, and calls back.
+ */
+static void ADXL345_StreamFrameEnd(ADXL345_STREAM_DECODER *decoder) {
+    size_t length = decoder->length;
+    bool overflow = decoder->overflow;
+    decoder->length = 0;
+    decoder->overflow = false;
+
+    if (overflow) {
+        decoder->stats.overruns++;
+        return;
+    }
+    if (length == 0) {
+        // Back to back delimiters, a sender may use them to resynchronize
+        return;
+    }
+
+    uint8_t raw[ADXL345_STREAM_MAX_RAW];
+    int rawLength = ADXL345_cobsDecode(decoder->buffer, length, raw, sizeof(raw));
+    if (rawLength < 0) {
+        decoder->stats.formatErrors++;
+        return;
+    }
+    if (!ADXL345_streamDecodeFrame(raw, (size_t) rawLength, &decoder->frame, &decoder->stats)) {
+        return;
+    }
+
+    if (decoder->haveSequence && decoder->frame.sequence != decoder->nextSequence) {
+        decoder->stats.lostFrames += decoder->frame.sequence - decoder->nextSequence;
+    }
+    decoder->haveSequence = true;
+    decoder->nextSequence = decoder->frame.sequence + 1;
+    decoder->stats.frames++;
+    decoder->stats.samples += decoder->frame.count;
+
+    if (decoder->callback != NULL) {
+        decoder->callback(&decoder->frame, decoder->arg);
+    }
+}
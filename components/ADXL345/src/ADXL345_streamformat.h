@@ -0,0 +1,96 @@
+/**
+ * File:       ADXL345_streamformat.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * Serial telemetry format.  Each frame is COBS encoded and followed by a
+ * zero byte, so a receiver can find the frame boundaries anywhere in the
+ * stream, and a dropped or corrupted byte costs only the frame it was in.
+ * Before encoding a frame is:
+ *
+ *   offset  size  field
+ *   0       1     magic (ADXL345_STREAM_MAGIC)
+ *   1       1     format version
+ *   2       1     BW_RATE code the samples were captured at
+ *   3       1     sample count, 1 to ADXL345_STREAM_MAX_SAMPLES
+ *   4       4     sequence number, little endian, one more for each frame
+ *   8       8     timestamp of the first sample, microseconds, little endian
+ *   16      6n    samples, each X, Y then Z as little endian int16_t
+ *   16+6n   2     CRC-16/CCITT of bytes 0 to 16+6n, little endian
+ *
+ * A gap in the sequence numbers is frames lost, on the device or the wire.
+ *
+ * This header and ADXL345_streamformat.c have no ESP-IDF dependencies, so
+ * the decoder can be built as-is on a host to read a device's serial port.
+ */
+
+#define ADXL345_STREAM_MAGIC        0xA5
+#define ADXL345_STREAM_VERSION      1
+// One FIFO's worth, the most one drain returns
+#define ADXL345_STREAM_MAX_SAMPLES  32
+#define ADXL345_STREAM_HEADER_SIZE  16
+#define ADXL345_STREAM_CRC_SIZE     2
+#define ADXL345_STREAM_MAX_RAW      (ADXL345_STREAM_HEADER_SIZE + 6 * ADXL345_STREAM_MAX_SAMPLES + ADXL345_STREAM_CRC_SIZE)
+// COBS adds a byte per 254 and one more, then the zero delimiter
+#define ADXL345_STREAM_MAX_FRAME    (ADXL345_STREAM_MAX_RAW + ADXL345_STREAM_MAX_RAW / 254 + 2)
+
+typedef struct _adxl345StreamFrame {
+    uint32_t sequence;
+    int64_t timestampUs;
+    uint8_t rateCode;
+    int count;
+    int16_t x[ADXL345_STREAM_MAX_SAMPLES];
+    int16_t y[ADXL345_STREAM_MAX_SAMPLES];
+    int16_t z[ADXL345_STREAM_MAX_SAMPLES];
+} ADXL345_STREAM_FRAME;
+
+typedef struct _adxl345StreamDecodeStats {
+    uint32_t frames;
+    uint32_t samples;
+    // Frames missing from the sequence
+    uint32_t lostFrames;
+    uint32_t crcErrors;
+    uint32_t formatErrors;
+    // Runs of bytes too long to be a frame, e.g. from a lost delimiter
+    uint32_t overruns;
+} ADXL345_STREAM_DECODE_STATS;
+
+typedef void (*ADXL345_STREAM_FRAME_CALLBACK)(const ADXL345_STREAM_FRAME *frame, void *arg);
+
+// Incremental receiver, fed bytes as they arrive in chunks of any size
+typedef struct _adxl345StreamDecoder {
+    uint8_t buffer[ADXL345_STREAM_MAX_FRAME];
+    size_t length;
+    bool overflow;
+    bool haveSequence;
+    uint32_t nextSequence;
+    ADXL345_STREAM_FRAME frame;
+    ADXL345_STREAM_FRAME_CALLBACK callback;
+    void *arg;
+    ADXL345_STREAM_DECODE_STATS stats;
+} ADXL345_STREAM_DECODER;
+
+
+// Public methods designed for the user to call
+size_t ADXL345_streamEncodeFrame(const ADXL345_STREAM_FRAME *frame, uint8_t *out, size_t capacity);
+
+bool ADXL345_streamDecodeFrame(const uint8_t *data, size_t length, ADXL345_STREAM_FRAME *frame,
+                               ADXL345_STREAM_DECODE_STATS *stats);
+
+void ADXL345_streamDecoderInit(ADXL345_STREAM_DECODER *decoder, ADXL345_STREAM_FRAME_CALLBACK callback, void *arg);
+
+void ADXL345_streamFeed(ADXL345_STREAM_DECODER *decoder, const uint8_t *data, size_t length);
+
+size_t ADXL345_cobsEncode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity);
+
+int ADXL345_cobsDecode(const uint8_t *in, size_t length, uint8_t *out, size_t capacity);
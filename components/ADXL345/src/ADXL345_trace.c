@@ -0,0 +1,322 @@
+/**
+ * File:       ADXL345_trace.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Transaction tracer for ADXL345_TRANSPORT.  A traced transport wraps any
+ * other one and records every transfer into a caller supplied RAM ring:
+ * device address, direction, the bytes on the wire, start and end times and
+ * the result.  The newest transfers overwrite the oldest.
+ *
+ * Recording costs an atomic increment, two esp_timer_get_time calls and a
+ * copy of at most ADXL345_TRACE_DATA_BYTES, and nothing is locked, so it can
+ * stay on in the field.  Queued transfers are finished from their completion
+ * callback, which may run in the I2C ISR.  As with the driver's FIFO drain,
+ * queued transfers must be submitted from one task at a time.
+ *
+ * ADXL345_traceDump writes the ring in the binary format in ADXL345_trace.h,
+ * and ADXL345_replay.c plays a decoded dump back to the driver.
+ */
+#include <string.h>
+#include "esp_timer.h"
+#include "ADXL345_trace.h"
+
+// 'Private' helpers designed for internal use
+static esp_err_t ADXL345_TraceWrite(void *ctx, const uint8_t *data, size_t length);
+static esp_err_t ADXL345_TraceWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+static esp_err_t ADXL345_TraceSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                     ADXL345_TRANSPORT_DONE done, void *arg);
+static esp_err_t ADXL345_TraceRecover(void *ctx);
+static bool ADXL345_TraceDone(esp_err_t result, void *arg);
+static uint32_t ADXL345_TraceBegin(ADXL345_TRACE *trace, ADXL345_TRACE_OP op, const uint8_t *tx, size_t txLength,
+                                   size_t rxLength);
+static void ADXL345_TraceEnd(ADXL345_TRACE *trace, uint32_t index, esp_err_t result, const uint8_t *rx);
+static void ADXL345_PutLe(uint8_t *out, uint64_t value, int bytes);
+static uint64_t ADXL345_GetLe(const uint8_t *in, int bytes);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes an empty, enabled trace.
+ *
+ * @param trace    ADXL345_TRACE to initialize
+ * @param entries  Ring storage, must outlive the trace
+ * @param capacity Number of entries in the ring
+ * @param address  7 bit device address recorded with each transfer
+ */
+void ADXL345_traceInit(ADXL345_TRACE *trace, ADXL345_TRACE_ENTRY *entries, uint32_t capacity, uint8_t address) {
+    memset(trace, 0, sizeof(*trace));
+    trace->entries = entries;
+    trace->capacity = capacity;
+    trace->address = address;
+    atomic_store(&trace->enabled, true);
+}
+
+/**
+ * Sets up a transport that records every transfer made through it and passes
+ * it on to the param inner transport.  It has the same ops as the inner one,
+ * so the driver makes the same choices through either.
+ *
+ * @param transport ADXL345_TRANSPORT to set up
+ * @param trace     ADXL345_TRACE to record into
+ * @param inner     ADXL345_TRANSPORT that does the work, copied
+ */
+void ADXL345_traceTransport(ADXL345_TRANSPORT *transport, ADXL345_TRACE *trace, const ADXL345_TRANSPORT *inner) {
+    trace->inner = *inner;
+    trace->ops = (ADXL345_TRANSPORT_OPS) {
+        .write = ADXL345_TraceWrite,
+        .writeRead = ADXL345_TraceWriteRead,
+        .submitWriteRead = (inner->ops->submitWriteRead != NULL) ? ADXL345_TraceSubmit : NULL,
+        .recover = (inner->ops->recover != NULL) ? ADXL345_TraceRecover : NULL,
+    };
+    transport->ops = &trace->ops;
+    transport->ctx = trace;
+}
+
+/**
+ * Pauses or resumes recording.  Transfers keep flowing either way.
+ * NOTE: Pause before dumping for a consistent snapshot.
+ *
+ * @param trace   ADXL345_TRACE to change
+ * @param enabled true to record
+ */
+void ADXL345_traceSetEnabled(ADXL345_TRACE *trace, bool enabled) {
+    atomic_store(&trace->enabled, enabled);
+}
+
+/**
+ * Forgets everything recorded so far.
+ *
+ * @param trace ADXL345_TRACE to clear
+ */
+void ADXL345_traceClear(ADXL345_TRACE *trace) {
+    atomic_store(&trace->head, 0);
+}
+
+/**
+ * Writes the ring, oldest transfer first, in the binary format described in
+ * ADXL345_trace.h.
+ *
+ * @param trace  ADXL345_TRACE to dump
+ * @param writer Function to hand each piece of the dump to
+ * @param arg    User argument passed to the writer
+ */
+esp_err_t ADXL345_traceDump(ADXL345_TRACE *trace, ADXL345_TRACE_WRITER writer, void *arg) {
+    uint32_t head = atomic_load(&trace->head);
+    uint32_t count = (head < trace->capacity) ? head : trace->capacity;
+    uint8_t record[ADXL345_TRACE_RECORD_SIZE];
+
+    memset(record, 0, ADXL345_TRACE_HEADER_SIZE);
+    ADXL345_PutLe(&record[0], ADXL345_TRACE_MAGIC, 4);
+    record[4] = ADXL345_TRACE_VERSION;
+    record[5] = ADXL345_TRACE_RECORD_SIZE;
+    ADXL345_PutLe(&record[8], count, 4);
+    ADXL345_PutLe(&record[12], head - count, 4);
+    esp_err_t err = writer(record, ADXL345_TRACE_HEADER_SIZE, arg);
+
+    for (uint32_t i = head - count; i != head && err == ESP_OK; i++) {
+        const ADXL345_TRACE_ENTRY *entry = &trace->entries[i % trace->capacity];
+        uint32_t durationUs = (entry->endUs >= entry->startUs) ?
+            (uint32_t) (entry->endUs - entry->startUs) : ADXL345_TRACE_INCOMPLETE;
+
+        ADXL345_PutLe(&record[0], (uint64_t) entry->startUs, 8);
+        ADXL345_PutLe(&record[8], durationUs, 4);
+        ADXL345_PutLe(&record[12], (uint16_t) entry->result, 2);
+        record[14] = entry->address;
+        record[15] = entry->op;
+        record[16] = entry->flags;
+        record[17] = entry->txLength;
+        record[18] = entry->rxLength;
+        memcpy(&record[19], entry->data, ADXL345_TRACE_DATA_BYTES);
+        err = writer(record, ADXL345_TRACE_RECORD_SIZE, arg);
+    }
+    return err;
+}
+
+/**
+ * Decodes a dump back into entries.  Returns the number decoded, zero if the
+ * header isn't valid.  Incomplete transfers come back with endUs before
+ * startUs.
+ *
+ * @param data     Dump to decode
+ * @param length   Length of the dump in bytes
+ * @param entries  Filled with the decoded transfers, oldest first
+ * @param capacity Most entries to decode
+ */
+size_t ADXL345_traceDecode(const uint8_t *data, size_t length, ADXL345_TRACE_ENTRY *entries, size_t capacity) {
+    if (length < ADXL345_TRACE_HEADER_SIZE || ADXL345_GetLe(&data[0], 4) != ADXL345_TRACE_MAGIC ||
+        data[4] != ADXL345_TRACE_VERSION || data[5] != ADXL345_TRACE_RECORD_SIZE) {
+        return 0;
+    }
+
+    size_t count = ADXL345_GetLe(&data[8], 4);
+    size_t available = (length - ADXL345_TRACE_HEADER_SIZE) / ADXL345_TRACE_RECORD_SIZE;
+    if (count > available) {
+        count = available;
+    }
+    if (count > capacity) {
+        count = capacity;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *record = &data[ADXL345_TRACE_HEADER_SIZE + i * ADXL345_TRACE_RECORD_SIZE];
+        ADXL345_TRACE_ENTRY *entry = &entries[i];
+        uint32_t durationUs = (uint32_t) ADXL345_GetLe(&record[8], 4);
+
+        entry->startUs = (int64_t) ADXL345_GetLe(&record[0], 8);
+        entry->endUs = (durationUs == ADXL345_TRACE_INCOMPLETE) ? entry->startUs - 1 : entry->startUs + durationUs;
+        entry->result = (int16_t) ADXL345_GetLe(&record[12], 2);
+        entry->address = record[14];
+        entry->op = record[15];
+        entry->flags = record[16];
+        entry->txLength = record[17];
+        entry->rxLength = record[18];
+        memcpy(entry->data, &record[19], ADXL345_TRACE_DATA_BYTES);
+    }
+    return count;
+}
+
+
+// 'Private' functions designed for internal use
+
+static esp_err_t ADXL345_TraceWrite(void *ctx, const uint8_t *data, size_t length) {
+    ADXL345_TRACE *trace = (ADXL345_TRACE *) ctx;
+    if (!atomic_load(&trace->enabled)) {
+        return trace->inner.ops->write(trace->inner.ctx, data, length);
+    }
+
+    uint32_t index = ADXL345_TraceBegin(trace, ADXL345_TRACE_WRITE, data, length, 0);
+    esp_err_t err = trace->inner.ops->write(trace->inner.ctx, data, length);
+    ADXL345_TraceEnd(trace, index, err, NULL);
+    return err;
+}
+
+static esp_err_t ADXL345_TraceWriteRead(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength) {
+    ADXL345_TRACE *trace = (ADXL345_TRACE *) ctx;
+    if (!atomic_load(&trace->enabled)) {
+        return trace->inner.ops->writeRead(trace->inner.ctx, tx, txLength, rx, rxLength);
+    }
+
+    uint32_t index = ADXL345_TraceBegin(trace, ADXL345_TRACE_READ, tx, txLength, rxLength);
+    esp_err_t err = trace->inner.ops->writeRead(trace->inner.ctx, tx, txLength, rx, rxLength);
+    ADXL345_TraceEnd(trace, index, err, rx);
+    return err;
+}
+
+/**
+ * Records the transfer as started and queues it with ADXL345_TraceDone as
+ * its completion, which finishes the record and calls the caller's.
+ */
+static esp_err_t ADXL345_TraceSubmit(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                     ADXL345_TRANSPORT_DONE done, void *arg) {
+    ADXL345_TRACE *trace = (ADXL345_TRACE *) ctx;
+    unsigned head = atomic_load(&trace->pendingHead);
+    if (!atomic_load(&trace->enabled) || head - atomic_load(&trace->pendingTail) == ADXL345_TRACE_PENDING) {
+        return trace->inner.ops->submitWriteRead(trace->inner.ctx, tx, txLength, rx, rxLength, done, arg);
+    }
+
+    ADXL345_TRACE_SLOT *slot = &trace->pending[head % ADXL345_TRACE_PENDING];
+    slot->index = ADXL345_TraceBegin(trace, ADXL345_TRACE_SUBMIT, tx, txLength, rxLength);
+    slot->rx = rx;
+    slot->done = done;
+    slot->arg = arg;
+    // Published before the submit, the completion may come before it returns
+    atomic_store(&trace->pendingHead, head + 1);
+
+    esp_err_t err = trace->inner.ops->submitWriteRead(trace->inner.ctx, tx, txLength, rx, rxLength,
+                                                      ADXL345_TraceDone, trace);
+    if (err != ESP_OK) {
+        atomic_store(&trace->pendingHead, head);
+        ADXL345_TraceEnd(trace, slot->index, err, NULL);
+    }
+    return err;
+}
+
+/**
+ * Completion of a traced queued transfer.  Runs in the I2C ISR on hardware.
+ */
+static bool ADXL345_TraceDone(esp_err_t result, void *arg) {
+    ADXL345_TRACE *trace = (ADXL345_TRACE *) arg;
+    unsigned tail = atomic_load(&trace->pendingTail);
+    ADXL345_TRACE_SLOT slot = trace->pending[tail % ADXL345_TRACE_PENDING];
+    atomic_store(&trace->pendingTail, tail + 1);
+
+    // The caller's buffer is only handed back once its own completion runs
+    ADXL345_TraceEnd(trace, slot.index, result, slot.rx);
+    return slot.done(result, slot.arg);
+}
+
+/**
+ * Records the recovery, and marks every traced transfer still queued as
+ * dropped, as the inner transport will never complete them.
+ */
+static esp_err_t ADXL345_TraceRecover(void *ctx) {
+    ADXL345_TRACE *trace = (ADXL345_TRACE *) ctx;
+    uint32_t index = ADXL345_TraceBegin(trace, ADXL345_TRACE_RECOVER, NULL, 0, 0);
+    esp_err_t err = trace->inner.ops->recover(trace->inner.ctx);
+    ADXL345_TraceEnd(trace, index, err, NULL);
+
+    unsigned head = atomic_load(&trace->pendingHead);
+    for (unsigned i = atomic_load(&trace->pendingTail); i != head; i++) {
+        trace->entries[trace->pending[i % ADXL345_TRACE_PENDING].index % trace->capacity].flags |= ADXL345_TRACE_DROPPED;
+    }
+    atomic_store(&trace->pendingTail, head);
+    return err;
+}
+
+/**
+ * Claims the next ring entry and records the start of a transfer in it.
+ * Returns the entry's sequence number.
+ */
+static uint32_t ADXL345_TraceBegin(ADXL345_TRACE *trace, ADXL345_TRACE_OP op, const uint8_t *tx, size_t txLength,
+                                   size_t rxLength) {
+    uint32_t index = atomic_fetch_add(&trace->head, 1);
+    ADXL345_TRACE_ENTRY *entry = &trace->entries[index % trace->capacity];
+    size_t copied = (txLength < ADXL345_TRACE_DATA_BYTES) ? txLength : ADXL345_TRACE_DATA_BYTES;
+
+    entry->startUs = esp_timer_get_time();
+    entry->endUs = entry->startUs - 1;
+    entry->result = ESP_OK;
+    entry->address = trace->address;
+    entry->op = op;
+    entry->flags = (txLength + rxLength > ADXL345_TRACE_DATA_BYTES) ? ADXL345_TRACE_TRUNCATED : 0;
+    entry->txLength = (uint8_t) txLength;
+    entry->rxLength = (uint8_t) rxLength;
+    memset(entry->data, 0, ADXL345_TRACE_DATA_BYTES);
+    if (copied > 0) {
+        memcpy(entry->data, tx, copied);
+    }
+    return index;
+}
+
+/**
+ * Records the end of a transfer, with the bytes read if it succeeded.
+ */
+static void ADXL345_TraceEnd(ADXL345_TRACE *trace, uint32_t index, esp_err_t result, const uint8_t *rx) {
+    ADXL345_TRACE_ENTRY *entry = &trace->entries[index % trace->capacity];
+
+    if (rx != NULL && result == ESP_OK && entry->txLength < ADXL345_TRACE_DATA_BYTES) {
+        size_t room = ADXL345_TRACE_DATA_BYTES - entry->txLength;
+        memcpy(&entry->data[entry->txLength], rx, (entry->rxLength < room) ? entry->rxLength : room);
+    }
+    entry->result = result;
+    entry->endUs = esp_timer_get_time();
+}
+
+static void ADXL345_PutLe(uint8_t *out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+static uint64_t ADXL345_GetLe(const uint8_t *in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t) in[i] << (8 * i);
+    }
+    return value;
+}
@@ -0,0 +1,114 @@
+/**
+ * File:       ADXL345_trace.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "ADXL345_transport.h"
+
+/**
+ * Binary trace dump format, all fields little endian.  A header:
+ *
+ *   offset  size  field
+ *   0       4     magic (ADXL345_TRACE_MAGIC)
+ *   4       1     format version
+ *   5       1     record size (ADXL345_TRACE_RECORD_SIZE)
+ *   6       2     reserved, zero
+ *   8       4     record count
+ *   12      4     transactions overwritten before the oldest record
+ *
+ * followed by one record per transaction, oldest first:
+ *
+ *   0       8     start timestamp, microseconds
+ *   8       4     duration, microseconds, 0xFFFFFFFF if it never completed
+ *   12      2     result (esp_err_t)
+ *   14      1     7 bit device address
+ *   15      1     ADXL345_TRACE_OP
+ *   16      1     ADXL345_TRACE_* flags
+ *   17      1     bytes written, register address included
+ *   18      1     bytes read
+ *   19      16    bytes written then bytes read, truncated to fit
+ */
+
+// Queued transfers one traced transport can have in flight
+#define ADXL345_TRACE_PENDING       40
+#define ADXL345_TRACE_DATA_BYTES    16
+
+typedef enum _adxl345TraceOp {
+    ADXL345_TRACE_WRITE = 0,
+    ADXL345_TRACE_READ,
+    ADXL345_TRACE_SUBMIT,
+    ADXL345_TRACE_RECOVER
+} ADXL345_TRACE_OP;
+
+typedef struct _adxl345TraceEntry {
+    int64_t startUs;
+    int64_t endUs;
+    esp_err_t result;
+    uint8_t address;
+    uint8_t op;
+    uint8_t flags;
+    uint8_t txLength;
+    uint8_t rxLength;
+    uint8_t data[ADXL345_TRACE_DATA_BYTES];
+} ADXL345_TRACE_ENTRY;
+
+typedef struct _adxl345TraceSlot {
+    uint32_t index;
+    uint8_t *rx;
+    ADXL345_TRANSPORT_DONE done;
+    void *arg;
+} ADXL345_TRACE_SLOT;
+
+typedef struct _adxl345Trace {
+    ADXL345_TRACE_ENTRY *entries;
+    uint32_t capacity;
+    // Total transactions recorded, the ring index is this modulo capacity
+    atomic_uint head;
+    atomic_bool enabled;
+    uint8_t address;
+    ADXL345_TRANSPORT inner;
+    // Mirrors which ops the inner transport has
+    ADXL345_TRANSPORT_OPS ops;
+    // Completions arrive in submission order, as for the I2C backend
+    ADXL345_TRACE_SLOT pending[ADXL345_TRACE_PENDING];
+    atomic_uint pendingHead;
+    atomic_uint pendingTail;
+} ADXL345_TRACE;
+
+// Receives the dump a piece at a time
+typedef esp_err_t (*ADXL345_TRACE_WRITER)(const uint8_t *data, size_t length, void *arg);
+
+
+// Public methods designed for the user to call
+void ADXL345_traceInit(ADXL345_TRACE *trace, ADXL345_TRACE_ENTRY *entries, uint32_t capacity, uint8_t address);
+
+void ADXL345_traceTransport(ADXL345_TRANSPORT *transport, ADXL345_TRACE *trace, const ADXL345_TRANSPORT *inner);
+
+void ADXL345_traceSetEnabled(ADXL345_TRACE *trace, bool enabled);
+
+void ADXL345_traceClear(ADXL345_TRACE *trace);
+
+esp_err_t ADXL345_traceDump(ADXL345_TRACE *trace, ADXL345_TRACE_WRITER writer, void *arg);
+
+size_t ADXL345_traceDecode(const uint8_t *data, size_t length, ADXL345_TRACE_ENTRY *entries, size_t capacity);
+
+// Constants for calculations
+#define ADXL345_TRACE_MAGIC         0x52545841
+#define ADXL345_TRACE_VERSION       1
+#define ADXL345_TRACE_HEADER_SIZE   16
+#define ADXL345_TRACE_RECORD_SIZE   (19 + ADXL345_TRACE_DATA_BYTES)
+#define ADXL345_TRACE_INCOMPLETE    0xFFFFFFFF
+
+// Bitmasks for the flags field
+#define ADXL345_TRACE_DROPPED       0x01
+#define ADXL345_TRACE_TRUNCATED     0x02
@@ -0,0 +1,44 @@
+/**
+ * File:       ADXL345_transport.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/**
+ * Register access backend for an ADXL345_DEVICE.  The driver only ever
+ * writes a register address followed by data, or writes a register address
+ * and reads back, so that is all a backend has to provide.  Every call must
+ * return within a bounded time, failing with ESP_ERR_TIMEOUT if the bus
+ * doesn't respond.
+ *
+ * Completion callback for queued transfers.  May be called from an ISR, so
+ * use the FromISR FreeRTOS calls, and return true if a higher priority task
+ * was woken.
+ */
+typedef bool (*ADXL345_TRANSPORT_DONE)(esp_err_t result, void *arg);
+
+typedef struct _adxl345TransportOps {
+    esp_err_t (*write)(void *ctx, const uint8_t *data, size_t length);
+    esp_err_t (*writeRead)(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength);
+    // Queues a write/read and returns straight away.  NULL for backends that
+    // are synchronous only.  The buffers must stay valid until done is called.
+    esp_err_t (*submitWriteRead)(void *ctx, const uint8_t *tx, size_t txLength, uint8_t *rx, size_t rxLength,
+                                 ADXL345_TRANSPORT_DONE done, void *arg);
+    // Frees a wedged bus and drops any transfers still queued, whose
+    // completions must then never be delivered.  NULL if the backend can't.
+    esp_err_t (*recover)(void *ctx);
+} ADXL345_TRANSPORT_OPS;
+
+typedef struct _adxl345Transport {
+    const ADXL345_TRANSPORT_OPS *ops;
+    void *ctx;
+} ADXL345_TRANSPORT;
@@ -0,0 +1,257 @@
+/**
+ * File:       Fusion_replay_benchmark.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Replays a recorded (or synthesized) dataset through the Madgwick filter,
+ * timing every update and comparing the estimated attitude to ground truth.
+ * Samples are generated or parsed a chunk at a time, and only the filter
+ * updates are timed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "esp_timer.h"
+#include "Fusion.h"
+
+#define CHUNK_SAMPLES       256
+#define SYNTH_RATE_HZ       1000
+#define SYNTH_SECONDS       60
+#define SETTLE_SECONDS      5
+#define REQUIRED_RATE_HZ    1000
+#define MAX_RMS_ERROR_DEG   2.0
+
+typedef struct _sample {
+    FUSION_INPUT input;
+    FUSION_QUATERNION truth;
+} SAMPLE;
+
+typedef struct _synth {
+    double q[4];
+    double t;
+    uint32_t seed;
+} SYNTH;
+
+static SAMPLE chunk[CHUNK_SAMPLES];
+
+// Function predefinition
+int fill_from_file(FILE *file, SAMPLE *samples, int max);
+int fill_synthetic(SYNTH *synth, SAMPLE *samples, int max);
+double noise(SYNTH *synth, double sigma);
+double error_degrees(const FUSION_QUATERNION *a, const FUSION_QUATERNION *b);
+
+/**
+ * Main function
+ */
+void app_main(void) {
+    const char *path = getenv("FUSION_DATASET");
+    FILE *file = (path != NULL) ? fopen(path, "r") : NULL;
+    if (path != NULL && file == NULL) {
+        printf("Couldn't open %s, using synthetic data\n", path);
+    }
+
+    SYNTH synth = { { 1.0, 0.0, 0.0, 0.0 }, 0.0, 12345 };
+    FUSION_MADGWICK filter;
+    FUSION_madgwickInit(&filter, FUSION_DEFAULT_BETA);
+
+    int64_t firstUs = -1;
+    int64_t lastUs = 0;
+    int64_t busyUs = 0;
+    uint32_t updates = 0;
+    uint32_t scored = 0;
+    double sumSquares = 0.0;
+    double maxError = 0.0;
+
+    while (1) {
+        int count = (file != NULL) ? fill_from_file(file, chunk, CHUNK_SAMPLES)
+                                   : fill_synthetic(&synth, chunk, CHUNK_SAMPLES);
+        if (count == 0) {
+            break;
+        }
+        if (firstUs < 0) {
+            firstUs = chunk[0].input.timestampUs;
+            lastUs = firstUs;
+        }
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < count; i++) {
+            float dt = (float) (chunk[i].input.timestampUs - lastUs) * 1e-6f;
+            lastUs = chunk[i].input.timestampUs;
+            if (dt > 0.0f && dt <= FUSION_MAX_DT) {
+                FUSION_madgwickUpdate(&filter, &chunk[i].input, dt);
+                // Copied out so that the error is measured per update, not per chunk
+                chunk[i].input.gyro[0] = filter.q.w;
+                chunk[i].input.gyro[1] = filter.q.x;
+                chunk[i].input.gyro[2] = filter.q.y;
+                chunk[i].input.accel[0] = filter.q.z;
+            } else {
+                chunk[i].input.gyro[0] = NAN;
+            }
+        }
+        busyUs += esp_timer_get_time() - start;
+
+        for (int i = 0; i < count; i++) {
+            if (isnan(chunk[i].input.gyro[0])) {
+                continue;
+            }
+            updates++;
+            if (chunk[i].input.timestampUs - firstUs < SETTLE_SECONDS * 1000000ll) {
+                continue;
+            }
+            FUSION_QUATERNION estimate = {
+                chunk[i].input.gyro[0], chunk[i].input.gyro[1], chunk[i].input.gyro[2], chunk[i].input.accel[0]
+            };
+            double error = error_degrees(&estimate, &chunk[i].truth);
+            sumSquares += error * error;
+            if (error > maxError) {
+                maxError = error;
+            }
+            scored++;
+        }
+    }
+
+    if (file != NULL) {
+        fclose(file);
+    }
+    if (updates == 0 || busyUs == 0) {
+        printf("No samples to replay\n");
+        return;
+    }
+
+    double nsPerUpdate = (double) busyUs * 1000.0 / updates;
+    double rateHz = 1e9 / nsPerUpdate;
+    double rmsError = (scored > 0) ? sqrt(sumSquares / scored) : 0.0;
+
+    printf("Updates:        %lu\n", (unsigned long) updates);
+    printf("Update cost:    %.0f ns (%.0f updates/s)\n", nsPerUpdate, rateHz);
+    printf("Attitude error: %.3f deg RMS, %.3f deg max (after %d s)\n", rmsError, maxError, SETTLE_SECONDS);
+    printf("%s\n", (rateHz >= REQUIRED_RATE_HZ && rmsError < MAX_RMS_ERROR_DEG) ? "PASS" : "FAIL");
+}
+
+/**
+ * Parses up to the param number of CSV rows from the param dataset file.
+ *
+ * @param file    Dataset to read
+ * @param samples Array to fill
+ * @param max     Size of the array
+ * @return Number of samples read, 0 at the end of the file
+ */
+int fill_from_file(FILE *file, SAMPLE *samples, int max) {
+    int count = 0;
+    char line[256];
+
+    while (count < max && fgets(line, sizeof(line), file) != NULL) {
+        SAMPLE *s = &samples[count];
+        long long timestampUs;
+        int fields = sscanf(line, "%lld,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &timestampUs,
+                            &s->input.gyro[0], &s->input.gyro[1], &s->input.gyro[2],
+                            &s->input.accel[0], &s->input.accel[1], &s->input.accel[2],
+                            &s->input.mag[0], &s->input.mag[1], &s->input.mag[2],
+                            &s->truth.w, &s->truth.x, &s->truth.y, &s->truth.z);
+        if (fields != 14) {
+            continue;
+        }
+        s->input.timestampUs = timestampUs;
+        s->input.magValid = !(s->input.mag[0] == 0.0f && s->input.mag[1] == 0.0f && s->input.mag[2] == 0.0f);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * Generates the next samples of the synthetic tumble.  The true attitude is
+ * integrated in double precision, and the sensor readings are the earth
+ * frame gravity and field rotated into the sensor frame, plus noise.
+ *
+ * @param synth   SYNTH state
+ * @param samples Array to fill
+ * @param max     Size of the array
+ * @return Number of samples generated, 0 once SYNTH_SECONDS have been produced
+ */
+int fill_synthetic(SYNTH *synth, SAMPLE *samples, int max) {
+    const double dt = 1.0 / SYNTH_RATE_HZ;
+    // Field pointing north and down at 60 degrees of inclination
+    const double field[3] = { 0.5, 0.0, -0.866 };
+    const double gyroBias[3] = { 0.004, -0.003, 0.002 };
+    int count = 0;
+
+    while (count < max && synth->t < SYNTH_SECONDS) {
+        double t = synth->t;
+        double w[3] = { 1.5 * sin(0.7 * t), 1.0 * sin(0.45 * t + 1.0), 0.8 * sin(0.3 * t + 2.0) };
+
+        // qDot = 0.5 * q (x) (0, w)
+        double *q = synth->q;
+        double dq[4] = {
+            0.5 * (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]),
+            0.5 * (q[0] * w[0] + q[2] * w[2] - q[3] * w[1]),
+            0.5 * (q[0] * w[1] - q[1] * w[2] + q[3] * w[0]),
+            0.5 * (q[0] * w[2] + q[1] * w[1] - q[2] * w[0]),
+        };
+        double norm = 0.0;
+        for (int i = 0; i < 4; i++) {
+            q[i] += dq[i] * dt;
+            norm += q[i] * q[i];
+        }
+        norm = sqrt(norm);
+        for (int i = 0; i < 4; i++) {
+            q[i] /= norm;
+        }
+
+        // Rows of R^T, rotating earth frame vectors into the sensor frame
+        double r[3][3] = {
+            { 1 - 2 * (q[2] * q[2] + q[3] * q[3]), 2 * (q[1] * q[2] + q[0] * q[3]), 2 * (q[1] * q[3] - q[0] * q[2]) },
+            { 2 * (q[1] * q[2] - q[0] * q[3]), 1 - 2 * (q[1] * q[1] + q[3] * q[3]), 2 * (q[2] * q[3] + q[0] * q[1]) },
+            { 2 * (q[1] * q[3] + q[0] * q[2]), 2 * (q[2] * q[3] - q[0] * q[1]), 1 - 2 * (q[1] * q[1] + q[2] * q[2]) },
+        };
+
+        SAMPLE *s = &samples[count++];
+        s->input.timestampUs = (int64_t) llround(t * 1e6);
+        s->input.magValid = true;
+        for (int i = 0; i < 3; i++) {
+            s->input.gyro[i] = (float) (w[i] + gyroBias[i] + noise(synth, 0.01));
+            s->input.accel[i] = (float) (r[i][2] + noise(synth, 0.02));
+            s->input.mag[i] = (float) (r[i][0] * field[0] + r[i][2] * field[2] + noise(synth, 0.02));
+        }
+        s->truth = (FUSION_QUATERNION) { (float) q[0], (float) q[1], (float) q[2], (float) q[3] };
+
+        synth->t += dt;
+    }
+    return count;
+}
+
+/**
+ * Returns approximately normally distributed noise, as the sum of four
+ * uniform values from a small xorshift generator.
+ *
+ * @param synth SYNTH holding the generator state
+ * @param sigma Standard deviation of the noise
+ */
+double noise(SYNTH *synth, double sigma) {
+    double sum = 0.0;
+    for (int i = 0; i < 4; i++) {
+        synth->seed ^= synth->seed << 13;
+        synth->seed ^= synth->seed >> 17;
+        synth->seed ^= synth->seed << 5;
+        sum += (double) synth->seed / 4294967296.0 - 0.5;
+    }
+    // Four uniforms on [-0.5, 0.5) have a variance of 1/3
+    return sum * sigma * 1.7320508;
+}
+
+/**
+ * Returns the angle of the rotation between two attitudes, in degrees.
+ *
+ * @param a First FUSION_QUATERNION
+ * @param b Second FUSION_QUATERNION
+ */
+double error_degrees(const FUSION_QUATERNION *a, const FUSION_QUATERNION *b) {
+    double dot = fabs((double) a->w * b->w + (double) a->x * b->x + (double) a->y * b->y + (double) a->z * b->z);
+    if (dot > 1.0) {
+        dot = 1.0;
+    }
+    return 2.0 * acos(dot) * 180.0 / M_PI;
+}
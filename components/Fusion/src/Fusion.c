@@ -0,0 +1,404 @@
+/**
+ * File:       Fusion.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Attitude estimation from accelerometer, gyro and (optionally) magnetometer
+ * readings, using Madgwick's gradient descent orientation filter.
+ *
+ * Unlike the integer paths elsewhere this is single precision float.  The
+ * ESP32 has a hardware single precision FPU, and a Q format version of the
+ * filter would need 64 bit intermediates throughout to keep the quaternion
+ * normalized, which costs more than the FPU does.  Everything here is kept
+ * to float (no double promotion, f suffixed constants and math calls).  The
+ * replay benchmark under examples measures the update cost and accuracy.
+ *
+ * The fusion task is fed through a lock free single producer, single
+ * consumer queue of inputs, and publishes the latest attitude through a
+ * sequence lock, so the sample pipeline never waits on fusion and readers
+ * never wait on either.
+ */
+#include <math.h>
+#include <string.h>
+#include "Fusion.h"
+
+#define FUSION_STACK_SIZE   3072
+
+// 'Private' helpers designed for internal use
+static void FUSION_Task(void *arg);
+static void FUSION_UpdateImu(FUSION_MADGWICK *filter, const FUSION_INPUT *input, float dt);
+static float FUSION_InvSqrt(float value);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Resets the param filter to the identity attitude.
+ *
+ * @param filter FUSION_MADGWICK to initialise
+ * @param beta   Filter gain, FUSION_DEFAULT_BETA is a reasonable start
+ */
+void FUSION_madgwickInit(FUSION_MADGWICK *filter, float beta) {
+    filter->q = (FUSION_QUATERNION) { 1.0f, 0.0f, 0.0f, 0.0f };
+    filter->beta = beta;
+}
+
+/**
+ * Advances the filter by one set of readings.  Falls back to the six axis
+ * update (no heading correction) if the magnetometer reading is missing.
+ *
+ * @param filter FUSION_MADGWICK to update
+ * @param input  FUSION_INPUT readings
+ * @param dt     Time since the previous update, in seconds
+ */
+void FUSION_madgwickUpdate(FUSION_MADGWICK *filter, const FUSION_INPUT *input, float dt) {
+    float mx = input->mag[0];
+    float my = input->mag[1];
+    float mz = input->mag[2];
+    if (!input->magValid || (mx == 0.0f && my == 0.0f && mz == 0.0f)) {
+        FUSION_UpdateImu(filter, input, dt);
+        return;
+    }
+
+    float q0 = filter->q.w;
+    float q1 = filter->q.x;
+    float q2 = filter->q.y;
+    float q3 = filter->q.z;
+    float gx = input->gyro[0];
+    float gy = input->gyro[1];
+    float gz = input->gyro[2];
+    float ax = input->accel[0];
+    float ay = input->accel[1];
+    float az = input->accel[2];
+
+    // Rate of change of quaternion from the gyro
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f)) {
+        float recipNorm = FUSION_InvSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        recipNorm = FUSION_InvSqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        // Auxiliary variables to avoid repeated arithmetic
+        float _2q0mx = 2.0f * q0 * mx;
+        float _2q0my = 2.0f * q0 * my;
+        float _2q0mz = 2.0f * q0 * mz;
+        float _2q1mx = 2.0f * q1 * mx;
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _2q0q2 = 2.0f * q0 * q2;
+        float _2q2q3 = 2.0f * q2 * q3;
+        float q0q0 = q0 * q0;
+        float q0q1 = q0 * q1;
+        float q0q2 = q0 * q2;
+        float q0q3 = q0 * q3;
+        float q1q1 = q1 * q1;
+        float q1q2 = q1 * q2;
+        float q1q3 = q1 * q3;
+        float q2q2 = q2 * q2;
+        float q2q3 = q2 * q3;
+        float q3q3 = q3 * q3;
+
+        // Reference direction of the earth's magnetic field
+        float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 -
+                   mx * q2q2 - mx * q3q3;
+        float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 -
+                   my * q3q3;
+        float _2bx = sqrtf(hx * hx + hy * hy);
+        float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 -
+                     mz * q2q2 + mz * q3q3;
+        float _4bx = 2.0f * _2bx;
+        float _4bz = 2.0f * _2bz;
+
+        // Objective function errors, shared by all four gradient terms
+        float fax = 2.0f * q1q3 - _2q0q2 - ax;
+        float fay = 2.0f * q0q1 + _2q2q3 - ay;
+        float faz = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+        float fmx = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+        float fmy = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+        float fmz = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+        // Gradient descent corrective step
+        float s0 = -_2q2 * fax + _2q1 * fay - _2bz * q2 * fmx + (-_2bx * q3 + _2bz * q1) * fmy + _2bx * q2 * fmz;
+        float s1 = _2q3 * fax + _2q0 * fay - 4.0f * q1 * faz + _2bz * q3 * fmx + (_2bx * q2 + _2bz * q0) * fmy +
+                   (_2bx * q3 - _4bz * q1) * fmz;
+        float s2 = -_2q0 * fax + _2q3 * fay - 4.0f * q2 * faz + (-_4bx * q2 - _2bz * q0) * fmx +
+                   (_2bx * q1 + _2bz * q3) * fmy + (_2bx * q0 - _4bz * q2) * fmz;
+        float s3 = _2q1 * fax + _2q2 * fay + (-_4bx * q3 + _2bz * q1) * fmx + (-_2bx * q0 + _2bz * q2) * fmy +
+                   _2bx * q1 * fmz;
+
+        // A zero step means the estimate already agrees with the reference, and has no direction to normalize
+        float stepSquared = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (stepSquared > 0.0f) {
+            recipNorm = FUSION_InvSqrt(stepSquared);
+            qDot1 -= filter->beta * s0 * recipNorm;
+            qDot2 -= filter->beta * s1 * recipNorm;
+            qDot3 -= filter->beta * s2 * recipNorm;
+            qDot4 -= filter->beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = FUSION_InvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    filter->q = (FUSION_QUATERNION) { q0 * recipNorm, q1 * recipNorm, q2 * recipNorm, q3 * recipNorm };
+}
+
+/**
+ * Converts an attitude quaternion to roll, pitch and yaw in hundredths of a
+ * degree, matching the units of ADXL345_ORIENTATION.
+ *
+ * @param q     FUSION_QUATERNION to convert
+ * @param roll  Pointer to store the roll in, rotation about X
+ * @param pitch Pointer to store the pitch in, rotation about Y
+ * @param yaw   Pointer to store the yaw in, rotation about Z, 0 to 35999
+ */
+void FUSION_toEulerCentideg(const FUSION_QUATERNION *q, int32_t *roll, int32_t *pitch, int32_t *yaw) {
+    const float toCentideg = 18000.0f / (float) M_PI;
+
+    float sinPitch = 2.0f * (q->w * q->y - q->z * q->x);
+    if (sinPitch > 1.0f) {
+        sinPitch = 1.0f;
+    } else if (sinPitch < -1.0f) {
+        sinPitch = -1.0f;
+    }
+
+    float r = atan2f(2.0f * (q->w * q->x + q->y * q->z), 1.0f - 2.0f * (q->x * q->x + q->y * q->y));
+    float p = asinf(sinPitch);
+    float y = atan2f(2.0f * (q->w * q->z + q->x * q->y), 1.0f - 2.0f * (q->y * q->y + q->z * q->z));
+
+    *roll = (int32_t) lrintf(r * toCentideg);
+    *pitch = (int32_t) lrintf(p * toCentideg);
+    int32_t heading = (int32_t) lrintf(y * toCentideg);
+    *yaw = (heading < 0) ? heading + 36000 : heading;
+}
+
+/**
+ * Publishes a new attitude.  Only one task may write a given snapshot.
+ *
+ * @param snapshot FUSION_SNAPSHOT to write
+ * @param attitude FUSION_ATTITUDE to publish
+ */
+void FUSION_snapshotWrite(FUSION_SNAPSHOT *snapshot, const FUSION_ATTITUDE *attitude) {
+    unsigned sequence = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+
+    // Odd while the copy is being written
+    atomic_store_explicit(&snapshot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    snapshot->attitude = *attitude;
+    atomic_store_explicit(&snapshot->sequence, sequence + 2, memory_order_release);
+}
+
+/**
+ * Reads the latest attitude, retrying if it was being written at the time.
+ *
+ * @param snapshot FUSION_SNAPSHOT to read
+ * @param attitude FUSION_ATTITUDE to copy into
+ */
+void FUSION_snapshotRead(FUSION_SNAPSHOT *snapshot, FUSION_ATTITUDE *attitude) {
+    unsigned before;
+    unsigned after;
+
+    do {
+        before = atomic_load_explicit(&snapshot->sequence, memory_order_acquire);
+        *attitude = snapshot->attitude;
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+    } while ((before & 1) != 0 || before != after);
+}
+
+/**
+ * Starts the fusion task.
+ *
+ * @param fusion   FUSION to start
+ * @param beta     Filter gain, see FUSION_madgwickInit
+ * @param priority FreeRTOS priority of the fusion task
+ * @param core     Core to pin the fusion task to, or tskNO_AFFINITY
+ */
+esp_err_t FUSION_start(FUSION *fusion, float beta, UBaseType_t priority, BaseType_t core) {
+    memset(fusion, 0, sizeof(*fusion));
+    FUSION_madgwickInit(&fusion->filter, beta);
+    atomic_init(&fusion->head, 0);
+    atomic_init(&fusion->tail, 0);
+    atomic_init(&fusion->snapshot.sequence, 0);
+    fusion->snapshot.attitude.q = fusion->filter.q;
+
+    if (xTaskCreatePinnedToCore(FUSION_Task, "fusion", FUSION_STACK_SIZE, fusion, priority, &fusion->task,
+                                core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Queues a set of readings for the fusion task.  Never blocks, and must only
+ * be called from one task.
+ *
+ * @param fusion FUSION to feed
+ * @param input  FUSION_INPUT to queue, copied
+ * @return false if the queue was full and the input was dropped
+ */
+bool FUSION_push(FUSION *fusion, const FUSION_INPUT *input) {
+    unsigned head = atomic_load_explicit(&fusion->head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&fusion->tail, memory_order_acquire) >= FUSION_QUEUE_SIZE) {
+        fusion->dropped++;
+        return false;
+    }
+
+    fusion->inputs[head & (FUSION_QUEUE_SIZE - 1)] = *input;
+    atomic_store_explicit(&fusion->head, head + 1, memory_order_release);
+    xTaskNotifyGive(fusion->task);
+    return true;
+}
+
+/**
+ * Reads the latest attitude from any task or core.
+ *
+ * @param fusion   FUSION to read
+ * @param attitude FUSION_ATTITUDE to copy into
+ */
+void FUSION_getAttitude(FUSION *fusion, FUSION_ATTITUDE *attitude) {
+    FUSION_snapshotRead(&fusion->snapshot, attitude);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Fusion task.  Runs every queued input through the filter, then publishes
+ * the resulting attitude.
+ *
+ * @param arg FUSION to run
+ */
+static void FUSION_Task(void *arg) {
+    FUSION *fusion = (FUSION *) arg;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        unsigned tail = atomic_load_explicit(&fusion->tail, memory_order_relaxed);
+        unsigned head = atomic_load_explicit(&fusion->head, memory_order_acquire);
+        if (tail == head) {
+            continue;
+        }
+
+        int64_t timestampUs = 0;
+        while (tail != head) {
+            const FUSION_INPUT *input = &fusion->inputs[tail & (FUSION_QUEUE_SIZE - 1)];
+            timestampUs = input->timestampUs;
+
+            float dt = (float) (timestampUs - fusion->lastTimestampUs) * 1e-6f;
+            if (fusion->lastTimestampUs != 0 && dt > 0.0f && dt <= FUSION_MAX_DT) {
+                FUSION_madgwickUpdate(&fusion->filter, input, dt);
+                fusion->updates++;
+            }
+            fusion->lastTimestampUs = timestampUs;
+
+            tail++;
+            atomic_store_explicit(&fusion->tail, tail, memory_order_release);
+        }
+
+        FUSION_ATTITUDE attitude = {
+            .q = fusion->filter.q,
+            .timestampUs = timestampUs,
+            .updates = fusion->updates,
+        };
+        FUSION_snapshotWrite(&fusion->snapshot, &attitude);
+    }
+}
+
+/**
+ * Six axis update, used when there is no magnetometer reading.  Heading is
+ * left to the gyro alone.
+ */
+static void FUSION_UpdateImu(FUSION_MADGWICK *filter, const FUSION_INPUT *input, float dt) {
+    float q0 = filter->q.w;
+    float q1 = filter->q.x;
+    float q2 = filter->q.y;
+    float q3 = filter->q.z;
+    float gx = input->gyro[0];
+    float gy = input->gyro[1];
+    float gz = input->gyro[2];
+    float ax = input->accel[0];
+    float ay = input->accel[1];
+    float az = input->accel[2];
+
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (!(ax == 0.0f && ay == 0.0f && az == 0.0f)) {
+        float recipNorm = FUSION_InvSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0;
+        float _4q1 = 4.0f * q1;
+        float _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1;
+        float _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0;
+        float q1q1 = q1 * q1;
+        float q2q2 = q2 * q2;
+        float q3q3 = q3 * q3;
+
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 +
+                   _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 +
+                   _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        // A zero step means the estimate already agrees with the reference, and has no direction to normalize
+        float stepSquared = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (stepSquared > 0.0f) {
+            recipNorm = FUSION_InvSqrt(stepSquared);
+            qDot1 -= filter->beta * s0 * recipNorm;
+            qDot2 -= filter->beta * s1 * recipNorm;
+            qDot3 -= filter->beta * s2 * recipNorm;
+            qDot4 -= filter->beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = FUSION_InvSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    filter->q = (FUSION_QUATERNION) { q0 * recipNorm, q1 * recipNorm, q2 * recipNorm, q3 * recipNorm };
+}
+
+/**
+ * Reciprocal square root.
+ * NOTE: Deliberately not the bit trick approximation, a divide and a square
+ *       root are exact and cheap enough on the FPU.
+ *
+ * @param value Value to take the reciprocal square root of, > 0
+ */
+static float FUSION_InvSqrt(float value) {
+    return 1.0f / sqrtf(value);
+}
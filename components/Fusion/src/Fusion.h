@@ -0,0 +1,92 @@
+/**
+ * File:       Fusion.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Number of queued inputs between the sample pipeline and the fusion task,
+// must be a power of two
+#define FUSION_QUEUE_SIZE       16
+
+typedef struct _fusionQuaternion {
+    float w;
+    float x;
+    float y;
+    float z;
+} FUSION_QUATERNION;
+
+// One synchronized set of readings.  Accelerometer and magnetometer units
+// don't matter, as both are normalized, but the gyro must be in rad/s.
+typedef struct _fusionInput {
+    int64_t timestampUs;
+    float gyro[3];
+    float accel[3];
+    float mag[3];
+    bool magValid;
+} FUSION_INPUT;
+
+typedef struct _fusionMadgwick {
+    FUSION_QUATERNION q;
+    // Gradient descent gain, higher trusts the accelerometer and magnetometer more
+    float beta;
+} FUSION_MADGWICK;
+
+typedef struct _fusionAttitude {
+    FUSION_QUATERNION q;
+    int64_t timestampUs;
+    uint32_t updates;
+} FUSION_ATTITUDE;
+
+// Sequence locked copy of the latest attitude.  One writer, any number of
+// readers, and neither side ever blocks the other.
+typedef struct _fusionSnapshot {
+    atomic_uint sequence;
+    FUSION_ATTITUDE attitude;
+} FUSION_SNAPSHOT;
+
+typedef struct _fusion {
+    FUSION_MADGWICK filter;
+    FUSION_INPUT inputs[FUSION_QUEUE_SIZE];
+    atomic_uint head;
+    atomic_uint tail;
+    uint32_t dropped;
+    uint32_t updates;
+    int64_t lastTimestampUs;
+    TaskHandle_t task;
+    FUSION_SNAPSHOT snapshot;
+} FUSION;
+
+
+// Public methods designed for the user to call
+void FUSION_madgwickInit(FUSION_MADGWICK *filter, float beta);
+
+void FUSION_madgwickUpdate(FUSION_MADGWICK *filter, const FUSION_INPUT *input, float dt);
+
+void FUSION_toEulerCentideg(const FUSION_QUATERNION *q, int32_t *roll, int32_t *pitch, int32_t *yaw);
+
+void FUSION_snapshotWrite(FUSION_SNAPSHOT *snapshot, const FUSION_ATTITUDE *attitude);
+
+void FUSION_snapshotRead(FUSION_SNAPSHOT *snapshot, FUSION_ATTITUDE *attitude);
+
+esp_err_t FUSION_start(FUSION *fusion, float beta, UBaseType_t priority, BaseType_t core);
+
+bool FUSION_push(FUSION *fusion, const FUSION_INPUT *input);
+
+void FUSION_getAttitude(FUSION *fusion, FUSION_ATTITUDE *attitude);
+
+// Constants for calculations
+#define FUSION_DEFAULT_BETA     0.1f
+// Longest gap between inputs that is integrated, anything longer is treated
+// as a restart rather than one huge gyro step
+#define FUSION_MAX_DT           0.1f
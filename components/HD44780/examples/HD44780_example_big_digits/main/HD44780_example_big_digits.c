@@ -0,0 +1,64 @@
+/**
+ * File:       HD44780_example_big_digits.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Example for a 4x20 HD44780 display that shows the time since boot as three
+ * row tall numerals, with a small readout underneath of how many characters
+ * were sent to the display against redrawing the numerals every second.
+ */
+#include <stdio.h>
+#include "HD44780.h"
+#include "HD44780_bigdigits.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define ONE_SECOND_DELAY (1000 / portTICK_PERIOD_MS)
+
+// Function predefinitions
+void showElapsed(HD44780_BIG_TEXT *text, uint32_t seconds);
+
+/**
+ * Application main
+ */
+void app_main(void) {
+    HD44780_FOUR_BIT_BUS bus = { 4, 20, 18, 19, 21, 22, 16, 17 };
+    HD44780_initFourBitBus(&bus);
+    HD44780_clear();
+    HD44780_bigLoadGlyphs();
+
+    // "MM:SS" is 17 columns wide plus its trailing gap, centred on the top three rows
+    HD44780_BIG_TEXT elapsed;
+    HD44780_bigInit(&elapsed, 1, 0, HD44780_BIG_THREE_ROW);
+
+    uint32_t seconds = 0;
+    TickType_t wake = xTaskGetTickCount();
+    while (true) {
+        showElapsed(&elapsed, seconds++);
+        vTaskDelayUntil(&wake, ONE_SECOND_DELAY);
+    }
+}
+
+/**
+ * Shows the param number of seconds as minutes and seconds, and how many
+ * characters have been sent so far on the bottom row.
+ *
+ * @param text    HD44780_BIG_TEXT to draw the time in
+ * @param seconds Seconds since boot
+ */
+void showElapsed(HD44780_BIG_TEXT *text, uint32_t seconds) {
+    char value[HD44780_BIG_MAX_CHARS + 1];
+    snprintf(value, sizeof(value), "%02lu:%02lu", (unsigned long) ((seconds / 60) % 100),
+             (unsigned long) (seconds % 60));
+    HD44780_bigPrint(text, value);
+
+    char status[21];
+    snprintf(status, sizeof(status), "Sent %lu of %lu     ", (unsigned long) text->cellsWritten,
+             (unsigned long) text->fullRedrawCells);
+    HD44780_setCursorPos(0, 3);
+    HD44780_print(status);
+}
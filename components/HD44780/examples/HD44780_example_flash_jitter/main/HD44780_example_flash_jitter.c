@@ -0,0 +1,179 @@
+/**
+ * File:       HD44780_example_flash_jitter.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Measures how steadily the bit-bang path clocks characters out to a 4x20
+ * HD44780, first with nothing else running, then with a lower priority task
+ * evicting the flash cache between rows, then with the other core erasing
+ * and writing flash.  In four bit mode each character is two E pulses, so
+ * the time from one character to the next is the Pulse_E period.  Build it
+ * with and without CONFIG_HD44780_IRAM_BIT_BANG to compare the two.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "HD44780.h"
+#include "Latency.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define ROWS_PER_PHASE      200
+#define ROW_CHARS           20
+#define DISPLAY_ROWS        4
+#define MEASURE_CORE        0
+#define FLASH_CORE          1
+#define MEASURE_PRIO        5
+#define PRESSURE_PRIO       4
+#define FLASH_PRIO          5
+#define SCRATCH_PARTITION   "scratch"
+#define SECTOR_BYTES        4096
+// Far more than the flash cache holds, read a cache line at a time
+#define PRESSURE_BYTES      (128 * 1024)
+#define CACHE_LINE_BYTES    32
+
+typedef enum _phase {
+    PHASE_IDLE = 0,
+    PHASE_CACHE,
+    PHASE_FLASH,
+    PHASE_DONE
+} PHASE;
+
+static const char *PHASE_NAMES[PHASE_DONE] = { "idle", "cache_pressure", "flash_write" };
+
+// Constant, so it stays in flash and every read of it goes through the cache
+static const uint8_t pressureTable[PRESSURE_BYTES] = { 1 };
+
+volatile PHASE phase = PHASE_IDLE;
+volatile uint32_t sectorsWritten;
+LATENCY_HISTOGRAM periods[PHASE_DONE];
+
+// Function predefinitions
+void runPhase(LATENCY_HISTOGRAM *histogram);
+void cachePressureTask(void *arg);
+void flashWriterTask(void *arg);
+
+/**
+ * Application main
+ */
+void app_main(void) {
+    HD44780_FOUR_BIT_BUS bus = { 4, 20, 18, 19, 21, 22, 16, 17 };
+    HD44780_initFourBitBus(&bus);
+    HD44780_clear();
+
+    const esp_partition_t *scratch = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                              SCRATCH_PARTITION);
+    if (scratch == NULL) {
+        printf("No %s partition, build with the partitions.csv next to this example\n", SCRATCH_PARTITION);
+        return;
+    }
+
+    // The pressure task shares this core, so it only runs in the gaps between rows
+    vTaskPrioritySet(NULL, MEASURE_PRIO);
+    xTaskCreatePinnedToCore(cachePressureTask, "cache_pressure", 2048, NULL, PRESSURE_PRIO, NULL, MEASURE_CORE);
+    xTaskCreatePinnedToCore(flashWriterTask, "flash_writer", 4096, (void *) scratch, FLASH_PRIO, NULL, FLASH_CORE);
+
+    for (int p = 0; p < PHASE_DONE; p++) {
+        LATENCY_init(&periods[p], PHASE_NAMES[p]);
+        phase = (PHASE) p;
+        runPhase(&periods[p]);
+    }
+    phase = PHASE_DONE;
+
+    printf("CONFIG_HD44780_IRAM_BIT_BANG %s\n",
+#ifdef CONFIG_HD44780_IRAM_BIT_BANG
+           "on"
+#else
+           "off"
+#endif
+    );
+    printf("%-16s %8s %8s %8s %8s\n", "Phase", "Periods", "P50 us", "P99 us", "Max us");
+    for (int p = 0; p < PHASE_DONE; p++) {
+        LATENCY_SUMMARY summary;
+        LATENCY_summarize(&periods[p], &summary);
+        printf("%-16s %8lu %8lu %8lu %8lu\n", PHASE_NAMES[p], (unsigned long) summary.count,
+               (unsigned long) summary.p50Us, (unsigned long) summary.p99Us, (unsigned long) summary.maxUs);
+        printf("BENCH,%s,period_p50_us,%lu\n", PHASE_NAMES[p], (unsigned long) summary.p50Us);
+        printf("BENCH,%s,period_p99_us,%lu\n", PHASE_NAMES[p], (unsigned long) summary.p99Us);
+        printf("BENCH,%s,period_max_us,%lu\n", PHASE_NAMES[p], (unsigned long) summary.maxUs);
+    }
+    printf("Flash sectors erased and written: %lu\n", (unsigned long) sectorsWritten);
+}
+
+/**
+ * Writes ROWS_PER_PHASE rows a character at a time, recording the time from
+ * each character to the next.  Sleeps a tick between rows, which is when
+ * the pressure task gets to run.
+ *
+ * @param histogram LATENCY_HISTOGRAM to record the periods in
+ */
+void runPhase(LATENCY_HISTOGRAM *histogram) {
+    char text[2] = { 0 };
+    for (int row = 0; row < ROWS_PER_PHASE; row++) {
+        HD44780_setCursorPos(0, row % DISPLAY_ROWS);
+        // Periods only count within a row, not across the sleep
+        int64_t lastUs = 0;
+        for (int c = 0; c < ROW_CHARS; c++) {
+            text[0] = (char) ('A' + (row + c) % 26);
+            HD44780_print(text);
+            int64_t nowUs = LATENCY_nowUs();
+            if (c > 0) {
+                LATENCY_record(histogram, (uint32_t) (nowUs - lastUs));
+            }
+            lastUs = nowUs;
+        }
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * Reads through the flash resident table a cache line at a time while the
+ * cache pressure phase runs, evicting whatever the display code had cached.
+ *
+ * @param arg Unused
+ */
+void cachePressureTask(void *arg) {
+    volatile uint32_t sum = 0;
+    while (phase != PHASE_DONE) {
+        if (phase != PHASE_CACHE) {
+            vTaskDelay(1);
+            continue;
+        }
+        for (int i = 0; i < PRESSURE_BYTES && phase == PHASE_CACHE; i += CACHE_LINE_BYTES) {
+            sum += pressureTable[i];
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+/**
+ * Erases and writes one sector of the scratch partition after another while
+ * the flash write phase runs.
+ *
+ * @param arg esp_partition_t to write
+ */
+void flashWriterTask(void *arg) {
+    const esp_partition_t *scratch = (const esp_partition_t *) arg;
+    static uint8_t sector[SECTOR_BYTES];
+    uint32_t sectors = scratch->size / SECTOR_BYTES;
+    memset(sector, 0x5A, sizeof(sector));
+
+    while (phase != PHASE_DONE) {
+        if (phase != PHASE_FLASH) {
+            vTaskDelay(1);
+            continue;
+        }
+        size_t offset = (sectorsWritten % sectors) * SECTOR_BYTES;
+        if (esp_partition_erase_range(scratch, offset, SECTOR_BYTES) == ESP_OK &&
+            esp_partition_write(scratch, offset, sector, SECTOR_BYTES) == ESP_OK) {
+            sectorsWritten++;
+        }
+        // Leave the other tasks on this core a tick
+        vTaskDelay(1);
+    }
+    vTaskDelete(NULL);
+}
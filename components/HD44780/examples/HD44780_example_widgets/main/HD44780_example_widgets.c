@@ -0,0 +1,105 @@
+/**
+ * File:       HD44780_example_widgets.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Example for a 4x20 HD44780 display that shows three simulated axes at
+ * 50 Hz, each as a value and a bar centered on zero, with a readout on the
+ * bottom row of how many characters were sent against redrawing every
+ * widget on every update.
+ */
+#include <math.h>
+#include <stdio.h>
+#include "HD44780.h"
+#include "HD44780_widgets.h"
+#include "esp_random.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define UPDATE_DELAY    (20 / portTICK_PERIOD_MS)
+#define UPDATES_PER_SEC 50
+#define AXES            3
+#define FIELD_WIDTH     8
+#define BAR_CELLS       12
+// Roughly what a still ADXL345 wanders by between samples, in milli-g
+#define NOISE_MILLI_G   8
+
+// Function predefinitions
+int32_t simulatedAxis(int axis, uint32_t update);
+void showSent(HD44780_FIELD *fields, HD44780_BAR *bars, uint32_t updates);
+
+/**
+ * Application main
+ */
+void app_main(void) {
+    HD44780_FOUR_BIT_BUS bus = { 4, 20, 18, 19, 21, 22, 16, 17 };
+    HD44780_initFourBitBus(&bus);
+    HD44780_clear();
+    HD44780_widgetLoadGlyphs();
+
+    // Milli-g shown to two decimal places, with a deadband of two of the last
+    // digit.  A bar step is 2000 / 60 milli-g, so it needs no deadband of its own.
+    HD44780_FIELD fields[AXES];
+    HD44780_BAR bars[AXES];
+    const char labels[AXES] = { 'X', 'Y', 'Z' };
+    for (int i = 0; i < AXES; i++) {
+        HD44780_fieldInit(&fields[i], 0, i, FIELD_WIDTH, labels[i], 1000, 2, 20);
+        HD44780_barInit(&bars[i], FIELD_WIDTH, i, BAR_CELLS, -1000, 1000, true, 0);
+    }
+
+    uint32_t updates = 0;
+    TickType_t wake = xTaskGetTickCount();
+    while (true) {
+        for (int i = 0; i < AXES; i++) {
+            int32_t value = simulatedAxis(i, updates);
+            HD44780_fieldSet(&fields[i], value);
+            HD44780_barSet(&bars[i], value);
+        }
+        updates++;
+
+        if (updates % UPDATES_PER_SEC == 0) {
+            showSent(fields, bars, updates);
+        }
+        vTaskDelayUntil(&wake, UPDATE_DELAY);
+    }
+}
+
+/**
+ * Returns a simulated reading for the param axis, a slow swing of a different
+ * period on each with a little noise on top.
+ *
+ * @param axis   Axis number, from 0
+ * @param update Number of updates so far
+ * @return Reading in milli-g
+ */
+int32_t simulatedAxis(int axis, uint32_t update) {
+    float seconds = (float) update / UPDATES_PER_SEC;
+    float swing = sinf(seconds * (0.5f + 0.3f * axis));
+    int32_t noise = (int32_t) (esp_random() % (2 * NOISE_MILLI_G + 1)) - NOISE_MILLI_G;
+    return (int32_t) (swing * 1000.0f) + noise;
+}
+
+/**
+ * Shows how many characters the widgets have sent so far, as a percentage
+ * of sending every one of their cells on every update.
+ *
+ * @param fields  Array of AXES fields
+ * @param bars    Array of AXES bars
+ * @param updates Number of updates so far
+ */
+void showSent(HD44780_FIELD *fields, HD44780_BAR *bars, uint32_t updates) {
+    uint32_t sent = 0;
+    for (int i = 0; i < AXES; i++) {
+        sent += fields[i].cellsWritten + bars[i].cellsWritten;
+    }
+
+    uint64_t fullRedraw = (uint64_t) updates * AXES * (FIELD_WIDTH + BAR_CELLS);
+    char status[21];
+    snprintf(status, sizeof(status), "Sent %lu%% of redraw ", (unsigned long) (sent * 100ULL / fullRedraw));
+    HD44780_setCursorPos(0, 3);
+    HD44780_print(status);
+}
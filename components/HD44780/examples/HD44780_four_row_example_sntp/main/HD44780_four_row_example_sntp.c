@@ -11,6 +11,9 @@
  * the current time from an NTP server.  If successful, it then sets the ESP-32s
  * internal real time clock (RTC) to the current time, and displays the current
  * date and time on the HD44780 display.
+ *
+ * The clock is drawn by the HD44780 clock renderer, which wakes right as each
+ * second ticks over and only rewrites the digits that changed.
  * 
  * NOTE: Much of this code was directly pulled from the ESP-IDF SNTP example,
  *       which states that much of the WLAN setup code is example code, and
@@ -22,12 +25,14 @@
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_attr.h"
+#include "esp_log.h"
 #include "nvs_flash.h"
 #include "protocol_examples_common.h"
 #include "esp_netif_sntp.h"
 #include "lwip/ip_addr.h"
 #include "esp_sntp.h"
 #include "HD44780.h"
+#include "HD44780_clock.h"
 
 // Definitions for custom display character RAM locations
 #define TOP_RIGHT_L 0
@@ -37,15 +42,19 @@
 #define BOTTOM_DASH 4
 #define PIPE 5
 
+#define CLOCK_TASK_PRIO 5
+
 #ifndef INET6_ADDRSTRLEN
 #define INET6_ADDRSTRLEN 48
 #endif
 
+HD44780_CLOCK lcdClock;
+
+static const char *TAG = "four_row_sntp";
+
 // Function predefinitions
 static void obtain_time();
-void updateTimeAfterInit();
 void setupDisplay(HD44780_FOUR_BIT_BUS *bus);
-void updateDisplay(struct tm *timeinfo);
 
 /**
  * Application main
@@ -70,10 +79,17 @@ void app_main() {
     setenv("TZ", "CST6CDT,M3.2.0,M11.1.0", 1);
     tzset();
 
+    // The date on the first row inside the border, the time on the second
+    HD44780_clockInit(&lcdClock, 4, 1, "%d %b, %Y", 6, 2, "%X");
+    ESP_ERROR_CHECK(HD44780_clockStart(&lcdClock, CLOCK_TASK_PRIO, tskNO_AFFINITY));
+
     while (true) {
-        // 500ms delay so that we always update on the second, due to Nyquist
-        vTaskDelay(500 / portTICK_PERIOD_MS);
-        updateTimeAfterInit();
+        vTaskDelay(60000 / portTICK_PERIOD_MS);
+        // Written by the clock task, a torn read only makes a log line slightly off
+        HD44780_CLOCK_STATS stats = lcdClock.stats;
+        ESP_LOGI(TAG, "%lu seconds drawn, %lu characters sent (%lu redrawing everything), %lu us late at most",
+                 (unsigned long) stats.renders, (unsigned long) stats.cellsWritten,
+                 (unsigned long) stats.fullRedrawCells, (unsigned long) stats.maxLateUs);
     }
 }
 
@@ -114,17 +130,6 @@ static void obtain_time() {
     esp_netif_sntp_deinit();
 }
 
-/**
- * Obtains the time from the local RTC and updates the display accordingly.
- */
-void updateTimeAfterInit() {
-    time_t now;
-    struct tm timeinfo;
-    time(&now);
-    localtime_r(&now, &timeinfo);
-    updateDisplay(&timeinfo);
-}
-
 /**
  * Sets up the HD44780 by defining all special characters used and 
  * storing them in CGRAM, and then draws a pattern on the display.
@@ -232,23 +237,3 @@ void setupDisplay(HD44780_FOUR_BIT_BUS *bus) {
     }
     HD44780_writeChar(BOTTOM_RIGHT_L);
 }
-
-/**
- * Updates the date and time on the display to match the param time object.
- * 
- * @param timeinfo tm object containing the time to update the display to
- */
-void updateDisplay(struct tm *timeinfo) {
-    
-    char strftime_buf[16];
-
-    // String format the date and print to the first row
-    strftime(strftime_buf, sizeof(strftime_buf), "%d %b, %Y", timeinfo);
-    HD44780_setCursorPos(4, 1);
-    HD44780_print(strftime_buf);
-
-    // String format the time and print to the second row
-    strftime(strftime_buf, sizeof(strftime_buf), "%X", timeinfo);
-    HD44780_setCursorPos(6, 2);
-    HD44780_print(strftime_buf);
-}
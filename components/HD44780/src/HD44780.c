@@ -7,7 +7,10 @@
  */
 
 #include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 #include "driver/gpio.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "rom/ets_sys.h"
@@ -20,12 +23,27 @@ HD44780_FOUR_BIT_BUS *fourBus;
 HD44780_EIGHT_BIT_BUS *eightBus;
 gpio_num_t enablePin;
 gpio_num_t rsPin;
+// DDRAM address the next character lands at, so redundant cursor moves can be skipped
+int cursorAddress = HD44780_ADDRESS_UNKNOWN;
 
 static uint32_t ONE_HUNDRED_MILLI_DELAY = (100 / portTICK_PERIOD_MS);
 static uint32_t TWENTY_MILLI_DELAY = (20 / portTICK_PERIOD_MS);
 static uint32_t VOLTAGE_CHANGE_DELAY_US = 5;
 static uint32_t INSTRUCTION_DELAY_US = 70;
 
+static const HD44780_TIMING TIMING_PROFILES[] = {
+    [HD44780_TIMING_STANDARD] = { 5, 70 },
+    [HD44780_TIMING_FAST] = { 1, 40 },
+    [HD44780_TIMING_SAFE] = { 10, 120 },
+};
+
+// Only written by the task driving the display.  Readers copy it between two
+// reads of the sequence, which is odd while an update is under way, so they
+// never block the display and never see a half written update.
+static HD44780_STATS stats;
+static atomic_uint statsSequence;
+static atomic_bool statsResetPending;
+
 // 'Public' functions, designed for use by the main application
 
 /**
@@ -93,10 +111,13 @@ void HD44780_initEightBitBus(HD44780_EIGHT_BIT_BUS *eightBitBus) {
  * @param data String to draw on the display as a character array
  */
 void HD44780_print(char* data) {
+    int64_t start = esp_timer_get_time();
     int length = strlen(data);
     for(int i = 0; i < length; i++) {
         HD44780_SendData(data[i]);
+        HD44780_AdvanceAddress();
     }
+    HD44780_Account(HD44780_API_PRINT, start, length);
 }
 
 /**
@@ -105,8 +126,11 @@ void HD44780_print(char* data) {
  *       so the delay is quite a bit longer then most other instructions.
  */
 void HD44780_clear() {
+    int64_t start = esp_timer_get_time();
     HD44780_SendInstruction(HD44780_DISP_CLEAR);
     vTaskDelay(TWENTY_MILLI_DELAY);
+    cursorAddress = HD44780_ROW1_START;
+    HD44780_Account(HD44780_API_CLEAR, start, 1);
 }
 
 /**
@@ -126,10 +150,14 @@ void HD44780_homeCursor() {
  */
 void HD44780_createChar(int slot, uint8_t* data) {
     if (slot < 8) {
+        int64_t start = esp_timer_get_time();
         HD44780_SendInstruction(HD44780_CGRAM_START + (slot * 8));
         for (int i = 0; i < 8; i++) {
             HD44780_SendData(data[i]);
         }
+        // Writes go to CGRAM until the next cursor move
+        cursorAddress = HD44780_ADDRESS_UNKNOWN;
+        HD44780_Account(HD44780_API_CREATE_CHAR, start, 9);
     }
 }
 
@@ -141,7 +169,10 @@ void HD44780_createChar(int slot, uint8_t* data) {
  */
 void HD44780_writeChar(int slot) {
     if (slot < 8) {
+        int64_t start = esp_timer_get_time();
         HD44780_SendData(slot);
+        HD44780_AdvanceAddress();
+        HD44780_Account(HD44780_API_WRITE_CHAR, start, 1);
     }
 }
 
@@ -149,18 +180,20 @@ void HD44780_writeChar(int slot) {
  * Shifts all characters in the display one space to the left
  */
 void HD44780_shiftDispLeft() {
-    HD44780_SendInstruction(HD44780_SHIFT_LEFT);
+    HD44780_SendTimedInstruction(HD44780_SHIFT_LEFT);
 }
 
 /**
  * Shifts all characters in the display one space to the right
  */
 void HD44780_shiftDispRight() {
-    HD44780_SendInstruction(HD44780_SHIFT_RIGHT);
+    HD44780_SendTimedInstruction(HD44780_SHIFT_RIGHT);
 }
 
 /**
  * Sets the position of the cursor based on the param column (x) and row (y)
+ * NOTE: The display moves the cursor on after every character, so a move to
+ *       where the last print left it is skipped, and counted as elided.
  * 
  * @param x column to set cursor to as an integer
  * @param y row to set cursor to as an integer
@@ -172,29 +205,41 @@ void HD44780_setCursorPos(int x, int y) {
     }
 
     // Set cursor based on row
+    int address;
     if (y == 0) {
-        HD44780_SendInstruction(HD44780_SET_POSITION | (HD44780_ROW1_START + x));
+        address = HD44780_ROW1_START + x;
     } else if (y == 1) {
-        HD44780_SendInstruction(HD44780_SET_POSITION | (HD44780_ROW2_START + x));
+        address = HD44780_ROW2_START + x;
     } else if (y == 2) {
-        HD44780_SendInstruction(HD44780_SET_POSITION | (HD44780_ROW3_START + x));
+        address = HD44780_ROW3_START + x;
     } else if (y == 3) {
-        HD44780_SendInstruction(HD44780_SET_POSITION | (HD44780_ROW4_START + x));
+        address = HD44780_ROW4_START + x;
+    } else {
+        return;
     }
+
+    if (address == cursorAddress) {
+        HD44780_AccountElided();
+        return;
+    }
+    int64_t start = esp_timer_get_time();
+    HD44780_SendInstruction(HD44780_SET_POSITION | address);
+    cursorAddress = address;
+    HD44780_Account(HD44780_API_SET_CURSOR, start, 1);
 }
 
 /**
  * Turns on the character cursor and sets it to blinking mode
  */
 void HD44780_blink() {
-    HD44780_SendInstruction(HD44780_CURSOR_BLINK);
+    HD44780_SendTimedInstruction(HD44780_CURSOR_BLINK);
 }
 
 /**
  * Turns on the character cursor and sets it to non blinking mode
  */
 void HD44780_noBlink() {
-    HD44780_SendInstruction(HD44780_CURSOR_ON);
+    HD44780_SendTimedInstruction(HD44780_CURSOR_ON);
 }
 
 /**
@@ -202,14 +247,14 @@ void HD44780_noBlink() {
  * NOTE: Functionally this is the same as HD445780_noBlink()
  */
 void HD44780_cursor() {
-    HD44780_SendInstruction(HD44780_CURSOR_ON);
+    HD44780_SendTimedInstruction(HD44780_CURSOR_ON);
 }
 
 /**
  * Turns off the character cursor
  */
 void HD44780_noCursor() {
-    HD44780_SendInstruction(HD44780_DISP_ON);
+    HD44780_SendTimedInstruction(HD44780_DISP_ON);
 }
 
 /**
@@ -218,7 +263,7 @@ void HD44780_noCursor() {
  *       that toggling the backlight on/off is handled by the main application.
  */
 void HD44780_dispOff() {
-    HD44780_SendInstruction(HD44780_DISP_OFF);
+    HD44780_SendTimedInstruction(HD44780_DISP_OFF);
 }
 
 /**
@@ -226,7 +271,71 @@ void HD44780_dispOff() {
  * NOTE: Functionally this is the same as HD44780_noCursor()
  */
 void HD44780_dispOn() {
-    HD44780_SendInstruction(HD44780_DISP_ON);
+    HD44780_SendTimedInstruction(HD44780_DISP_ON);
+}
+
+/**
+ * Switches to one of the preset timing profiles.  Takes effect from the
+ * next byte sent.
+ *
+ * @param profile HD44780_TIMING_PROFILE to use
+ */
+void HD44780_setTimingProfile(HD44780_TIMING_PROFILE profile) {
+    if (profile <= HD44780_TIMING_SAFE) {
+        HD44780_setTiming(&TIMING_PROFILES[profile]);
+    }
+}
+
+/**
+ * Sets the bus timing.  Shorter delays give more display updates per second,
+ * too short and the display drops or garbles characters.
+ * NOTE: Safe to call from another task while the display is being driven,
+ *       each delay is a single word and is only ever read.
+ *
+ * @param timing HD44780_TIMING to use
+ */
+void HD44780_setTiming(const HD44780_TIMING *timing) {
+    VOLTAGE_CHANGE_DELAY_US = timing->voltageChangeUs;
+    INSTRUCTION_DELAY_US = timing->instructionUs;
+}
+
+/**
+ * Reads the bus timing in use.
+ *
+ * @param timing HD44780_TIMING to fill
+ */
+void HD44780_getTiming(HD44780_TIMING *timing) {
+    timing->voltageChangeUs = VOLTAGE_CHANGE_DELAY_US;
+    timing->instructionUs = INSTRUCTION_DELAY_US;
+}
+
+/**
+ * Takes a consistent snapshot of the per call statistics.  Never blocks the
+ * task driving the display, so it's safe from any other task.
+ *
+ * @param snapshot HD44780_STATS to fill
+ */
+void HD44780_getStats(HD44780_STATS *snapshot) {
+    while (1) {
+        unsigned int sequence = atomic_load_explicit(&statsSequence, memory_order_acquire);
+        if ((sequence & 1) == 0) {
+            *snapshot = stats;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&statsSequence, memory_order_relaxed) == sequence) {
+                return;
+            }
+        }
+        // Let the display task finish its update, in case we preempted it
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * Zeroes the statistics.  The display task does the zeroing on its next
+ * call, so this never waits on it.
+ */
+void HD44780_resetStats() {
+    atomic_store_explicit(&statsResetPending, true, memory_order_relaxed);
 }
 
 
@@ -269,6 +378,7 @@ void HD44780_InitDisplay() {
     vTaskDelay(TWENTY_MILLI_DELAY);
     HD44780_SendInstruction(HD44780_ENTRY_MODE);
     HD44780_SendInstruction(HD44780_DISP_ON);
+    cursorAddress = HD44780_ROW1_START;
 }
 
 /**
@@ -423,3 +533,83 @@ void HD44780_SendData(unsigned short int data) {
     }
 }
 
+/**
+ * Sends the param instruction on behalf of a public call with no statistics
+ * of its own, and accounts it as HD44780_API_OTHER.
+ *
+ * @param data Instruction to send
+ */
+void HD44780_SendTimedInstruction(unsigned short int data) {
+    int64_t start = esp_timer_get_time();
+    HD44780_SendInstruction(data);
+    HD44780_Account(HD44780_API_OTHER, start, 1);
+}
+
+/**
+ * Moves the tracked cursor address on by one character, the way the
+ * display's own address counter does in the increment entry mode.
+ */
+void HD44780_AdvanceAddress() {
+    if (cursorAddress == HD44780_ADDRESS_UNKNOWN) {
+        return;
+    }
+
+    cursorAddress++;
+    if (cursorAddress == HD44780_ROW1_END) {
+        cursorAddress = HD44780_ROW2_START;
+    } else if (cursorAddress == HD44780_ROW2_END) {
+        cursorAddress = HD44780_ROW1_START;
+    }
+}
+
+/**
+ * Adds one call to the statistics, along with the time since the param
+ * start time.
+ *
+ * @param api     HD44780_API that was called
+ * @param startUs Time the call started
+ * @param bytes   Instructions and characters it sent
+ */
+void HD44780_Account(HD44780_API api, int64_t startUs, uint32_t bytes) {
+    int64_t elapsed = esp_timer_get_time() - startUs;
+
+    unsigned int sequence = HD44780_BeginStats();
+    stats.api[api].calls++;
+    stats.api[api].bytes += bytes;
+    stats.api[api].busUs += (uint64_t) elapsed;
+    HD44780_EndStats(sequence);
+}
+
+/**
+ * Counts a cursor move that was skipped.
+ */
+void HD44780_AccountElided() {
+    unsigned int sequence = HD44780_BeginStats();
+    stats.elided++;
+    HD44780_EndStats(sequence);
+}
+
+/**
+ * Marks the statistics as being updated, and carries out any pending reset.
+ *
+ * @return Sequence to hand to HD44780_EndStats
+ */
+unsigned int HD44780_BeginStats() {
+    unsigned int sequence = atomic_load_explicit(&statsSequence, memory_order_relaxed) + 1;
+    atomic_store_explicit(&statsSequence, sequence, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (atomic_exchange_explicit(&statsResetPending, false, memory_order_relaxed)) {
+        memset(&stats, 0, sizeof(stats));
+    }
+    return sequence;
+}
+
+/**
+ * Marks the update begun by HD44780_BeginStats as complete.
+ *
+ * @param sequence Sequence HD44780_BeginStats returned
+ */
+void HD44780_EndStats(unsigned int sequence) {
+    atomic_store_explicit(&statsSequence, sequence + 1, memory_order_release);
+}
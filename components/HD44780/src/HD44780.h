@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include "driver/gpio.h"
 
 typedef enum _displayMode {
@@ -41,6 +42,47 @@ typedef struct _eightBitBus {
     gpio_num_t E;
 } HD44780_EIGHT_BIT_BUS;
 
+typedef enum _timingProfile {
+    // The datasheet figures, with margin, what this library has always used
+    HD44780_TIMING_STANDARD,
+    // Genuine HD44780s at 5V, 37us per instruction at the nominal 270kHz clock
+    HD44780_TIMING_FAST,
+    // Slow clones, long ribbon cables, or modules run at 3.3V
+    HD44780_TIMING_SAFE
+} HD44780_TIMING_PROFILE;
+
+typedef struct _timing {
+    // Settling time around each edge of E
+    uint32_t voltageChangeUs;
+    // Execution time allowed after each instruction or character
+    uint32_t instructionUs;
+} HD44780_TIMING;
+
+// Public calls that are timed separately, everything else is HD44780_API_OTHER
+typedef enum _api {
+    HD44780_API_PRINT,
+    HD44780_API_SET_CURSOR,
+    HD44780_API_CLEAR,
+    HD44780_API_CREATE_CHAR,
+    HD44780_API_WRITE_CHAR,
+    HD44780_API_OTHER,
+    HD44780_API_COUNT
+} HD44780_API;
+
+typedef struct _apiStats {
+    uint32_t calls;
+    // Instructions and characters sent to the display
+    uint32_t bytes;
+    // Time spent in the call, bit banging and waiting on the display
+    uint64_t busUs;
+} HD44780_API_STATS;
+
+typedef struct _stats {
+    HD44780_API_STATS api[HD44780_API_COUNT];
+    // Cursor moves skipped because the cursor was already there
+    uint32_t elided;
+} HD44780_STATS;
+
 // 'Private' methods designed for internal use
 void HD44780_InitDisplay();
 
@@ -60,6 +102,18 @@ void HD44780_SendInstruction(unsigned short int data);
 
 void HD44780_SendData(unsigned short int data);
 
+void HD44780_SendTimedInstruction(unsigned short int data);
+
+void HD44780_AdvanceAddress();
+
+void HD44780_Account(HD44780_API api, int64_t startUs, uint32_t bytes);
+
+void HD44780_AccountElided();
+
+unsigned int HD44780_BeginStats();
+
+void HD44780_EndStats(unsigned int sequence);
+
 
 // Public methods designed for the user to call
 void HD44780_initFourBitBus(HD44780_FOUR_BIT_BUS *bus);
@@ -94,6 +148,16 @@ void HD44780_dispOff();
 
 void HD44780_dispOn();
 
+void HD44780_setTimingProfile(HD44780_TIMING_PROFILE profile);
+
+void HD44780_setTiming(const HD44780_TIMING *timing);
+
+void HD44780_getTiming(HD44780_TIMING *timing);
+
+void HD44780_getStats(HD44780_STATS *stats);
+
+void HD44780_resetStats();
+
 // HD44780 Instruction Definitions
 #define HD44780_INIT_SEQ        0x30
 #define HD44780_DISP_CLEAR      0x01
@@ -120,3 +184,8 @@ void HD44780_dispOn();
 #define HD44780_ROW3_START      0x14
 #define HD44780_ROW4_START      0x54
 #define HD44780_CGRAM_START     0x40
+// Where DDRAM addresses wrap to in two row mode
+#define HD44780_ROW1_END        0x28
+#define HD44780_ROW2_END        0x68
+// Cursor address isn't known, e.g. while writing CGRAM
+#define HD44780_ADDRESS_UNKNOWN -1
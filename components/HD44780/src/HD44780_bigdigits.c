@@ -0,0 +1,220 @@
+/**
+ * File:       HD44780_bigdigits.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Big numerals, two or three rows tall, for readouts that need to be read
+ * from across a room.
+ *
+ * Every character is built from the ROM's full block, spaces, and six bar
+ * and dot glyphs shared by both heights, so they're uploaded to CGRAM once
+ * and leave two slots free.  The glyphs and the cell layout of every
+ * character are constant tables, so drawing is just printing rows of them.
+ * Each text keeps what it last drew and only rewrites the characters that
+ * changed or moved, a row at a time for each run of them.
+ */
+#include <string.h>
+#include "HD44780.h"
+#include "HD44780_bigdigits.h"
+
+// Cell codes, the glyphs through their CGRAM mirror
+#define BIG_T   "\x08"  // Top bar
+#define BIG_B   "\x09"  // Bottom bar
+#define BIG_TB  "\x0A"  // Top and bottom bars
+#define BIG_M   "\x0B"  // Middle bar
+#define BIG_DU  "\x0C"  // Upper dot
+#define BIG_DL  "\x0D"  // Lower dot
+#define BIG_FF  "\xFF"  // Full block, from the character ROM
+#define BIG___  " "
+
+// Characters the tables cover, in table order
+static const char BIG_CHARS[] = "0123456789-:. ";
+
+static const uint8_t BIG_GLYPHS[HD44780_BIG_GLYPHS][8] = {
+    { 0b11111, 0b11111, 0b11111, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000 },
+    { 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b11111, 0b11111, 0b11111 },
+    { 0b11111, 0b11111, 0b11111, 0b00000, 0b00000, 0b11111, 0b11111, 0b11111 },
+    { 0b00000, 0b00000, 0b00000, 0b11111, 0b11111, 0b11111, 0b00000, 0b00000 },
+    { 0b00000, 0b01110, 0b01110, 0b00000, 0b00000, 0b00000, 0b00000, 0b00000 },
+    { 0b00000, 0b00000, 0b00000, 0b00000, 0b00000, 0b01110, 0b01110, 0b00000 },
+};
+
+// Rows of each character, including the blank column that follows it
+static const char *const BIG_TWO_ROW[][2] = {
+    { BIG_FF BIG_T  BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_T  BIG_FF BIG___ BIG___, BIG_B  BIG_FF BIG_B  BIG___ },
+    { BIG_TB BIG_TB BIG_FF BIG___, BIG_FF BIG_B  BIG_B  BIG___ },
+    { BIG_TB BIG_TB BIG_FF BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG_B  BIG_FF BIG___, BIG___ BIG___ BIG_FF BIG___ },
+    { BIG_FF BIG_TB BIG_TB BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG_TB BIG_TB BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_T  BIG_T  BIG_FF BIG___, BIG___ BIG___ BIG_FF BIG___ },
+    { BIG_FF BIG_TB BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG_TB BIG_FF BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG_B  BIG_B  BIG_B  BIG___, BIG___ BIG___ BIG___ BIG___ },
+    { BIG_DL BIG___,               BIG_DU BIG___ },
+    { BIG___ BIG___,               BIG_DL BIG___ },
+    { BIG___ BIG___ BIG___ BIG___, BIG___ BIG___ BIG___ BIG___ },
+};
+
+static const char *const BIG_THREE_ROW[][3] = {
+    { BIG_FF BIG_T  BIG_FF BIG___, BIG_FF BIG___ BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_T  BIG_FF BIG___ BIG___, BIG___ BIG_FF BIG___ BIG___, BIG_B  BIG_FF BIG_B  BIG___ },
+    { BIG_T  BIG_T  BIG_FF BIG___, BIG_B  BIG_B  BIG_FF BIG___, BIG_FF BIG_B  BIG_B  BIG___ },
+    { BIG_T  BIG_T  BIG_FF BIG___, BIG___ BIG_B  BIG_FF BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG___ BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___, BIG___ BIG___ BIG_FF BIG___ },
+    { BIG_FF BIG_T  BIG_T  BIG___, BIG_FF BIG_B  BIG_B  BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG_T  BIG_T  BIG___, BIG_FF BIG_B  BIG_B  BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_T  BIG_T  BIG_FF BIG___, BIG___ BIG___ BIG_FF BIG___, BIG___ BIG___ BIG_FF BIG___ },
+    { BIG_FF BIG_T  BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___ },
+    { BIG_FF BIG_T  BIG_FF BIG___, BIG_FF BIG_B  BIG_FF BIG___, BIG_B  BIG_B  BIG_FF BIG___ },
+    { BIG___ BIG___ BIG___ BIG___, BIG_M  BIG_M  BIG_M  BIG___, BIG___ BIG___ BIG___ BIG___ },
+    { BIG_DL BIG___,               BIG___ BIG___,               BIG_DU BIG___ },
+    { BIG___ BIG___,               BIG___ BIG___,               BIG_DL BIG___ },
+    { BIG___ BIG___ BIG___ BIG___, BIG___ BIG___ BIG___ BIG___, BIG___ BIG___ BIG___ BIG___ },
+};
+
+// 'Private' helpers designed for internal use
+static const char *HD44780_BigRow(HD44780_BIG_HEIGHT height, char c, int row);
+static int HD44780_BigLayout(const char *value, int count, int *x);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Uploads the glyphs to CGRAM slots 0 to HD44780_BIG_GLYPHS - 1.  Needed
+ * once after the display is initialized, before any big text is drawn.
+ * NOTE: Leaves the cursor in CGRAM, so move it before printing anything else.
+ */
+void HD44780_bigLoadGlyphs() {
+    for (int i = 0; i < HD44780_BIG_GLYPHS; i++) {
+        HD44780_createChar(i, (uint8_t *) BIG_GLYPHS[i]);
+    }
+}
+
+/**
+ * Sets up a big text.  Nothing is drawn until the first HD44780_bigPrint.
+ *
+ * @param text   HD44780_BIG_TEXT to set up
+ * @param col    Column of its top left corner
+ * @param row    Row of its top left corner
+ * @param height HD44780_BIG_HEIGHT of its characters
+ */
+void HD44780_bigInit(HD44780_BIG_TEXT *text, int col, int row, HD44780_BIG_HEIGHT height) {
+    memset(text, 0, sizeof(*text));
+    text->col = col;
+    text->row = row;
+    text->height = height;
+}
+
+/**
+ * Shows the param value, rewriting only the characters that changed or moved
+ * and blanking whatever is left over from a wider value.
+ * NOTE: Digits, '-', ':', '.' and ' ' are drawn, anything else is drawn as a
+ *       space.  Only the first HD44780_BIG_MAX_CHARS characters are shown,
+ *       and as with HD44780_print it's up to the caller that they fit.
+ *
+ * @param text  HD44780_BIG_TEXT to draw
+ * @param value String to show
+ */
+void HD44780_bigPrint(HD44780_BIG_TEXT *text, const char *value) {
+    int count = (int) strnlen(value, HD44780_BIG_MAX_CHARS);
+    int shownCount = (int) strnlen(text->shown, HD44780_BIG_MAX_CHARS);
+    int x[HD44780_BIG_MAX_CHARS];
+    int shownX[HD44780_BIG_MAX_CHARS];
+    int width = HD44780_BigLayout(value, count, x);
+    HD44780_BigLayout(text->shown, shownCount, shownX);
+
+    char line[HD44780_BIG_MAX_CHARS * 4 + 1];
+    int i = 0;
+    while (i < count) {
+        if (i < shownCount && text->shown[i] == value[i] && shownX[i] == x[i]) {
+            i++;
+            continue;
+        }
+
+        // Every row of a run of changed characters goes out in one print
+        int start = i;
+        while (i < count && (i >= shownCount || text->shown[i] != value[i] || shownX[i] != x[i])) {
+            i++;
+        }
+        for (int r = 0; r < (int) text->height; r++) {
+            line[0] = '\0';
+            for (int j = start; j < i; j++) {
+                strcat(line, HD44780_BigRow(text->height, value[j], r));
+            }
+            HD44780_setCursorPos(text->col + x[start], text->row + r);
+            HD44780_print(line);
+            text->cellsWritten += strlen(line);
+        }
+    }
+
+    if (width < text->shownWidth) {
+        int blank = text->shownWidth - width;
+        memset(line, ' ', blank);
+        line[blank] = '\0';
+        for (int r = 0; r < (int) text->height; r++) {
+            HD44780_setCursorPos(text->col + width, text->row + r);
+            HD44780_print(line);
+            text->cellsWritten += blank;
+        }
+    }
+
+    text->fullRedrawCells += width * text->height;
+    memset(text->shown, 0, sizeof(text->shown));
+    memcpy(text->shown, value, count);
+    text->shownWidth = width;
+}
+
+/**
+ * Returns the number of columns the param value takes up when drawn big,
+ * including the blank column after its last character.
+ *
+ * @param value String to measure
+ */
+int HD44780_bigWidth(const char *value) {
+    int x[HD44780_BIG_MAX_CHARS];
+    return HD44780_BigLayout(value, (int) strnlen(value, HD44780_BIG_MAX_CHARS), x);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns the cells of one row of the param character, or of a space if
+ * there's no big version of it.
+ *
+ * @param height HD44780_BIG_HEIGHT to draw at
+ * @param c      Character to draw
+ * @param row    Row of the character, from 0 at the top
+ */
+static const char *HD44780_BigRow(HD44780_BIG_HEIGHT height, char c, int row) {
+    const char *found = (c != '\0') ? strchr(BIG_CHARS, c) : NULL;
+    int index = (found != NULL) ? (int) (found - BIG_CHARS) : (int) (sizeof(BIG_CHARS) - 2);
+
+    if (height == HD44780_BIG_TWO_ROW) {
+        return BIG_TWO_ROW[index][row];
+    }
+    return BIG_THREE_ROW[index][row];
+}
+
+/**
+ * Works out the column each character of the param value starts at.  Every
+ * row of a character is the same width, so the top row sets it.
+ *
+ * @param value String to lay out
+ * @param count Number of characters in it
+ * @param x     Array of at least count to fill with start columns
+ * @return Total width
+ */
+static int HD44780_BigLayout(const char *value, int count, int *x) {
+    int width = 0;
+    for (int i = 0; i < count; i++) {
+        x[i] = width;
+        width += (int) strlen(HD44780_BigRow(HD44780_BIG_TWO_ROW, value[i], 0));
+    }
+    return width;
+}
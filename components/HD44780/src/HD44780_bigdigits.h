@@ -0,0 +1,50 @@
+/**
+ * File:       HD44780_bigdigits.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Characters a single big text can hold, e.g. "-1234.5" or "12:34"
+#define HD44780_BIG_MAX_CHARS   8
+
+typedef enum _bigHeight {
+    HD44780_BIG_TWO_ROW = 2,
+    HD44780_BIG_THREE_ROW = 3
+} HD44780_BIG_HEIGHT;
+
+typedef struct _bigText {
+    int col;
+    int row;
+    HD44780_BIG_HEIGHT height;
+
+    // Characters on the display now, a zero ends them
+    char shown[HD44780_BIG_MAX_CHARS];
+    // Columns they cover
+    int shownWidth;
+    // Cells written, and what redrawing the whole text every time would have written
+    uint32_t cellsWritten;
+    uint32_t fullRedrawCells;
+} HD44780_BIG_TEXT;
+
+
+// Public methods designed for the user to call
+void HD44780_bigLoadGlyphs();
+
+void HD44780_bigInit(HD44780_BIG_TEXT *text, int col, int row, HD44780_BIG_HEIGHT height);
+
+void HD44780_bigPrint(HD44780_BIG_TEXT *text, const char *value);
+
+int HD44780_bigWidth(const char *value);
+
+// Constants for calculations
+// CGRAM slots the glyphs are uploaded to, from 0.  Slots above are left free.
+#define HD44780_BIG_GLYPHS      6
+// CGRAM characters can also be written as 0x08 to 0x0F, which unlike 0x00
+// can go in a string
+#define HD44780_CGRAM_MIRROR    0x08
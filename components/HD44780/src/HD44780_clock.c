@@ -0,0 +1,218 @@
+/**
+ * File:       HD44780_clock.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Clock renderer.  Shows the RTC's date and time on the display, updated
+ * right as each second ticks over.
+ *
+ * A one shot esp_timer is armed for just past the next second boundary,
+ * worked out afresh from the RTC every time, so the clock neither drifts
+ * against the RTC nor falls behind when SNTP adjusts it.  The timer only
+ * wakes the clock task, as writing to the display would hold up every other
+ * esp_timer callback.  The task keeps what it last drew and only sends the
+ * cells that changed, which is usually a digit or two of the time.  The date
+ * is only formatted again once the day changes.
+ */
+#include <string.h>
+#include <sys/time.h>
+#include "HD44780.h"
+#include "HD44780_clock.h"
+
+#define HD44780_CLOCK_STACK_SIZE    3072
+
+// 'Private' helpers designed for internal use
+static void HD44780_ClockTask(void *arg);
+static void HD44780_ClockWake(void *arg);
+static void HD44780_ClockSchedule(HD44780_CLOCK *lcdClock);
+static uint32_t HD44780_ClockUpdate(int col, int row, char *shown, const char *next);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Sets up a clock.  Either string can be left off by passing a NULL format.
+ * NOTE: Both strings are formatted with strftime, and must fit within
+ *       HD44780_CLOCK_MAX_CHARS.
+ *
+ * @param lcdClock   HD44780_CLOCK to set up
+ * @param dateCol    Column the date starts at
+ * @param dateRow    Row the date is on
+ * @param dateFormat strftime format of the date, e.g. "%d %b, %Y"
+ * @param timeCol    Column the time starts at
+ * @param timeRow    Row the time is on
+ * @param timeFormat strftime format of the time, e.g. "%X"
+ */
+void HD44780_clockInit(HD44780_CLOCK *lcdClock, int dateCol, int dateRow, const char *dateFormat, int timeCol,
+                       int timeRow, const char *timeFormat) {
+    memset(lcdClock, 0, sizeof(*lcdClock));
+    lcdClock->dateCol = dateCol;
+    lcdClock->dateRow = dateRow;
+    lcdClock->dateFormat = dateFormat;
+    lcdClock->timeCol = timeCol;
+    lcdClock->timeRow = timeRow;
+    lcdClock->timeFormat = timeFormat;
+    lcdClock->shownDay = -1;
+}
+
+/**
+ * Starts the clock task, which draws the clock straight away and then on
+ * every second.
+ * NOTE: The display driver isn't thread safe, so once the clock is running
+ *       nothing else should write to the display.
+ *
+ * @param lcdClock HD44780_CLOCK to run
+ * @param priority FreeRTOS priority of the clock task
+ * @param core     Core to pin the clock task to, or tskNO_AFFINITY
+ */
+esp_err_t HD44780_clockStart(HD44780_CLOCK *lcdClock, UBaseType_t priority, BaseType_t core) {
+    esp_timer_create_args_t timerArgs = {
+        .callback = HD44780_ClockWake,
+        .arg = lcdClock,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "hd44780clk",
+    };
+    esp_err_t err = esp_timer_create(&timerArgs, &lcdClock->timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    if (xTaskCreatePinnedToCore(HD44780_ClockTask, "hd44780clk", HD44780_CLOCK_STACK_SIZE, lcdClock, priority,
+                                &lcdClock->task, core) != pdPASS) {
+        esp_timer_delete(lcdClock->timer);
+        lcdClock->timer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Brings the display up to date with the param time, writing only the cells
+ * that differ from what's already there.
+ *
+ * @param lcdClock HD44780_CLOCK to render
+ * @param timeinfo Local time to show
+ */
+void HD44780_clockRender(HD44780_CLOCK *lcdClock, const struct tm *timeinfo) {
+    char text[HD44780_CLOCK_MAX_CHARS + 1];
+    HD44780_CLOCK_STATS *stats = &lcdClock->stats;
+
+    int day = timeinfo->tm_year * 366 + timeinfo->tm_yday;
+    if (lcdClock->dateFormat != NULL && day != lcdClock->shownDay) {
+        if (strftime(text, sizeof(text), lcdClock->dateFormat, timeinfo) > 0) {
+            stats->cellsWritten += HD44780_ClockUpdate(lcdClock->dateCol, lcdClock->dateRow, lcdClock->shownDate,
+                                                       text);
+        }
+        lcdClock->shownDay = day;
+    }
+    if (lcdClock->dateFormat != NULL) {
+        stats->fullRedrawCells += strnlen(lcdClock->shownDate, HD44780_CLOCK_MAX_CHARS);
+    }
+
+    if (lcdClock->timeFormat != NULL && strftime(text, sizeof(text), lcdClock->timeFormat, timeinfo) > 0) {
+        stats->cellsWritten += HD44780_ClockUpdate(lcdClock->timeCol, lcdClock->timeRow, lcdClock->shownTime,
+                                                   text);
+        stats->fullRedrawCells += strlen(text);
+    }
+    stats->renders++;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Clock task.  Renders the current time, then sleeps until the next second.
+ *
+ * @param arg HD44780_CLOCK to run
+ */
+static void HD44780_ClockTask(void *arg) {
+    HD44780_CLOCK *lcdClock = (HD44780_CLOCK *) arg;
+
+    while (1) {
+        struct timeval now;
+        struct tm timeinfo;
+        gettimeofday(&now, NULL);
+        localtime_r(&now.tv_sec, &timeinfo);
+        HD44780_clockRender(lcdClock, &timeinfo);
+
+        // Measured against the second that was drawn, so a render that ran
+        // into the next one still counts in full
+        struct timeval done;
+        gettimeofday(&done, NULL);
+        int64_t lateUs = (int64_t) (done.tv_sec - now.tv_sec) * 1000000 + done.tv_usec;
+        lcdClock->stats.lastLateUs = (uint32_t) lateUs;
+        if (lcdClock->stats.lastLateUs > lcdClock->stats.maxLateUs) {
+            lcdClock->stats.maxLateUs = lcdClock->stats.lastLateUs;
+        }
+
+        HD44780_ClockSchedule(lcdClock);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/**
+ * esp_timer callback, wakes the clock task for the new second.
+ *
+ * @param arg HD44780_CLOCK to wake
+ */
+static void HD44780_ClockWake(void *arg) {
+    HD44780_CLOCK *lcdClock = (HD44780_CLOCK *) arg;
+    xTaskNotifyGive(lcdClock->task);
+}
+
+/**
+ * Arms the timer for just past the next second boundary of the RTC.
+ *
+ * @param lcdClock HD44780_CLOCK to schedule
+ */
+static void HD44780_ClockSchedule(HD44780_CLOCK *lcdClock) {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    esp_timer_start_once(lcdClock->timer, (uint64_t) (1000000 - now.tv_usec) + HD44780_CLOCK_GUARD_US);
+}
+
+/**
+ * Writes each run of cells where the param next string differs from what's
+ * shown, and blanks anything left over from a longer string.
+ *
+ * @param col   Column the string starts at
+ * @param row   Row the string is on
+ * @param shown HD44780_CLOCK_MAX_CHARS cells shown now, updated to match
+ * @param next  String to show
+ * @return Number of cells written
+ */
+static uint32_t HD44780_ClockUpdate(int col, int row, char *shown, const char *next) {
+    char run[HD44780_CLOCK_MAX_CHARS + 1];
+    int length = (int) strnlen(next, HD44780_CLOCK_MAX_CHARS);
+    uint32_t written = 0;
+
+    int i = 0;
+    while (i < HD44780_CLOCK_MAX_CHARS) {
+        // Past the end of the string, only cells that were drawn need blanking
+        char want = (i < length) ? next[i] : (shown[i] != '\0' ? ' ' : '\0');
+        if (want == '\0' || shown[i] == want) {
+            i++;
+            continue;
+        }
+
+        int start = i;
+        int runLength = 0;
+        while (i < HD44780_CLOCK_MAX_CHARS) {
+            want = (i < length) ? next[i] : (shown[i] != '\0' ? ' ' : '\0');
+            if (want == '\0' || shown[i] == want) {
+                break;
+            }
+            run[runLength++] = want;
+            shown[i++] = want;
+        }
+        run[runLength] = '\0';
+
+        HD44780_setCursorPos(col + start, row);
+        HD44780_print(run);
+        written += runLength;
+    }
+    return written;
+}
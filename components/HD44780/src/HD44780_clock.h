@@ -0,0 +1,61 @@
+/**
+ * File:       HD44780_clock.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Longest date or time string the clock can show, a full row of a 4x20 display
+#define HD44780_CLOCK_MAX_CHARS 20
+
+typedef struct _clockStats {
+    uint32_t renders;
+    // Characters written, and what redrawing both strings every time would have written
+    uint32_t cellsWritten;
+    uint32_t fullRedrawCells;
+    // How long after the second ticked over the display had caught up
+    uint32_t lastLateUs;
+    uint32_t maxLateUs;
+} HD44780_CLOCK_STATS;
+
+typedef struct _clock {
+    int dateCol;
+    int dateRow;
+    const char *dateFormat;
+    int timeCol;
+    int timeRow;
+    const char *timeFormat;
+
+    // What's on the display now, a zero is a cell that hasn't been drawn
+    char shownDate[HD44780_CLOCK_MAX_CHARS];
+    char shownTime[HD44780_CLOCK_MAX_CHARS];
+    // Day the date was last drawn for, -1 until it has been
+    int shownDay;
+
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    HD44780_CLOCK_STATS stats;
+} HD44780_CLOCK;
+
+
+// Public methods designed for the user to call
+void HD44780_clockInit(HD44780_CLOCK *lcdClock, int dateCol, int dateRow, const char *dateFormat, int timeCol,
+                       int timeRow, const char *timeFormat);
+
+esp_err_t HD44780_clockStart(HD44780_CLOCK *lcdClock, UBaseType_t priority, BaseType_t core);
+
+void HD44780_clockRender(HD44780_CLOCK *lcdClock, const struct tm *timeinfo);
+
+// Constants for calculations
+// Wake this long after each second boundary, so the RTC has surely ticked over
+#define HD44780_CLOCK_GUARD_US  200
@@ -0,0 +1,265 @@
+/**
+ * File:       HD44780_widgets.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Widgets for live readouts, bar graphs and fixed width numeric fields.
+ *
+ * A bar moves a pixel column at a time, HD44780_BAR_STEPS steps to a cell,
+ * using partial blocks in CGRAM for the cell at its end and the ROM's full
+ * block for the rest.  A centered bar grows left from its middle with the
+ * right aligned partials and right with the left aligned ones.
+ *
+ * Every widget remembers the value it drew and ignores anything within its
+ * deadband of it, so a reading jittering in its last digit isn't redrawn at
+ * all.  Past that, the new cells are rendered off screen and only the runs
+ * that differ from what's shown are sent, which for a bar that moved a step
+ * is usually one cell.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HD44780.h"
+#include "HD44780_bigdigits.h"
+#include "HD44780_widgets.h"
+
+#define WIDGET_FULL     '\xFF'  // Full block, from the character ROM
+#define WIDGET_EMPTY    ' '
+
+// Partial blocks 1 to 4 columns wide, left aligned then right aligned
+static const uint8_t WIDGET_GLYPH_ROWS[HD44780_WIDGET_GLYPHS] = {
+    0b10000, 0b11000, 0b11100, 0b11110,
+    0b00001, 0b00011, 0b00111, 0b01111,
+};
+
+// 'Private' helpers designed for internal use
+static bool HD44780_WidgetInDeadband(bool drawn, int32_t shownValue, int32_t value, int32_t deadband);
+static void HD44780_WidgetFill(char *cells, int count, int steps, bool fromRight);
+static uint32_t HD44780_WidgetUpdate(int col, int row, char *shown, const char *next, int count);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Uploads the partial blocks to all eight CGRAM slots.  Needed once after
+ * the display is initialized, before any bar is drawn.
+ * NOTE: Overwrites the big digit glyphs, so bars and big text can't be on
+ *       the display at the same time.  Leaves the cursor in CGRAM, so move
+ *       it before printing anything else.
+ */
+void HD44780_widgetLoadGlyphs() {
+    uint8_t glyph[8];
+    for (int i = 0; i < HD44780_WIDGET_GLYPHS; i++) {
+        memset(glyph, WIDGET_GLYPH_ROWS[i], sizeof(glyph));
+        HD44780_createChar(i, glyph);
+    }
+}
+
+/**
+ * Sets up a bar graph.  Nothing is drawn until the first HD44780_barSet.
+ * NOTE: A centered bar should have an even number of cells, so its middle
+ *       falls between two of them.
+ *
+ * @param bar      HD44780_BAR to set up
+ * @param col      Column of its left end
+ * @param row      Row it's on
+ * @param cells    Width in cells, up to HD44780_WIDGET_MAX_CELLS
+ * @param min      Value shown as an empty bar, or a full bar to the left if centered
+ * @param max      Value shown as a full bar
+ * @param centered true for a bar grown out from the middle, for signed values
+ * @param deadband Changes smaller than this aren't drawn, 0 to draw every change
+ */
+void HD44780_barInit(HD44780_BAR *bar, int col, int row, int cells, int32_t min, int32_t max, bool centered,
+                     int32_t deadband) {
+    memset(bar, 0, sizeof(*bar));
+    bar->col = col;
+    bar->row = row;
+    bar->cells = (cells > HD44780_WIDGET_MAX_CELLS) ? HD44780_WIDGET_MAX_CELLS : cells;
+    bar->min = min;
+    bar->max = max;
+    bar->centered = centered;
+    bar->deadband = deadband;
+}
+
+/**
+ * Shows the param value on the bar, clamped to its range.
+ *
+ * @param bar   HD44780_BAR to draw
+ * @param value Value to show
+ */
+void HD44780_barSet(HD44780_BAR *bar, int32_t value) {
+    if (HD44780_WidgetInDeadband(bar->drawn, bar->shownValue, value, bar->deadband)) {
+        return;
+    }
+    int32_t clamped = (value < bar->min) ? bar->min : (value > bar->max) ? bar->max : value;
+    int64_t range = (int64_t) bar->max - bar->min;
+    char next[HD44780_WIDGET_MAX_CELLS];
+
+    if (!bar->centered) {
+        int steps = (range > 0) ? (int) (((int64_t) clamped - bar->min) * bar->cells * HD44780_BAR_STEPS / range) : 0;
+        HD44780_WidgetFill(next, bar->cells, steps, false);
+    } else {
+        // Each half covers half the range, measured from the midpoint
+        int half = bar->cells / 2;
+        int64_t halfRange = range / 2;
+        int64_t offset = ((int64_t) clamped - bar->min) - halfRange;
+        int steps = (halfRange > 0) ? (int) (llabs(offset) * half * HD44780_BAR_STEPS / halfRange) : 0;
+        HD44780_WidgetFill(next, half, (offset < 0) ? steps : 0, true);
+        HD44780_WidgetFill(next + half, bar->cells - half, (offset > 0) ? steps : 0, false);
+    }
+
+    bar->cellsWritten += HD44780_WidgetUpdate(bar->col, bar->row, bar->shown, next, bar->cells);
+    bar->shownValue = value;
+    bar->drawn = true;
+}
+
+/**
+ * Sets up a numeric field.  Nothing is drawn until the first HD44780_fieldSet.
+ *
+ * @param field    HD44780_FIELD to set up
+ * @param col      Column it starts at
+ * @param row      Row it's on
+ * @param width    Cells it covers, up to HD44780_WIDGET_MAX_CELLS
+ * @param label    Character shown before the value, or 0 for none
+ * @param unit     Value steps per whole unit, e.g. 100 for a value in hundredths
+ * @param decimals Decimal places shown, which are truncated rather than rounded
+ * @param deadband Changes smaller than this aren't drawn, 0 to draw every change
+ */
+void HD44780_fieldInit(HD44780_FIELD *field, int col, int row, int width, char label, int32_t unit, int decimals,
+                       int32_t deadband) {
+    memset(field, 0, sizeof(*field));
+    field->col = col;
+    field->row = row;
+    field->width = (width > HD44780_WIDGET_MAX_CELLS) ? HD44780_WIDGET_MAX_CELLS : width;
+    field->label = label;
+    field->unit = (unit > 0) ? unit : 1;
+    field->decimals = decimals;
+    field->deadband = deadband;
+}
+
+/**
+ * Shows the param value in the field, left aligned and padded with spaces to
+ * its full width so nothing from a longer value is left behind.
+ * NOTE: A value too long for the field is cut off at its right edge.
+ *
+ * @param field HD44780_FIELD to draw
+ * @param value Value to show, in steps of 1 / unit
+ */
+void HD44780_fieldSet(HD44780_FIELD *field, int32_t value) {
+    if (HD44780_WidgetInDeadband(field->drawn, field->shownValue, value, field->deadband)) {
+        return;
+    }
+
+    int32_t scale = 1;
+    for (int i = 0; i < field->decimals; i++) {
+        scale *= 10;
+    }
+    int64_t magnitude = llabs((int64_t) value);
+    long whole = (long) (magnitude / field->unit);
+    long fraction = (long) ((magnitude % field->unit) * scale / field->unit);
+    const char *sign = (value < 0) ? "-" : "";
+
+    char text[32];
+    int length = 0;
+    if (field->label != 0) {
+        length = snprintf(text, sizeof(text), "%c:", field->label);
+    }
+    if (field->decimals > 0) {
+        snprintf(text + length, sizeof(text) - length, "%s%ld.%0*ld", sign, whole, field->decimals, fraction);
+    } else {
+        snprintf(text + length, sizeof(text) - length, "%s%ld", sign, whole);
+    }
+
+    char next[HD44780_WIDGET_MAX_CELLS];
+    length = (int) strnlen(text, field->width);
+    memcpy(next, text, length);
+    memset(next + length, ' ', field->width - length);
+
+    field->cellsWritten += HD44780_WidgetUpdate(field->col, field->row, field->shown, next, field->width);
+    field->shownValue = value;
+    field->drawn = true;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns whether the param value is close enough to what's drawn to leave
+ * the widget alone.
+ *
+ * @param drawn      Whether the widget has been drawn yet
+ * @param shownValue Value it was last drawn with
+ * @param value      New value
+ * @param deadband   Smallest change that gets drawn
+ */
+static bool HD44780_WidgetInDeadband(bool drawn, int32_t shownValue, int32_t value, int32_t deadband) {
+    if (!drawn) {
+        return false;
+    }
+    int64_t change = llabs((int64_t) value - shownValue);
+    return change == 0 || change < deadband;
+}
+
+/**
+ * Fills the param cells with a bar the param number of steps long.
+ *
+ * @param cells     Cells to fill
+ * @param count     Number of cells
+ * @param steps     Length of the bar in pixel columns
+ * @param fromRight true to grow the bar from the right hand end
+ */
+static void HD44780_WidgetFill(char *cells, int count, int steps, bool fromRight) {
+    for (int i = 0; i < count; i++) {
+        int cell = fromRight ? count - 1 - i : i;
+        int filled = steps - i * HD44780_BAR_STEPS;
+        if (filled >= HD44780_BAR_STEPS) {
+            cells[cell] = WIDGET_FULL;
+        } else if (filled > 0) {
+            int slot = (fromRight ? HD44780_BAR_STEPS - 1 : 0) + filled - 1;
+            cells[cell] = (char) (HD44780_CGRAM_MIRROR + slot);
+        } else {
+            cells[cell] = WIDGET_EMPTY;
+        }
+    }
+}
+
+/**
+ * Writes each run of cells where the param next cells differ from what's
+ * shown.
+ *
+ * @param col   Column the widget starts at
+ * @param row   Row the widget is on
+ * @param shown Cells shown now, zero where nothing's drawn, updated to match
+ * @param next  Cells to show
+ * @param count Number of cells
+ * @return Number of cells written
+ */
+static uint32_t HD44780_WidgetUpdate(int col, int row, char *shown, const char *next, int count) {
+    char run[HD44780_WIDGET_MAX_CELLS + 1];
+    uint32_t written = 0;
+
+    int i = 0;
+    while (i < count) {
+        if (shown[i] == next[i]) {
+            i++;
+            continue;
+        }
+
+        int start = i;
+        int runLength = 0;
+        while (i < count && shown[i] != next[i]) {
+            run[runLength++] = next[i];
+            shown[i] = next[i];
+            i++;
+        }
+        run[runLength] = '\0';
+
+        HD44780_setCursorPos(col + start, row);
+        HD44780_print(run);
+        written += runLength;
+    }
+    return written;
+}
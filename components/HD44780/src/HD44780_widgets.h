@@ -0,0 +1,70 @@
+/**
+ * File:       HD44780_widgets.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Widest widget, a full row of a 4x20 display
+#define HD44780_WIDGET_MAX_CELLS    20
+
+typedef struct _bar {
+    int col;
+    int row;
+    int cells;
+    int32_t min;
+    int32_t max;
+    // Grows out from the middle, left for values below the midpoint and right above it
+    bool centered;
+    // Changes smaller than this from the drawn value are not drawn
+    int32_t deadband;
+
+    int32_t shownValue;
+    bool drawn;
+    char shown[HD44780_WIDGET_MAX_CELLS];
+    uint32_t cellsWritten;
+} HD44780_BAR;
+
+typedef struct _field {
+    int col;
+    int row;
+    int width;
+    // Printed before the value as "label:", or nothing if zero
+    char label;
+    // Value steps per whole unit, e.g. 1000 for milli-g, and decimal places shown
+    int32_t unit;
+    int decimals;
+    int32_t deadband;
+
+    int32_t shownValue;
+    bool drawn;
+    char shown[HD44780_WIDGET_MAX_CELLS];
+    uint32_t cellsWritten;
+} HD44780_FIELD;
+
+
+// Public methods designed for the user to call
+void HD44780_widgetLoadGlyphs();
+
+void HD44780_barInit(HD44780_BAR *bar, int col, int row, int cells, int32_t min, int32_t max, bool centered,
+                     int32_t deadband);
+
+void HD44780_barSet(HD44780_BAR *bar, int32_t value);
+
+void HD44780_fieldInit(HD44780_FIELD *field, int col, int row, int width, char label, int32_t unit, int decimals,
+                       int32_t deadband);
+
+void HD44780_fieldSet(HD44780_FIELD *field, int32_t value);
+
+// Constants for calculations
+// Pixel columns in a character cell, each one a step of a bar
+#define HD44780_BAR_STEPS       5
+// CGRAM slots 0 to 3 hold left aligned partial blocks one to four columns
+// wide, 4 to 7 the same right aligned
+#define HD44780_WIDGET_GLYPHS   8
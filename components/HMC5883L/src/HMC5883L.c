@@ -0,0 +1,171 @@
+/**
+ * File:       HMC5883L.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "HMC5883L.h"
+
+static const int I2C_TIMEOUT_MS = 50;
+
+// 'Private' helpers designed for internal use
+static esp_err_t HMC5883L_Transfer(HMC5883L_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                              size_t rxLength);
+
+// Identification registers A to C read back "H43"
+static const uint8_t HMC5883L_ID[3] = { 'H', '4', '3' };
+
+// LSB per gauss for each HMC5883L_GAIN setting
+static const int32_t HMC5883L_LSB_PER_GAUSS[8] = { 1370, 1090, 820, 660, 440, 390, 330, 230 };
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the HMC5883L magnetometer on an already registered I2C device
+ * handle.  Verifies the identification registers, applies the output rate,
+ * averaging and gain in the param config, and starts continuous measurement.
+ * NOTE: On a bus created with trans_queue_depth the config's queuedBus must
+ *       be set, or transfers return before they run.
+ *
+ * @param dev    HMC5883L_DEVICE to initialize
+ * @param handle I2C device handle from i2c_master_bus_add_device
+ * @param config HMC5883L_CONFIG to apply to the sensor
+ */
+esp_err_t HMC5883L_init(HMC5883L_DEVICE *dev, i2c_master_dev_handle_t handle, const HMC5883L_CONFIG *config) {
+    memset(dev, 0, sizeof(*dev));
+    dev->handle = handle;
+    dev->config = *config;
+
+    uint8_t id[3];
+    esp_err_t err = HMC5883L_readRegisters(dev, HMC5883L_ID_A, id, sizeof(id));
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (memcmp(id, HMC5883L_ID, sizeof(id)) != 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // CONFIG_A, CONFIG_B and MODE in a single burst, the address auto increments
+    uint8_t writeCmd[4] = {
+        HMC5883L_CONFIG_A,
+        (uint8_t) (((config->averagingLog2 & 0x03) << HMC5883L_AVERAGE_SHIFT) | (config->rate << HMC5883L_RATE_SHIFT)),
+        (uint8_t) (config->gain << HMC5883L_GAIN_SHIFT),
+        HMC5883L_MODE_CONTINUOUS,
+    };
+    err = HMC5883L_Transfer(dev, writeCmd, sizeof(writeCmd), NULL, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    dev->mGaussPerLsbQ8 = (1000 * 256) / HMC5883L_LSB_PER_GAUSS[config->gain & 0x07];
+
+    // The first measurement after a gain change still uses the old gain
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return ESP_OK;
+}
+
+/**
+ * Reads all three axes in a single six byte burst starting at DATA_X_MSB.
+ * NOTE: The device only updates the data registers once all six have been
+ *       read, so a burst also keeps the axes from the same measurement.
+ *
+ * @param dev    HMC5883L_DEVICE to read from
+ * @param sample HMC5883L_SAMPLE to store the raw counts in
+ */
+esp_err_t HMC5883L_readSample(HMC5883L_DEVICE *dev, HMC5883L_SAMPLE *sample) {
+    uint8_t regData[HMC5883L_DATA_BYTES];
+    esp_err_t err = HMC5883L_readRegisters(dev, HMC5883L_DATA_REG, regData, sizeof(regData));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    HMC5883L_unpackSample(regData, sample);
+    return ESP_OK;
+}
+
+/**
+ * Unpacks an HMC5883L_DATA_BYTES burst from HMC5883L_DATA_REG, for callers
+ * that read the registers themselves (e.g. through a bus scheduler).
+ * NOTE: Each value is big endian, and the register order is X, Z, Y.
+ *
+ * @param regData Register bytes starting at DATA_X_MSB
+ * @param sample  HMC5883L_SAMPLE to store the raw counts in
+ */
+void HMC5883L_unpackSample(const uint8_t *regData, HMC5883L_SAMPLE *sample) {
+    sample->x = (int16_t) ((regData[0] << 8) | regData[1]);
+    sample->z = (int16_t) ((regData[2] << 8) | regData[3]);
+    sample->y = (int16_t) ((regData[4] << 8) | regData[5]);
+}
+
+/**
+ * Writes a single byte to the param register.
+ *
+ * @param dev   HMC5883L_DEVICE to write to
+ * @param reg   Register address
+ * @param value Byte to write
+ */
+esp_err_t HMC5883L_writeRegister(HMC5883L_DEVICE *dev, uint8_t reg, uint8_t value) {
+    uint8_t writeCmd[2] = { reg, value };
+    return HMC5883L_Transfer(dev, writeCmd, sizeof(writeCmd), NULL, 0);
+}
+
+/**
+ * Reads the param number of consecutive registers starting at the param
+ * register address.
+ *
+ * @param dev    HMC5883L_DEVICE to read from
+ * @param reg    First register address to read
+ * @param data   Buffer to store the register contents in
+ * @param length Number of registers to read
+ */
+esp_err_t HMC5883L_readRegisters(HMC5883L_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length) {
+    return HMC5883L_Transfer(dev, &reg, 1, data, length);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Makes one transfer, a plain write when rxLength is 0.  On a queued bus the
+ * driver call only queues it, so it runs from the device's own buffers and
+ * is waited for, along with anything queued ahead of it.
+ * NOTE: A queued transfer's result isn't handed back, so the read buffer is
+ *       cleared first and a device that doesn't answer reads as zeros.
+ */
+static esp_err_t HMC5883L_Transfer(HMC5883L_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                              size_t rxLength) {
+    if (dev->config.queuedBus == NULL) {
+        if (rxLength > 0) {
+            return i2c_master_transmit_receive(dev->handle, tx, txLength, rx, rxLength, I2C_TIMEOUT_MS);
+        }
+        return i2c_master_transmit(dev->handle, tx, txLength, I2C_TIMEOUT_MS);
+    }
+    if (txLength > sizeof(dev->tx) || rxLength > sizeof(dev->rx)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // A transfer that timed out earlier may still be using the buffers
+    esp_err_t err = i2c_master_bus_wait_all_done(dev->config.queuedBus, I2C_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    memcpy(dev->tx, tx, txLength);
+    memset(dev->rx, 0, rxLength);
+    if (rxLength > 0) {
+        err = i2c_master_transmit_receive(dev->handle, dev->tx, txLength, dev->rx, rxLength, I2C_TIMEOUT_MS);
+    } else {
+        err = i2c_master_transmit(dev->handle, dev->tx, txLength, I2C_TIMEOUT_MS);
+    }
+    if (err == ESP_OK) {
+        err = i2c_master_bus_wait_all_done(dev->config.queuedBus, I2C_TIMEOUT_MS);
+    }
+    if (err == ESP_OK && rxLength > 0) {
+        memcpy(rx, dev->rx, rxLength);
+    }
+    return err;
+}
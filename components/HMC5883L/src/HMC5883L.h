@@ -0,0 +1,113 @@
+/**
+ * File:       HMC5883L.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+// Longest transfer each way on a queued bus, a whole data burst
+#define HMC5883L_MAX_TRANSFER   6
+
+typedef enum _hmc5883lRate {
+    HMC5883L_RATE_0_75HZ = 0,
+    HMC5883L_RATE_1_5HZ  = 1,
+    HMC5883L_RATE_3HZ    = 2,
+    HMC5883L_RATE_7_5HZ  = 3,
+    HMC5883L_RATE_15HZ   = 4,
+    HMC5883L_RATE_30HZ   = 5,
+    HMC5883L_RATE_75HZ   = 6
+} HMC5883L_RATE;
+
+typedef enum _hmc5883lGain {
+    HMC5883L_GAIN_0_88GA = 0,
+    HMC5883L_GAIN_1_3GA  = 1,
+    HMC5883L_GAIN_1_9GA  = 2,
+    HMC5883L_GAIN_2_5GA  = 3,
+    HMC5883L_GAIN_4_0GA  = 4,
+    HMC5883L_GAIN_4_7GA  = 5,
+    HMC5883L_GAIN_5_6GA  = 6,
+    HMC5883L_GAIN_8_1GA  = 7
+} HMC5883L_GAIN;
+
+typedef struct _hmc5883lSample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} HMC5883L_SAMPLE;
+
+typedef struct _hmc5883lConfig {
+    HMC5883L_RATE rate;
+    HMC5883L_GAIN gain;
+    // log2 of the number of measurements averaged per output, 0-3
+    uint8_t averagingLog2;
+    // Bus the handle is on if it was created with trans_queue_depth, which
+    // queues every transfer, so each one is waited for.  NULL otherwise.
+    i2c_master_bus_handle_t queuedBus;
+} HMC5883L_CONFIG;
+
+typedef struct _hmc5883lDevice {
+    i2c_master_dev_handle_t handle;
+    HMC5883L_CONFIG config;
+    // Milli-gauss per LSB in Q8 fixed point, chosen from the gain at config time
+    int32_t mGaussPerLsbQ8;
+    // A queued transfer runs from these, so it can outlive the call
+    uint8_t tx[HMC5883L_MAX_TRANSFER];
+    uint8_t rx[HMC5883L_MAX_TRANSFER];
+} HMC5883L_DEVICE;
+
+
+// Public methods designed for the user to call
+esp_err_t HMC5883L_init(HMC5883L_DEVICE *dev, i2c_master_dev_handle_t handle, const HMC5883L_CONFIG *config);
+
+esp_err_t HMC5883L_readSample(HMC5883L_DEVICE *dev, HMC5883L_SAMPLE *sample);
+
+void HMC5883L_unpackSample(const uint8_t *regData, HMC5883L_SAMPLE *sample);
+
+esp_err_t HMC5883L_writeRegister(HMC5883L_DEVICE *dev, uint8_t reg, uint8_t value);
+
+esp_err_t HMC5883L_readRegisters(HMC5883L_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length);
+
+/**
+ * Converts a raw count from the param device to milli-gauss using the integer
+ * scale chosen when the gain was configured.
+ *
+ * @param dev HMC5883L_DEVICE the count was read from
+ * @param raw Raw signed count from a DATA register pair
+ */
+static inline int32_t HMC5883L_toMilliGauss(const HMC5883L_DEVICE *dev, int16_t raw) {
+    return (raw * dev->mGaussPerLsbQ8) / 256;
+}
+
+// HMC5883L Register Definitions
+#define HMC5883L_CONFIG_A       0x00
+#define HMC5883L_CONFIG_B       0x01
+#define HMC5883L_MODE           0x02
+#define HMC5883L_DATA_X_MSB     0x03
+#define HMC5883L_DATA_X_LSB     0x04
+#define HMC5883L_DATA_Z_MSB     0x05
+#define HMC5883L_DATA_Z_LSB     0x06
+#define HMC5883L_DATA_Y_MSB     0x07
+#define HMC5883L_DATA_Y_LSB     0x08
+#define HMC5883L_STATUS         0x09
+#define HMC5883L_ID_A           0x0A
+
+// Bitmasks for various registers
+#define HMC5883L_AVERAGE_SHIFT  5
+#define HMC5883L_RATE_SHIFT     2
+#define HMC5883L_GAIN_SHIFT     5
+#define HMC5883L_MODE_CONTINUOUS 0x00
+
+// Constants for calculations
+#define HMC5883L_DEFAULT_ADDR   0x1E
+// DATA_X through DATA_Y in one burst, in X, Z, Y order
+#define HMC5883L_DATA_REG       HMC5883L_DATA_X_MSB
+#define HMC5883L_DATA_BYTES     6
+// Reading reports -4096 on any axis that overflowed the selected range
+#define HMC5883L_OVERFLOW       -4096
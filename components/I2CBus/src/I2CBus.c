@@ -0,0 +1,577 @@
+/**
+ * File:       I2CBus.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * I2C bus scheduler.  Owns the bus handle and runs periodic read jobs for
+ * every device on it from a single task, so that sensors with different
+ * rates share the bus without hand written interleaving.
+ *
+ * Each wake up gathers every job due within batchWindowUs of now and runs
+ * them back to back, highest priority first, then sleeps on a one shot
+ * esp_timer until the next job falls due.  A job that completes later than
+ * its deadline, or that fell so far behind a whole period was skipped, is
+ * counted as a deadline miss.
+ *
+ * Statistics are only written by the scheduler task, and read through a
+ * sequence count rather than a lock, so reading them never holds up a batch.
+ * The SCL speed is fixed when a device is added, so changing it re-adds
+ * every device between two batches.
+ *
+ * A bus created with trans_queue_depth runs every transfer on it from a
+ * queue, for every device, so i2c_master_transmit_receive returns before
+ * the data has landed.  On such a bus each device gets an on_trans_done
+ * callback, and the register read jobs wait on it.  A driver that needs its
+ * own, such as the ADXL345 async transport, replaces it, and its jobs then
+ * need a run hook that waits for themselves.
+ */
+#include <string.h>
+#include "esp_log.h"
+#include "I2CBus.h"
+
+#define I2CBUS_STACK_SIZE   4096
+// Reads of the totals that may overlap an update before backing off
+#define I2CBUS_STATS_SPINS  64
+
+static const char *TAG = "I2CBus";
+
+// 'Private' helpers designed for internal use
+static void I2CBUS_Task(void *arg);
+static void I2CBUS_Wake(void *arg);
+static int I2CBUS_CollectDue(I2CBUS *bus, int64_t nowUs, I2CBUS_JOB **due);
+static void I2CBUS_RunJob(I2CBUS *bus, I2CBUS_JOB *job);
+static int64_t I2CBUS_NextDue(I2CBUS *bus);
+static esp_err_t I2CBUS_ApplySpeed(I2CBUS *bus, uint32_t sclHz);
+static unsigned int I2CBUS_BeginStats(I2CBUS *bus);
+static void I2CBUS_EndStats(I2CBUS *bus, unsigned int sequence);
+static esp_err_t I2CBUS_WatchDevice(I2CBUS *bus, i2c_master_dev_handle_t handle);
+static bool I2CBUS_TransDone(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *event, void *arg);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Creates the I2C master bus the scheduler will own.
+ *
+ * @param bus    I2CBUS to initialise
+ * @param config Bus configuration, as for i2c_new_master_bus
+ */
+esp_err_t I2CBUS_init(I2CBUS *bus, const i2c_master_bus_config_t *config) {
+    memset(bus, 0, sizeof(*bus));
+    bus->batchWindowUs = I2CBUS_DEFAULT_BATCH_US;
+    atomic_init(&bus->requestedHz, 0);
+    atomic_init(&bus->statsSequence, 0);
+
+    esp_timer_create_args_t timerArgs = {
+        .callback = I2CBUS_Wake,
+        .arg = bus,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "i2cbus",
+    };
+    esp_err_t err = esp_timer_create(&timerArgs, &bus->timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = i2c_new_master_bus(config, &bus->handle);
+    if (err == ESP_OK && config->trans_queue_depth > 0) {
+        bus->queued = true;
+        bus->transDone = xSemaphoreCreateBinary();
+        if (bus->transDone == NULL) {
+            i2c_del_master_bus(bus->handle);
+            bus->handle = NULL;
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    if (err != ESP_OK) {
+        esp_timer_delete(bus->timer);
+        bus->timer = NULL;
+    }
+    return err;
+}
+
+/**
+ * Probes for and registers a device on the bus.
+ * NOTE: The handle is replaced if the bus speed is changed, so the param
+ *       pointer must stay valid while the bus runs.  On a queued bus the
+ *       device's on_trans_done callback is taken for the register read jobs.
+ *
+ * @param bus    I2CBUS to add the device to
+ * @param config Device configuration, as for i2c_master_bus_add_device
+ * @param handle Pointer to store the device handle in
+ */
+esp_err_t I2CBUS_addDevice(I2CBUS *bus, const i2c_device_config_t *config, i2c_master_dev_handle_t *handle) {
+    if (bus->numDevices == I2CBUS_MAX_DEVICES) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t err = i2c_master_probe(bus->handle, config->device_address, I2CBUS_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "No device at 0x%02x", config->device_address);
+        return err;
+    }
+    err = i2c_master_bus_add_device(bus->handle, config, handle);
+    if (err == ESP_OK) {
+        err = I2CBUS_WatchDevice(bus, *handle);
+        if (err != ESP_OK) {
+            i2c_master_bus_rm_device(*handle);
+            *handle = NULL;
+        }
+    }
+    if (err == ESP_OK) {
+        bus->devices[bus->numDevices++] = (I2CBUS_DEVICE) { *config, handle };
+    }
+    return err;
+}
+
+/**
+ * Sets up a periodic register read job.  The deadline defaults to the
+ * period, set job->deadlineUs afterwards to tighten it, or job->run to
+ * replace the register read with a custom transfer.
+ *
+ * @param job      I2CBUS_JOB to set up
+ * @param handle   Device handle to read from
+ * @param reg      First register to read
+ * @param data     Buffer the registers are read into, read by the callback
+ * @param length   Number of registers to read
+ * @param periodUs Interval between reads
+ * @param priority Order within a batch, higher runs first
+ * @param callback Called after every run, may be NULL
+ * @param arg      User argument passed to run and the callback
+ */
+void I2CBUS_jobInit(I2CBUS_JOB *job, i2c_master_dev_handle_t handle, uint8_t reg, uint8_t *data, size_t length,
+                    uint32_t periodUs, uint8_t priority, I2CBUS_JOB_CALLBACK callback, void *arg) {
+    memset(job, 0, sizeof(*job));
+    job->handle = handle;
+    job->reg = reg;
+    job->data = data;
+    job->length = length;
+    job->periodUs = periodUs;
+    job->deadlineUs = periodUs;
+    job->priority = priority;
+    job->callback = callback;
+    job->arg = arg;
+}
+
+/**
+ * Adds a job to the schedule.  Must be called before I2CBUS_start.
+ *
+ * @param bus I2CBUS to schedule the job on
+ * @param job I2CBUS_JOB to add, must stay valid while the bus runs
+ */
+esp_err_t I2CBUS_addJob(I2CBUS *bus, I2CBUS_JOB *job) {
+    if (bus->task != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (bus->numJobs == I2CBUS_MAX_JOBS) {
+        return ESP_ERR_NO_MEM;
+    }
+    bus->jobs[bus->numJobs++] = job;
+    return ESP_OK;
+}
+
+/**
+ * Starts the scheduler task.  Every job falls due immediately.
+ *
+ * @param bus      I2CBUS to start
+ * @param priority FreeRTOS priority of the scheduler task
+ * @param core     Core to pin the scheduler task to, or tskNO_AFFINITY
+ */
+esp_err_t I2CBUS_start(I2CBUS *bus, UBaseType_t priority, BaseType_t core) {
+    int64_t now = esp_timer_get_time();
+    for (int i = 0; i < bus->numJobs; i++) {
+        bus->jobs[i]->dueUs = now;
+    }
+    bus->statsStartUs = now;
+
+    if (xTaskCreatePinnedToCore(I2CBUS_Task, "i2cbus", I2CBUS_STACK_SIZE, bus, priority, &bus->task,
+                                core) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * Reads the bus statistics.  Utilization covers the time since the previous
+ * call, the counters are totals.
+ *
+ * @param bus   I2CBUS to read the statistics of
+ * @param stats I2CBUS_STATS to fill
+ */
+void I2CBUS_getStats(I2CBUS *bus, I2CBUS_STATS *stats) {
+    I2CBUS_TOTALS totals;
+    I2CBUS_getTotals(bus, &totals);
+    int64_t elapsed = totals.timestampUs - bus->statsStartUs;
+    uint64_t busy = totals.busyUs - bus->statsBusyUs;
+
+    stats->batches = totals.batches;
+    stats->transactions = totals.transactions;
+    stats->errors = totals.errors;
+    stats->deadlineMisses = totals.deadlineMisses;
+    stats->recoveries = totals.recoveries;
+    stats->utilizationPermille = (elapsed > 0) ? (uint32_t) ((busy * 1000) / elapsed) : 0;
+
+    bus->statsBusyUs = totals.busyUs;
+    bus->statsStartUs = totals.timestampUs;
+}
+
+/**
+ * Takes a consistent snapshot of the running totals, stamped with the time
+ * it was taken.  Never blocks the scheduler task, and doesn't disturb the
+ * utilization I2CBUS_getStats reports, so any number of tasks can use it.
+ *
+ * @param bus    I2CBUS to read the totals of
+ * @param totals I2CBUS_TOTALS to fill
+ */
+void I2CBUS_getTotals(I2CBUS *bus, I2CBUS_TOTALS *totals) {
+    int spins = 0;
+    while (1) {
+        unsigned int sequence = atomic_load_explicit(&bus->statsSequence, memory_order_acquire);
+        if ((sequence & 1) == 0) {
+            *totals = bus->totals;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&bus->statsSequence, memory_order_relaxed) == sequence) {
+                break;
+            }
+        }
+        // An update is a few stores, so one running on the other core is over
+        // within a few retries.  Only if this task preempted it does the
+        // scheduler task need a tick to finish.
+        if (++spins >= I2CBUS_STATS_SPINS) {
+            spins = 0;
+            vTaskDelay(1);
+        }
+    }
+    totals->timestampUs = esp_timer_get_time();
+}
+
+/**
+ * Changes the SCL speed of every device added through I2CBUS_addDevice.
+ * Once the bus is running the change is made by the scheduler task before
+ * its next batch, so no transfer is ever cut short.  Each device is removed
+ * and re-added, the handles given to I2CBUS_addDevice and any job using them
+ * are updated, and onDeviceChanged is called for each so that drivers holding
+ * their own copy can follow.
+ *
+ * @param bus   I2CBUS to change the speed of
+ * @param sclHz New SCL speed, up to I2CBUS_MAX_SCL_HZ
+ */
+esp_err_t I2CBUS_setSpeed(I2CBUS *bus, uint32_t sclHz) {
+    if (sclHz == 0 || sclHz > I2CBUS_MAX_SCL_HZ) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (bus->task == NULL) {
+        return I2CBUS_ApplySpeed(bus, sclHz);
+    }
+
+    atomic_store_explicit(&bus->requestedHz, sclHz, memory_order_relaxed);
+    xTaskNotifyGive(bus->task);
+    return ESP_OK;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Scheduler task.  Runs each batch of due jobs, then sleeps until the next
+ * one falls due.
+ *
+ * @param arg I2CBUS to schedule
+ */
+static void I2CBUS_Task(void *arg) {
+    I2CBUS *bus = (I2CBUS *) arg;
+    I2CBUS_JOB *due[I2CBUS_MAX_JOBS];
+
+    while (1) {
+        uint32_t sclHz = atomic_exchange_explicit(&bus->requestedHz, 0, memory_order_relaxed);
+        if (sclHz != 0) {
+            I2CBUS_ApplySpeed(bus, sclHz);
+        }
+
+        int64_t now = esp_timer_get_time();
+        int numDue = I2CBUS_CollectDue(bus, now, due);
+
+        if (numDue > 0) {
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < numDue; i++) {
+                I2CBUS_RunJob(bus, due[i]);
+            }
+
+            unsigned int sequence = I2CBUS_BeginStats(bus);
+            bus->totals.batches++;
+            bus->totals.busyUs += esp_timer_get_time() - start;
+            I2CBUS_EndStats(bus, sequence);
+        }
+
+        int64_t wait = I2CBUS_NextDue(bus) - esp_timer_get_time();
+        if (wait > 0) {
+            // A speed change can wake us with the timer still armed
+            esp_timer_stop(bus->timer);
+            esp_timer_start_once(bus->timer, (uint64_t) wait);
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+}
+
+/**
+ * esp_timer callback, wakes the scheduler task for the next batch.
+ *
+ * @param arg I2CBUS to wake
+ */
+static void I2CBUS_Wake(void *arg) {
+    I2CBUS *bus = (I2CBUS *) arg;
+    xTaskNotifyGive(bus->task);
+}
+
+/**
+ * Gathers the jobs due within the batch window into the param array, sorted
+ * highest priority first.
+ *
+ * @param bus   I2CBUS to collect from
+ * @param nowUs Current time
+ * @param due   Array of at least I2CBUS_MAX_JOBS to fill
+ * @return Number of jobs collected
+ */
+static int I2CBUS_CollectDue(I2CBUS *bus, int64_t nowUs, I2CBUS_JOB **due) {
+    int count = 0;
+
+    for (int i = 0; i < bus->numJobs; i++) {
+        I2CBUS_JOB *job = bus->jobs[i];
+        if (job->dueUs > nowUs + bus->batchWindowUs) {
+            continue;
+        }
+
+        // Insertion sort, there are only ever a handful of jobs
+        int pos = count++;
+        while (pos > 0 && due[pos - 1]->priority < job->priority) {
+            due[pos] = due[pos - 1];
+            pos--;
+        }
+        due[pos] = job;
+    }
+    return count;
+}
+
+/**
+ * Runs one job, invokes its callback, and moves it on to its next due time.
+ *
+ * @param bus I2CBUS the job is scheduled on
+ * @param job I2CBUS_JOB to run
+ */
+static void I2CBUS_RunJob(I2CBUS *bus, I2CBUS_JOB *job) {
+    esp_err_t err;
+    if (job->handle == NULL) {
+        // Its device was lost in a speed change, the old handle is gone
+        err = ESP_ERR_INVALID_STATE;
+    } else if (job->run != NULL) {
+        err = job->run(job, job->arg);
+    } else {
+        if (bus->queued) {
+            // Drops a completion left by a transfer made outside the scheduler
+            xSemaphoreTake(bus->transDone, 0);
+        }
+        err = i2c_master_transmit_receive(job->handle, &job->reg, 1, job->data, job->length, I2CBUS_TIMEOUT_MS);
+        if (err == ESP_OK && bus->queued) {
+            // Only queued so far, the data hasn't landed until the callback runs
+            if (xSemaphoreTake(bus->transDone, pdMS_TO_TICKS(I2CBUS_TIMEOUT_MS)) == pdTRUE) {
+                err = bus->transResult;
+            } else {
+                err = ESP_ERR_TIMEOUT;
+            }
+        }
+        if (err == ESP_ERR_TIMEOUT) {
+            // Most likely a slave holding SDA low, clock it free so the
+            // other jobs don't all time out behind it.  Jobs with their own
+            // run hook handle recovery themselves.
+            i2c_master_bus_reset(bus->handle);
+            unsigned int sequence = I2CBUS_BeginStats(bus);
+            bus->totals.recoveries++;
+            I2CBUS_EndStats(bus, sequence);
+        }
+    }
+
+    int64_t done = esp_timer_get_time();
+    int64_t latency = done - job->dueUs;
+    uint32_t misses = 0;
+
+    job->runs++;
+    if (latency > 0 && (uint64_t) latency > job->maxLatencyUs) {
+        job->maxLatencyUs = (uint32_t) latency;
+    }
+    if (latency > (int64_t) job->deadlineUs) {
+        misses++;
+    }
+
+    // Stay on the original time grid, skipping (and counting) any periods
+    // that have already gone by entirely
+    job->dueUs += job->periodUs;
+    while (job->dueUs + job->deadlineUs < done) {
+        job->dueUs += job->periodUs;
+        misses++;
+    }
+    job->misses += misses;
+    if (err != ESP_OK) {
+        job->errors++;
+    }
+
+    unsigned int sequence = I2CBUS_BeginStats(bus);
+    bus->totals.transactions++;
+    bus->totals.deadlineMisses += misses;
+    if (err != ESP_OK) {
+        bus->totals.errors++;
+    }
+    I2CBUS_EndStats(bus, sequence);
+
+    if (job->callback != NULL) {
+        job->callback(job, err, job->arg);
+    }
+}
+
+/**
+ * Returns the earliest due time of any job.
+ *
+ * @param bus I2CBUS to search
+ */
+static int64_t I2CBUS_NextDue(I2CBUS *bus) {
+    int64_t next = INT64_MAX;
+    for (int i = 0; i < bus->numJobs; i++) {
+        if (bus->jobs[i]->dueUs < next) {
+            next = bus->jobs[i]->dueUs;
+        }
+    }
+    return next;
+}
+
+/**
+ * Re-adds every device at the param SCL speed, and points the jobs and
+ * handles that used each old handle at its new one.  A device that can't be
+ * re-added at the new speed is put back at its old one.  If even that
+ * fails its handle becomes NULL and its jobs are skipped from then on.
+ *
+ * @param bus   I2CBUS to change the speed of
+ * @param sclHz New SCL speed
+ * @return The first error hit, the remaining devices are still re-added
+ */
+static esp_err_t I2CBUS_ApplySpeed(I2CBUS *bus, uint32_t sclHz) {
+    esp_err_t result = ESP_OK;
+
+    for (int i = 0; i < bus->numDevices; i++) {
+        I2CBUS_DEVICE *device = &bus->devices[i];
+        i2c_master_dev_handle_t oldHandle = *device->handle;
+        i2c_master_dev_handle_t newHandle = NULL;
+        uint32_t oldHz = device->config.scl_speed_hz;
+        if (oldHandle == NULL) {
+            continue;
+        }
+
+        esp_err_t err = i2c_master_bus_rm_device(oldHandle);
+        if (err != ESP_OK) {
+            // Still registered under the old handle, which stays valid
+            ESP_LOGE(TAG, "Removing 0x%02x failed: %s", device->config.device_address, esp_err_to_name(err));
+            if (result == ESP_OK) {
+                result = err;
+            }
+            continue;
+        }
+
+        device->config.scl_speed_hz = sclHz;
+        err = i2c_master_bus_add_device(bus->handle, &device->config, &newHandle);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Re-adding 0x%02x at %lu Hz failed: %s", device->config.device_address,
+                     (unsigned long) sclHz, esp_err_to_name(err));
+            if (result == ESP_OK) {
+                result = err;
+            }
+            device->config.scl_speed_hz = oldHz;
+            if (i2c_master_bus_add_device(bus->handle, &device->config, &newHandle) != ESP_OK) {
+                newHandle = NULL;
+            }
+        }
+
+        *device->handle = newHandle;
+        err = (newHandle != NULL) ? I2CBUS_WatchDevice(bus, newHandle) : ESP_OK;
+        if (err != ESP_OK && result == ESP_OK) {
+            result = err;
+        }
+        for (int j = 0; j < bus->numJobs; j++) {
+            if (bus->jobs[j]->handle == oldHandle) {
+                bus->jobs[j]->handle = newHandle;
+            }
+        }
+        if (bus->onDeviceChanged != NULL) {
+            bus->onDeviceChanged(oldHandle, newHandle, bus->deviceArg);
+        }
+    }
+
+    ESP_LOGI(TAG, "SCL now %lu Hz", (unsigned long) sclHz);
+    return result;
+}
+
+/**
+ * Marks the totals as being updated by the scheduler task.
+ *
+ * @param bus I2CBUS being updated
+ * @return Sequence to hand to I2CBUS_EndStats
+ */
+static unsigned int I2CBUS_BeginStats(I2CBUS *bus) {
+    unsigned int sequence = atomic_load_explicit(&bus->statsSequence, memory_order_relaxed) + 1;
+    atomic_store_explicit(&bus->statsSequence, sequence, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return sequence;
+}
+
+/**
+ * Marks the update begun by I2CBUS_BeginStats as complete.
+ *
+ * @param bus      I2CBUS being updated
+ * @param sequence Sequence I2CBUS_BeginStats returned
+ */
+static void I2CBUS_EndStats(I2CBUS *bus, unsigned int sequence) {
+    atomic_store_explicit(&bus->statsSequence, sequence + 1, memory_order_release);
+}
+
+/**
+ * Registers the completion callback the register read jobs wait on, when
+ * the bus queues its transfers.
+ *
+ * @param bus    I2CBUS the device is on
+ * @param handle Device handle to watch
+ */
+static esp_err_t I2CBUS_WatchDevice(I2CBUS *bus, i2c_master_dev_handle_t handle) {
+    if (!bus->queued) {
+        return ESP_OK;
+    }
+    i2c_master_event_callbacks_t callbacks = {
+        .on_trans_done = I2CBUS_TransDone,
+    };
+    return i2c_master_register_event_callbacks(handle, &callbacks, bus);
+}
+
+/**
+ * I2C driver completion callback, runs in the I2C ISR.  Hands the result to
+ * the job waiting in I2CBUS_RunJob.
+ */
+static bool I2CBUS_TransDone(i2c_master_dev_handle_t handle, const i2c_master_event_data_t *event, void *arg) {
+    I2CBUS *bus = (I2CBUS *) arg;
+    switch (event->event) {
+        case I2C_EVENT_DONE:
+            bus->transResult = ESP_OK;
+            break;
+        case I2C_EVENT_TIMEOUT:
+            bus->transResult = ESP_ERR_TIMEOUT;
+            break;
+        case I2C_EVENT_NACK:
+            bus->transResult = ESP_ERR_INVALID_RESPONSE;
+            break;
+        default:
+            // Progress notifications, the transfer isn't finished yet
+            return false;
+    }
+
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(bus->transDone, &woken);
+    return woken == pdTRUE;
+}
@@ -0,0 +1,139 @@
+/**
+ * File:       I2CBus.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define I2CBUS_MAX_JOBS         8
+#define I2CBUS_MAX_DEVICES      8
+
+typedef struct _i2cBusJob I2CBUS_JOB;
+
+// Replaces the default register read of a job, e.g. for a FIFO drain
+typedef esp_err_t (*I2CBUS_JOB_RUN)(I2CBUS_JOB *job, void *arg);
+
+// Called from the scheduler task once a job has run, with its result
+typedef void (*I2CBUS_JOB_CALLBACK)(I2CBUS_JOB *job, esp_err_t result, void *arg);
+
+// Called from the scheduler task when a device has been re-added under a new
+// handle, for anything other than the jobs that kept a copy of the old one.
+// The new handle is NULL if the device couldn't be re-added at all.
+typedef void (*I2CBUS_DEVICE_CALLBACK)(i2c_master_dev_handle_t oldHandle, i2c_master_dev_handle_t newHandle,
+                                       void *arg);
+
+struct _i2cBusJob {
+    i2c_master_dev_handle_t handle;
+    uint8_t reg;
+    uint8_t *data;
+    size_t length;
+    uint32_t periodUs;
+    // Time after the job falls due by which it must have completed
+    uint32_t deadlineUs;
+    // Higher runs first when several jobs are due together
+    uint8_t priority;
+    I2CBUS_JOB_RUN run;
+    I2CBUS_JOB_CALLBACK callback;
+    void *arg;
+
+    int64_t dueUs;
+    uint32_t runs;
+    uint32_t errors;
+    uint32_t misses;
+    uint32_t maxLatencyUs;
+};
+
+typedef struct _i2cBusStats {
+    uint32_t batches;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t deadlineMisses;
+    uint32_t recoveries;
+    // Bus busy time as a share of elapsed time since the last call, in 0.1%
+    uint32_t utilizationPermille;
+} I2CBUS_STATS;
+
+// Running totals since I2CBUS_start, for callers keeping their own baseline
+typedef struct _i2cBusTotals {
+    uint32_t batches;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t deadlineMisses;
+    uint32_t recoveries;
+    uint64_t busyUs;
+    int64_t timestampUs;
+} I2CBUS_TOTALS;
+
+typedef struct _i2cBusDevice {
+    i2c_device_config_t config;
+    i2c_master_dev_handle_t *handle;
+} I2CBUS_DEVICE;
+
+typedef struct _i2cBus {
+    i2c_master_bus_handle_t handle;
+    I2CBUS_JOB *jobs[I2CBUS_MAX_JOBS];
+    int numJobs;
+    // Jobs due within this long of the earliest are run in the same batch
+    uint32_t batchWindowUs;
+    TaskHandle_t task;
+    esp_timer_handle_t timer;
+
+    I2CBUS_DEVICE devices[I2CBUS_MAX_DEVICES];
+    int numDevices;
+    // SCL speed waiting for the scheduler task to apply it, 0 when none is
+    atomic_uint requestedHz;
+    I2CBUS_DEVICE_CALLBACK onDeviceChanged;
+    void *deviceArg;
+
+    // Set when the bus was created with trans_queue_depth, which queues every
+    // transfer on it, so register reads wait here for their completion
+    bool queued;
+    SemaphoreHandle_t transDone;
+    volatile esp_err_t transResult;
+
+    // Only written by the scheduler task, read through the sequence, which
+    // is odd while an update is under way
+    I2CBUS_TOTALS totals;
+    atomic_uint statsSequence;
+    // Where the previous I2CBUS_getStats call left off
+    uint64_t statsBusyUs;
+    int64_t statsStartUs;
+} I2CBUS;
+
+
+// Public methods designed for the user to call
+esp_err_t I2CBUS_init(I2CBUS *bus, const i2c_master_bus_config_t *config);
+
+esp_err_t I2CBUS_addDevice(I2CBUS *bus, const i2c_device_config_t *config, i2c_master_dev_handle_t *handle);
+
+void I2CBUS_jobInit(I2CBUS_JOB *job, i2c_master_dev_handle_t handle, uint8_t reg, uint8_t *data, size_t length,
+                    uint32_t periodUs, uint8_t priority, I2CBUS_JOB_CALLBACK callback, void *arg);
+
+esp_err_t I2CBUS_addJob(I2CBUS *bus, I2CBUS_JOB *job);
+
+esp_err_t I2CBUS_start(I2CBUS *bus, UBaseType_t priority, BaseType_t core);
+
+void I2CBUS_getStats(I2CBUS *bus, I2CBUS_STATS *stats);
+
+void I2CBUS_getTotals(I2CBUS *bus, I2CBUS_TOTALS *totals);
+
+esp_err_t I2CBUS_setSpeed(I2CBUS *bus, uint32_t sclHz);
+
+// Constants for calculations
+#define I2CBUS_DEFAULT_BATCH_US 500
+#define I2CBUS_TIMEOUT_MS       50
+// Fast mode plus, the fastest the ESP32's I2C controller supports
+#define I2CBUS_MAX_SCL_HZ       1000000
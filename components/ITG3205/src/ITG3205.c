@@ -0,0 +1,167 @@
+/**
+ * File:       ITG3205.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "ITG3205.h"
+
+static const int I2C_TIMEOUT_MS = 50;
+
+// 'Private' helpers designed for internal use
+static esp_err_t ITG3205_Transfer(ITG3205_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                              size_t rxLength);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes the ITG-3205 gyro on an already registered I2C device handle.
+ * Verifies WHO_AM_I, selects the X gyro PLL as the clock, and applies the
+ * lowpass filter and sample rate divider in the param config.
+ * NOTE: FS_SEL must always be set to 3 (+/-2000 degrees/s), other values are
+ *       reserved on this part.  On a bus created with trans_queue_depth the
+ *       config's queuedBus must be set, or transfers return before they run.
+ *
+ * @param dev    ITG3205_DEVICE to initialize
+ * @param handle I2C device handle from i2c_master_bus_add_device
+ * @param config ITG3205_CONFIG to apply to the sensor
+ */
+esp_err_t ITG3205_init(ITG3205_DEVICE *dev, i2c_master_dev_handle_t handle, const ITG3205_CONFIG *config) {
+    memset(dev, 0, sizeof(*dev));
+    dev->handle = handle;
+    dev->config = *config;
+
+    uint8_t id = 0;
+    esp_err_t err = ITG3205_readRegisters(dev, ITG3205_WHO_AM_I, &id, 1);
+    if (err != ESP_OK) {
+        return err;
+    }
+    // The low bit follows the AD0 pin, so 0x68 and 0x69 are both valid
+    if ((id & ITG3205_ID_MASK) != ITG3205_ID_VALUE) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    err = ITG3205_writeRegister(dev, ITG3205_PWR_MGM, ITG3205_CLK_SEL_PLL_X);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = ITG3205_writeRegister(dev, ITG3205_SMPLRT_DIV, config->sampleRateDivider);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = ITG3205_writeRegister(dev, ITG3205_DLPF_FS, ITG3205_FS_SEL_2000DPS | (config->lowpass & ITG3205_DLPF_CFG_MASK));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    // The PLL takes a few milliseconds to settle after switching clock source
+    vTaskDelay(pdMS_TO_TICKS(50));
+    return ESP_OK;
+}
+
+/**
+ * Reads temperature and all three gyro axes in a single burst.
+ *
+ * @param dev    ITG3205_DEVICE to read from
+ * @param sample ITG3205_SAMPLE to store the raw counts in
+ */
+esp_err_t ITG3205_readSample(ITG3205_DEVICE *dev, ITG3205_SAMPLE *sample) {
+    uint8_t regData[ITG3205_DATA_BYTES];
+    esp_err_t err = ITG3205_readRegisters(dev, ITG3205_DATA_REG, regData, sizeof(regData));
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    ITG3205_unpackSample(regData, sample);
+    return ESP_OK;
+}
+
+/**
+ * Unpacks an ITG3205_DATA_BYTES burst from ITG3205_DATA_REG, for callers that
+ * read the registers themselves (e.g. through a bus scheduler).
+ * NOTE: Unlike the ADXL345, each value is big endian.
+ *
+ * @param regData Register bytes starting at TEMP_OUT_H
+ * @param sample  ITG3205_SAMPLE to store the raw counts in
+ */
+void ITG3205_unpackSample(const uint8_t *regData, ITG3205_SAMPLE *sample) {
+    sample->temperature = (int16_t) ((regData[0] << 8) | regData[1]);
+    sample->x = (int16_t) ((regData[2] << 8) | regData[3]);
+    sample->y = (int16_t) ((regData[4] << 8) | regData[5]);
+    sample->z = (int16_t) ((regData[6] << 8) | regData[7]);
+}
+
+/**
+ * Writes a single byte to the param register.
+ *
+ * @param dev   ITG3205_DEVICE to write to
+ * @param reg   Register address
+ * @param value Byte to write
+ */
+esp_err_t ITG3205_writeRegister(ITG3205_DEVICE *dev, uint8_t reg, uint8_t value) {
+    uint8_t writeCmd[2] = { reg, value };
+    return ITG3205_Transfer(dev, writeCmd, sizeof(writeCmd), NULL, 0);
+}
+
+/**
+ * Reads the param number of consecutive registers starting at the param
+ * register address.
+ *
+ * @param dev    ITG3205_DEVICE to read from
+ * @param reg    First register address to read
+ * @param data   Buffer to store the register contents in
+ * @param length Number of registers to read
+ */
+esp_err_t ITG3205_readRegisters(ITG3205_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length) {
+    return ITG3205_Transfer(dev, &reg, 1, data, length);
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Makes one transfer, a plain write when rxLength is 0.  On a queued bus the
+ * driver call only queues it, so it runs from the device's own buffers and
+ * is waited for, along with anything queued ahead of it.
+ * NOTE: A queued transfer's result isn't handed back, so the read buffer is
+ *       cleared first and a device that doesn't answer reads as zeros.
+ */
+static esp_err_t ITG3205_Transfer(ITG3205_DEVICE *dev, const uint8_t *tx, size_t txLength, uint8_t *rx,
+                              size_t rxLength) {
+    if (dev->config.queuedBus == NULL) {
+        if (rxLength > 0) {
+            return i2c_master_transmit_receive(dev->handle, tx, txLength, rx, rxLength, I2C_TIMEOUT_MS);
+        }
+        return i2c_master_transmit(dev->handle, tx, txLength, I2C_TIMEOUT_MS);
+    }
+    if (txLength > sizeof(dev->tx) || rxLength > sizeof(dev->rx)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // A transfer that timed out earlier may still be using the buffers
+    esp_err_t err = i2c_master_bus_wait_all_done(dev->config.queuedBus, I2C_TIMEOUT_MS);
+    if (err != ESP_OK) {
+        return err;
+    }
+    memcpy(dev->tx, tx, txLength);
+    memset(dev->rx, 0, rxLength);
+    if (rxLength > 0) {
+        err = i2c_master_transmit_receive(dev->handle, dev->tx, txLength, dev->rx, rxLength, I2C_TIMEOUT_MS);
+    } else {
+        err = i2c_master_transmit(dev->handle, dev->tx, txLength, I2C_TIMEOUT_MS);
+    }
+    if (err == ESP_OK) {
+        err = i2c_master_bus_wait_all_done(dev->config.queuedBus, I2C_TIMEOUT_MS);
+    }
+    if (err == ESP_OK && rxLength > 0) {
+        memcpy(rx, dev->rx, rxLength);
+    }
+    return err;
+}
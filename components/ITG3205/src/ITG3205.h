@@ -0,0 +1,115 @@
+/**
+ * File:       ITG3205.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "driver/i2c_master.h"
+
+// Gyro scale in milli-degrees/s per LSB, Q8 fixed point
+#define ITG3205_MDPS_PER_LSB_Q8 17809
+// Longest transfer each way on a queued bus, a whole data burst
+#define ITG3205_MAX_TRANSFER    8
+
+typedef enum _itg3205Lowpass {
+    ITG3205_LOWPASS_256HZ = 0,
+    ITG3205_LOWPASS_188HZ = 1,
+    ITG3205_LOWPASS_98HZ  = 2,
+    ITG3205_LOWPASS_42HZ  = 3,
+    ITG3205_LOWPASS_20HZ  = 4,
+    ITG3205_LOWPASS_10HZ  = 5,
+    ITG3205_LOWPASS_5HZ   = 6
+} ITG3205_LOWPASS;
+
+typedef struct _itg3205Sample {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    int16_t temperature;
+} ITG3205_SAMPLE;
+
+typedef struct _itg3205Config {
+    ITG3205_LOWPASS lowpass;
+    // Output rate is the internal rate (8 kHz at 256 Hz lowpass, 1 kHz
+    // otherwise) divided by sampleRateDivider + 1
+    uint8_t sampleRateDivider;
+    // Bus the handle is on if it was created with trans_queue_depth, which
+    // queues every transfer, so each one is waited for.  NULL otherwise.
+    i2c_master_bus_handle_t queuedBus;
+} ITG3205_CONFIG;
+
+typedef struct _itg3205Device {
+    i2c_master_dev_handle_t handle;
+    ITG3205_CONFIG config;
+    // A queued transfer runs from these, so it can outlive the call
+    uint8_t tx[ITG3205_MAX_TRANSFER];
+    uint8_t rx[ITG3205_MAX_TRANSFER];
+} ITG3205_DEVICE;
+
+
+// Public methods designed for the user to call
+esp_err_t ITG3205_init(ITG3205_DEVICE *dev, i2c_master_dev_handle_t handle, const ITG3205_CONFIG *config);
+
+esp_err_t ITG3205_readSample(ITG3205_DEVICE *dev, ITG3205_SAMPLE *sample);
+
+void ITG3205_unpackSample(const uint8_t *regData, ITG3205_SAMPLE *sample);
+
+esp_err_t ITG3205_writeRegister(ITG3205_DEVICE *dev, uint8_t reg, uint8_t value);
+
+esp_err_t ITG3205_readRegisters(ITG3205_DEVICE *dev, uint8_t reg, uint8_t *data, size_t length);
+
+/**
+ * Converts a raw gyro count to milli-degrees per second.
+ * NOTE: Sensitivity is 14.375 LSB per degree/s, or 69.565 mdps/LSB.
+ *
+ * @param raw Raw signed count from a GYRO_xOUT register pair
+ */
+static inline int32_t ITG3205_toMilliDps(int16_t raw) {
+    return (raw * ITG3205_MDPS_PER_LSB_Q8) / 256;
+}
+
+/**
+ * Converts a raw temperature count to hundredths of a degree C.
+ * NOTE: 280 LSB/C, with -13200 counts at 35C.
+ *
+ * @param raw Raw signed count from the TEMP_OUT register pair
+ */
+static inline int32_t ITG3205_toCentiC(int16_t raw) {
+    return 3500 + ((raw + 13200) * 100) / 280;
+}
+
+// ITG3205 Register Definitions
+#define ITG3205_WHO_AM_I        0x00
+#define ITG3205_SMPLRT_DIV      0x15
+#define ITG3205_DLPF_FS         0x16
+#define ITG3205_INT_CFG         0x17
+#define ITG3205_INT_STATUS      0x1A
+#define ITG3205_TEMP_OUT_H      0x1B
+#define ITG3205_TEMP_OUT_L      0x1C
+#define ITG3205_GYRO_XOUT_H     0x1D
+#define ITG3205_GYRO_XOUT_L     0x1E
+#define ITG3205_GYRO_YOUT_H     0x1F
+#define ITG3205_GYRO_YOUT_L     0x20
+#define ITG3205_GYRO_ZOUT_H     0x21
+#define ITG3205_GYRO_ZOUT_L     0x22
+#define ITG3205_PWR_MGM         0x3E
+
+// Bitmasks for various registers
+#define ITG3205_ID_MASK         0x7E
+#define ITG3205_FS_SEL_2000DPS  0x18
+#define ITG3205_DLPF_CFG_MASK   0x07
+#define ITG3205_CLK_SEL_PLL_X   0x01
+#define ITG3205_H_RESET         0x80
+
+// Constants for calculations
+#define ITG3205_DEFAULT_ADDR    0x68
+#define ITG3205_ID_VALUE        0x68
+// TEMP_OUT through GYRO_ZOUT in one burst
+#define ITG3205_DATA_REG        ITG3205_TEMP_OUT_H
+#define ITG3205_DATA_BYTES      8
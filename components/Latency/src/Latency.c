@@ -0,0 +1,175 @@
+/**
+ * File:       Latency.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Latency and jitter histograms, cheap enough to leave running.  Buckets are
+ * log-linear, exact up to LATENCY_LINEAR_US and then eight to each doubling,
+ * so a percentile is never more than 12.5% above the true value however
+ * wide the range.  Everything here is compiled out when
+ * CONFIG_LATENCY_INSTRUMENTATION is off.
+ */
+#include "Latency.h"
+
+#if LATENCY_ENABLED
+
+// 'Private' helpers designed for internal use
+static int LATENCY_Bucket(uint32_t us);
+static uint32_t LATENCY_Percentile(const uint32_t *counts, uint32_t total, uint32_t permille, uint32_t maxUs);
+
+// 'Public' functions, designed for use by the main application
+
+/**
+ * Initializes an empty histogram.
+ *
+ * @param histogram LATENCY_HISTOGRAM to initialize
+ * @param name      Name to report it under, must outlive the histogram
+ */
+void LATENCY_init(LATENCY_HISTOGRAM *histogram, const char *name) {
+    histogram->name = name;
+    LATENCY_reset(histogram);
+}
+
+/**
+ * Records one duration.  Safe from any task or ISR, and never blocks.
+ * Durations past the last bucket are counted in it, and still reach the max.
+ *
+ * @param histogram LATENCY_HISTOGRAM to record into
+ * @param us        Duration in microseconds
+ */
+void LATENCY_record(LATENCY_HISTOGRAM *histogram, uint32_t us) {
+    atomic_fetch_add_explicit(&histogram->buckets[LATENCY_Bucket(us)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+
+    unsigned max = atomic_load_explicit(&histogram->maxUs, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak_explicit(&histogram->maxUs, &max, us, memory_order_relaxed,
+                                                              memory_order_relaxed)) {
+    }
+}
+
+/**
+ * Initializes an interval tracker for a source expected every param nominal
+ * period.
+ *
+ * @param interval  LATENCY_INTERVAL to initialize
+ * @param name      Name to report the intervals under, the jitter histogram shares it
+ * @param nominalUs Expected time between events
+ */
+void LATENCY_intervalInit(LATENCY_INTERVAL *interval, const char *name, uint32_t nominalUs) {
+    LATENCY_init(&interval->intervals, name);
+    LATENCY_init(&interval->jitter, name);
+    interval->nominalUs = nominalUs;
+    interval->lastUs = 0;
+}
+
+/**
+ * Marks one event, recording the time since the last one and its distance
+ * from the nominal period.  Only one task may mark a given interval.
+ *
+ * @param interval LATENCY_INTERVAL to mark
+ * @param nowUs    Time of the event, from LATENCY_nowUs
+ */
+void LATENCY_intervalMark(LATENCY_INTERVAL *interval, int64_t nowUs) {
+    if (interval->lastUs != 0 && nowUs > interval->lastUs) {
+        int64_t elapsed = nowUs - interval->lastUs;
+        uint32_t us = (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t) elapsed;
+        LATENCY_record(&interval->intervals, us);
+        LATENCY_record(&interval->jitter, (us > interval->nominalUs) ? us - interval->nominalUs :
+                                                                       interval->nominalUs - us);
+    }
+    interval->lastUs = nowUs;
+}
+
+/**
+ * Summarizes the histogram while it's still being recorded into.  Each
+ * percentile is the top of the bucket it falls in, capped at the max.
+ * NOTE: Records landing mid-read may be missed from this summary, never
+ *       from the histogram.
+ *
+ * @param histogram LATENCY_HISTOGRAM to summarize
+ * @param summary   LATENCY_SUMMARY to fill in
+ */
+void LATENCY_summarize(LATENCY_HISTOGRAM *histogram, LATENCY_SUMMARY *summary) {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint32_t total = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        total += counts[i];
+    }
+
+    summary->count = total;
+    summary->maxUs = atomic_load_explicit(&histogram->maxUs, memory_order_relaxed);
+    summary->p50Us = LATENCY_Percentile(counts, total, 500, summary->maxUs);
+    summary->p90Us = LATENCY_Percentile(counts, total, 900, summary->maxUs);
+    summary->p99Us = LATENCY_Percentile(counts, total, 990, summary->maxUs);
+}
+
+/**
+ * Empties the histogram.
+ * NOTE: Records made while it's being cleared may survive it.
+ *
+ * @param histogram LATENCY_HISTOGRAM to reset
+ */
+void LATENCY_reset(LATENCY_HISTOGRAM *histogram) {
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+    }
+    atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->maxUs, 0, memory_order_relaxed);
+}
+
+/**
+ * Returns the largest duration the param bucket holds, for printing the
+ * histogram itself.  The last bucket also holds everything longer.
+ *
+ * @param bucket Bucket index, 0 to LATENCY_BUCKETS - 1
+ */
+uint32_t LATENCY_bucketUpperUs(int bucket) {
+    if (bucket < LATENCY_LINEAR_US) {
+        return bucket;
+    }
+    int octave = (bucket - LATENCY_LINEAR_US) / LATENCY_SUB_BUCKETS;
+    int sub = (bucket - LATENCY_LINEAR_US) % LATENCY_SUB_BUCKETS;
+    // LATENCY_LINEAR_US is 2 ^ 4 and each octave is split in 2 ^ 3
+    uint32_t width = 1u << (octave + 1);
+    return ((uint32_t) (LATENCY_SUB_BUCKETS + sub) << (octave + 1)) + width - 1;
+}
+
+
+// 'Private' functions designed for internal use
+
+/**
+ * Returns the bucket a duration falls in.  Past LATENCY_LINEAR_US the top
+ * set bit picks the octave and the three bits below it the sub-bucket.
+ */
+static int LATENCY_Bucket(uint32_t us) {
+    if (us < LATENCY_LINEAR_US) {
+        return (int) us;
+    }
+    int top = 31 - __builtin_clz(us);
+    int bucket = LATENCY_LINEAR_US + (top - 4) * LATENCY_SUB_BUCKETS + (int) ((us >> (top - 3)) & 7);
+    return (bucket < LATENCY_BUCKETS) ? bucket : LATENCY_BUCKETS - 1;
+}
+
+static uint32_t LATENCY_Percentile(const uint32_t *counts, uint32_t total, uint32_t permille, uint32_t maxUs) {
+    if (total == 0) {
+        return 0;
+    }
+    // The rank of the percentile, rounded up so p99 of 100 records is the 99th
+    uint32_t rank = (uint32_t) (((uint64_t) total * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            uint32_t upper = LATENCY_bucketUpperUs(i);
+            return (upper < maxUs) ? upper : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * File:       Latency.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+// On unless the project configuration turns it off, always on off target
+#if !defined(ESP_PLATFORM) || defined(CONFIG_LATENCY_INSTRUMENTATION)
+#define LATENCY_ENABLED         1
+#else
+#define LATENCY_ENABLED         0
+#endif
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+// Exact below LATENCY_LINEAR_US, then eight buckets per doubling up to about a second
+#define LATENCY_LINEAR_US       16
+#define LATENCY_SUB_BUCKETS     8
+#define LATENCY_BUCKETS         (LATENCY_LINEAR_US + 16 * LATENCY_SUB_BUCKETS)
+
+typedef struct _latencySummary {
+    uint32_t count;
+    uint32_t p50Us;
+    uint32_t p90Us;
+    uint32_t p99Us;
+    uint32_t maxUs;
+} LATENCY_SUMMARY;
+
+#if LATENCY_ENABLED
+
+/**
+ * Fixed bucket histogram of durations in microseconds.  Any number of tasks
+ * or ISRs can record into it at once, each record being a few relaxed atomic
+ * adds, and it can be read at any time without stopping them.
+ */
+typedef struct _latencyHistogram {
+    const char *name;
+    atomic_uint buckets[LATENCY_BUCKETS];
+    atomic_uint count;
+    atomic_uint maxUs;
+} LATENCY_HISTOGRAM;
+
+// Intervals between the events of one periodic source, and how far each
+// strays from the nominal period.  Marked by a single producer.
+typedef struct _latencyInterval {
+    LATENCY_HISTOGRAM intervals;
+    LATENCY_HISTOGRAM jitter;
+    uint32_t nominalUs;
+    int64_t lastUs;
+} LATENCY_INTERVAL;
+
+#else
+
+// Compiled out, the collectors keep their names but hold nothing
+typedef struct _latencyHistogram {
+    const char *name;
+} LATENCY_HISTOGRAM;
+
+typedef struct _latencyInterval {
+    LATENCY_HISTOGRAM intervals;
+    LATENCY_HISTOGRAM jitter;
+} LATENCY_INTERVAL;
+
+#endif
+
+
+// Public methods designed for the user to call
+#if LATENCY_ENABLED
+
+void LATENCY_init(LATENCY_HISTOGRAM *histogram, const char *name);
+
+void LATENCY_record(LATENCY_HISTOGRAM *histogram, uint32_t us);
+
+void LATENCY_intervalInit(LATENCY_INTERVAL *interval, const char *name, uint32_t nominalUs);
+
+void LATENCY_intervalMark(LATENCY_INTERVAL *interval, int64_t nowUs);
+
+void LATENCY_summarize(LATENCY_HISTOGRAM *histogram, LATENCY_SUMMARY *summary);
+
+void LATENCY_reset(LATENCY_HISTOGRAM *histogram);
+
+uint32_t LATENCY_bucketUpperUs(int bucket);
+
+#else
+
+static inline void LATENCY_init(LATENCY_HISTOGRAM *histogram, const char *name) { histogram->name = name; }
+static inline void LATENCY_record(LATENCY_HISTOGRAM *histogram, uint32_t us) {}
+static inline void LATENCY_intervalInit(LATENCY_INTERVAL *interval, const char *name, uint32_t nominalUs) {}
+static inline void LATENCY_intervalMark(LATENCY_INTERVAL *interval, int64_t nowUs) {}
+static inline void LATENCY_summarize(LATENCY_HISTOGRAM *histogram, LATENCY_SUMMARY *summary) {
+    *summary = (LATENCY_SUMMARY) { 0 };
+}
+static inline void LATENCY_reset(LATENCY_HISTOGRAM *histogram) {}
+
+#endif
+
+/**
+ * Timestamp for the collectors, in microseconds from an arbitrary start.
+ * The esp_timer clock on ESP-IDF, including its Linux target, and the
+ * monotonic clock on any other host.  Free when compiled out.
+ */
+static inline int64_t LATENCY_nowUs(void) {
+#if !LATENCY_ENABLED
+    return 0;
+#elif defined(ESP_PLATFORM)
+    return esp_timer_get_time();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#endif
+}
+
+/**
+ * Records the time since the param start timestamp, taken with LATENCY_nowUs.
+ */
+static inline void LATENCY_since(LATENCY_HISTOGRAM *histogram, int64_t startUs) {
+#if LATENCY_ENABLED
+    int64_t elapsed = LATENCY_nowUs() - startUs;
+    if (elapsed < 0) {
+        elapsed = 0;
+    } else if (elapsed > UINT32_MAX) {
+        elapsed = UINT32_MAX;
+    }
+    LATENCY_record(histogram, (uint32_t) elapsed);
+#endif
+}
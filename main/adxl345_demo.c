@@ -7,22 +7,64 @@
  */
 
 #include <stdio.h>
+#include <stdatomic.h>
 #include "HD44780.h"
+#include "HD44780_widgets.h"
+#include "ADXL345.h"
+#include "ADXL345_filter.h"
+#include "ADXL345_orientation.h"
+#include "ADXL345_ring.h"
+#include "ADXL345_power.h"
+#include "ADXL345_i2c.h"
+#include "ADXL345_stream.h"
+#include "ADXL345_stream_uart.h"
+#include "ADXL345_logger.h"
+#include "ITG3205.h"
+#include "HMC5883L.h"
+#include "I2CBus.h"
+#include "Fusion.h"
+#include "Latency.h"
+#include "perf_console.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_spiffs.h"
 #include "driver/i2c_master.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 #define I2C_MASTER_SCL_IO    22    // GPIO 22 for I2C SCL
 #define I2C_MASTER_SDA_IO    21    // GPIO 21 for I2C SDA
 
-#define ADXL345_SENSOR_ADDR  0x53  // I2C address for ADXL345 accelerometer on GY85 9-DOF module 
-#define ADXL345_POW_CTL_REG  0x2D  // AXDL345 Power Control Register (sensor comes up in sleep mode, set to monitor)
-#define ADXL345_DATAX0       0x32  // X-Axis Data 0
-#define ADXL345_DATAX1       0x33  // X-Axis Data 1
-#define ADXL345_DATAY0       0x34  // Y-Axis Data 0
-#define ADXL345_DATAY1       0x35  // Y-Axis Data 1
-#define ADXL345_DATAZ0       0x36  // Z-Axis Data 0
-#define ADXL345_DATAZ1       0x37  // Z-Axis Data 1
+#define TELEMETRY_UART       UART_NUM_1
+#define TELEMETRY_TX_IO      4     // GPIO 4 for telemetry UART TX
+
+#define ADXL345_SENSOR_ADDR  ADXL345_DEFAULT_ADDR   // I2C address for ADXL345 accelerometer on GY85 9-DOF module
+#define ITG3205_SENSOR_ADDR  ITG3205_DEFAULT_ADDR   // I2C address for ITG3205 gyro on GY85 9-DOF module
+#define HMC5883L_SENSOR_ADDR HMC5883L_DEFAULT_ADDR  // I2C address for HMC5883L magnetometer on GY85 9-DOF module
+
+#define ACQUIRE_TASK_CORE    1     // Sampling runs on the APP core, the display stays on the PRO core with app_main
+#define ACQUIRE_TASK_PRIO    5
+#define FUSION_TASK_PRIO     4     // Below the bus task, so fusion never delays a read
+#define TELEMETRY_TASK_CORE  0     // Telemetry is sent from the PRO core, away from sampling
+#define TELEMETRY_TASK_PRIO  3
+#define LOGGER_TASK_CORE     0     // Flash writes happen on the PRO core too
+#define LOGGER_TASK_PRIO     2
+
+// Sample log on the "storage" SPIFFS partition, see partitions.csv
+#define LOG_PARTITION        "storage"
+#define LOG_MOUNT_POINT      "/log"
+#define LOG_PATH             LOG_MOUNT_POINT "/accel.log"
+
+// Bus scheduler periods for each sensor
+#define ACCEL_BLOCK_SAMPLES  8       // Samples per accelerometer drain while active
+#define ACCEL_PERIOD_US      80000   // Eight samples at 100 Hz, fresh enough to steer the fusion filter
+#define ACCEL_IDLE_PERIOD_US 320000  // Four samples at the 12.5 Hz idle rate, while the board is still
+#define GYRO_PERIOD_US       10000   // Every sample at the 100 Hz gyro rate
+#define MAG_PERIOD_US        66667   // Every sample at the 15 Hz magnetometer rate
+
+#define ACCEL_CHECK_RUNS     64      // Accel drains between checks that the sensor hasn't reset itself
+#define GYRO_BIAS_SAMPLES    64      // At rest gyro samples averaged into the bias at startup
+#define MILLI_DPS_TO_RAD_S   (3.14159265f / 180000.0f)
 
 // Global variable definition
 i2c_master_bus_config_t i2cConfig = {
@@ -30,6 +72,10 @@ i2c_master_bus_config_t i2cConfig = {
     .scl_io_num = I2C_MASTER_SCL_IO,
     .sda_io_num = I2C_MASTER_SDA_IO,
     .glitch_ignore_cnt = 7,
+    // Queued transfers, so FIFO drains run without the CPU waiting on the bus.
+    // This queues every device's transfers, so the gyro and magnetometer
+    // drivers and the scheduler's register reads wait for theirs to land.
+    .trans_queue_depth = ADXL345_I2C_QUEUE_DEPTH,
     .flags.enable_internal_pullup = true,
 };
 
@@ -39,8 +85,94 @@ i2c_device_config_t adxl345Config = {
     .scl_speed_hz = 100000,
 };
 
-i2c_master_bus_handle_t i2cBusHandle;
+i2c_device_config_t itg3205Config = {
+    .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+    .device_address = ITG3205_SENSOR_ADDR,
+    .scl_speed_hz = 100000,
+};
+
+i2c_device_config_t hmc5883lConfig = {
+    .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+    .device_address = HMC5883L_SENSOR_ADDR,
+    .scl_speed_hz = 100000,
+};
+
+ADXL345_CONFIG accelConfig = {
+    .range = ADXL345_RANGE_2G,
+    .fullResolution = true,
+    .bwRate = ADXL345_RATE_100HZ,
+};
+
+ITG3205_CONFIG gyroConfig = {
+    .lowpass = ITG3205_LOWPASS_42HZ,
+    .sampleRateDivider = 9,    // 1 kHz / (9 + 1) = 100 Hz
+};
+
+HMC5883L_CONFIG magConfig = {
+    .rate = HMC5883L_RATE_15HZ,
+    .gain = HMC5883L_GAIN_1_3GA,
+    .averagingLog2 = 3,
+};
+
+I2CBUS i2cBus;
 i2c_master_dev_handle_t adxlSensorHandle;
+i2c_master_dev_handle_t itgSensorHandle;
+i2c_master_dev_handle_t hmcSensorHandle;
+ADXL345_I2C_ASYNC accelI2c;
+ADXL345_DEVICE accel;
+ADXL345_FIFO_READ accelFifoRead;
+ADXL345_FILTER_PIPELINE accelFilter;
+ADXL345_RING accelRing;
+ADXL345_POWER accelPower;
+ITG3205_DEVICE gyro;
+HMC5883L_DEVICE mag;
+
+I2CBUS_JOB accelJob;
+I2CBUS_JOB gyroJob;
+I2CBUS_JOB magJob;
+uint8_t gyroData[ITG3205_DATA_BYTES];
+uint8_t magData[HMC5883L_DATA_BYTES];
+ITG3205_SAMPLE gyroSample;
+// Gyro bias, accumulated over the first GYRO_BIAS_SAMPLES reads
+int32_t gyroBiasSum[3];
+int gyroBiasCount;
+// Newest accelerometer and magnetometer readings, only touched by the bus task
+ADXL345_SAMPLE latestAccel;
+HMC5883L_SAMPLE latestMag;
+bool haveAccel;
+bool haveMag;
+FUSION fusion;
+ADXL345_STREAM telemetry;
+ADXL345_LOGGER accelLog;
+// Copy of the last block drained, appended to the telemetry and the log while
+// the next drain is on the bus.  Copied before it's published, as the display
+// task filters the ring slot in place once it has it.
+ADXL345_BLOCK accelPendingBlock;
+bool accelPending;
+int64_t accelPendingUs;
+uint8_t accelPendingRate;
+
+// Only written by the bus task, and read one word at a time by the console
+uint32_t accelSamples;
+uint32_t accelFifoFull;
+// BW_RATE rate code the console has asked for, or -1 when none is pending
+atomic_int accelRequestedRate = -1;
+
+// How long each stage from sensor to display takes, and how regular sampling is
+LATENCY_HISTOGRAM accelReadLatency;
+LATENCY_HISTOGRAM accelProcessLatency;
+LATENCY_HISTOGRAM displayLatency;
+LATENCY_HISTOGRAM displayAge;
+LATENCY_INTERVAL accelInterval;
+LATENCY_INTERVAL gyroInterval;
+
+// Readout on the display, pitch and roll on the top row, total g and heading underneath
+HD44780_FIELD pitchField;
+HD44780_FIELD rollField;
+HD44780_FIELD gField;
+HD44780_FIELD headingField;
+
+static const char *TAG = "adxl345_demo";
 
 static uint32_t ONE_HUNDRED_MILLI_DELAY = (100 / portTICK_PERIOD_MS);
 static uint32_t TWO_HUNDRED_FIFTY_MILLI_DELAY = (250 / portTICK_PERIOD_MS);
@@ -48,9 +180,27 @@ static uint32_t TWO_HUNDRED_FIFTY_MILLI_DELAY = (250 / portTICK_PERIOD_MS);
 // Function predefinition
 void setup_i2c();
 void setup_accel_sensor();
-void read_x_axis();
-void read_y_axis();
-void read_z_axis();
+void setup_gyro_sensor();
+void setup_mag_sensor();
+void setup_bus_jobs();
+void setup_latency();
+void setup_telemetry();
+void setup_logger();
+void setup_power();
+void setup_console();
+void accel_power_changed(ADXL345_POWER_STATE state, void *arg);
+esp_err_t accel_request_rate(uint8_t rateCode);
+void accel_apply_rate(uint8_t rateCode);
+void i2c_device_changed(i2c_master_dev_handle_t oldHandle, i2c_master_dev_handle_t newHandle, void *arg);
+esp_err_t accel_job(I2CBUS_JOB *job, void *arg);
+void accel_append_pending();
+void gyro_job_done(I2CBUS_JOB *job, esp_err_t result, void *arg);
+void mag_job_done(I2CBUS_JOB *job, esp_err_t result, void *arg);
+void report_bus_stats();
+void report_latency_stats();
+void warn_on_error(esp_err_t err, const char *what);
+void read_accel();
+void setup_readout();
 
 /**
  * Main function
@@ -60,126 +210,594 @@ void app_main() {
     HD44780_FOUR_BIT_BUS bus = { 2, 16, 25, 26, 27, 32, 17, 19 };
     HD44780_initFourBitBus(&bus);
     HD44780_clear();
+    setup_readout();
 
     setup_i2c();
     setup_accel_sensor();
+    setup_gyro_sensor();
+    setup_mag_sensor();
 
     vTaskDelay(ONE_HUNDRED_MILLI_DELAY);
 
+    // Sampling gets its own core, so the slow display path below can't
+    // throttle it.  The bus scheduler reads every sensor at its own rate,
+    // and accelerometer blocks reach us through the ring without being copied.
+    ADXL345_ringInit(&accelRing);
+    // Attitude fusion shares the sampling core, fed by each gyro read
+    ESP_ERROR_CHECK(FUSION_start(&fusion, FUSION_DEFAULT_BETA, FUSION_TASK_PRIO, ACQUIRE_TASK_CORE));
+    setup_latency();
+    setup_telemetry();
+    setup_logger();
+    setup_bus_jobs();
+    setup_power();
+    ESP_ERROR_CHECK(I2CBUS_start(&i2cBus, ACQUIRE_TASK_PRIO, ACQUIRE_TASK_CORE));
+    setup_console();
+
+    int loops = 0;
     while (1) {
-        read_x_axis();
-        read_y_axis();
-        read_z_axis();
+        read_accel();
+        // Roughly every ten seconds
+        if (++loops % 40 == 0) {
+            report_bus_stats();
+            report_latency_stats();
+        }
         vTaskDelay(TWO_HUNDRED_FIFTY_MILLI_DELAY);
     }
 }
 
 /**
- * Initializes the I2C bus using the global I2C config
+ * Initializes the I2C bus using the global I2C config, owned by the bus
+ * scheduler, and registers all three GY85 sensors on it.
  * NOTE: GPIO 21 and 22 are the standard pins for I2C SDA 
  *       and SCL respectively.
  */
 void setup_i2c() {
-    // Step 1: Define the I2C bus configuration, and run i2c_new_master_bus to get an I2C Bus Handle
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2cConfig, &i2cBusHandle));
+    // Step 1: Define the I2C bus configuration, and hand it to the bus scheduler to create the I2C Bus Handle
+    ESP_ERROR_CHECK(I2CBUS_init(&i2cBus, &i2cConfig));
 
-    // Step 2 (Optional): Probe the expected I2C slave devices to verify that the I2C bus handle/wiring is working
-    ESP_ERROR_CHECK(i2c_master_probe(i2cBusHandle, ADXL345_SENSOR_ADDR, -1));
-
-    // Step 3: Setup I2C device configs for each slave device, and run i2c_master_bus_add_device to get I2C slave
-    //         device handles for each slave device.  This is what you'll primarily use to talk to the device.
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2cBusHandle, &adxl345Config, &adxlSensorHandle));
+    // Step 2: Setup I2C device configs for each slave device, and register them through the scheduler, which
+    //         probes each one first to verify that the wiring is working.  The device handles are what you'll
+    //         primarily use to talk to the devices.
+    ESP_ERROR_CHECK(I2CBUS_addDevice(&i2cBus, &adxl345Config, &adxlSensorHandle));
+    ESP_ERROR_CHECK(I2CBUS_addDevice(&i2cBus, &itg3205Config, &itgSensorHandle));
+    ESP_ERROR_CHECK(I2CBUS_addDevice(&i2cBus, &hmc5883lConfig, &hmcSensorHandle));
+    // The drivers keep their own copy of each handle, which changes with the bus speed
+    i2cBus.onDeviceChanged = i2c_device_changed;
 }
 
 /**
  * Sets up the ADXL345 accelerometer sensor
- * NOTE: The sensor powers on in "sleep mode" so this function is simply
- *       setting the deivce into "measure mode" via the POWER_CTL register
+ * NOTE: The sensor powers on in "sleep mode", ADXL345_init sets the data format
+ *       and rate from the global accel config and then puts the device into
+ *       "measure mode" via the POWER_CTL register.  Calibration assumes the
+ *       board is lying flat and still when the demo starts.
+ *
+ *       A sensor that doesn't answer here isn't fatal, the driver keeps its
+ *       configuration and brings the sensor up on a later access.
  */
 void setup_accel_sensor() {
-    uint8_t monitor_cmd[2] = {ADXL345_POW_CTL_REG, 0x08};
-    ESP_ERROR_CHECK(i2c_master_transmit(adxlSensorHandle, monitor_cmd, 2, -1));
+    ADXL345_TRANSPORT transport;
+    ESP_ERROR_CHECK(ADXL345_i2cAsyncTransport(&transport, &accelI2c, i2cBus.handle, adxlSensorHandle));
+    esp_err_t err = ADXL345_initTransport(&accel, &transport, &accelConfig);
+    warn_on_error(err, "ADXL345 init");
+    if (err == ESP_OK) {
+        warn_on_error(ADXL345_calibrate(&accel, 32), "ADXL345 calibration");
+    }
+
+    // Buffer samples in the sensor's FIFO between display updates, and smooth
+    // them with a 5 Hz low-pass so the display isn't showing a single raw sample.
+    warn_on_error(ADXL345_setFifoMode(&accel, ADXL345_FIFO_STREAM, 0), "ADXL345 FIFO setup");
+    ESP_ERROR_CHECK(ADXL345_fifoReadInit(&accelFifoRead));
+    ADXL345_pipelineInit(&accelFilter);
+    ADXL345_biquadLowPass(&accelFilter.biquads[0], 100.0f, 5.0f);
+    accelFilter.numBiquads = 1;
 }
 
 /**
- * Reads the two x-axis accelerometer registers, converts the contents to a signed
- * integer, and writes the contents to the HD44780 display.
+ * Sets up the ITG3205 gyro at 100 Hz with a 42 Hz lowpass.
  */
-void read_x_axis() {
-    // Double write both X registers, indicating we want to read both X registers.
-    uint8_t x_axis_reg[2] = {ADXL345_DATAX0, ADXL345_DATAX1};
-    ESP_ERROR_CHECK(i2c_master_transmit(adxlSensorHandle, x_axis_reg, 2, -1));
+void setup_gyro_sensor() {
+    gyroConfig.queuedBus = i2cBus.handle;
+    warn_on_error(ITG3205_init(&gyro, itgSensorHandle, &gyroConfig), "ITG3205 init");
+}
 
-    // Read both X registers
-    uint8_t reg_data[2];
-    ESP_ERROR_CHECK(i2c_master_receive(adxlSensorHandle, reg_data, 2, -1));
+/**
+ * Sets up the HMC5883L magnetometer, continuously measuring at 15 Hz.
+ */
+void setup_mag_sensor() {
+    magConfig.queuedBus = i2cBus.handle;
+    warn_on_error(HMC5883L_init(&mag, hmcSensorHandle, &magConfig), "HMC5883L init");
+}
 
-    // Result is a signed 16 bit number, but is stored as two uint_8t
-    // We need to push them into one 'unsigned' 16 bit integer, and then
-    // do signed/unsigned conversion to correctly show +/- 0.
-    unsigned int uns_result = (reg_data[1] << 8) | reg_data[0];
-    int result = (int16_t) uns_result;
+/**
+ * Registers a read job for each sensor with the bus scheduler.  The gyro
+ * has the tightest deadline, so it goes first whenever reads coincide.
+ */
+void setup_bus_jobs() {
+    I2CBUS_jobInit(&accelJob, adxlSensorHandle, 0, NULL, 0, ACCEL_PERIOD_US, 1, NULL, NULL);
+    accelJob.run = accel_job;
+    I2CBUS_jobInit(&gyroJob, itgSensorHandle, ITG3205_DATA_REG, gyroData, sizeof(gyroData), GYRO_PERIOD_US, 2,
+                   gyro_job_done, NULL);
+    I2CBUS_jobInit(&magJob, hmcSensorHandle, HMC5883L_DATA_REG, magData, sizeof(magData), MAG_PERIOD_US, 0,
+                   mag_job_done, NULL);
 
-    // Blank out the last two digits in case it spilled over
-    HD44780_setCursorPos(6, 0);
-    HD44780_print("  ");
-    
-    HD44780_homeCursor();
-    char xAxis[10];
-    sprintf(xAxis, "x:%.02f", result / 256.0);
-    HD44780_print(xAxis);
+    ESP_ERROR_CHECK(I2CBUS_addJob(&i2cBus, &accelJob));
+    ESP_ERROR_CHECK(I2CBUS_addJob(&i2cBus, &gyroJob));
+    ESP_ERROR_CHECK(I2CBUS_addJob(&i2cBus, &magJob));
 }
 
 /**
- * Reads the two y-axis accelerometer registers, converts the contents to a signed
- * integer, and writes the contents to the HD44780 display.
+ * Sets up the readout fields.  Angles are in hundredths of a degree shown to
+ * one decimal place, and total acceleration in milli-g shown to two.  Each
+ * deadband is two of the last digits shown, so sensor noise flickering that
+ * digit doesn't cost a display write.
  */
-void read_y_axis() {
-    uint8_t y_axis_reg[2] = {ADXL345_DATAY0, ADXL345_DATAY1};
-    ESP_ERROR_CHECK(i2c_master_transmit(adxlSensorHandle, y_axis_reg, 2, -1));
+void setup_readout() {
+    HD44780_fieldInit(&pitchField, 0, 0, 8, 'P', 100, 1, 20);
+    HD44780_fieldInit(&rollField, 8, 0, 8, 'R', 100, 1, 20);
+    HD44780_fieldInit(&gField, 0, 1, 8, 'g', 1000, 2, 20);
+    HD44780_fieldInit(&headingField, 8, 1, 8, 'H', 100, 1, 20);
+}
 
-    uint8_t reg_data[2];
-    ESP_ERROR_CHECK(i2c_master_receive(adxlSensorHandle, reg_data, 2, -1));
+/**
+ * Sets up the latency histograms.  Reading the accelerometer is timer driven
+ * here, so its read latency runs from the bus job falling due rather than
+ * from an interrupt.  The display age is how old the newest reading is when
+ * it reaches the screen, give or take one sample period for the time it sat
+ * in the FIFO.
+ */
+void setup_latency() {
+    LATENCY_init(&accelReadLatency, "accel due to read");
+    LATENCY_init(&accelProcessLatency, "accel read to filtered");
+    LATENCY_init(&displayLatency, "filtered to display");
+    LATENCY_init(&displayAge, "display age");
+    LATENCY_intervalInit(&accelInterval, "accel drain", ACCEL_PERIOD_US);
+    LATENCY_intervalInit(&gyroInterval, "gyro sample", GYRO_PERIOD_US);
+}
 
-    // Result is a signed 16 bit number, but is stored as two uint_8t
-    // We need to push them into one 'unsigned' 16 bit integer, and then
-    // do signed/unsigned conversion to correctly show +/- 0.
-    unsigned int uns_result = (reg_data[1] << 8) | reg_data[0];
-    int result = (int16_t) uns_result;
+/**
+ * Streams every accelerometer block out of the telemetry UART, COBS framed
+ * with sequence numbers, timestamps and a CRC, for a host to log or plot.
+ * Telemetry is optional, so failing to set it up isn't fatal.
+ * NOTE: GPIO 4 carries the stream at 2 Mbaud, wire it to a USB serial
+ *       adapter's RX pin.
+ */
+void setup_telemetry() {
+    esp_err_t err = ADXL345_streamUartInit(TELEMETRY_UART, TELEMETRY_TX_IO, ADXL345_STREAM_UART_BAUD);
+    if (err == ESP_OK) {
+        err = ADXL345_streamStart(&telemetry, ADXL345_streamUartWriter, (void *) (intptr_t) TELEMETRY_UART,
+                                  accelConfig.bwRate, TELEMETRY_TASK_PRIO, TELEMETRY_TASK_CORE);
+    }
+    warn_on_error(err, "Telemetry setup");
+}
 
-    // Blank out the last two digits in case it spilled over
-    HD44780_setCursorPos(14, 0);
-    HD44780_print("  ");
+/**
+ * Logs every accelerometer block to flash, compressed, on the storage
+ * partition's SPIFFS.  The log is appended to across restarts, and can be
+ * pulled off with the partition and decoded by tools/adxl345_log_decode.c.
+ * Logging is optional, so failing to set it up isn't fatal.
+ * NOTE: Once the partition is full every page write fails and is counted,
+ *       delete the log to start a new one.
+ */
+void setup_logger() {
+    esp_vfs_spiffs_conf_t conf = {
+        .base_path = LOG_MOUNT_POINT,
+        .partition_label = LOG_PARTITION,
+        .max_files = 2,
+        .format_if_mount_failed = true,
+    };
+    esp_err_t err = esp_vfs_spiffs_register(&conf);
+    if (err == ESP_OK) {
+        err = ADXL345_loggerStart(&accelLog, LOG_PATH, accelConfig.bwRate & ADXL345_RATE_MASK, LOGGER_TASK_PRIO,
+                                  LOGGER_TASK_CORE);
+    }
+    warn_on_error(err, "Sample log setup");
+}
 
-    HD44780_setCursorPos(8, 0);
-    char yAxis[10];
-    sprintf(yAxis, "y:%.02f", result / 256.0);
-    HD44780_print(yAxis);
+/**
+ * Drops the accelerometer to 12.5 Hz in low power mode once the board has
+ * been still for five seconds, and back to 100 Hz as soon as it moves.  The
+ * bus job already drains the FIFO, so the manager is polled from it rather
+ * than given the INT pin, and it only changes the rate and the job period.
+ * NOTE: Automatic light sleep would also stop the APB clock the telemetry
+ *       UART runs from, so the host stays awake here.  The power manager
+ *       example shows the interrupt driven version.
+ */
+void setup_power() {
+    ADXL345_POWER_CONFIG config;
+    ADXL345_powerConfigInit(&config);
+    config.activeRate = accelConfig.bwRate;
+    warn_on_error(ADXL345_powerInit(&accelPower, &accel, &config, NULL, accel_power_changed, NULL),
+                  "ADXL345 power manager");
 }
 
 /**
- * Reads the two z-axis accelerometer registers, converts the contents to a signed
- * integer, and writes the contents to the HD44780 display.
+ * Starts the performance console on the default UART.  Typing "help" lists
+ * its commands, which print and reset the display, bus and accelerometer
+ * statistics, and change the display timing, data rate and bus speed.  The
+ * demo runs on without it, so failing to start it isn't fatal.
  */
-void read_z_axis() {
-    uint8_t z_axis_reg[2] = {ADXL345_DATAZ0, ADXL345_DATAZ1};
-    ESP_ERROR_CHECK(i2c_master_transmit(adxlSensorHandle, z_axis_reg, 2, -1));
+void setup_console() {
+    static LATENCY_HISTOGRAM *stages[] = { &accelReadLatency, &accelProcessLatency, &displayLatency, &displayAge };
+    static LATENCY_INTERVAL *intervals[] = { &accelInterval, &gyroInterval };
+
+    PERF_CONSOLE_SOURCES sources = {
+        .bus = &i2cBus,
+        .accel = &accel,
+        .ring = &accelRing,
+        .samples = &accelSamples,
+        .fifoFull = &accelFifoFull,
+        .stages = stages,
+        .numStages = sizeof(stages) / sizeof(stages[0]),
+        .intervals = intervals,
+        .numIntervals = sizeof(intervals) / sizeof(intervals[0]),
+        .setRate = accel_request_rate,
+    };
+    warn_on_error(perf_console_start(&sources), "Performance console");
+}
 
-    uint8_t reg_data[2];
-    ESP_ERROR_CHECK(i2c_master_receive(adxlSensorHandle, reg_data, 2, -1));
+/**
+ * Power manager callback, runs in the bus task.  Stretches the accelerometer
+ * job to match the sensor's rate.
+ * NOTE: The display's 5 Hz low-pass was designed for 100 Hz, so while idle
+ *       its cutoff drops to well under 1 Hz, which is fine for a board that
+ *       isn't moving.  It isn't redesigned for rates set from the console
+ *       either, its cutoff scales with the rate.
+ */
+void accel_power_changed(ADXL345_POWER_STATE state, void *arg) {
+    if (state == ADXL345_POWER_ACTIVE) {
+        accelJob.periodUs = ACCEL_BLOCK_SAMPLES * ADXL345_samplePeriodUs(accel.config.bwRate);
+    } else {
+        accelJob.periodUs = ACCEL_IDLE_PERIOD_US;
+    }
+    ESP_LOGI(TAG, "ADXL345 %s", (state == ADXL345_POWER_ACTIVE) ? "active" : "idle");
+}
 
-    // Result is a signed 16 bit number, but is stored as two uint_8t
-    // We need to push them into one 'unsigned' 16 bit integer, and then
-    // do signed/unsigned conversion to correctly show +/- 0.
-    unsigned int uns_result = (reg_data[1] << 8) | reg_data[0];
-    int result = (int16_t) uns_result;
+/**
+ * Console callback, hands a new data rate to the bus task, which owns the
+ * sensor.  It's applied before the next FIFO drain.
+ *
+ * @param rateCode BW_RATE rate code to switch to
+ */
+esp_err_t accel_request_rate(uint8_t rateCode) {
+    atomic_store(&accelRequestedRate, rateCode & ADXL345_RATE_MASK);
+    return ESP_OK;
+}
+
+/**
+ * Switches the accelerometer's active rate, from the bus task.  While the
+ * power manager has the sensor idle, the new rate takes over on the next wake.
+ *
+ * @param rateCode BW_RATE rate code to switch to
+ */
+void accel_apply_rate(uint8_t rateCode) {
+    bool active = true;
+    if (accelPower.lock != NULL) {
+        accelPower.config.activeRate = rateCode;
+        active = (accelPower.state == ADXL345_POWER_ACTIVE);
+    }
+    if (active) {
+        warn_on_error(ADXL345_setRate(&accel, rateCode), "ADXL345 rate change");
+        accel_power_changed(ADXL345_POWER_ACTIVE, NULL);
+    }
+}
+
+/**
+ * Bus scheduler callback, runs in the bus task after a device has been
+ * re-added for a new bus speed.  The jobs have already moved over.
+ *
+ * @param oldHandle Handle the device had
+ * @param newHandle Handle it has now
+ * @param arg       Unused
+ */
+void i2c_device_changed(i2c_master_dev_handle_t oldHandle, i2c_master_dev_handle_t newHandle, void *arg) {
+    if (oldHandle == accelI2c.handle) {
+        warn_on_error(ADXL345_i2cAsyncRebind(&accelI2c, newHandle), "ADXL345 rebind");
+    } else if (oldHandle == gyro.handle) {
+        gyro.handle = newHandle;
+    } else if (oldHandle == mag.handle) {
+        mag.handle = newHandle;
+    }
+}
+
+/**
+ * Accelerometer bus job, drains the FIFO straight into a ring slot and
+ * publishes it for the display loop on the other core.  The bursts are
+ * queued on the bus, and while they run the previous block goes to the
+ * telemetry and the log, then the bus task sleeps until they land.
+ * Every so often it also checks that the sensor hasn't browned out and lost
+ * its configuration, which wouldn't show up as a bus error.  Once the FIFO
+ * is empty it lets the power manager change the rate if it needs to.  A
+ * rate asked for from the console is put in place here too.
+ *
+ * @param job I2CBUS_JOB being run
+ * @param arg Unused
+ */
+esp_err_t accel_job(I2CBUS_JOB *job, void *arg) {
+    static uint32_t reportedOverruns = 0;
+    static uint32_t seenReinits = 0;
+
+    int rateCode = atomic_exchange(&accelRequestedRate, -1);
+    if (rateCode >= 0) {
+        accel_apply_rate((uint8_t) rateCode);
+    }
+
+    if (job->runs % ACCEL_CHECK_RUNS == 0) {
+        ADXL345_checkConfig(&accel);
+        // A re-init only restores the basic configuration, not activity detection
+        if (accel.health.reinits != seenReinits && accelPower.lock != NULL) {
+            seenReinits = accel.health.reinits;
+            ADXL345_powerRestore(&accelPower);
+        }
+    }
+
+    ADXL345_BLOCK *block = ADXL345_ringAcquire(&accelRing);
+    if (block == NULL) {
+        accel_append_pending();
+        if (accelRing.overruns != reportedOverruns) {
+            reportedOverruns = accelRing.overruns;
+            ESP_LOGW(TAG, "Sample ring overrun (%lu total, high water %lu)", (unsigned long) reportedOverruns,
+                     (unsigned long) accelRing.highWater);
+        }
+        return ESP_OK;
+    }
+
+    LATENCY_intervalMark(&accelInterval, LATENCY_nowUs());
+    esp_err_t err = ADXL345_readFifoStart(&accel, &accelFifoRead);
+    accel_append_pending();
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = ADXL345_readFifoFinish(&accel, &accelFifoRead, block);
+    if (err == ESP_OK && block->count > 0) {
+        int newest = block->count - 1;
+        latestAccel = (ADXL345_SAMPLE) { block->x[newest], block->y[newest], block->z[newest] };
+        haveAccel = true;
+        accelSamples += block->count;
+        if (block->count == ADXL345_FIFO_DEPTH) {
+            accelFifoFull++;
+        }
+        LATENCY_since(&accelReadLatency, job->dueUs);
+        // Stamped with when the read finished, the newest sample is about that old
+        int64_t readUs = esp_timer_get_time();
+        accelPendingBlock = *block;
+        accelPending = true;
+        accelPendingUs = readUs - (int64_t) newest * ADXL345_samplePeriodUs(accel.config.bwRate);
+        accelPendingRate = accel.config.bwRate & ADXL345_RATE_MASK;
+        ADXL345_ringPublish(&accelRing, readUs);
+    }
+    if (err == ESP_OK && accelPower.lock != NULL) {
+        ADXL345_powerService(&accelPower, job->dueUs);
+    }
+    return err;
+}
+
+/**
+ * Appends the last block drained to the telemetry stream and the sample log,
+ * with the rate it was captured at, if it hasn't been already.
+ */
+void accel_append_pending() {
+    if (!accelPending) {
+        return;
+    }
+    if (telemetry.sender != NULL) {
+        telemetry.rateCode = accelPendingRate;
+        ADXL345_streamAppend(&telemetry, &accelPendingBlock, accelPendingUs);
+    }
+    if (accelLog.writer != NULL) {
+        accelLog.rateCode = accelPendingRate;
+        ADXL345_loggerAppend(&accelLog, &accelPendingBlock, accelPendingUs);
+    }
+    accelPending = false;
+}
+
+/**
+ * Gyro bus job completion.  The first few samples are averaged into the gyro
+ * bias, after that each sample is paired with the newest accelerometer and
+ * magnetometer readings and handed to the fusion task.
+ * NOTE: Like the accelerometer calibration, the bias assumes the board is
+ *       still when the demo starts.
+ *
+ * @param job    I2CBUS_JOB that ran
+ * @param result Result of the register read
+ * @param arg    Unused
+ */
+void gyro_job_done(I2CBUS_JOB *job, esp_err_t result, void *arg) {
+    if (result != ESP_OK) {
+        return;
+    }
+    LATENCY_intervalMark(&gyroInterval, LATENCY_nowUs());
+    ITG3205_unpackSample(gyroData, &gyroSample);
+
+    if (gyroBiasCount < GYRO_BIAS_SAMPLES) {
+        gyroBiasSum[0] += gyroSample.x;
+        gyroBiasSum[1] += gyroSample.y;
+        gyroBiasSum[2] += gyroSample.z;
+        gyroBiasCount++;
+        return;
+    }
+    if (!haveAccel) {
+        return;
+    }
+
+    FUSION_INPUT input = {
+        .timestampUs = esp_timer_get_time(),
+        .gyro = {
+            ITG3205_toMilliDps(gyroSample.x - gyroBiasSum[0] / GYRO_BIAS_SAMPLES) * MILLI_DPS_TO_RAD_S,
+            ITG3205_toMilliDps(gyroSample.y - gyroBiasSum[1] / GYRO_BIAS_SAMPLES) * MILLI_DPS_TO_RAD_S,
+            ITG3205_toMilliDps(gyroSample.z - gyroBiasSum[2] / GYRO_BIAS_SAMPLES) * MILLI_DPS_TO_RAD_S,
+        },
+        .accel = { latestAccel.x, latestAccel.y, latestAccel.z },
+        .mag = { latestMag.x, latestMag.y, latestMag.z },
+        .magValid = haveMag,
+    };
+    FUSION_push(&fusion, &input);
+}
+
+/**
+ * Magnetometer bus job completion, keeps the newest reading for the fusion
+ * task, which turns it into a tilt compensated heading.
+ *
+ * @param job    I2CBUS_JOB that ran
+ * @param result Result of the register read
+ * @param arg    Unused
+ */
+void mag_job_done(I2CBUS_JOB *job, esp_err_t result, void *arg) {
+    if (result != ESP_OK) {
+        return;
+    }
+
+    HMC5883L_SAMPLE sample;
+    HMC5883L_unpackSample(magData, &sample);
+    if (sample.x == HMC5883L_OVERFLOW || sample.y == HMC5883L_OVERFLOW) {
+        return;
+    }
+
+    latestMag = sample;
+    haveMag = true;
+}
+
+/**
+ * Logs the bus scheduler's utilization and deadline statistics.
+ */
+void report_bus_stats() {
+    I2CBUS_STATS stats;
+    I2CBUS_getStats(&i2cBus, &stats);
+    ESP_LOGI(TAG, "I2C bus %lu.%lu%% busy, %lu transactions in %lu batches, %lu deadline misses, %lu errors, "
+             "%lu recoveries", (unsigned long) (stats.utilizationPermille / 10),
+             (unsigned long) (stats.utilizationPermille % 10), (unsigned long) stats.transactions,
+             (unsigned long) stats.batches, (unsigned long) stats.deadlineMisses, (unsigned long) stats.errors,
+             (unsigned long) stats.recoveries);
+
+    // Written by the bus task, a torn read only makes a log line slightly off
+    ADXL345_HEALTH health = accel.health;
+    if (health.errors > 0) {
+        ESP_LOGW(TAG, "ADXL345 %lu errors (%lu timeouts, %lu NACKs), %lu retries, %lu failed, %lu recoveries, "
+                 "%lu re-inits", (unsigned long) health.errors, (unsigned long) health.timeouts,
+                 (unsigned long) health.nacks, (unsigned long) health.retries, (unsigned long) health.failures,
+                 (unsigned long) health.recoveries, (unsigned long) health.reinits);
+    }
+
+    if (accelPower.lock != NULL) {
+        ADXL345_POWER_STATS power;
+        ADXL345_powerGetStats(&accelPower, &power);
+        uint64_t totalUs = power.activeUs + power.idleUs;
+        ESP_LOGI(TAG, "ADXL345 %lu wakes, %lu sleeps, %lu%% idle, %llu uJ, %lu samples/J",
+                 (unsigned long) power.wakes, (unsigned long) power.sleeps,
+                 (unsigned long) (totalUs ? power.idleUs * 100 / totalUs : 0), (unsigned long long) power.sensorUj,
+                 (unsigned long) power.samplesPerJoule);
+    }
+
+    ADXL345_STREAM_STATS telemetryStats = telemetry.stats;
+    if (telemetry.sender != NULL) {
+        ESP_LOGI(TAG, "Telemetry %lu frames, %llu bytes sent, %lu frames dropped, %lu write errors",
+                 (unsigned long) telemetryStats.framesSent, (unsigned long long) telemetryStats.bytesSent,
+                 (unsigned long) telemetryStats.framesDropped, (unsigned long) telemetryStats.writeErrors);
+    }
+
+    ADXL345_LOGGER_STATS logStats = accelLog.stats;
+    if (accelLog.writer != NULL) {
+        ESP_LOGI(TAG, "Sample log %lu samples in %lu pages, %llu:%llu bytes, %lu dropped, %lu write errors",
+                 (unsigned long) logStats.samplesLogged, (unsigned long) logStats.pagesWritten,
+                 (unsigned long long) logStats.rawBytes, (unsigned long long) logStats.encodedBytes,
+                 (unsigned long) logStats.samplesDropped, (unsigned long) logStats.writeErrors);
+    }
+}
+
+/**
+ * Logs the percentiles of each latency histogram, and the intervals and
+ * jitter of the sampling.  Logs nothing with the instrumentation compiled out.
+ */
+void report_latency_stats() {
+    LATENCY_HISTOGRAM *stages[] = { &accelReadLatency, &accelProcessLatency, &displayLatency, &displayAge };
+    LATENCY_SUMMARY summary;
+
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++) {
+        LATENCY_summarize(stages[i], &summary);
+        if (summary.count > 0) {
+            ESP_LOGI(TAG, "Latency %s: p50 %lu us, p90 %lu us, p99 %lu us, max %lu us", stages[i]->name,
+                     (unsigned long) summary.p50Us, (unsigned long) summary.p90Us, (unsigned long) summary.p99Us,
+                     (unsigned long) summary.maxUs);
+        }
+    }
+
+    LATENCY_INTERVAL *intervals[] = { &accelInterval, &gyroInterval };
+    for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++) {
+        LATENCY_SUMMARY jitter;
+        LATENCY_summarize(&intervals[i]->intervals, &summary);
+        LATENCY_summarize(&intervals[i]->jitter, &jitter);
+        if (summary.count > 0) {
+            ESP_LOGI(TAG, "Interval %s: p50 %lu us, max %lu us, jitter p99 %lu us, max %lu us",
+                     intervals[i]->intervals.name, (unsigned long) summary.p50Us, (unsigned long) summary.maxUs,
+                     (unsigned long) jitter.p99Us, (unsigned long) jitter.maxUs);
+        }
+    }
+}
+
+/**
+ * Logs a warning if the param sensor call failed.  Used in place of
+ * ESP_ERROR_CHECK for anything the drivers can recover from later, so that
+ * a sensor that's slow to come up doesn't reboot the board.
+ *
+ * @param err  Result of the call
+ * @param what Description of the call for the log
+ */
+void warn_on_error(esp_err_t err, const char *what) {
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "%s failed: %s", what, esp_err_to_name(err));
+    }
+}
+
+/**
+ * Runs every block waiting in the sample ring through the filter pipeline,
+ * and writes the fused pitch, roll and heading, along with the total
+ * acceleration of the newest filtered sample, to the HD44780 display.
+ */
+void read_accel() {
+    ADXL345_SAMPLE sample;
+    bool haveSample = false;
+    int64_t readUs;
+    int64_t sampleReadUs = 0;
+
+    ADXL345_BLOCK *block;
+    while ((block = ADXL345_ringPeek(&accelRing, &readUs)) != NULL) {
+        // The slot is ours until released, so filter it in place
+        ADXL345_pipelineProcess(&accelFilter, block);
+        LATENCY_since(&accelProcessLatency, readUs);
+
+        int newest = block->count - 1;
+        if (newest >= 0) {
+            sample = (ADXL345_SAMPLE) { block->x[newest], block->y[newest], block->z[newest] };
+            sampleReadUs = readUs;
+            haveSample = true;
+        }
+        ADXL345_ringRelease(&accelRing);
+    }
+    if (!haveSample) {
+        return;
+    }
+    int64_t filteredUs = LATENCY_nowUs();
+
+    ADXL345_ORIENTATION orientation;
+    ADXL345_orientationFromSample(&sample, &orientation);
+
+    // Until the fusion task has run, fall back on the accelerometer alone
+    FUSION_ATTITUDE attitude;
+    FUSION_getAttitude(&fusion, &attitude);
+    int32_t roll = orientation.roll;
+    int32_t pitch = orientation.pitch;
+    int32_t heading = 0;
+    if (attitude.updates > 0) {
+        FUSION_toEulerCentideg(&attitude.q, &roll, &pitch, &heading);
+    }
 
-    // Blank out the last two digits in case it spilled over
-    HD44780_setCursorPos(6, 1);
-    HD44780_print("  ");
+    // Only readings that moved past their deadband reach the display
+    HD44780_fieldSet(&pitchField, pitch);
+    HD44780_fieldSet(&rollField, roll);
+    HD44780_fieldSet(&gField, ADXL345_toMilliG(&accel, orientation.magnitude));
+    HD44780_fieldSet(&headingField, heading);
 
-    HD44780_setCursorPos(0, 1);
-    char zAxis[10];
-    sprintf(zAxis, "z:%.02f", result / 256.0);
-    HD44780_print(zAxis);
+    // The HD44780 latches each character as it's written, so it's on screen now
+    LATENCY_since(&displayLatency, filteredUs);
+    LATENCY_since(&displayAge, sampleReadUs);
 }
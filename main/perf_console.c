@@ -0,0 +1,348 @@
+/**
+ * File:       perf_console.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Performance console.  Serial commands that print and reset the live
+ * statistics of the display, the I2C bus and the accelerometer, and that
+ * change the display timing, the sensor's data rate and the bus speed while
+ * the demo runs.
+ *
+ * Nothing here takes a lock the sampling or display paths use.  Counters
+ * are read through each driver's lock free snapshot, or one word at a time,
+ * and resetting them records a baseline to report from rather than writing
+ * to them, so querying costs the hot paths nothing.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_console.h"
+#include "esp_timer.h"
+#include "HD44780.h"
+#include "perf_console.h"
+
+// Slowest rate the odr command accepts, in BW_RATE rate code
+#define PERF_CONSOLE_MIN_RATE   0x06
+
+typedef struct _perfConsoleBaseline {
+    I2CBUS_TOTALS bus;
+    ADXL345_HEALTH health;
+    uint32_t overruns;
+    uint32_t fifoFull;
+    uint32_t samples;
+} PERF_CONSOLE_BASELINE;
+
+static PERF_CONSOLE_SOURCES sources;
+static PERF_CONSOLE_BASELINE baseline;
+
+static const char *API_NAMES[HD44780_API_COUNT] = {
+    "print", "setCursorPos", "clear", "createChar", "writeChar", "other",
+};
+static const char *PROFILE_NAMES[] = { "standard", "fast", "safe" };
+
+// Function predefinition
+static int stats_command(int argc, char **argv);
+static int stats_reset_command(int argc, char **argv);
+static int lcd_timing_command(int argc, char **argv);
+static int odr_command(int argc, char **argv);
+static int i2c_speed_command(int argc, char **argv);
+static void take_baseline();
+static void print_display_stats();
+static void print_bus_stats(const I2CBUS_TOTALS *totals);
+static void print_accel_stats(int64_t elapsedUs);
+static void print_latency_stats();
+static void print_summary(const char *what, const char *name, LATENCY_HISTOGRAM *histogram);
+static uint32_t rate_milli_hz(uint8_t rateCode);
+
+/**
+ * Registers the console commands and starts the console on the default
+ * UART, sharing it with the log.  Statistics are reported from this call
+ * until the first stats_reset.
+ *
+ * @param consoleSources PERF_CONSOLE_SOURCES to report on, copied
+ */
+esp_err_t perf_console_start(const PERF_CONSOLE_SOURCES *consoleSources) {
+    sources = *consoleSources;
+    take_baseline();
+
+    const esp_console_cmd_t commands[] = {
+        {
+            .command = "stats",
+            .help = "Print display, I2C bus, accelerometer and latency statistics since the last reset",
+            .func = stats_command,
+        },
+        {
+            .command = "stats_reset",
+            .help = "Start the statistics again from zero",
+            .func = stats_reset_command,
+        },
+        {
+            .command = "lcd_timing",
+            .help = "Show or set the display bus timing, as a profile or as E settle and instruction delays",
+            .hint = "[standard|fast|safe | <settle_us> <instruction_us>]",
+            .func = lcd_timing_command,
+        },
+        {
+            .command = "odr",
+            .help = "Set the accelerometer's active output data rate, 6.25 to 3200 Hz",
+            .hint = "<hz>",
+            .func = odr_command,
+        },
+        {
+            .command = "i2c_speed",
+            .help = "Set the I2C SCL speed of every device on the bus",
+            .hint = "<hz>",
+            .func = i2c_speed_command,
+        },
+    };
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        esp_err_t err = esp_console_cmd_register(&commands[i]);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    esp_err_t err = esp_console_register_help_command();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t replConfig = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+    replConfig.prompt = "perf>";
+    esp_console_dev_uart_config_t uartConfig = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    err = esp_console_new_repl_uart(&uartConfig, &replConfig, &repl);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return esp_console_start_repl(repl);
+}
+
+/**
+ * stats command, prints everything since the last reset.
+ */
+static int stats_command(int argc, char **argv) {
+    I2CBUS_TOTALS totals;
+    I2CBUS_getTotals(sources.bus, &totals);
+    int64_t elapsedUs = totals.timestampUs - baseline.bus.timestampUs;
+
+    printf("Over %lld.%03lld s\n", (long long) (elapsedUs / 1000000), (long long) ((elapsedUs / 1000) % 1000));
+    print_display_stats();
+    print_bus_stats(&totals);
+    print_accel_stats(elapsedUs);
+    print_latency_stats();
+    return 0;
+}
+
+/**
+ * stats_reset command.  The display statistics are zeroed by the display
+ * task on its next update, the latency histograms are cleared in place, and
+ * everything else is reported relative to a new baseline.
+ */
+static int stats_reset_command(int argc, char **argv) {
+    HD44780_resetStats();
+    for (int i = 0; i < sources.numStages; i++) {
+        LATENCY_reset(sources.stages[i]);
+    }
+    for (int i = 0; i < sources.numIntervals; i++) {
+        LATENCY_reset(&sources.intervals[i]->intervals);
+        LATENCY_reset(&sources.intervals[i]->jitter);
+    }
+    take_baseline();
+    printf("Statistics reset\n");
+    return 0;
+}
+
+/**
+ * lcd_timing command.  With no arguments prints the timing in use.
+ */
+static int lcd_timing_command(int argc, char **argv) {
+    if (argc == 2) {
+        int profile = -1;
+        for (size_t i = 0; i < sizeof(PROFILE_NAMES) / sizeof(PROFILE_NAMES[0]); i++) {
+            if (strcmp(argv[1], PROFILE_NAMES[i]) == 0) {
+                profile = (int) i;
+            }
+        }
+        if (profile < 0) {
+            printf("Unknown profile %s, use standard, fast or safe\n", argv[1]);
+            return 1;
+        }
+        HD44780_setTimingProfile((HD44780_TIMING_PROFILE) profile);
+    } else if (argc == 3) {
+        HD44780_TIMING timing = {
+            .voltageChangeUs = (uint32_t) strtoul(argv[1], NULL, 10),
+            .instructionUs = (uint32_t) strtoul(argv[2], NULL, 10),
+        };
+        HD44780_setTiming(&timing);
+    } else if (argc != 1) {
+        printf("Usage: lcd_timing [standard|fast|safe | <settle_us> <instruction_us>]\n");
+        return 1;
+    }
+
+    HD44780_TIMING timing;
+    HD44780_getTiming(&timing);
+    printf("Display timing: %lu us E settle, %lu us per instruction\n", (unsigned long) timing.voltageChangeUs,
+           (unsigned long) timing.instructionUs);
+    return 0;
+}
+
+/**
+ * odr command.  The rate is applied by the sampling task, between two FIFO
+ * drains, as the console can't touch the sensor while it's being read.
+ */
+static int odr_command(int argc, char **argv) {
+    char *end = NULL;
+    float hz = (argc == 2) ? strtof(argv[1], &end) : 0.0f;
+    if (argc != 2 || end == argv[1] || *end != '\0') {
+        printf("Usage: odr <hz>\n");
+        return 1;
+    }
+
+    // Converting anything outside the table isn't defined, NaN included, and
+    // no rate is 0
+    uint32_t milliHz = 0;
+    if (hz > 0.0f && hz <= rate_milli_hz(ADXL345_RATE_MASK) / 1000.0f) {
+        milliHz = (uint32_t) (hz * 1000.0f + 0.5f);
+    }
+    for (uint8_t rateCode = PERF_CONSOLE_MIN_RATE; rateCode <= ADXL345_RATE_MASK; rateCode++) {
+        if (rate_milli_hz(rateCode) == milliHz) {
+            esp_err_t err = sources.setRate(rateCode);
+            printf("ODR %s: %s\n", argv[1], (err == ESP_OK) ? "requested" : esp_err_to_name(err));
+            return (err == ESP_OK) ? 0 : 1;
+        }
+    }
+    printf("Unsupported rate, use 6.25, 12.5, 25, 50, 100, 200, 400, 800, 1600 or 3200\n");
+    return 1;
+}
+
+/**
+ * i2c_speed command.  The bus scheduler makes the change between two batches.
+ */
+static int i2c_speed_command(int argc, char **argv) {
+    if (argc != 2) {
+        printf("Usage: i2c_speed <hz>\n");
+        return 1;
+    }
+
+    esp_err_t err = I2CBUS_setSpeed(sources.bus, (uint32_t) strtoul(argv[1], NULL, 10));
+    printf("I2C speed %s: %s\n", argv[1], (err == ESP_OK) ? "requested" : esp_err_to_name(err));
+    return (err == ESP_OK) ? 0 : 1;
+}
+
+/**
+ * Records every counter as it stands, to report from.
+ * NOTE: The accelerometer counters are written by the bus task one word at a
+ *       time, so the copy can be a transaction apart between fields, never
+ *       torn within one.
+ */
+static void take_baseline() {
+    I2CBUS_getTotals(sources.bus, &baseline.bus);
+    baseline.health = sources.accel->health;
+    baseline.overruns = sources.ring->overruns;
+    baseline.fifoFull = *sources.fifoFull;
+    baseline.samples = *sources.samples;
+}
+
+/**
+ * Prints the time each display call has spent on the bus, and the cursor
+ * moves that were skipped.
+ */
+static void print_display_stats() {
+    HD44780_STATS stats;
+    HD44780_getStats(&stats);
+
+    printf("Display (call, calls, bytes, total ms, average us):\n");
+    for (int i = 0; i < HD44780_API_COUNT; i++) {
+        const HD44780_API_STATS *api = &stats.api[i];
+        if (api->calls == 0) {
+            continue;
+        }
+        printf("  %-12s %8lu %8lu %8llu %6llu\n", API_NAMES[i], (unsigned long) api->calls,
+               (unsigned long) api->bytes, (unsigned long long) (api->busUs / 1000),
+               (unsigned long long) (api->busUs / api->calls));
+    }
+    printf("  %lu cursor moves elided\n", (unsigned long) stats.elided);
+}
+
+/**
+ * Prints the bus scheduler's counters and utilization since the baseline.
+ *
+ * @param totals I2CBUS_TOTALS just read
+ */
+static void print_bus_stats(const I2CBUS_TOTALS *totals) {
+    const I2CBUS_TOTALS *base = &baseline.bus;
+    int64_t elapsed = totals->timestampUs - base->timestampUs;
+    uint64_t busy = totals->busyUs - base->busyUs;
+    uint32_t permille = (elapsed > 0) ? (uint32_t) ((busy * 1000) / elapsed) : 0;
+
+    printf("I2C bus: %lu.%lu%% busy, %lu transactions in %lu batches, %lu errors, %lu deadline misses, "
+           "%lu recoveries\n", (unsigned long) (permille / 10), (unsigned long) (permille % 10),
+           (unsigned long) (totals->transactions - base->transactions),
+           (unsigned long) (totals->batches - base->batches), (unsigned long) (totals->errors - base->errors),
+           (unsigned long) (totals->deadlineMisses - base->deadlineMisses),
+           (unsigned long) (totals->recoveries - base->recoveries));
+}
+
+/**
+ * Prints the accelerometer's delivered sample rate, overruns and transfer
+ * health since the baseline.
+ *
+ * @param elapsedUs Time since the baseline
+ */
+static void print_accel_stats(int64_t elapsedUs) {
+    ADXL345_HEALTH health = sources.accel->health;
+    const ADXL345_HEALTH *base = &baseline.health;
+    uint32_t samples = *sources.samples - baseline.samples;
+    // In tenths of a hertz
+    uint64_t rate = (elapsedUs > 0) ? ((uint64_t) samples * 10000000) / (uint64_t) elapsedUs : 0;
+    uint32_t odr = rate_milli_hz(sources.accel->config.bwRate);
+
+    printf("ADXL345: ODR %lu.%02lu Hz, %lu samples, %llu.%llu samples/s\n", (unsigned long) (odr / 1000),
+           (unsigned long) ((odr % 1000) / 10), (unsigned long) samples, (unsigned long long) (rate / 10),
+           (unsigned long long) (rate % 10));
+    printf("  %lu ring overruns, %lu drains found the FIFO full\n",
+           (unsigned long) (sources.ring->overruns - baseline.overruns),
+           (unsigned long) (*sources.fifoFull - baseline.fifoFull));
+    printf("  %lu errors (%lu timeouts, %lu NACKs), %lu retries, %lu failed, %lu recoveries, %lu re-inits\n",
+           (unsigned long) (health.errors - base->errors), (unsigned long) (health.timeouts - base->timeouts),
+           (unsigned long) (health.nacks - base->nacks), (unsigned long) (health.retries - base->retries),
+           (unsigned long) (health.failures - base->failures),
+           (unsigned long) (health.recoveries - base->recoveries),
+           (unsigned long) (health.reinits - base->reinits));
+}
+
+/**
+ * Prints the percentiles of every latency histogram and interval.  Prints
+ * nothing with the instrumentation compiled out.
+ */
+static void print_latency_stats() {
+    for (int i = 0; i < sources.numStages; i++) {
+        print_summary("Latency", sources.stages[i]->name, sources.stages[i]);
+    }
+    for (int i = 0; i < sources.numIntervals; i++) {
+        print_summary("Interval", sources.intervals[i]->intervals.name, &sources.intervals[i]->intervals);
+        print_summary("Jitter", sources.intervals[i]->jitter.name, &sources.intervals[i]->jitter);
+    }
+}
+
+static void print_summary(const char *what, const char *name, LATENCY_HISTOGRAM *histogram) {
+    LATENCY_SUMMARY summary;
+    LATENCY_summarize(histogram, &summary);
+    if (summary.count > 0) {
+        printf("%s %s: %lu, p50 %lu us, p90 %lu us, p99 %lu us, max %lu us\n", what, name,
+               (unsigned long) summary.count, (unsigned long) summary.p50Us, (unsigned long) summary.p90Us,
+               (unsigned long) summary.p99Us, (unsigned long) summary.maxUs);
+    }
+}
+
+/**
+ * Returns the output data rate of the param BW_RATE rate code in milli-hertz,
+ * each code doubling the rate of the one below, up to 3200 Hz.
+ */
+static uint32_t rate_milli_hz(uint8_t rateCode) {
+    return 3200000u >> (15 - (rateCode & ADXL345_RATE_MASK));
+}
@@ -0,0 +1,38 @@
+/**
+ * File:       perf_console.h
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "ADXL345.h"
+#include "ADXL345_ring.h"
+#include "I2CBus.h"
+#include "Latency.h"
+
+// Asks the sampling task to switch the accelerometer to the param BW_RATE rate code
+typedef esp_err_t (*PERF_CONSOLE_SET_RATE)(uint8_t rateCode);
+
+// Everything the console reports on, all owned by the application
+typedef struct _perfConsoleSources {
+    I2CBUS *bus;
+    ADXL345_DEVICE *accel;
+    ADXL345_RING *ring;
+    // Samples drained, and drains that found the sensor's FIFO already full
+    const uint32_t *samples;
+    const uint32_t *fifoFull;
+    LATENCY_HISTOGRAM **stages;
+    int numStages;
+    LATENCY_INTERVAL **intervals;
+    int numIntervals;
+    PERF_CONSOLE_SET_RATE setRate;
+} PERF_CONSOLE_SOURCES;
+
+
+// Public methods designed for the user to call
+esp_err_t perf_console_start(const PERF_CONSOLE_SOURCES *sources);
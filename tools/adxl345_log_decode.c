@@ -0,0 +1,129 @@
+/**
+ * File:       adxl345_log_decode.c
+ * Author:     Franklyn Dahlberg
+ * Created:    18 October, 2026
+ * Copyright:  2026 (c) Franklyn Dahlberg
+ * License:    MIT License (see https://choosealicense.com/licenses/mit/)
+ */
+
+/**
+ * Host decoder for ADXL345 sample logs pulled off a device.  Reads a log
+ * written by ADXL345_logger and prints every sample as CSV, the time of each
+ * worked out from its frame's timestamp and rate, followed by a summary on
+ * stderr of how many frames and samples decoded and how many pages held a
+ * damaged frame.  Build it on the host with the format's own source:
+ *
+ *   cc -O2 -I components/ADXL345/src -o adxl345_log_decode \
+ *       tools/adxl345_log_decode.c components/ADXL345/src/ADXL345_logformat.c
+ *
+ *   ./adxl345_log_decode accel.log > accel.csv
+ *
+ * With -s only the summary is printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "ADXL345_logformat.h"
+
+typedef struct _decodeState {
+    bool quiet;
+    uint64_t rawBytes;
+} DECODE_STATE;
+
+// Function predefinition
+void print_frame(const ADXL345_LOG_FRAME *frame, void *arg);
+uint8_t *read_file(const char *path, size_t *length);
+
+/**
+ * Main function
+ */
+int main(int argc, char **argv) {
+    DECODE_STATE state = { 0 };
+    const char *path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0) {
+            state.quiet = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == NULL) {
+        fprintf(stderr, "usage: %s [-s] <log file>\n", argv[0]);
+        return 2;
+    }
+
+    size_t length;
+    uint8_t *data = read_file(path, &length);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to read %s\n", path);
+        return 1;
+    }
+
+    if (!state.quiet) {
+        printf("time_us,rate_code,x,y,z\n");
+    }
+    ADXL345_LOG_DECODE_STATS stats = { 0 };
+    ADXL345_logDecodePages(data, length, print_frame, &state, &stats);
+    free(data);
+
+    fprintf(stderr, "%lu frames, %lu samples, %lu CRC errors, %lu format errors, %.2f:1 over %zu bytes\n",
+            (unsigned long) stats.frames, (unsigned long) stats.samples, (unsigned long) stats.crcErrors,
+            (unsigned long) stats.formatErrors, (length > 0) ? (double) state.rawBytes / length : 0.0, length);
+    return (stats.crcErrors + stats.formatErrors > 0) ? 1 : 0;
+}
+
+/**
+ * Frame callback, prints each of the frame's samples as a CSV row.
+ *
+ * @param frame Decoded ADXL345_LOG_FRAME
+ * @param arg   DECODE_STATE
+ */
+void print_frame(const ADXL345_LOG_FRAME *frame, void *arg) {
+    DECODE_STATE *state = (DECODE_STATE *) arg;
+    // Each sample is the width of three int16_t axes on the device
+    state->rawBytes += (uint64_t) frame->count * 3 * sizeof(int16_t);
+    if (state->quiet) {
+        return;
+    }
+
+    // Same period as ADXL345_samplePeriodUs, which needs the driver
+    uint8_t rateCode = frame->rateCode & 0x0F;
+    uint64_t periodUs = (1000000ull << (15 - rateCode)) / 3200u;
+    for (int i = 0; i < frame->count; i++) {
+        printf("%lld,%u,%d,%d,%d\n", (long long) (frame->timestampUs + (int64_t) (i * periodUs)),
+               (unsigned) frame->rateCode, frame->x[i], frame->y[i], frame->z[i]);
+    }
+}
+
+/**
+ * Reads the whole param file into a buffer the caller frees.
+ *
+ * @param path   File to read
+ * @param length Pointer to store the number of bytes read in
+ * @return The buffer, or NULL if the file couldn't be read
+ */
+uint8_t *read_file(const char *path, size_t *length) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = ADXL345_LOG_PAGE_SIZE;
+    uint8_t *data = malloc(capacity);
+    *length = 0;
+    size_t got;
+    while (data != NULL && (got = fread(&data[*length], 1, capacity - *length, file)) > 0) {
+        *length += got;
+        if (*length == capacity) {
+            capacity *= 2;
+            uint8_t *grown = realloc(data, capacity);
+            if (grown == NULL) {
+                free(data);
+            }
+            data = grown;
+        }
+    }
+    fclose(file);
+    return data;
+}
@@ -0,0 +1,133 @@
+# Lists where the linker put the display and acquisition code, and what the
+# IRAM placement options cost.  Run after linking with
+#
+#   cmake -DMAP=<project>.map -DREPORT=<report>.txt -P placement_report.cmake
+#
+# Every function and table of the listed component libraries that ended up
+# in IRAM or DRAM is printed with its size, followed by the totals and what
+# was left in flash.  Static IRAM_ATTR functions have no symbol in the map,
+# so they show as their numbered .iram1 section.
+
+if (NOT DEFINED LIBRARIES)
+    set(LIBRARIES HD44780 ADXL345)
+endif()
+list(JOIN LIBRARIES "|" libraryPattern)
+list(JOIN LIBRARIES ", " libraryNames)
+
+# Only the lines that matter: section headers, wrapped input section names,
+# our input sections and the symbols that name them
+file(STRINGS "${MAP}" lines REGEX
+     "^Linker script and memory map|^Cross Reference Table|^\\.[A-Za-z0-9_.]+|^ \\.[^ ]+$|lib(${libraryPattern})\\.a\\(|^ +0x[0-9a-f]+ +(${libraryPattern})[A-Za-z0-9_]*$")
+
+set(inMap FALSE)
+set(outputSection "")
+set(pendingName "")
+set(lastIndex -1)
+set(count 0)
+foreach (line IN LISTS lines)
+    if (line MATCHES "^Linker script and memory map")
+        set(inMap TRUE)
+        continue()
+    elseif (line MATCHES "^Cross Reference Table")
+        break()
+    elseif (NOT inMap)
+        continue()
+    endif()
+
+    if (line MATCHES "^(\\.[A-Za-z0-9_.]+)")
+        set(outputSection "${CMAKE_MATCH_1}")
+        set(pendingName "")
+        set(lastIndex -1)
+    elseif (line MATCHES "^ (\\.[^ ]+)$")
+        # ld wraps a long input section name onto its own line
+        set(pendingName "${CMAKE_MATCH_1}")
+    elseif (line MATCHES "^ (\\.[^ ]+)? +0x[0-9a-f]+ +(0x[0-9a-f]+) .*lib(${libraryPattern})\\.a\\(([^)]+)\\)")
+        set(inputSection "${CMAKE_MATCH_1}")
+        math(EXPR size "${CMAKE_MATCH_2}")
+        set(object "${CMAKE_MATCH_4}")
+        if (inputSection STREQUAL "")
+            set(inputSection "${pendingName}")
+        endif()
+        set(pendingName "")
+        set(lastIndex -1)
+
+        # Only code and constant data move between flash and RAM
+        if (size GREATER 0 AND inputSection MATCHES "^\\.(text|literal|iram1|rodata|dram1)")
+            if (inputSection MATCHES "^\\.(text|literal|rodata)\\.(.+)$")
+                set(name "${CMAKE_MATCH_2}")
+            else()
+                set(name "${inputSection}")
+            endif()
+            string(REGEX REPLACE "\\.c\\.obj$|\\.obj$|\\.o$" ".c" object "${object}")
+            set(entry${count}_name "${name}")
+            set(entry${count}_size ${size})
+            set(entry${count}_object "${object}")
+            set(entry${count}_output "${outputSection}")
+            set(lastIndex ${count})
+            math(EXPR count "${count} + 1")
+        endif()
+    elseif (line MATCHES "^ +0x[0-9a-f]+ +([A-Za-z_][A-Za-z0-9_]*)$")
+        # IRAM_ATTR and DRAM_ATTR sections are numbered, the symbol names them
+        if (lastIndex GREATER -1 AND entry${lastIndex}_name MATCHES "^\\.")
+            set(entry${lastIndex}_name "${CMAKE_MATCH_1}")
+        endif()
+        set(pendingName "")
+    endif()
+endforeach()
+
+# A function's literal pool is listed separately, fold it into the function
+set(iramBytes 0)
+set(dramBytes 0)
+set(flashBytes 0)
+set(flashCount 0)
+set(placed "")
+set(report "Code placement for ${libraryNames}\n")
+math(EXPR last "${count} - 1")
+foreach (i RANGE 0 ${last})
+    if (count EQUAL 0)
+        break()
+    endif()
+    set(output "${entry${i}_output}")
+    set(size ${entry${i}_size})
+    if (output MATCHES "^\\.iram0")
+        set(region "IRAM")
+        math(EXPR iramBytes "${iramBytes} + ${size}")
+    elseif (output MATCHES "^\\.dram0")
+        set(region "DRAM")
+        math(EXPR dramBytes "${dramBytes} + ${size}")
+    else()
+        math(EXPR flashBytes "${flashBytes} + ${size}")
+        if (NOT entry${i}_name MATCHES "^\\.")
+            math(EXPR flashCount "${flashCount} + 1")
+        endif()
+        continue()
+    endif()
+    set(key "${region} ${entry${i}_name}")
+    list(FIND placed "${key}" found)
+    if (found EQUAL -1)
+        list(APPEND placed "${key}")
+        set(placed_${region}_${entry${i}_name}_size ${size})
+        set(placed_${region}_${entry${i}_name}_object "${entry${i}_object}")
+    else()
+        math(EXPR placed_${region}_${entry${i}_name}_size "${placed_${region}_${entry${i}_name}_size} + ${size}")
+    endif()
+endforeach()
+
+foreach (key IN LISTS placed)
+    string(REPLACE " " ";" parts "${key}")
+    list(GET parts 0 region)
+    list(GET parts 1 name)
+    string(LENGTH "${name}" length)
+    math(EXPR pad "36 - ${length}")
+    if (pad LESS 1)
+        set(pad 1)
+    endif()
+    string(REPEAT " " ${pad} spaces)
+    set(report "${report}  ${region}  ${name}${spaces}${placed_${region}_${name}_size} bytes  ${placed_${region}_${name}_object}\n")
+endforeach()
+set(report "${report}IRAM ${iramBytes} bytes, DRAM tables ${dramBytes} bytes, flash ${flashBytes} bytes in ${flashCount} functions and tables\n")
+
+message("${report}")
+if (DEFINED REPORT)
+    file(WRITE "${REPORT}" "${report}")
+endif()